@@ -192,6 +192,14 @@ API_EXPORT void API_CALL mk_set_option(const char *key, const char *val);
  */
 API_EXPORT const char * API_CALL mk_get_option(const char *key);
 
+/**
+ * 在服务器默认ssl上下文上安装kTLS所需的回调(general.enableKTls开启时)
+ * mk_env_init加载证书后已自动调用，自行重新加载ssl证书后需再次调用
+ * Install the callbacks needed by kTLS on the default server ssl context (when general.enableKTls is on)
+ * mk_env_init calls it after loading certificates, call it again after reloading the ssl certificates yourself
+ */
+API_EXPORT void API_CALL mk_ktls_install_callbacks();
+
 
 /**
  * 创建http[s]服务器
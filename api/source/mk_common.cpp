@@ -22,6 +22,7 @@
 #include "Rtmp/RtmpSession.h"
 #include "Http/HttpSession.h"
 #include "Shell/ShellSession.h"
+#include "Common/KTls.h"
 using namespace std;
 using namespace toolkit;
 using namespace mediakit;
@@ -156,6 +157,7 @@ API_EXPORT void API_CALL mk_env_init2(int thread_num,
             // Set SSL certificate
             SSL_Initor::Instance().loadCertificate(ssl, true, ssl_pwd ? ssl_pwd : "", ssl_is_path);
         }
+        KTls::installCallbacks();
     });
 }
 
@@ -189,13 +191,17 @@ API_EXPORT const char * API_CALL mk_get_option(const char *key)
     return mINI::Instance()[key].data();
 }
 
+API_EXPORT void API_CALL mk_ktls_install_callbacks() {
+    KTls::installCallbacks();
+}
+
 
 API_EXPORT uint16_t API_CALL mk_http_server_start(uint16_t port, int ssl) {
     ssl = MAX(0,MIN(ssl,1));
     try {
         http_server[ssl] = std::make_shared<TcpServer>();
         if(ssl){
-            http_server[ssl]->start<SessionWithSSL<HttpSession> >(port);
+            http_server[ssl]->start<HttpsSession>(port);
         } else{
             http_server[ssl]->start<HttpSession>(port);
         }
@@ -212,7 +218,7 @@ API_EXPORT uint16_t API_CALL mk_rtsp_server_start(uint16_t port, int ssl) {
     try {
         rtsp_server[ssl] = std::make_shared<TcpServer>();
         if(ssl){
-            rtsp_server[ssl]->start<SessionWithSSL<RtspSession> >(port);
+            rtsp_server[ssl]->start<RtspSessionWithSSL>(port);
         }else{
             rtsp_server[ssl]->start<RtspSession>(port);
         }
@@ -229,7 +235,7 @@ API_EXPORT uint16_t API_CALL mk_rtmp_server_start(uint16_t port, int ssl) {
     try {
         rtmp_server[ssl] = std::make_shared<TcpServer>();
         if(ssl){
-            rtmp_server[ssl]->start<SessionWithSSL<RtmpSession> >(port);
+            rtmp_server[ssl]->start<RtmpSessionWithSSL>(port);
         }else{
             rtmp_server[ssl]->start<RtmpSession>(port);
         }
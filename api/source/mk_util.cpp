@@ -173,8 +173,8 @@ API_EXPORT void API_CALL mk_get_statistic(on_mk_get_statistic_cb func, void *use
     auto obj = std::make_shared<toolkit::mINI>();
     auto &val = *obj;
 
-    val["object.MediaSource"] = ObjectStatistic<MediaSource>::count();
-    val["object.MultiMediaSourceMuxer"] = ObjectStatistic<MultiMediaSourceMuxer>::count();
+    val["object.MediaSource"] = ObjectCounter<MediaSource>::count();
+    val["object.MultiMediaSourceMuxer"] = ObjectCounter<MultiMediaSourceMuxer>::count();
 
     val["object.TcpServer"] = ObjectStatistic<TcpServer>::count();
     val["object.TcpSession"] = ObjectStatistic<TcpSession>::count();
@@ -183,16 +183,16 @@ API_EXPORT void API_CALL mk_get_statistic(on_mk_get_statistic_cb func, void *use
     val["object.TcpClient"] = ObjectStatistic<TcpClient>::count();
     val["object.Socket"] = ObjectStatistic<Socket>::count();
 
-    val["object.FrameImp"] = ObjectStatistic<FrameImp>::count();
-    val["object.Frame"] = ObjectStatistic<Frame>::count();
+    val["object.FrameImp"] = ObjectCounter<FrameImp>::count();
+    val["object.Frame"] = ObjectCounter<Frame>::count();
 
     val["object.Buffer"] = ObjectStatistic<Buffer>::count();
     val["object.BufferRaw"] = ObjectStatistic<BufferRaw>::count();
     val["object.BufferLikeString"] = ObjectStatistic<BufferLikeString>::count();
     val["object.BufferList"] = ObjectStatistic<BufferList>::count();
 
-    val["object.RtpPacket"] = ObjectStatistic<RtpPacket>::count();
-    val["object.RtmpPacket"] = ObjectStatistic<RtmpPacket>::count();
+    val["object.RtpPacket"] = ObjectCounter<RtpPacket>::count();
+    val["object.RtmpPacket"] = ObjectCounter<RtmpPacket>::count();
 #ifdef ENABLE_MEM_DEBUG
     auto bytes = getTotalMemUsage();
     val["memory.memUsage"] = bytes;
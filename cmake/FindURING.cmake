@@ -0,0 +1,23 @@
+# - Find the liburing include file and library
+#
+#  URING_FOUND - system has liburing
+#  URING_INCLUDE_DIRS - the liburing include directory
+#  URING_LIBRARIES - The libraries needed to use liburing
+
+find_path(URING_INCLUDE_DIRS
+	NAMES liburing.h
+	PATH_SUFFIXES include
+)
+
+find_library(URING_LIBRARIES
+	NAMES uring
+	PATH_SUFFIXES lib
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(URING
+	DEFAULT_MSG
+	URING_INCLUDE_DIRS URING_LIBRARIES
+)
+
+mark_as_advanced(URING_INCLUDE_DIRS URING_LIBRARIES)
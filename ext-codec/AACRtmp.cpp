@@ -28,7 +28,7 @@ void AACRtmpDecoder::inputRtmp(const RtmpPacket::Ptr &pkt) {
 /////////////////////////////////////////////////////////////////////////////////////
 
 bool AACRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
-    auto pkt = RtmpPacket::create();
+    auto pkt = RtmpPacket::create(frame->size() - frame->prefixSize() + 2);
     // header
     pkt->buffer.push_back(_audio_flv_flags);
     pkt->buffer.push_back((uint8_t)RtmpAACPacketType::aac_raw);
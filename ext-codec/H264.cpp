@@ -22,6 +22,25 @@
 #include "mpeg4-avc.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENABLE_START_CODE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(ENABLE_START_CODE_SSE2) && defined(__GNUC__) && !defined(_MSC_VER) && !defined(__ANDROID__)
+#define ENABLE_START_CODE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENABLE_START_CODE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 using namespace std;
 using namespace toolkit;
 
@@ -50,13 +69,137 @@ bool getAVCInfo(const string &strSps, int &iVideoWidth, int &iVideoHeight, float
     return getAVCInfo(strSps.data(), strSps.size(), iVideoWidth, iVideoHeight, iVideoFps);
 }
 
-static const char *memfind(const char *buf, ssize_t len, const char *subbuf, ssize_t sublen) {
-    for (auto i = 0; i < len - sublen; ++i) {
-        if (memcmp(buf + i, subbuf, sublen) == 0) {
-            return buf + i;
+/////////////////////////////////////起始码查找/Start code search//////////////////////////////////////
+
+static const char *findStartCode_scalar(const char *ptr, size_t len) {
+    auto p = (const uint8_t *)ptr;
+    size_t i = 0;
+    while (i + 3 <= len) {
+        // 0x00 00 01的第三个字节大于1时，前两个位置都不可能是起始码，直接跳过3个字节
+        // If the third byte is greater than 1, neither of the two previous positions can start a start code, skip 3 bytes
+        if (p[i + 2] > 1) {
+            i += 3;
+        } else if (p[i + 2] == 0) {
+            ++i;
+        } else if (p[i] == 0 && p[i + 1] == 0) {
+            return ptr + i;
+        } else {
+            i += 3;
+        }
+    }
+    return nullptr;
+}
+
+static inline int countTrailingZero(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+#ifdef ENABLE_START_CODE_SSE2
+static const char *findStartCode_sse2(const char *ptr, size_t len) {
+    // 每次比较16个位置：p[i]==0 && p[i+1]==0 && p[i+2]==1
+    // Compare 16 positions at a time: p[i]==0 && p[i+1]==0 && p[i+2]==1
+    auto zero = _mm_setzero_si128();
+    auto one = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 16 + 2 <= len; i += 16) {
+        auto b0 = _mm_loadu_si128((const __m128i *)(ptr + i));
+        auto b1 = _mm_loadu_si128((const __m128i *)(ptr + i + 1));
+        auto b2 = _mm_loadu_si128((const __m128i *)(ptr + i + 2));
+        auto hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)), _mm_cmpeq_epi8(b2, one));
+        auto mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask) {
+            return ptr + i + countTrailingZero(mask);
+        }
+    }
+    return findStartCode_scalar(ptr + i, len - i);
+}
+#endif
+
+#ifdef ENABLE_START_CODE_AVX2
+__attribute__((target("avx2"))) static const char *findStartCode_avx2(const char *ptr, size_t len) {
+    auto zero = _mm256_setzero_si256();
+    auto one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 + 2 <= len; i += 32) {
+        auto b0 = _mm256_loadu_si256((const __m256i *)(ptr + i));
+        auto b1 = _mm256_loadu_si256((const __m256i *)(ptr + i + 1));
+        auto b2 = _mm256_loadu_si256((const __m256i *)(ptr + i + 2));
+        auto hit = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)), _mm256_cmpeq_epi8(b2, one));
+        auto mask = (uint32_t)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return ptr + i + countTrailingZero(mask);
+        }
+    }
+    return findStartCode_sse2(ptr + i, len - i);
+}
+#endif
+
+#ifdef ENABLE_START_CODE_NEON
+static const char *findStartCode_neon(const char *ptr, size_t len) {
+    auto zero = vdupq_n_u8(0);
+    auto one = vdupq_n_u8(1);
+    size_t i = 0;
+    for (; i + 16 + 2 <= len; i += 16) {
+        auto b0 = vld1q_u8((const uint8_t *)ptr + i);
+        auto b1 = vld1q_u8((const uint8_t *)ptr + i + 1);
+        auto b2 = vld1q_u8((const uint8_t *)ptr + i + 2);
+        auto hit = vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+        // 把16字节的比较结果压缩成64位掩码，每个位置占4比特
+        // Narrow the 16 byte result to a 64 bit mask, 4 bits per position
+        auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask) {
+            return ptr + i + (__builtin_ctzll(mask) >> 2);
         }
     }
-    return NULL;
+    return findStartCode_scalar(ptr + i, len - i);
+}
+#endif
+
+static FindStartCode selectFindStartCode() {
+#ifdef ENABLE_START_CODE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findStartCode_avx2;
+    }
+#endif
+#ifdef ENABLE_START_CODE_SSE2
+    return findStartCode_sse2;
+#elif defined(ENABLE_START_CODE_NEON)
+    return findStartCode_neon;
+#else
+    return findStartCode_scalar;
+#endif
+}
+
+const char *findStartCode(const char *ptr, size_t len) {
+    // 运行时根据cpu特性选择实现
+    // Pick the implementation by the cpu features at runtime
+    static auto s_find = selectFindStartCode();
+    return s_find(ptr, len);
+}
+
+vector<pair<string, FindStartCode>> getFindStartCodeImpls() {
+    vector<pair<string, FindStartCode>> ret;
+    ret.emplace_back("scalar", findStartCode_scalar);
+#ifdef ENABLE_START_CODE_SSE2
+    ret.emplace_back("sse2", findStartCode_sse2);
+#endif
+#ifdef ENABLE_START_CODE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        ret.emplace_back("avx2", findStartCode_avx2);
+    }
+#endif
+#ifdef ENABLE_START_CODE_NEON
+    ret.emplace_back("neon", findStartCode_neon);
+#endif
+    return ret;
 }
 
 void splitH264(
@@ -65,7 +208,9 @@ void splitH264(
     auto end = ptr + len;
     size_t next_prefix;
     while (true) {
-        auto next_start = memfind(start, end - start, "\x00\x00\x01", 3);
+        // 起始码之后至少要有一个字节
+        // At least one byte must follow the start code
+        auto next_start = end - start > 1 ? findStartCode(start, end - start - 1) : nullptr;
         if (next_start) {
             // 找到下一帧  [AUTO-TRANSLATED:7161f54a]
             // Find the next frame
@@ -18,6 +18,27 @@
 
 namespace mediakit{
 
+/**
+ * 查找第一个0x00 00 01起始码，根据cpu特性使用SSE2/AVX2/NEON加速
+ * @param ptr 数据指针
+ * @param len 数据长度
+ * @return 起始码位置，未找到时返回nullptr
+ * Find the first 0x00 00 01 start code, accelerated by SSE2/AVX2/NEON according to the cpu features
+ * @param ptr Data pointer
+ * @param len Data length
+ * @return Position of the start code, nullptr if not found
+ */
+const char *findStartCode(const char *ptr, size_t len);
+
+using FindStartCode = const char *(*)(const char *ptr, size_t len);
+
+/**
+ * 获取当前cpu支持的所有起始码查找实现，第一个为逐字节查找的标量实现，用于校验各加速实现的正确性
+ * Get all start code search implementations supported by the current cpu, the first one is the scalar byte by byte search,
+ * used to verify the accelerated implementations
+ */
+std::vector<std::pair<std::string, FindStartCode>> getFindStartCodeImpls();
+
 void splitH264(const char *ptr, size_t len, size_t prefix, const std::function<void(const char *, size_t, size_t)> &cb);
 size_t prefixSize(const char *ptr, size_t len);
 
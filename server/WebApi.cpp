@@ -19,6 +19,8 @@
 #include <tchar.h>
 #endif // _WIN32
 
+#include <set>
+#include <map>
 #include <functional>
 #include <unordered_map>
 #include <regex>
@@ -42,12 +44,21 @@
 
 #include "Common/config.h"
 #include "Common/MediaSource.h"
+#include "Common/UdpBatchSender.h"
+#include "Common/UdpBatchReceiver.h"
+#include "Common/PacketArena.h"
+#include "Common/PacketCache.h"
+#include "Common/RingFanoutMonitor.h"
+#include "Common/KTls.h"
+#include "Common/GopCacheBudget.h"
+#include "Common/Metrics.h"
 #include "Http/HttpSession.h"
 #include "Http/HttpRequester.h"
 #include "Player/PlayerProxy.h"
 #include "Pusher/PusherProxy.h"
 #include "Rtp/RtpProcess.h"
 #include "Record/MP4Reader.h"
+#include "Record/HlsMediaSource.h"
 
 #if defined(ENABLE_RTPPROXY)
 #include "Rtp/RtpServer.h"
@@ -402,6 +413,12 @@ Value makeMediaSourceJson(MediaSource &media){
     item["originUrl"] = media.getOriginUrl();
     item["isRecordingMP4"] = media.isRecording(Recorder::type_mp4);
     item["isRecordingHLS"] = media.isRecording(Recorder::type_hls);
+    // 本媒体源的解复用与分发开销，复用开销见getMediaCost接口
+    // Demuxing and fan-out cost of this media source, see the getMediaCost api for the muxing cost
+    auto &cost = media.getCost();
+    item["cpuUs"] = (Json::UInt64)cost.getCpuTime();
+    item["cpuLoad"] = cost.getCpuLoad();
+    item["cacheBytes"] = (Json::UInt64)cost.getCacheBytes();
     auto originSock = media.getOriginSock();
     if (originSock) {
         fillSockInfo(item["originSock"], originSock.get());
@@ -494,8 +511,8 @@ uint16_t openRtpServer(uint16_t local_port, const mediakit::MediaTuple &tuple, i
 void getStatisticJson(const function<void(Value &val)> &cb) {
     auto obj = std::make_shared<Value>(objectValue);
     auto &val = *obj;
-    val["MediaSource"] = (Json::UInt64)(ObjectStatistic<MediaSource>::count());
-    val["MultiMediaSourceMuxer"] = (Json::UInt64)(ObjectStatistic<MultiMediaSourceMuxer>::count());
+    val["MediaSource"] = (Json::UInt64)(ObjectCounter<MediaSource>::count());
+    val["MultiMediaSourceMuxer"] = (Json::UInt64)(ObjectCounter<MultiMediaSourceMuxer>::count());
 
     val["TcpServer"] = (Json::UInt64)(ObjectStatistic<TcpServer>::count());
     val["TcpSession"] = (Json::UInt64)(ObjectStatistic<TcpSession>::count());
@@ -504,16 +521,71 @@ void getStatisticJson(const function<void(Value &val)> &cb) {
     val["TcpClient"] = (Json::UInt64)(ObjectStatistic<TcpClient>::count());
     val["Socket"] = (Json::UInt64)(ObjectStatistic<Socket>::count());
 
-    val["FrameImp"] = (Json::UInt64)(ObjectStatistic<FrameImp>::count());
-    val["Frame"] = (Json::UInt64)(ObjectStatistic<Frame>::count());
+    val["FrameImp"] = (Json::UInt64)(ObjectCounter<FrameImp>::count());
+    val["Frame"] = (Json::UInt64)(ObjectCounter<Frame>::count());
 
     val["Buffer"] = (Json::UInt64)(ObjectStatistic<Buffer>::count());
     val["BufferRaw"] = (Json::UInt64)(ObjectStatistic<BufferRaw>::count());
     val["BufferLikeString"] = (Json::UInt64)(ObjectStatistic<BufferLikeString>::count());
     val["BufferList"] = (Json::UInt64)(ObjectStatistic<BufferList>::count());
 
-    val["RtpPacket"] = (Json::UInt64)(ObjectStatistic<RtpPacket>::count());
-    val["RtmpPacket"] = (Json::UInt64)(ObjectStatistic<RtmpPacket>::count());
+    val["RtpPacket"] = (Json::UInt64)(ObjectCounter<RtpPacket>::count());
+    val["RtmpPacket"] = (Json::UInt64)(ObjectCounter<RtmpPacket>::count());
+
+    auto udp_batch = UdpBatchSender::getStatistic();
+    val["UdpBatchPackets"] = (Json::UInt64)udp_batch.packets;
+    val["UdpBatchSyscalls"] = (Json::UInt64)udp_batch.syscalls;
+    val["UdpBatchGsoPackets"] = (Json::UInt64)udp_batch.gso_packets;
+    // 每次系统调用平均发送的udp包个数
+    // Average udp packets sent per syscall
+    val["UdpPacketsPerSyscall"] = udp_batch.syscalls ? (double)udp_batch.packets / udp_batch.syscalls : 0.0;
+    auto udp_recv = UdpBatchReceiver::getStatistic();
+    val["UdpBatchRecvDatagrams"] = (Json::UInt64)udp_recv.datagrams;
+    val["UdpBatchRecvBatches"] = (Json::UInt64)udp_recv.batches;
+    // 内存hls切片占用的字节数
+    // Bytes taken by in-memory hls segments
+    val["HlsMemoryBytes"] = (Json::UInt64)HlsMediaSource::getSegmentsMemory();
+    // 包内存池各容量级别的统计
+    // Statistics of each capacity class of the packet arena
+    for (auto &stat : PacketArenaBase::getStatistic()) {
+        Value item;
+        item["classSize"] = (Json::UInt64)stat.class_size;
+        item["obtain"] = (Json::UInt64)stat.obtain;
+        item["hit"] = (Json::UInt64)stat.hit;
+        item["fallback"] = (Json::UInt64)stat.fallback;
+        item["recycle"] = (Json::UInt64)stat.recycle;
+        item["drop"] = (Json::UInt64)stat.drop;
+        item["liveBytes"] = (Json::Int64)stat.live_bytes;
+        item["hitRate"] = stat.obtain ? (double)stat.hit / stat.obtain : 0.0;
+        val["PacketArena"].append(item);
+    }
+    auto merge_write = FlushPolicy::getStatistic();
+    val["MergeWriteFlushes"] = (Json::UInt64)merge_write.flushes;
+    val["MergeWritePackets"] = (Json::UInt64)merge_write.packets;
+    // 平均每次合并写刷新的包数
+    // Average packets per merge write flush
+    val["MergeWritePacketsPerFlush"] = merge_write.flushes ? (double)merge_write.packets / merge_write.flushes : 0.0;
+    // 每个线程的环形缓冲分发队列
+    // Ring buffer fan-out queue of every thread
+    for (auto &stat : RingFanoutMonitor::getStatistic()) {
+        Value item;
+        item["poller"] = stat.poller;
+        item["probes"] = (Json::UInt64)stat.probes;
+        item["pending"] = (Json::Int64)stat.pending;
+        item["lastDelayUs"] = (Json::UInt64)stat.last_delay_us;
+        item["maxDelayUs"] = (Json::UInt64)stat.max_delay_us;
+        val["RingFanout"].append(item);
+    }
+    auto ktls = KTls::getStatistic();
+    val["KTlsSessions"] = (Json::UInt64)ktls.sessions;
+    val["KTlsOffloaded"] = (Json::UInt64)ktls.offloaded;
+    val["KTlsFallback"] = (Json::UInt64)ktls.fallback;
+    auto gop_cache = GopCacheBudget::getStatistic();
+    val["GopCacheBytes"] = (Json::UInt64)gop_cache.cache_bytes;
+    val["GopCacheProtocolBytes"] = (Json::UInt64)gop_cache.protocol_cache_bytes;
+    val["GopCacheBudgetBytes"] = (Json::UInt64)gop_cache.budget_bytes;
+    val["GopCacheEvictions"] = (Json::UInt64)gop_cache.evictions;
+    val["GopCacheRebuilds"] = (Json::UInt64)gop_cache.rebuilds;
 #ifdef ENABLE_MEM_DEBUG
     auto bytes = getTotalMemUsage();
     val["totalMemUsage"] = (Json::UInt64) bytes;
@@ -933,6 +1005,64 @@ void installWebApi() {
         }
     });
 
+    // 获取每个流的cpu与缓存开销，可选筛选参数
+    // Get the cpu and cache cost of every stream, optional filtering parameters
+    // 测试url http://127.0.0.1/index/api/getMediaCost?vhost=__defaultVhost__&app=live&stream=obs
+    api_regist("/index/api/getMediaCost",[](API_ARGS_MAP){
+        CHECK_SECRET();
+        // 同一个流的各协议媒体源共用一个MultiMediaSourceMuxer，按流汇总
+        // The media sources of all protocols of a stream share one MultiMediaSourceMuxer, sum them up per stream
+        struct StreamCost {
+            MediaTuple tuple;
+            uint64_t cpu_us[MediaCost::kTypeMax] = { 0 };
+            float cpu_load = 0;
+            uint64_t cache_bytes = 0;
+            Value sources { arrayValue };
+            std::set<MultiMediaSourceMuxer *> muxers;
+        };
+        std::map<std::string, StreamCost> streams;
+        auto add = [](StreamCost &stream, MediaCost &cost) {
+            for (int i = 0; i < MediaCost::kTypeMax; ++i) {
+                stream.cpu_us[i] += cost.getCpuTime((MediaCost::Type)i);
+            }
+            stream.cpu_load += cost.getCpuLoad();
+            stream.cache_bytes += cost.getCacheBytes();
+        };
+        MediaSource::for_each_media([&](const MediaSource::Ptr &media) {
+            auto &stream = streams[media->getMediaTuple().shortUrl()];
+            stream.tuple = media->getMediaTuple();
+            auto &cost = media->getCost();
+            add(stream, cost);
+            Value obj;
+            obj["schema"] = media->getSchema();
+            obj["demuxUs"] = (Json::UInt64)cost.getCpuTime(MediaCost::kDemux);
+            obj["fanoutUs"] = (Json::UInt64)cost.getCpuTime(MediaCost::kFanout);
+            obj["cacheBytes"] = (Json::UInt64)cost.getCacheBytes();
+            stream.sources.append(obj);
+            auto muxer = media->getMuxer();
+            if (muxer && stream.muxers.emplace(muxer.get()).second) {
+                add(stream, muxer->getCost());
+            }
+        }, "", allArgs["vhost"], allArgs["app"], allArgs["stream"]);
+
+        val["data"] = Value(arrayValue);
+        for (auto &pr : streams) {
+            auto &stream = pr.second;
+            Value item;
+            dumpMediaTuple(stream.tuple, item);
+            item["demuxUs"] = (Json::UInt64)stream.cpu_us[MediaCost::kDemux];
+            item["muxUs"] = (Json::UInt64)stream.cpu_us[MediaCost::kMux];
+            item["fanoutUs"] = (Json::UInt64)stream.cpu_us[MediaCost::kFanout];
+            item["cpuUs"] = (Json::UInt64)(stream.cpu_us[MediaCost::kDemux] + stream.cpu_us[MediaCost::kMux] + stream.cpu_us[MediaCost::kFanout]);
+            // 单核的百分比
+            // Percent of one core
+            item["cpuLoad"] = stream.cpu_load;
+            item["cacheBytes"] = (Json::UInt64)stream.cache_bytes;
+            item["sources"] = std::move(stream.sources);
+            val["data"].append(std::move(item));
+        }
+    });
+
     // 测试url http://127.0.0.1/index/api/isMediaOnline?schema=rtsp&vhost=__defaultVhost__&app=live&stream=obs  [AUTO-TRANSLATED:126a75e8]
     // Test url http://127.0.0.1/index/api/isMediaOnline?schema=rtsp&vhost=__defaultVhost__&app=live&stream=obs
     api_regist("/index/api/isMediaOnline",[](API_ARGS_MAP){
@@ -2068,6 +2198,15 @@ void installWebApi() {
         });
     });
 
+    // 以prometheus文本格式获取统计指标(各协议收发包数与字节数、丢包、重传、对象个数等)
+    // Get the metrics in the prometheus text format (packets and bytes of each protocol, drops, retransmits, object counts etc.)
+    // 测试url http://127.0.0.1/index/api/metrics
+    api_regist("/index/api/metrics",[](API_ARGS_MAP_ASYNC){
+        CHECK_SECRET();
+        headerOut["Content-Type"] = "text/plain; version=0.0.4; charset=utf-8";
+        invoker(200, headerOut, Metric::toPrometheus());
+    });
+
 #ifdef ENABLE_WEBRTC
     api_regist("/index/api/webrtc",[](API_ARGS_STRING_ASYNC){
         CHECK_ARGS("type");
@@ -306,6 +306,7 @@ int start_main(int argc,char *argv[]) {
             };
         }
         g_reload_certificates();
+        KTls::installCallbacks();
 
         std::string listen_ip = mINI::Instance()[General::kListenIP];
         uint16_t shellPort = mINI::Instance()[Shell::kPort];
@@ -492,6 +493,7 @@ int start_main(int argc,char *argv[]) {
         signal(SIGHUP, [](int) {
             mediakit::loadIniConfig(g_ini_file.data());
             g_reload_certificates();
+            KTls::installCallbacks();
         });
 #endif
         sem.wait();
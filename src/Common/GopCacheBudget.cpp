@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+#include <algorithm>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "GopCacheBudget.h"
+#include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Common/MediaSource.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+static Metric s_evictions("zlm_gop_cache_evictions_total", "Gop caches evicted by the gop cache budget");
+static Metric s_rebuilds("zlm_gop_cache_rebuilds_total", "Evicted gop caches rebuilt from the frame level gop cache");
+
+INSTANCE_IMP(GopCacheBudget);
+
+GopCacheBudget::GopCacheBudget() {
+    _timer = std::make_shared<Timer>(
+        1.0f,
+        [this]() {
+            onManager();
+            return true;
+        },
+        nullptr);
+}
+
+GopCacheBudget::~GopCacheBudget() {
+    _timer.reset();
+}
+
+GopCacheBudget::Statistic GopCacheBudget::getStatistic() {
+    GET_CONFIG(size_t, max_mb, General::kGopCacheMaxMB);
+    Statistic ret;
+    ret.cache_bytes = MediaCost::getTotalCacheBytes();
+    ret.protocol_cache_bytes = MediaCost::getProtocolCacheBytes();
+    ret.budget_bytes = (uint64_t)max_mb * 1024 * 1024;
+    ret.evictions = s_evictions.value();
+    ret.rebuilds = s_rebuilds.value();
+    return ret;
+}
+
+void GopCacheBudget::onRebuild() {
+    s_rebuilds.add();
+}
+
+void GopCacheBudget::onManager() {
+    GET_CONFIG(size_t, max_mb, General::kGopCacheMaxMB);
+    if (!max_mb) {
+        return;
+    }
+    size_t budget = max_mb * 1024 * 1024;
+    // 帧级gop缓存用于重建，不可淘汰，只统计协议环形缓冲
+    // Frame level gop caches are needed for rebuilding and can not be evicted, only the protocol ring buffers are counted
+    size_t total = MediaCost::getProtocolCacheBytes();
+    if (total <= budget) {
+        return;
+    }
+
+    struct Candidate {
+        MediaSource::Ptr src;
+        size_t bytes;
+        bool idle;
+        uint64_t last_access;
+    };
+    vector<Candidate> candidates;
+    MediaSource::for_each_media([&](const MediaSource::Ptr &src) {
+        auto bytes = src->getCost().getCacheBytes();
+        if (bytes && src->isGopCacheEvictable()) {
+            candidates.emplace_back(Candidate { src, bytes, src->readerCount() == 0, src->getLastReaderChangedMS() });
+        }
+    });
+
+    // 无人观看的流优先，其次最近一次观看人数变化越早越先淘汰
+    // Streams without readers first, then the earlier the reader count last changed, the earlier it is evicted
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.idle != b.idle) {
+            return a.idle;
+        }
+        return a.last_access < b.last_access;
+    });
+
+    size_t evicted = 0;
+    for (auto &candidate : candidates) {
+        if (total <= budget) {
+            break;
+        }
+        if (candidate.src->evictGopCache()) {
+            total -= std::min(total, candidate.bytes);
+            s_evictions.add();
+            ++evicted;
+        }
+    }
+    if (evicted) {
+        DebugL << "gop cache over budget, evicted " << evicted << " gop caches, " << MediaCost::getProtocolCacheBytes() << " -> " << total
+               << " bytes, budget: " << budget;
+    }
+}
+
+} // namespace mediakit
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_GOPCACHEBUDGET_H
+#define ZLMEDIAKIT_GOPCACHEBUDGET_H
+
+#include <memory>
+#include <cstdint>
+#include "Util/List.h"
+#include "Util/RingBuffer.h"
+#include "Poller/Timer.h"
+
+namespace mediakit {
+
+/**
+ * 全局gop缓存内存预算(general.gopCacheMaxMB)
+ * 每秒检查一次协议环形缓冲中gop缓存的总字节数，超出预算时按最近最少使用的顺序淘汰可重建的rtsp/rtmp/ts环形缓冲中的gop缓存(无人观看的流优先)，
+ * 淘汰后有播放器加入时由MultiMediaSourceMuxer从帧级gop缓存重新生成首个gop
+ * Global memory budget of gop caches (general.gopCacheMaxMB)
+ * The total bytes of the gop caches in the protocol ring buffers are checked every second, when over budget the gop caches in the
+ * rebuildable rtsp/rtmp/ts ring buffers are evicted in least recently used order (streams without readers first), then when a player joins,
+ * MultiMediaSourceMuxer regenerates the first gop from its frame level gop cache
+ */
+class GopCacheBudget {
+public:
+    struct Statistic {
+        // 所有gop缓存的字节数，含帧级gop缓存
+        // Bytes of all gop caches, frame level gop caches included
+        uint64_t cache_bytes;
+        // 协议环形缓冲的gop缓存字节数，不含帧级gop缓存，与内存预算比较
+        // Bytes of the gop caches in the protocol ring buffers, frame level gop caches excluded, compared against the budget
+        uint64_t protocol_cache_bytes;
+        // 内存预算字节数，0代表不限制
+        // Memory budget in bytes, 0 means unlimited
+        uint64_t budget_bytes;
+        // 淘汰次数
+        // Number of evictions
+        uint64_t evictions;
+        // 播放器加入时重建gop缓存的次数
+        // Number of gop caches rebuilt when players joined
+        uint64_t rebuilds;
+    };
+
+    static GopCacheBudget &Instance();
+    ~GopCacheBudget();
+
+    /**
+     * 获取gop缓存统计
+     * Get the gop cache statistics
+     */
+    static Statistic getStatistic();
+
+    /**
+     * 重建gop缓存后调用
+     * Called after a gop cache is rebuilt
+     */
+    static void onRebuild();
+
+private:
+    GopCacheBudget();
+    void onManager();
+
+private:
+    toolkit::Timer::Ptr _timer;
+};
+
+/**
+ * 收集复用器输出到环形缓冲的包，用于重建协议gop缓存
+ * Collect the packets a muxer writes into its ring buffer, used to rebuild protocol gop caches
+ */
+template <typename Packet>
+class GopCollector : public toolkit::RingDelegate<std::shared_ptr<Packet> > {
+public:
+    using Ptr = std::shared_ptr<GopCollector>;
+    using List = toolkit::List<std::shared_ptr<Packet> >;
+
+    void onWrite(std::shared_ptr<Packet> in, bool is_key) override {
+        _gop->emplace_back(std::move(in));
+    }
+
+    /**
+     * 获取收集到的包
+     * Get the collected packets
+     */
+    const std::shared_ptr<List> &getGop() const {
+        return _gop;
+    }
+
+private:
+    std::shared_ptr<List> _gop = std::make_shared<List>();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_GOPCACHEBUDGET_H
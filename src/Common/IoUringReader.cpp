@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#if defined(ENABLE_IO_URING)
+
+#include <cstring>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "IoUringReader.h"
+#include "Common/config.h"
+#include "Util/logger.h"
+#include "Util/uv_errno.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 提交队列深度
+// Depth of the submission queue
+static constexpr unsigned kQueueDepth = 256;
+// 每个线程注册到内核的固定缓存个数
+// Number of fixed buffers registered per thread
+static constexpr int kFixedBufferCount = 16;
+
+// 固定缓存释放时归还给所属读取器
+// A fixed buffer is returned to its reader when it is released
+class IoUringBuffer : public Buffer {
+public:
+    IoUringBuffer(IoUringReader::Ptr reader, int index, char *data, size_t size)
+        : _index(index), _size(size), _data(data), _reader(std::move(reader)) {}
+
+    ~IoUringBuffer() override { _reader->recycleFixedBuffer(_index); }
+
+    char *data() const override { return _data; }
+    size_t size() const override { return _size; }
+
+private:
+    int _index;
+    size_t _size;
+    char *_data;
+    IoUringReader::Ptr _reader;
+};
+
+bool IoUringReader::isSupported() {
+    static bool s_supported = []() {
+        auto probe = io_uring_get_probe();
+        if (!probe) {
+            WarnL << "io_uring is not supported by the kernel";
+            return false;
+        }
+        auto ret = io_uring_opcode_supported(probe, IORING_OP_READ) && io_uring_opcode_supported(probe, IORING_OP_READ_FIXED);
+        io_uring_free_probe(probe);
+        if (!ret) {
+            WarnL << "io_uring read is not supported by the kernel";
+        }
+        return ret;
+    }();
+    return s_supported;
+}
+
+IoUringReader::Ptr IoUringReader::getCurrent() {
+    static thread_local Ptr s_reader;
+    static thread_local bool s_failed = false;
+    if (s_reader || s_failed) {
+        return s_reader;
+    }
+    auto poller = EventPoller::getCurrentPoller();
+    if (!poller || !isSupported()) {
+        return nullptr;
+    }
+    Ptr reader(new IoUringReader);
+    if (!reader->init(poller)) {
+        // 初始化失败后本线程不再尝试
+        // Do not try again in this thread after a failure
+        s_failed = true;
+        return nullptr;
+    }
+    s_reader = std::move(reader);
+    return s_reader;
+}
+
+bool IoUringReader::init(const EventPoller::Ptr &poller) {
+    auto ret = io_uring_queue_init(kQueueDepth, &_ring, 0);
+    if (ret < 0) {
+        WarnL << "io_uring_queue_init failed:" << strerror(-ret);
+        return false;
+    }
+    _ring_inited = true;
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        WarnL << "eventfd failed:" << get_uv_errmsg();
+        return false;
+    }
+    ret = io_uring_register_eventfd(&_ring, _event_fd);
+    if (ret < 0) {
+        WarnL << "io_uring_register_eventfd failed:" << strerror(-ret);
+        return false;
+    }
+
+    // 固定缓存大小与http文件服务器读文件缓存大小一致
+    // The size of the fixed buffers is the same as the read buffer size of the http file server
+    GET_CONFIG(uint32_t, send_buf_size, Http::kSendBufSize);
+    _buffer_size = send_buf_size;
+    _memory.reset(new char[_buffer_size * kFixedBufferCount], [](char *ptr) { delete[] ptr; });
+    vector<iovec> iovecs(kFixedBufferCount);
+    for (int i = 0; i < kFixedBufferCount; ++i) {
+        iovecs[i].iov_base = _memory.get() + i * _buffer_size;
+        iovecs[i].iov_len = _buffer_size;
+    }
+    ret = io_uring_register_buffers(&_ring, iovecs.data(), iovecs.size());
+    if (ret < 0) {
+        // 比如RLIMIT_MEMLOCK不足，此时只使用普通读
+        // For example RLIMIT_MEMLOCK is too small, only normal reads are used then
+        WarnL << "io_uring_register_buffers failed:" << strerror(-ret);
+        _memory = nullptr;
+    } else {
+        for (int i = kFixedBufferCount - 1; i >= 0; --i) {
+            _free_buffers.emplace_back(i);
+        }
+    }
+
+    weak_ptr<IoUringReader> weak_self = shared_from_this();
+    if (poller->addEvent(_event_fd, EventPoller::Event_Read, [weak_self](int event) {
+            auto strong_self = weak_self.lock();
+            if (strong_self) {
+                strong_self->onEvent();
+            }
+        }) == -1) {
+        WarnL << "add eventfd of io_uring to poller failed";
+        return false;
+    }
+    _poller = poller;
+    return true;
+}
+
+IoUringReader::~IoUringReader() {
+    if (_event_fd != -1) {
+        auto fd = _event_fd;
+        auto poller = _poller.lock();
+        if (poller) {
+            poller->delEvent(fd, [fd](bool) { close(fd); });
+        } else {
+            close(fd);
+        }
+    }
+    if (_ring_inited) {
+        cancelRequests();
+        io_uring_queue_exit(&_ring);
+    }
+    for (auto req : _requests) {
+        delete req;
+    }
+}
+
+void IoUringReader::cancelRequests() {
+    // 内核可能仍在向未完成请求的缓存写入数据，必须取消并等待其完成后才能释放
+    // The kernel may still be writing into the buffers of the pending requests, they must be cancelled and reaped before being freed
+    for (auto req : _requests) {
+        auto sqe = io_uring_get_sqe(&_ring);
+        if (!sqe) {
+            io_uring_submit(&_ring);
+            sqe = io_uring_get_sqe(&_ring);
+        }
+        if (!sqe) {
+            break;
+        }
+        io_uring_prep_cancel(sqe, req, 0);
+        // 取消操作本身的完成事件不关联请求
+        // The completion of the cancel operation itself is not bound to any request
+        io_uring_sqe_set_data(sqe, nullptr);
+    }
+    io_uring_submit(&_ring);
+
+    struct io_uring_cqe *cqe;
+    while (!_requests.empty()) {
+        auto ret = io_uring_wait_cqe(&_ring, &cqe);
+        if (ret == -EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            WarnL << "io_uring_wait_cqe failed:" << strerror(-ret);
+            break;
+        }
+        auto req = (Request *)io_uring_cqe_get_data(cqe);
+        io_uring_cqe_seen(&_ring, cqe);
+        if (req && _requests.erase(req)) {
+            // 已无法回调(本对象正在析构)，仅释放请求
+            // The callback can no longer be invoked (this object is being destroyed), only free the request
+            delete req;
+        }
+    }
+}
+
+int IoUringReader::obtainFixedBuffer() {
+    lock_guard<mutex> lck(_mtx);
+    if (_free_buffers.empty()) {
+        return -1;
+    }
+    auto ret = _free_buffers.back();
+    _free_buffers.pop_back();
+    return ret;
+}
+
+void IoUringReader::recycleFixedBuffer(int index) {
+    // 固定缓存可能在其他线程(比如发送失败时)释放
+    // A fixed buffer may be released in other threads (for example when sending fails)
+    lock_guard<mutex> lck(_mtx);
+    _free_buffers.emplace_back(index);
+}
+
+void IoUringReader::read(int fd, uint64_t offset, size_t size, onReadCB cb) {
+    auto sqe = io_uring_get_sqe(&_ring);
+    if (!sqe) {
+        io_uring_submit(&_ring);
+        sqe = io_uring_get_sqe(&_ring);
+    }
+    if (!sqe) {
+        cb(nullptr, EBUSY);
+        return;
+    }
+
+    auto req = new Request;
+    req->cb = std::move(cb);
+    if (_memory && size <= _buffer_size && (req->index = obtainFixedBuffer()) >= 0) {
+        req->data = _memory.get() + req->index * _buffer_size;
+        io_uring_prep_read_fixed(sqe, fd, req->data, size, offset, req->index);
+    } else {
+        req->raw = BufferRaw::create();
+        req->raw->setCapacity(size + 1);
+        req->data = req->raw->data();
+        io_uring_prep_read(sqe, fd, req->data, size, offset);
+    }
+    io_uring_sqe_set_data(sqe, req);
+    _requests.emplace(req);
+    io_uring_submit(&_ring);
+}
+
+void IoUringReader::onEvent() {
+    uint64_t count;
+    while (::read(_event_fd, &count, sizeof(count)) == -1 && UV_EINTR == get_uv_error(false));
+
+    struct io_uring_cqe *cqe;
+    while (io_uring_peek_cqe(&_ring, &cqe) == 0) {
+        auto req = (Request *)io_uring_cqe_get_data(cqe);
+        auto res = cqe->res;
+        io_uring_cqe_seen(&_ring, cqe);
+        _requests.erase(req);
+        std::unique_ptr<Request> holder(req);
+
+        Buffer::Ptr buf;
+        int err = 0;
+        if (res > 0) {
+            if (req->index >= 0) {
+                buf = std::make_shared<IoUringBuffer>(shared_from_this(), req->index, req->data, res);
+            } else {
+                req->raw->setSize(res);
+                buf = std::move(req->raw);
+            }
+        } else {
+            if (req->index >= 0) {
+                recycleFixedBuffer(req->index);
+            }
+            err = -res;
+        }
+        req->cb(buf, err);
+    }
+}
+
+} // namespace mediakit
+#endif // defined(ENABLE_IO_URING)
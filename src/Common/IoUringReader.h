@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_IOURINGREADER_H
+#define ZLMEDIAKIT_IOURINGREADER_H
+
+#if defined(ENABLE_IO_URING)
+
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <unordered_set>
+#include <liburing.h>
+#include "Network/Buffer.h"
+#include "Poller/EventPoller.h"
+
+namespace mediakit {
+
+/**
+ * 基于io_uring的异步文件读取器
+ * 每个EventPoller线程一个实例，io_uring完成事件通过eventfd加入EventPoller监听，读取回调在该线程触发；
+ * 读缓存优先使用注册到内核的固定缓存(IORING_OP_READ_FIXED)，避免冷数据时mmap缺页中断阻塞poller线程
+ * Asynchronous file reader based on io_uring
+ * One instance per EventPoller thread, the io_uring completions are watched by the EventPoller through an eventfd,
+ * the read callbacks are triggered in that thread; registered fixed buffers (IORING_OP_READ_FIXED) are preferred,
+ * so reading cold files no longer blocks the poller thread with mmap page faults
+ */
+class IoUringReader : public std::enable_shared_from_this<IoUringReader> {
+public:
+    using Ptr = std::shared_ptr<IoUringReader>;
+    /**
+     * 读取回调
+     * @param buf 读取到的数据，文件结束或读取失败时为nullptr
+     * @param err 读取失败时的错误码，文件结束时为0
+     * Read callback
+     * @param buf Data read, nullptr at the end of the file or on failure
+     * @param err Error code on failure, 0 at the end of the file
+     */
+    using onReadCB = std::function<void(const toolkit::Buffer::Ptr &buf, int err)>;
+
+    ~IoUringReader();
+
+    /**
+     * 内核是否支持io_uring读文件
+     * Whether the kernel supports reading files with io_uring
+     */
+    static bool isSupported();
+
+    /**
+     * 获取当前EventPoller线程的实例，不支持或不在EventPoller线程时返回nullptr
+     * Get the instance of the current EventPoller thread, nullptr if it is not supported or not in an EventPoller thread
+     */
+    static Ptr getCurrent();
+
+    /**
+     * 异步读取文件，必须在本实例所在线程调用
+     * @param fd 文件描述符
+     * @param offset 文件偏移量
+     * @param size 读取字节数
+     * @param cb 读取回调，在本实例所在线程触发；提交队列已满时同步回调EBUSY
+     * Read a file asynchronously, must be called in the thread of this instance
+     * @param fd File descriptor
+     * @param offset File offset
+     * @param size Bytes to read
+     * @param cb Read callback triggered in the thread of this instance; EBUSY is called back synchronously when the submission queue is full
+     */
+    void read(int fd, uint64_t offset, size_t size, onReadCB cb);
+
+private:
+    struct Request {
+        int index = -1;
+        char *data = nullptr;
+        toolkit::BufferRaw::Ptr raw;
+        onReadCB cb;
+    };
+
+    IoUringReader() = default;
+    bool init(const toolkit::EventPoller::Ptr &poller);
+    void onEvent();
+    void cancelRequests();
+    int obtainFixedBuffer();
+    void recycleFixedBuffer(int index);
+
+    friend class IoUringBuffer;
+
+private:
+    bool _ring_inited = false;
+    int _event_fd = -1;
+    size_t _buffer_size = 0;
+    struct io_uring _ring;
+    std::weak_ptr<toolkit::EventPoller> _poller;
+    std::shared_ptr<char> _memory;
+    std::unordered_set<Request *> _requests;
+
+    std::mutex _mtx;
+    std::vector<int> _free_buffers;
+};
+
+} // namespace mediakit
+#endif // defined(ENABLE_IO_URING)
+#endif // ZLMEDIAKIT_IOURINGREADER_H
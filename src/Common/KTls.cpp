@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstring>
+#include "KTls.h"
+#include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Util/logger.h"
+
+#if defined(ENABLE_OPENSSL)
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include "Util/SSLBox.h"
+#include "Util/SSLUtil.h"
+#endif
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <linux/tls.h>
+#endif
+
+#if defined(ENABLE_OPENSSL) && defined(__linux__) && defined(TLS_TX)
+#define ENABLE_KTLS
+#endif
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+static Metric s_sessions("zlm_ktls_sessions_total", "Tls sessions that tried kernel tls offload");
+static Metric s_offloaded("zlm_ktls_offloaded_total", "Tls sessions offloaded to kernel tls");
+static Metric s_fallback("zlm_ktls_fallbacks_total", "Tls sessions that kept using openssl after a kernel tls failure");
+
+// 本线程正在处理ssl数据的会话
+// Session processing ssl data in this thread
+static thread_local KTls *s_current = nullptr;
+
+KTls::Statistic KTls::getStatistic() {
+    return Statistic { (uint64_t)s_sessions.value(), (uint64_t)s_offloaded.value(), (uint64_t)s_fallback.value() };
+}
+
+KTls::Scope::Scope(KTls &ktls) {
+    _prev = s_current;
+    s_current = &ktls;
+}
+
+KTls::Scope::~Scope() {
+    s_current = _prev;
+}
+
+#if defined(ENABLE_KTLS)
+
+static void onSSLMessage(int write_p, int version, int content_type, const void *buf, size_t len, SSL *ssl, void *arg) {
+    if (write_p && s_current) {
+        s_current->onMessage(ssl, content_type, buf, len);
+    }
+}
+
+static string hexToBytes(const char *hex) {
+    auto value = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f') {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F') {
+            return ch - 'A' + 10;
+        }
+        return -1;
+    };
+    string ret;
+    for (; value(hex[0]) >= 0 && value(hex[1]) >= 0; hex += 2) {
+        ret.push_back((char)(value(hex[0]) << 4 | value(hex[1])));
+    }
+    return ret;
+}
+
+static void onSSLKeyLog(const SSL *ssl, const char *line) {
+    if (s_current) {
+        s_current->onKeyLog(ssl, line);
+    }
+}
+
+void KTls::installCallbacks() {
+    GET_CONFIG(bool, enable, General::kEnableKTls);
+    if (!enable) {
+        return;
+    }
+    auto ctx = SSL_Initor::Instance().getSSLCtx("", true);
+    if (!ctx || SSL_CTX_get_keylog_callback(ctx.get()) == onSSLKeyLog) {
+        return;
+    }
+    SSL_CTX_set_keylog_callback(ctx.get(), onSSLKeyLog);
+    SSL_CTX_set_msg_callback(ctx.get(), onSSLMessage);
+}
+
+void KTls::onMessage(const SSL *ssl, int content_type, const void *buf, size_t len) {
+    _ssl = ssl;
+    switch (content_type) {
+        case SSL3_RT_HEADER: {
+            // 每写出一个ssl记录回调一次
+            // Called once for every ssl record written
+            if (_state == kEnabled) {
+                _broken = true;
+            }
+            if (_records_after_ccs >= 0) {
+                ++_records_after_ccs;
+            }
+            if (_records_after_finished >= 0) {
+                ++_records_after_finished;
+            }
+            break;
+        }
+        case SSL3_RT_CHANGE_CIPHER_SPEC: {
+            // 该消息的记录头先于本回调，之后的记录使用新密钥且序号从0开始
+            // The record header of this message comes before this callback, later records use the new key with sequence from 0
+            _records_after_ccs = 0;
+            break;
+        }
+        case SSL3_RT_HANDSHAKE: {
+            if (len && ((const uint8_t *)buf)[0] == SSL3_MT_FINISHED) {
+                _records_after_finished = 0;
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+void KTls::onKeyLog(const SSL *ssl, const char *line) {
+    static const char kLabel[] = "SERVER_TRAFFIC_SECRET_0 ";
+    if (strncmp(line, kLabel, sizeof(kLabel) - 1)) {
+        return;
+    }
+    // 格式: 标签 client_random 密钥，均为十六进制
+    // Format: label client_random secret, both in hex
+    auto secret = strchr(line + sizeof(kLabel) - 1, ' ');
+    if (!secret) {
+        return;
+    }
+    _ssl = ssl;
+    _tx_secret = hexToBytes(secret + 1);
+}
+
+// TLS1.2 PRF
+static bool tls12Prf(const EVP_MD *md, const string &secret, const string &label, const string &seed, size_t len, string &out) {
+    shared_ptr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr), [](EVP_PKEY_CTX *ptr) { EVP_PKEY_CTX_free(ptr); });
+    out.resize(len);
+    return ctx && EVP_PKEY_derive_init(ctx.get()) > 0 && EVP_PKEY_CTX_set_tls1_prf_md(ctx.get(), md) > 0
+        && EVP_PKEY_CTX_set1_tls1_prf_secret(ctx.get(), (const uint8_t *)secret.data(), (int)secret.size()) > 0
+        && EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), (const uint8_t *)label.data(), (int)label.size()) > 0
+        && EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), (const uint8_t *)seed.data(), (int)seed.size()) > 0
+        && EVP_PKEY_derive(ctx.get(), (uint8_t *)&out[0], &len) > 0 && len == out.size();
+}
+
+// TLS1.3 HKDF-Expand-Label，上下文为空
+// TLS1.3 HKDF-Expand-Label with empty context
+static bool tls13ExpandLabel(const EVP_MD *md, const string &secret, const string &label, size_t len, string &out) {
+    string info;
+    info.push_back((char)(len >> 8));
+    info.push_back((char)len);
+    info.push_back((char)(6 + label.size()));
+    info.append("tls13 ").append(label);
+    info.push_back(0);
+    shared_ptr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr), [](EVP_PKEY_CTX *ptr) { EVP_PKEY_CTX_free(ptr); });
+    out.resize(len);
+    return ctx && EVP_PKEY_derive_init(ctx.get()) > 0 && EVP_PKEY_CTX_hkdf_mode(ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0
+        && EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) > 0
+        && EVP_PKEY_CTX_set1_hkdf_key(ctx.get(), (const uint8_t *)secret.data(), (int)secret.size()) > 0
+        && EVP_PKEY_CTX_add1_hkdf_info(ctx.get(), (const uint8_t *)info.data(), (int)info.size()) > 0
+        && EVP_PKEY_derive(ctx.get(), (uint8_t *)&out[0], &len) > 0 && len == out.size();
+}
+
+template <typename T>
+static void fillCryptoInfo(T &info, uint16_t version, uint16_t cipher_type, const string &key, const string &iv, const string &salt, const uint8_t *seq,
+                           string &out) {
+    memset(&info, 0, sizeof(info));
+    info.info.version = version;
+    info.info.cipher_type = cipher_type;
+    memcpy(info.key, key.data(), sizeof(info.key));
+    memcpy(info.iv, iv.data(), sizeof(info.iv));
+    memcpy(info.salt, salt.data(), sizeof(info.salt));
+    memcpy(info.rec_seq, seq, sizeof(info.rec_seq));
+    out.assign((const char *)&info, sizeof(info));
+}
+
+bool KTls::makeCryptoInfo(string &out) const {
+    if (!_ssl) {
+        return false;
+    }
+    auto version = SSL_version(_ssl);
+    auto cipher = SSL_get_current_cipher(_ssl);
+    if (!cipher || (version != TLS1_2_VERSION && version != TLS1_3_VERSION)) {
+        return false;
+    }
+    auto records = version == TLS1_3_VERSION ? _records_after_finished : _records_after_ccs;
+    if (records < 0) {
+        // 未观察到密钥切换(例如回调安装前创建的ssl对象)
+        // The key change was not observed (such as an ssl object created before the callbacks were installed)
+        return false;
+    }
+
+    size_t key_len;
+    // TLS1.2下AES-GCM的隐式iv为4字节，其余为12字节
+    // The implicit iv is 4 bytes for AES-GCM under TLS1.2 and 12 bytes otherwise
+    size_t iv_len = 12;
+    uint16_t cipher_type;
+    switch (SSL_CIPHER_get_cipher_nid(cipher)) {
+        case NID_aes_128_gcm:
+            key_len = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+            cipher_type = TLS_CIPHER_AES_GCM_128;
+            iv_len = version == TLS1_2_VERSION ? 4 : 12;
+            break;
+        case NID_aes_256_gcm:
+            key_len = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+            cipher_type = TLS_CIPHER_AES_GCM_256;
+            iv_len = version == TLS1_2_VERSION ? 4 : 12;
+            break;
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+        case NID_chacha20_poly1305:
+            key_len = TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE;
+            cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            break;
+#endif
+        default: return false;
+    }
+
+    auto md = SSL_CIPHER_get_handshake_digest(cipher);
+    if (!md) {
+        return false;
+    }
+    string key, iv;
+    if (version == TLS1_3_VERSION) {
+        if (_tx_secret.empty() || !tls13ExpandLabel(md, _tx_secret, "key", key_len, key) || !tls13ExpandLabel(md, _tx_secret, "iv", iv_len, iv)) {
+            return false;
+        }
+    } else {
+        // key_block = client_write_key + server_write_key + client_write_iv + server_write_iv
+        auto session = SSL_get_session(_ssl);
+        if (!session) {
+            return false;
+        }
+        string master(SSL_MAX_MASTER_KEY_LENGTH, '\0');
+        master.resize(SSL_SESSION_get_master_key(session, (uint8_t *)&master[0], master.size()));
+        string seed(2 * SSL3_RANDOM_SIZE, '\0');
+        if (SSL_get_server_random(_ssl, (uint8_t *)&seed[0], SSL3_RANDOM_SIZE) != SSL3_RANDOM_SIZE
+            || SSL_get_client_random(_ssl, (uint8_t *)&seed[SSL3_RANDOM_SIZE], SSL3_RANDOM_SIZE) != SSL3_RANDOM_SIZE) {
+            return false;
+        }
+        string key_block;
+        if (master.empty() || !tls12Prf(md, master, "key expansion", seed, 2 * (key_len + iv_len), key_block)) {
+            return false;
+        }
+        key = key_block.substr(key_len, key_len);
+        iv = key_block.substr(2 * key_len + iv_len, iv_len);
+    }
+
+    uint8_t seq[8];
+    for (int i = 7; i >= 0; --i) {
+        seq[i] = (uint8_t)records;
+        records >>= 8;
+    }
+    uint16_t tls_version = version == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+    switch (cipher_type) {
+        case TLS_CIPHER_AES_GCM_128: {
+            tls12_crypto_info_aes_gcm_128 info;
+            if (version == TLS1_3_VERSION) {
+                // 12字节iv拆分为4字节salt与8字节iv
+                // The 12 bytes iv is split into a 4 bytes salt and an 8 bytes iv
+                fillCryptoInfo(info, tls_version, cipher_type, key, iv.substr(4), iv.substr(0, 4), seq, out);
+            } else {
+                // 显式nonce使用记录序号
+                // The explicit nonce uses the record sequence
+                fillCryptoInfo(info, tls_version, cipher_type, key, string((char *)seq, 8), iv, seq, out);
+            }
+            return true;
+        }
+        case TLS_CIPHER_AES_GCM_256: {
+            tls12_crypto_info_aes_gcm_256 info;
+            if (version == TLS1_3_VERSION) {
+                fillCryptoInfo(info, tls_version, cipher_type, key, iv.substr(4), iv.substr(0, 4), seq, out);
+            } else {
+                fillCryptoInfo(info, tls_version, cipher_type, key, string((char *)seq, 8), iv, seq, out);
+            }
+            return true;
+        }
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+        case TLS_CIPHER_CHACHA20_POLY1305: {
+            tls12_crypto_info_chacha20_poly1305 info;
+            fillCryptoInfo(info, tls_version, cipher_type, key, iv, string(), seq, out);
+            return true;
+        }
+#endif
+        default: return false;
+    }
+}
+
+bool KTls::tryEnable(const Socket::Ptr &sock) {
+    if (_state != kPending) {
+        return _state == kEnabled;
+    }
+    GET_CONFIG(bool, enable, General::kEnableKTls);
+    if (!enable) {
+        _state = kDisabled;
+        return false;
+    }
+    if (!_ssl || !SSL_is_init_finished(_ssl) || !sock) {
+        // 握手未完成
+        // The handshake is not done
+        return false;
+    }
+    if (sock->getSendBufferCount()) {
+        // 等待OpenSSL加密的数据全部写入socket后才能切换
+        // Wait for all data encrypted by OpenSSL to be written into the socket before switching
+        return false;
+    }
+    _state = kDisabled;
+    s_sessions.add();
+    string info;
+    if (!makeCryptoInfo(info)) {
+        s_fallback.add();
+        DebugL << "ktls not supported for " << SSL_get_version(_ssl) << " " << SSL_get_cipher_name(_ssl) << ", keep using openssl";
+        return false;
+    }
+    auto fd = sock->rawFD();
+    // 即使挂载tls ulp成功而设置TLS_TX失败，socket仍按普通tcp发送，可以继续使用OpenSSL加密
+    // Even if the tls ulp is attached but TLS_TX fails, the socket still sends as plain tcp, so OpenSSL encryption can go on
+    if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == -1 || setsockopt(fd, SOL_TLS, TLS_TX, info.data(), (socklen_t)info.size()) == -1) {
+        s_fallback.add();
+        DebugL << "enable ktls failed: " << get_uv_errmsg(true) << ", keep using openssl";
+        return false;
+    }
+    _state = kEnabled;
+    s_offloaded.add();
+    auto ssl = const_cast<SSL *>(_ssl);
+#if defined(SSL_OP_NO_RENEGOTIATION)
+    // 重协商会由OpenSSL写出握手记录，卸载后的会话拒绝重协商
+    // Renegotiation makes OpenSSL write handshake records, offloaded sessions refuse it
+    SSL_set_options(ssl, SSL_OP_NO_RENEGOTIATION);
+#endif
+    // 关闭时不再由OpenSSL写出close_notify
+    // OpenSSL no longer writes close_notify on shutdown
+    SSL_set_quiet_shutdown(ssl, 1);
+    return true;
+}
+
+#else
+
+void KTls::installCallbacks() {}
+void KTls::onMessage(const SSL *ssl, int content_type, const void *buf, size_t len) {}
+void KTls::onKeyLog(const SSL *ssl, const char *line) {}
+bool KTls::makeCryptoInfo(string &info) const { return false; }
+
+bool KTls::tryEnable(const Socket::Ptr &sock) {
+    _state = kDisabled;
+    return false;
+}
+
+#endif // defined(ENABLE_KTLS)
+
+} // namespace mediakit
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_KTLS_H
+#define ZLMEDIAKIT_KTLS_H
+
+#include <string>
+#include <cstdint>
+#include "Network/Session.h"
+
+typedef struct ssl_st SSL;
+
+namespace mediakit {
+
+/**
+ * 内核TLS(kTLS)发送卸载
+ * ssl握手仍由OpenSSL完成，握手结束后从OpenSSL回调中取得发送方向的密钥与记录序号并设置到socket(TLS_TX)，
+ * 此后明文直接交给socket，由内核加密，writev合并写与mmap文件缓存无需在用户态拷贝加密
+ * Kernel TLS (kTLS) transmit offload
+ * The ssl handshake is still done by OpenSSL, after it the transmit key and record sequence collected from the OpenSSL callbacks
+ * are set on the socket (TLS_TX), then plaintext is handed to the socket directly and encrypted by the kernel,
+ * so writev merged writes and mmapped file buffers are not copied and encrypted in userland
+ */
+class KTls {
+public:
+    struct Statistic {
+        // 握手完成后尝试开启kTLS的会话数
+        // Number of sessions that tried kTLS after the handshake
+        uint64_t sessions;
+        // 成功开启kTLS的会话数
+        // Number of sessions offloaded to kTLS
+        uint64_t offloaded;
+        // 因加密套件、协议版本或内核不支持等原因继续使用OpenSSL加密的会话数
+        // Number of sessions kept on OpenSSL encryption because of the cipher, protocol version or kernel support
+        uint64_t fallback;
+    };
+
+    /**
+     * 获取kTLS统计
+     * Get the kTLS statistics
+     */
+    static Statistic getStatistic();
+
+    /**
+     * 在服务器默认ssl上下文上安装握手信息收集回调，仅在启动及重新加载证书后调用一次，
+     * ssl上下文由所有会话共享，不可在会话中调用
+     * Install the handshake collecting callbacks on the default server ssl context, call it only once at startup and after reloading certificates,
+     * the ssl context is shared by all sessions, do not call it from a session
+     */
+    static void installCallbacks();
+
+    /**
+     * 处理ssl数据(可能推进握手或写出ssl记录)期间的作用域，把本线程的OpenSSL回调关联到该会话
+     * Scope of processing ssl data (which may advance the handshake or write ssl records),
+     * associates the OpenSSL callbacks of this thread with the session
+     */
+    class Scope {
+    public:
+        Scope(KTls &ktls);
+        ~Scope();
+
+    private:
+        KTls *_prev;
+    };
+
+    /**
+     * 是否已开启kTLS发送
+     * Whether kTLS transmit is enabled
+     */
+    bool enabled() const { return _state == kEnabled; }
+
+    /**
+     * 开启kTLS后OpenSSL又写出了ssl记录(如密钥更新或告警)，该记录会被内核再次加密，对端收到的是无效记录，会话必须立即关闭
+     * OpenSSL wrote an ssl record (such as a key update or an alert) after kTLS was enabled, the kernel encrypts it again
+     * and the peer receives an invalid record, so the session must be closed at once
+     */
+    bool broken() const { return _broken; }
+
+    /**
+     * 尝试开启kTLS发送，握手完成且socket中没有待发送的加密数据时才会真正尝试，且只尝试一次
+     * @param sock socket对象
+     * @return 是否已开启
+     * Try to enable kTLS transmit, it is really tried only once, after the handshake and when the socket has no pending encrypted data
+     * @param sock Socket object
+     * @return Whether it is enabled
+     */
+    bool tryEnable(const toolkit::Socket::Ptr &sock);
+
+    /**
+     * 生成内核TLS_TX参数(struct tls12_crypto_info_*)
+     * @param info 生成的参数
+     * @return 是否成功，加密套件或协议版本不支持时返回false
+     * Make the kernel TLS_TX parameter (struct tls12_crypto_info_*)
+     * @param info The generated parameter
+     * @return Whether it succeeded, false if the cipher or protocol version is not supported
+     */
+    bool makeCryptoInfo(std::string &info) const;
+
+    // 供OpenSSL回调使用
+    // Used by the OpenSSL callbacks
+    void onMessage(const SSL *ssl, int content_type, const void *buf, size_t len);
+    void onKeyLog(const SSL *ssl, const char *line);
+
+private:
+    enum State { kPending, kEnabled, kDisabled };
+
+    State _state = kPending;
+    bool _broken = false;
+    // 发送CCS(TLS1.2)或Finished(TLS1.3)后写出的记录数，即新密钥下的记录序号，-1代表尚未开始
+    // Records written after the CCS (TLS1.2) or Finished (TLS1.3) message, i.e. the record sequence under the new key, -1 means not started
+    int64_t _records_after_ccs = -1;
+    int64_t _records_after_finished = -1;
+    const SSL *_ssl = nullptr;
+    // TLS1.3服务器应用数据发送密钥
+    // TLS1.3 server application traffic secret
+    std::string _tx_secret;
+};
+
+/**
+ * 支持kTLS发送卸载的ssl会话
+ * Ssl session supporting kTLS transmit offload
+ */
+template <typename SessionType>
+class SessionWithKTls : public toolkit::SessionWithSSL<SessionType> {
+public:
+    using Base = toolkit::SessionWithSSL<SessionType>;
+
+    template <typename... ArgsType>
+    SessionWithKTls(ArgsType &&...args) : Base(std::forward<ArgsType>(args)...) {}
+
+    void onRecv(const toolkit::Buffer::Ptr &buf) override {
+        {
+            KTls::Scope scope(_ktls);
+            Base::onRecv(buf);
+        }
+        if (_ktls.broken()) {
+            // 处理输入时OpenSSL写出了记录(如回复KeyUpdate)，不再等到下次发送
+            // OpenSSL wrote a record while processing the input (such as answering a KeyUpdate), do not wait for the next send
+            this->shutdown(toolkit::SockException(toolkit::Err_other, "ssl records written after ktls was enabled"));
+        }
+    }
+
+protected:
+    ssize_t send(toolkit::Buffer::Ptr buf) override {
+        if (_ktls.enabled() || _ktls.tryEnable(this->getSock())) {
+            if (_ktls.broken()) {
+                this->shutdown(toolkit::SockException(toolkit::Err_other, "ssl records written after ktls was enabled"));
+                return -1;
+            }
+            // 明文直接交给socket，由内核加密
+            // Hand the plaintext to the socket directly, the kernel encrypts it
+            return SessionType::send(std::move(buf));
+        }
+        KTls::Scope scope(_ktls);
+        return Base::send(std::move(buf));
+    }
+
+private:
+    KTls _ktls;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_KTLS_H
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "MediaCost.h"
+#include "Metrics.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace mediakit {
+
+static Metric s_ring_overflows("zlm_ring_overflows_total", "Ring buffer overflows, a gop has more writes than the ring size");
+static Metric s_cache_bytes("zlm_gop_cache_bytes", "Bytes kept in gop caches", Metric::Gauge, "level=\"protocol\"");
+static Metric s_frame_cache_bytes("zlm_gop_cache_bytes", "Bytes kept in gop caches", Metric::Gauge, "level=\"frame\"");
+
+static Metric &getCacheMetric(bool frame_cache) {
+    return frame_cache ? s_frame_cache_bytes : s_cache_bytes;
+}
+
+// 本线程当前最内层的计时器
+// The innermost timer of this thread
+static thread_local MediaCost::Scope *s_current = nullptr;
+
+MediaCost::Scope::Scope(MediaCost &cost, Type type) : _type(type), _cost(cost), _parent(s_current) {
+    s_current = this;
+    _start = steady_clock::now();
+}
+
+MediaCost::Scope::~Scope() {
+    uint64_t elapsed = duration_cast<nanoseconds>(steady_clock::now() - _start).count();
+    auto &counter = _cost._cpu_ns[_type];
+    counter.store(counter.load(memory_order_relaxed) + (elapsed > _child_ns ? elapsed - _child_ns : 0), memory_order_relaxed);
+    if (_parent) {
+        _parent->_child_ns += elapsed;
+    }
+    s_current = _parent;
+}
+
+MediaCost::~MediaCost() {
+    getCacheMetric(_frame_cache).add(-(int64_t)_cache_bytes.load(memory_order_relaxed));
+}
+
+uint64_t MediaCost::getCpuTime(Type type) const {
+    return _cpu_ns[type].load(memory_order_relaxed) / 1000;
+}
+
+uint64_t MediaCost::getCpuTime() const {
+    uint64_t ret = 0;
+    for (auto &ns : _cpu_ns) {
+        ret += ns.load(memory_order_relaxed);
+    }
+    return ret / 1000;
+}
+
+float MediaCost::getCpuLoad() {
+    lock_guard<mutex> lck(_load_mtx);
+    auto now = steady_clock::now();
+    auto elapsed = duration_cast<nanoseconds>(now - _last_stamp).count();
+    if (elapsed < 1000 * 1000 * 1000) {
+        // 采样间隔不足1秒，返回上次的结果
+        // Less than one second since the last sample, return the last result
+        return _cpu_load;
+    }
+    uint64_t total = 0;
+    for (auto &ns : _cpu_ns) {
+        total += ns.load(memory_order_relaxed);
+    }
+    _cpu_load = (total - _last_cpu_ns) * 100.0f / elapsed;
+    _last_cpu_ns = total;
+    _last_stamp = now;
+    return _cpu_load;
+}
+
+void MediaCost::onCache(size_t bytes, bool key_pos, size_t ring_size) {
+    // 只在写入线程中修改
+    // Only modified in the writer thread
+    auto old_bytes = _cache_bytes.load(memory_order_relaxed);
+    auto new_bytes = key_pos ? bytes : old_bytes + bytes;
+    _cache_bytes.store(new_bytes, memory_order_relaxed);
+    getCacheMetric(_frame_cache).add((int64_t)new_bytes - (int64_t)old_bytes);
+    _cache_items = key_pos ? 1 : _cache_items + 1;
+    if (ring_size && _cache_items == ring_size + 1) {
+        // 每个gop只统计一次
+        // Counted once per gop
+        s_ring_overflows.add();
+    }
+}
+
+void MediaCost::onClearCache() {
+    getCacheMetric(_frame_cache).add(-(int64_t)_cache_bytes.exchange(0, memory_order_relaxed));
+    _cache_items = 0;
+}
+
+size_t MediaCost::getCacheBytes() const {
+    return _cache_bytes.load(memory_order_relaxed);
+}
+
+size_t MediaCost::getTotalCacheBytes() {
+    auto ret = s_cache_bytes.value() + s_frame_cache_bytes.value();
+    return ret > 0 ? (size_t)ret : 0;
+}
+
+size_t MediaCost::getProtocolCacheBytes() {
+    auto ret = s_cache_bytes.value();
+    return ret > 0 ? (size_t)ret : 0;
+}
+
+} // namespace mediakit
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_MEDIACOST_H
+#define ZLMEDIAKIT_MEDIACOST_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * 媒体流资源开销统计：解复用、复用、环形缓冲分发的cpu时间，以及gop缓存字节数
+ * Media stream cost accounting: cpu time of demuxing, muxing and ring buffer fan-out, and bytes kept in the gop cache
+ */
+class MediaCost {
+public:
+    /**
+     * @param frame_cache 是否为MultiMediaSourceMuxer的帧级gop缓存，帧级gop缓存用于重建协议gop缓存，不计入gop缓存预算
+     * @param frame_cache Whether it is the frame level gop cache of MultiMediaSourceMuxer, which is used to rebuild protocol gop caches
+     * and is not counted against the gop cache budget
+     */
+    explicit MediaCost(bool frame_cache = false) : _frame_cache(frame_cache) {}
+    ~MediaCost();
+
+    enum Type {
+        // 解复用(rtmp/rtp解析成帧)
+        // Demuxing (parsing rtmp/rtp into frames)
+        kDemux = 0,
+        // 复用(帧转换为各协议)
+        // Muxing (converting frames into each protocol)
+        kMux,
+        // 写入环形缓冲并分发
+        // Writing into the ring buffer and dispatching
+        kFanout,
+        kTypeMax
+    };
+
+    /**
+     * 作用域计时器，嵌套时只统计本层独占的时间(子计时器的时间从父计时器中扣除)
+     * Scope timer, only the exclusive time is counted when nested (the time of child timers is taken out of the parent)
+     */
+    class Scope {
+    public:
+        Scope(MediaCost &cost, Type type);
+        ~Scope();
+
+    private:
+        Type _type;
+        MediaCost &_cost;
+        Scope *_parent;
+        uint64_t _child_ns = 0;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    /**
+     * 获取累计cpu时间，单位微秒
+     * Get the accumulated cpu time, in microseconds
+     */
+    uint64_t getCpuTime(Type type) const;
+    uint64_t getCpuTime() const;
+
+    /**
+     * 获取最近一段时间的cpu占用，单位为单核的百分比
+     * Get the recent cpu usage, in percent of one core
+     */
+    float getCpuLoad();
+
+    /**
+     * 写入环形缓冲后调用，统计gop缓存字节数
+     * @param bytes 写入的字节数
+     * @param key_pos 是否为gop起始(环形缓冲在此清空之前的gop)
+     * @param ring_size 环形缓冲大小，gop内写入次数超过该值时环形缓冲溢出(丢弃gop开头的数据)，0代表不统计溢出
+     * Called after writing into the ring buffer, to count the bytes in the gop cache
+     * @param bytes Bytes written
+     * @param key_pos Whether it starts a gop (the ring buffer drops the previous gop here)
+     * @param ring_size Ring buffer size, the ring overflows (drops the head of the gop) when a gop has more writes than it, 0 means not counted
+     */
+    void onCache(size_t bytes, bool key_pos, size_t ring_size = 0);
+
+    /**
+     * 清空环形缓冲的gop缓存后调用
+     * Called after the gop cache of the ring buffer is cleared
+     */
+    void onClearCache();
+
+    /**
+     * 获取gop缓存字节数
+     * Get the bytes kept in the gop cache
+     */
+    size_t getCacheBytes() const;
+
+    /**
+     * 获取所有媒体源(含帧级gop缓存)的gop缓存字节数
+     * Get the bytes kept in the gop caches of all media sources (frame level gop caches included)
+     */
+    static size_t getTotalCacheBytes();
+
+    /**
+     * 获取所有协议环形缓冲(不含帧级gop缓存)的gop缓存字节数，即gop缓存预算可淘汰的部分
+     * Get the bytes kept in the gop caches of all protocol ring buffers (frame level gop caches excluded),
+     * i.e. the part the gop cache budget can evict
+     */
+    static size_t getProtocolCacheBytes();
+
+    /**
+     * 统计包列表的字节数
+     * Count the bytes of a packet list
+     */
+    template <typename List>
+    static size_t getBytes(const List &list) {
+        size_t ret = 0;
+        for (auto &pkt : list) {
+            ret += pkt->size();
+        }
+        return ret;
+    }
+
+private:
+    bool _frame_cache;
+    std::atomic<uint64_t> _cpu_ns[kTypeMax] { { 0 }, { 0 }, { 0 } };
+    std::atomic<size_t> _cache_bytes { 0 };
+    // 当前gop内写入环形缓冲的次数，只在写入线程中访问
+    // Writes into the ring buffer in the current gop, only accessed in the writer thread
+    size_t _cache_items = 0;
+
+    // 以下用于计算cpu占用，只在读取时访问
+    // Used to compute the cpu usage, only accessed when read
+    std::mutex _load_mtx;
+    float _cpu_load = 0;
+    uint64_t _last_cpu_ns = 0;
+    std::chrono::steady_clock::time_point _last_stamp = std::chrono::steady_clock::now();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_MEDIACOST_H
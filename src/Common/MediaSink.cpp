@@ -9,6 +9,7 @@
  */
 
 #include "MediaSink.h"
+#include "Util/onceToken.h"
 #include "Common/config.h"
 #include "Extension/Factory.h"
 
@@ -56,7 +57,7 @@ bool MediaSink::addTrack(const Track::Ptr &track_in) {
 
     track->addDelegate([this](const Frame::Ptr &frame) {
         if (_all_track_ready) {
-            return onTrackFrame(frame);
+            return dispatchFrame(frame);
         }
         auto &frame_unread = _frame_unread[frame->getIndex()];
 
@@ -83,6 +84,7 @@ void MediaSink::resetTracks() {
     _ticker.resetTime();
     _track_map.clear();
     _frame_unread.clear();
+    _frame_batch.clear();
     _track_ready_callback.clear();
 }
 
@@ -103,6 +105,43 @@ bool MediaSink::inputFrame(const Frame::Ptr &frame) {
     return ret;
 }
 
+bool MediaSink::inputFrames(const Frame::Ptr *frames, size_t size) {
+    if (_batching) {
+        return MediaSinkInterface::inputFrames(frames, size);
+    }
+    bool ret = false;
+    {
+        _batching = true;
+        toolkit::onceToken token(nullptr, [&]() { _batching = false; });
+        for (size_t i = 0; i < size; ++i) {
+            ret = MediaSink::inputFrame(frames[i]) ? true : ret;
+        }
+    }
+    if (_frame_batch.empty()) {
+        return ret;
+    }
+    std::vector<Frame::Ptr> batch;
+    batch.swap(_frame_batch);
+    onTrackFrames(batch.data(), batch.size());
+    // 复用内存
+    // Reuse the memory
+    batch.clear();
+    if (_frame_batch.empty()) {
+        _frame_batch.swap(batch);
+    }
+    return ret;
+}
+
+bool MediaSink::dispatchFrame(const Frame::Ptr &frame) {
+    if (!_batching) {
+        return onTrackFrame(frame);
+    }
+    // Track输出的帧可能引用其内部缓存，批量输出前需可缓存
+    // Frames output by tracks may reference their internal buffers, they must be cacheable before the batch is output
+    _frame_batch.emplace_back(Frame::getCacheAbleFrame(frame));
+    return true;
+}
+
 void MediaSink::checkTrackIfReady() {
     if (!_all_track_ready && !_track_ready_callback.empty()) {
         for (auto &pr : _track_map) {
@@ -315,7 +354,7 @@ bool MediaSink::addMuteAudioTrack() {
     audio->setIndex(MUTE_AUDIO_INDEX);
     audio->setExtraData(ADTS_CONFIG, 2);
     _track_map[MUTE_AUDIO_INDEX] = std::make_pair(audio, true);
-    audio->addDelegate([this](const Frame::Ptr &frame) { return onTrackFrame(frame); });
+    audio->addDelegate([this](const Frame::Ptr &frame) { return dispatchFrame(frame); });
     _mute_audio_maker = std::make_shared<MuteAudioMaker>();
     _mute_audio_maker->addDelegate([audio](const Frame::Ptr &frame) { return audio->inputFrame(frame); });
     onTrackReady(audio);
@@ -94,6 +94,12 @@ public:
      */
     bool inputFrame(const Frame::Ptr &frame) override;
 
+    /**
+     * 批量输入frame，经Track处理后的帧通过onTrackFrames一次性输出
+     * Input a batch of frames, the frames processed by the tracks are output at once via onTrackFrames
+     */
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override;
+
     /**
      * 添加track，内部会调用Track的clone方法
      * 只会克隆sps pps这些信息 ，而不会克隆Delegate相关关系
@@ -217,7 +223,25 @@ protected:
      */
     virtual bool onTrackFrame(const Frame::Ptr &frame) { return false; };
 
+    /**
+     * 某批帧经Track处理后输出，默认逐帧调用onTrackFrame
+     * A batch of frames is output after being processed by the tracks, onTrackFrame is called for each frame by default
+     */
+    virtual bool onTrackFrames(const Frame::Ptr *frames, size_t size) {
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = onTrackFrame(frames[i]) ? true : ret;
+        }
+        return ret;
+    }
+
 private:
+    /**
+     * 输出Track处理后的帧，批量输入时先缓存
+     * Output a frame processed by the track, it is cached first while a batch is being input
+     */
+    bool dispatchFrame(const Frame::Ptr &frame);
+
     /**
      * 触发onAllTrackReady事件
      * Trigger the onAllTrackReady event
@@ -249,10 +273,12 @@ private:
     bool _only_audio = false;
     bool _add_mute_audio = true;
     bool _all_track_ready = false;
+    bool _batching = false;
     size_t _max_track_size = 2;
 
     toolkit::Ticker _ticker;
     MuteAudioMaker::Ptr _mute_audio_maker;
+    std::vector<Frame::Ptr> _frame_batch;
 
     std::unordered_map<int, toolkit::List<Frame::Ptr> > _frame_unread;
     std::unordered_map<int, std::function<void()> > _track_ready_callback;
@@ -18,22 +18,39 @@
 #include "Common/MultiMediaSourceMuxer.h"
 #include "Record/MP4Reader.h"
 #include "PacketCache.h"
+#include "GopCacheBudget.h"
 
 using namespace std;
 using namespace toolkit;
 
-namespace toolkit {
-    StatisticImp(mediakit::MediaSource);
+namespace mediakit {
+    ObjectCounterImp(MediaSource)
 }
 
 namespace mediakit {
 
-static recursive_mutex s_media_source_mtx;
 using StreamMap = unordered_map<string/*strema_id*/, weak_ptr<MediaSource> >;
 using AppStreamMap = unordered_map<string/*app*/, StreamMap>;
 using VhostAppStreamMap = unordered_map<string/*vhost*/, AppStreamMap>;
 using SchemaVhostAppStreamMap = unordered_map<string/*schema*/, VhostAppStreamMap>;
-static SchemaVhostAppStreamMap s_media_source_map;
+
+// 媒体源注册表分片，按vhost/app/stream哈希，同一个流的所有协议落在同一分片
+// Media source registry shard, hashed by vhost/app/stream, all schemas of one stream fall into the same shard
+struct alignas(64) MediaSourceShard {
+    recursive_mutex mtx;
+    SchemaVhostAppStreamMap map;
+};
+
+static constexpr size_t kMediaSourceShardCount = 64;
+static MediaSourceShard s_media_source_shards[kMediaSourceShardCount];
+
+static MediaSourceShard &getMediaSourceShard(const string &vhost, const string &app, const string &stream) {
+    std::hash<string> hasher;
+    auto h = hasher(vhost);
+    h ^= hasher(app) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= hasher(stream) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return s_media_source_shards[h % kMediaSourceShardCount];
+}
 
 string getOriginTypeString(MediaOriginType type){
 #define SWITCH_CASE(type) case MediaOriginType::type : return #type
@@ -83,6 +100,7 @@ MediaSource::MediaSource(const string &schema, const MediaTuple& tuple): _tuple(
     }
     _schema = schema;
     _create_stamp = time(NULL);
+    _last_reader_changed_ms = getCurrentMillisecond();
 }
 
 MediaSource::~MediaSource() {
@@ -247,6 +265,7 @@ std::shared_ptr<RtpProcess> MediaSource::getRtpProcess() const {
 }
 
 void MediaSource::onReaderChanged(int size) {
+    _last_reader_changed_ms = getCurrentMillisecond();
     try {
         weak_ptr<MediaSource> weak_self = shared_from_this();
         getOwnerPoller()->async([weak_self, size]() {
@@ -271,6 +290,42 @@ void MediaSource::onReaderChanged(int size) {
     }
 }
 
+bool MediaSource::evictGopCache() {
+    if (!isGopCacheEvictable() || _gop_evicted || _gop_evict_request.exchange(true)) {
+        return false;
+    }
+    return true;
+}
+
+void MediaSource::rebuildGopCache(const EventPoller::Ptr &poller, const function<void()> &cb) {
+    EventPoller::Ptr owner;
+    if (_gop_evicted) {
+        try {
+            owner = getOwnerPoller();
+        } catch (std::exception &ex) {
+            WarnL << ex.what();
+        }
+    }
+    if (!owner) {
+        cb();
+        return;
+    }
+    weak_ptr<MediaSource> weak_self = shared_from_this();
+    owner->async([weak_self, poller, cb]() {
+        auto strong_self = weak_self.lock();
+        if (strong_self && strong_self->_gop_evicted) {
+            auto listener = strong_self->_listener.lock();
+            if (listener && listener->rebuildGopCache(*strong_self)) {
+                GopCacheBudget::onRebuild();
+            }
+            // 重建失败时从下一个关键帧开始恢复缓存
+            // If the rebuild failed, caching resumes from the next key frame
+            strong_self->_gop_evicted = false;
+        }
+        poller->async(cb);
+    });
+}
+
 bool MediaSource::setupRecord(Recorder::type type, bool start, const string &custom_path, size_t max_second){
     auto listener = _listener.lock();
     if (!listener) {
@@ -347,9 +402,19 @@ void MediaSource::for_each_media(const function<void(const Ptr &src)> &cb,
                                  const string &app,
                                  const string &stream) {
     deque<Ptr> src_list;
-    {
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        for_each_media_l(s_media_source_map, src_list, schema, vhost, app, stream);
+    if (!vhost.empty() && !app.empty() && !stream.empty()) {
+        // 精确查找只需锁定一个分片
+        // Exact lookup only needs to lock one shard
+        auto &shard = getMediaSourceShard(vhost, app, stream);
+        lock_guard<recursive_mutex> lock(shard.mtx);
+        for_each_media_l(shard.map, src_list, schema, vhost, app, stream);
+    } else {
+        // 遍历需要逐个分片加锁，但同一时刻只持有一把锁
+        // Traversal locks shards one by one, holding only one lock at a time
+        for (auto &shard : s_media_source_shards) {
+            lock_guard<recursive_mutex> lock(shard.mtx);
+            for_each_media_l(shard.map, src_list, schema, vhost, app, stream);
+        }
     }
     for (auto &src : src_list) {
         cb(src);
@@ -385,8 +450,14 @@ static MediaSource::Ptr find_l(const string &schema, const string &vhost_in, con
 static void findAsync_l(const MediaInfo &info, const std::shared_ptr<Session> &session, bool retry,
                         const function<void(const MediaSource::Ptr &src)> &cb){
     auto src = find_l(info.schema, info.vhost, info.app, info.stream, true);
-    if (src || !retry) {
-        cb(src);
+    if (src) {
+        // gop缓存已被淘汰时先重建，以便播放器秒开
+        // Rebuild the evicted gop cache first so that the player starts instantly
+        src->rebuildGopCache(session->getPoller(), [cb, src]() { cb(src); });
+        return;
+    }
+    if (!retry) {
+        cb(nullptr);
         return;
     }
 
@@ -509,8 +580,9 @@ void MediaSource::regist() {
     {
         // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
         // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        auto &ref = s_media_source_map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
+        auto &shard = getMediaSourceShard(_tuple.vhost, _tuple.app, _tuple.stream);
+        lock_guard<recursive_mutex> lock(shard.mtx);
+        auto &ref = shard.map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
         auto src = ref.lock();
         if (src) {
             if (src.get() == this) {
@@ -556,8 +628,9 @@ bool MediaSource::unregist() {
     {
         // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
         // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        erase_media_source(ret, this, s_media_source_map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
+        auto &shard = getMediaSourceShard(_tuple.vhost, _tuple.app, _tuple.stream);
+        lock_guard<recursive_mutex> lock(shard.mtx);
+        erase_media_source(ret, this, shard.map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
     }
 
     if (ret) {
@@ -830,6 +903,14 @@ std::shared_ptr<RtpProcess> MediaSourceEventInterceptor::getRtpProcess(MediaSour
     return listener->getRtpProcess(sender);
 }
 
+bool MediaSourceEventInterceptor::rebuildGopCache(MediaSource &sender) {
+    auto listener = _listener.lock();
+    if (!listener) {
+        return MediaSourceEvent::rebuildGopCache(sender);
+    }
+    return listener->rebuildGopCache(sender);
+}
+
 bool MediaSourceEventInterceptor::setupRecord(MediaSource &sender, Recorder::type type, bool start, const string &custom_path, size_t max_second) {
     auto listener = _listener.lock();
     if (!listener) {
@@ -916,13 +997,33 @@ static bool isFlushAble_merge(bool is_video, uint64_t last_stamp, uint64_t new_s
 }
 
 bool FlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size) {
+    return isFlushAble_l(is_video, is_key, new_stamp, cache_size, getMergeWriteMS());
+}
+
+int FlushPolicy::getMergeWriteMS() const {
+    GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
+    return mergeWriteMS;
+}
+
+static Metric s_flushes("zlm_merge_write_flushes_total", "Merge write flushes");
+static Metric s_flushed_packets("zlm_merge_write_packets_total", "Packets flushed by merge write");
+
+void FlushPolicy::onFlushed(size_t packets) {
+    s_flushes.add();
+    s_flushed_packets.add(packets);
+}
+
+FlushPolicy::Statistic FlushPolicy::getStatistic() {
+    return Statistic { (uint64_t)s_flushes.value(), (uint64_t)s_flushed_packets.value() };
+}
+
+bool FlushPolicy::isFlushAble_l(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size, int mergeWriteMS) {
     bool flush_flag = false;
     if (is_key && is_video) {
         // 遇到关键帧flush掉前面的数据，确保关键帧为该组数据的第一帧，确保GOP缓存有效  [AUTO-TRANSLATED:e2ebbf9b]
         // Encounter a key frame, flush the previous data, ensure that the key frame is the first frame of this group of data, and ensure the GOP cache is valid.
         flush_flag = true;
     } else {
-        GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
         if (mergeWriteMS <= 0) {
             // 关闭了合并写或者合并写阈值小于等于0  [AUTO-TRANSLATED:2397b647]
             // Merge writing is closed or the merge writing threshold is less than or equal to 0.
@@ -938,4 +1039,56 @@ bool FlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, si
     return flush_flag;
 }
 
+/////////////////////////////////////AdaptiveFlushPolicy//////////////////////////////////////
+
+// 码率统计周期，单位毫秒
+// Bitrate estimation period, in milliseconds
+static constexpr uint64_t kBitrateWindowMS = 1000;
+
+bool AdaptiveFlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size) {
+    return isFlushAble_l(is_video, is_key, new_stamp, cache_size, getMergeWriteMS());
+}
+
+int AdaptiveFlushPolicy::getMergeWriteMS() const {
+    int merge_ms = _merge_write_ms;
+    if (merge_ms >= 0) {
+        // 按流指定了合并写时长
+        // The merge write window is set for this stream
+        return merge_ms;
+    }
+    GET_CONFIG(bool, adaptive, General::kMergeWriteAdaptive);
+    if (!adaptive) {
+        return FlushPolicy::getMergeWriteMS();
+    }
+    int readers = _reader_count;
+    if (readers <= 1) {
+        // 单个观看者时逐帧发送，延时最低
+        // Send per frame for a single reader, lowest latency
+        return 0;
+    }
+    // 每个观看者每Mbps码率增加1毫秒合并写时长，例如10个观看者观看4Mbps的流时合并写40毫秒
+    // Every reader per Mbps adds 1ms to the window, e.g. 40ms for 10 readers of a 4Mbps stream
+    GET_CONFIG(int, maxMS, General::kMergeWriteMaxMS);
+    auto ms = readers * _bitrate_kbps / 1000;
+    return (int)MIN(ms, (uint64_t)MAX(maxMS, 0));
+}
+
+void AdaptiveFlushPolicy::onPacket(size_t bytes, uint64_t stamp) {
+    if (stamp < _window_stamp || stamp > _window_stamp + 10 * kBitrateWindowMS) {
+        // 时间戳回退或跳变，重新开始统计
+        // Timestamp rolled back or jumped, restart the estimation
+        _window_stamp = stamp;
+        _window_bytes = 0;
+    }
+    _window_bytes += bytes;
+    auto duration = stamp - _window_stamp;
+    if (duration >= kBitrateWindowMS) {
+        // 字节数*8/毫秒数即为kbps
+        // bytes * 8 / milliseconds is kbps
+        _bitrate_kbps = _window_bytes * 8 / duration;
+        _window_stamp = stamp;
+        _window_bytes = 0;
+    }
+}
+
 } /* namespace mediakit */
\ No newline at end of file
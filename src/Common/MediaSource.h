@@ -19,6 +19,8 @@
 #include "Network/Socket.h"
 #include "Extension/Track.h"
 #include "Record/Recorder.h"
+#include "Common/MediaCost.h"
+#include "Common/Metrics.h"
 
 namespace toolkit {
 class Session;
@@ -111,6 +113,9 @@ public:
     // 获取RtpProcess对象  [AUTO-TRANSLATED:c6b7da43]
     // Get RtpProcess object
     virtual std::shared_ptr<RtpProcess> getRtpProcess(MediaSource &sender) const { return nullptr; }
+    // 从帧级gop缓存重建被淘汰的协议gop缓存，在归属线程中调用
+    // Rebuild an evicted protocol gop cache from the frame level gop cache, called in the owner thread
+    virtual bool rebuildGopCache(MediaSource &sender) { return false; }
 
     class SendRtpArgs {
     public:
@@ -245,6 +250,10 @@ public:
     // This configuration can solve some problems where the stream is not sent smoothly, resulting in zlmediakit forwarding not being smooth
     uint32_t paced_sender_ms;
 
+    // 合并写时长，单位毫秒，-1代表使用general.mergeWriteMS或自适应合并写，0代表不合并写
+    // Merge write window, in milliseconds, -1 means following general.mergeWriteMS or the adaptive policy, 0 means no merge write
+    int merge_write_ms;
+
     // 是否开启转换为hls(mpegts)  [AUTO-TRANSLATED:bfc1167a]
     // Whether to enable conversion to hls(mpegts)
     bool enable_hls;
@@ -282,6 +291,9 @@ public:
     // http[s]-fmp4、ws[s]-fmp4协议是否按需生成  [AUTO-TRANSLATED:828d25c7]
     // Whether to generate http[s]-fmp4、ws[s]-fmp4 protocol on demand
     bool fmp4_demand;
+    // 按需生成的协议被首个播放者激活时，是否用帧级gop缓存填充，使首个播放者秒开
+    // Whether protocols generated on demand are seeded from the frame level gop cache when activated by the first player
+    bool demand_seed_gop;
 
     // 是否将mp4录制当做观看者  [AUTO-TRANSLATED:ba351230]
     // Whether to treat mp4 recording as a viewer
@@ -319,6 +331,7 @@ public:
         GET_OPT_VALUE(auto_close);
         GET_OPT_VALUE(continue_push_ms);
         GET_OPT_VALUE(paced_sender_ms);
+        GET_OPT_VALUE(merge_write_ms);
 
         GET_OPT_VALUE(enable_hls);
         GET_OPT_VALUE(enable_hls_fmp4);
@@ -333,6 +346,7 @@ public:
         GET_OPT_VALUE(rtmp_demand);
         GET_OPT_VALUE(ts_demand);
         GET_OPT_VALUE(fmp4_demand);
+        GET_OPT_VALUE(demand_seed_gop);
 
         GET_OPT_VALUE(mp4_max_second);
         GET_OPT_VALUE(mp4_as_player);
@@ -371,11 +385,49 @@ public:
     toolkit::EventPoller::Ptr getOwnerPoller(MediaSource &sender) override;
     std::shared_ptr<MultiMediaSourceMuxer> getMuxer(MediaSource &sender) const override;
     std::shared_ptr<RtpProcess> getRtpProcess(MediaSource &sender) const override;
+    bool rebuildGopCache(MediaSource &sender) override;
 
 private:
     std::weak_ptr<MediaSourceEvent> _listener;
 };
 
+/**
+ * 按需生成的协议复用器的gop填充标记
+ * 复用器被首个播放者激活时，由MultiMediaSourceMuxer把帧级gop缓存中的最后一个gop通过inputFrames输入，使首个播放者立即收到关键帧
+ * Gop seeding flag of a protocol muxer generated on demand
+ * When the muxer is activated by the first player, MultiMediaSourceMuxer inputs the last gop of the frame level gop cache
+ * through inputFrames, so that the first player receives a key frame immediately
+ */
+class DemandGopSeeder {
+public:
+    /**
+     * 观看人数变化时、更新启用状态之前调用
+     * @param demand 是否按需生成
+     * @param enabled 变化前是否已启用
+     * @param size 观看人数
+     * Called when the reader count changes, before the enabled state is updated
+     * @param demand Whether it is generated on demand
+     * @param enabled Whether it was enabled before the change
+     * @param size Reader count
+     */
+    void onDemandReaderChanged(bool demand, bool enabled, int size) { _seed_gop = demand && !enabled && size; }
+
+    /**
+     * 是否需要用帧级gop缓存填充
+     * Whether it needs to be seeded from the frame level gop cache
+     */
+    bool needSeedGop() const { return _seed_gop; }
+
+    /**
+     * 填充前调用，清除标记
+     * Called before seeding, clears the flag
+     */
+    void onSeedGop() { _seed_gop = false; }
+
+private:
+    bool _seed_gop = false;
+};
+
 /**
  * 解析url获取媒体相关信息
  * Parse the url to get media information
@@ -454,6 +506,9 @@ public:
     // 获取流上线时间，单位秒  [AUTO-TRANSLATED:a087d56a]
     // Get the stream online time, unit seconds
     uint64_t getAliveSecond() const;
+    // 获取本媒体源的cpu与缓存开销统计
+    // Get the cpu and cache cost accounting of this media source
+    MediaCost &getCost() { return _cost; }
 
     // //////////////MediaSourceEvent相关接口实现////////////////  [AUTO-TRANSLATED:aa63d949]
     // //////////////MediaSourceEvent related interface implementation////////////////
@@ -531,6 +586,28 @@ public:
     // Get the RtpProcess object
     std::shared_ptr<RtpProcess> getRtpProcess() const;
 
+    // //////////////gop缓存预算相关接口////////////////
+    // //////////////Gop cache budget related interfaces////////////////
+
+    // 该媒体源的环形缓冲是否缓存了视频gop，可被gop缓存预算淘汰
+    // Whether the ring buffer of this media source caches video gops and can be evicted by the gop cache budget
+    bool isGopCacheEvictable() const { return _gop_evictable && _gop_rebuildable; }
+    // 标记该媒体源的环形缓冲由MultiMediaSourceMuxer中的协议复用器写入，淘汰后可以从帧级gop缓存重建；
+    // 直接转发协议数据的媒体源(如rtsp/rtmp直接代理)与fmp4媒体源无法重建，不参与淘汰
+    // Mark that the ring buffer of this media source is written by a protocol muxer of MultiMediaSourceMuxer, so it can be rebuilt from
+    // the frame level gop cache after eviction; media sources forwarding protocol data directly (such as rtsp/rtmp direct proxies)
+    // and fmp4 media sources can not be rebuilt and are never evicted
+    void setGopCacheRebuildable() { _gop_rebuildable = true; }
+    // 请求淘汰gop缓存，在写入线程下次写入环形缓冲时生效，不支持或已淘汰时返回false
+    // Request to evict the gop cache, it takes effect the next time the writer thread writes the ring buffer, false if not supported or already evicted
+    bool evictGopCache();
+    // 重建被淘汰的gop缓存后在poller线程中回调，播放器查找到媒体源后、开始播放前调用
+    // Rebuild the evicted gop cache then invoke cb in the poller thread, called after a player finds the media source and before it starts playing
+    void rebuildGopCache(const toolkit::EventPoller::Ptr &poller, const std::function<void()> &cb);
+    // 最近一次观看人数变化的时间，单位毫秒，用于按最近最少使用的顺序淘汰gop缓存
+    // Time the reader count changed last, in milliseconds, used to evict gop caches in least recently used order
+    uint64_t getLastReaderChangedMS() const { return _last_reader_changed_ms; }
+
     // //////////////static方法，查找或生成MediaSource////////////////  [AUTO-TRANSLATED:c3950036]
     // //////////////static methods, find or generate MediaSource////////////////
 
@@ -560,6 +637,43 @@ protected:
     // Media registration
     void regist();
 
+    /**
+     * 写入环形缓冲前调用，处理gop缓存淘汰请求并统计gop缓存字节数
+     * @param ring 环形缓冲
+     * @param bytes 写入的字节数
+     * @param have_video 是否有视频，没有视频时不缓存gop
+     * @param key_pos 是否为gop起始
+     * @param ring_size 环形缓冲大小
+     * @return 写入环形缓冲时的gop起始标记，gop缓存已淘汰时总是false(不再缓存gop)
+     * Called before writing the ring buffer, handles gop cache eviction requests and counts the bytes in the gop cache
+     * @param ring Ring buffer
+     * @param bytes Bytes written
+     * @param have_video Whether there is video, gops are not cached without video
+     * @param key_pos Whether it starts a gop
+     * @param ring_size Ring buffer size
+     * @return The gop start flag to write the ring buffer with, always false when the gop cache is evicted (gops are not cached anymore)
+     */
+    template <typename RingType>
+    bool onGopCacheWrite(RingType &ring, size_t bytes, bool have_video, bool key_pos, size_t ring_size) {
+        if (have_video && !_gop_evictable.load(std::memory_order_relaxed)) {
+            _gop_evictable = true;
+        }
+        if (have_video && _gop_evict_request.load(std::memory_order_relaxed)) {
+            _gop_evict_request = false;
+            _gop_evicted = true;
+            ring.clearCache();
+            _cost.onClearCache();
+        }
+        if (_gop_evicted.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
+        // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
+        key_pos = have_video ? key_pos : true;
+        _cost.onCache(bytes, key_pos, ring_size);
+        return key_pos;
+    }
+
 private:
     // 媒体注销  [AUTO-TRANSLATED:06a0630a]
     // Media unregistration
@@ -571,6 +685,7 @@ private:
 protected:
     toolkit::BytesSpeed _speed[TrackMax];
     MediaTuple _tuple;
+    MediaCost _cost;
 
 private:
     std::atomic_flag _owned { false };
@@ -578,9 +693,16 @@ private:
     toolkit::Ticker _ticker;
     std::string _schema;
     std::weak_ptr<MediaSourceEvent> _listener;
+    // gop缓存淘汰状态，写入线程中修改
+    // Gop cache eviction state, modified in the writer thread
+    std::atomic<bool> _gop_evictable { false };
+    std::atomic<bool> _gop_rebuildable { false };
+    std::atomic<bool> _gop_evict_request { false };
+    std::atomic<bool> _gop_evicted { false };
+    std::atomic<uint64_t> _last_reader_changed_ms;
     // 对象个数统计  [AUTO-TRANSLATED:f4a012d0]
     // Object count statistics
-    toolkit::ObjectStatistic<MediaSource> _statistic;
+    ObjectCounter<MediaSource> _statistic;
 };
 
 } /* namespace mediakit */
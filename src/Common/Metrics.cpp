@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <mutex>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "Metrics.h"
+
+using namespace std;
+
+namespace mediakit {
+
+constexpr size_t Metric::kMaxSlots;
+
+thread_local atomic<int64_t> *Metric::s_shard = nullptr;
+thread_local bool Metric::s_retired = false;
+
+struct MetricShard {
+    atomic<int64_t> slots[Metric::kMaxSlots];
+
+    MetricShard() {
+        for (auto &slot : slots) {
+            slot.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+// 全局对象不析构，防止线程退出晚于全局对象析构
+// Global objects are never destructed, in case threads exit after global destruction
+static mutex &getMutex() {
+    static auto s_mtx = new mutex;
+    return *s_mtx;
+}
+
+static vector<Metric *> &getMetrics() {
+    static auto s_metrics = new vector<Metric *>;
+    return *s_metrics;
+}
+
+static unordered_set<MetricShard *> &getShards() {
+    static auto s_shards = new unordered_set<MetricShard *>;
+    return *s_shards;
+}
+
+// 已退出线程的计数，线程退出后其thread_local析构函数中的计数也写到这里
+// Counts of exited threads, counts from thread_local destructors after the thread shard is gone are written here as well
+static MetricShard &getRetiredShard() {
+    static auto s_retired = new MetricShard;
+    return *s_retired;
+}
+
+class ThreadMetricShard {
+public:
+    ThreadMetricShard() {
+        lock_guard<mutex> lck(getMutex());
+        getShards().emplace(&_shard);
+    }
+
+    ~ThreadMetricShard() {
+        lock_guard<mutex> lck(getMutex());
+        auto &retired = getRetiredShard();
+        for (size_t i = 0; i < Metric::kMaxSlots; ++i) {
+            retired.slots[i] += _shard.slots[i].load(memory_order_relaxed);
+        }
+        getShards().erase(&_shard);
+        Metric::s_shard = retired.slots;
+        Metric::s_retired = true;
+    }
+
+    atomic<int64_t> *slots() { return _shard.slots; }
+
+private:
+    MetricShard _shard;
+};
+
+atomic<int64_t> *Metric::createShard() {
+    static thread_local ThreadMetricShard s_thread_shard;
+    s_shard = s_thread_shard.slots();
+    return s_shard;
+}
+
+Metric::Metric(const char *name, const char *help, Type type, const char *labels) {
+    _type = type;
+    _name = name;
+    _help = help;
+    _labels = labels;
+    lock_guard<mutex> lck(getMutex());
+    auto &metrics = getMetrics();
+    // 超出槽位个数的指标共用最后一个槽位，导出时忽略
+    // Metrics beyond the slot count share the last slot and are skipped when exported
+    _index = std::min(metrics.size(), kMaxSlots - 1);
+    metrics.emplace_back(this);
+}
+
+int64_t Metric::value() const {
+    lock_guard<mutex> lck(getMutex());
+    auto ret = getRetiredShard().slots[_index].load(memory_order_relaxed);
+    for (auto shard : getShards()) {
+        ret += shard->slots[_index].load(memory_order_relaxed);
+    }
+    return ret;
+}
+
+string Metric::toPrometheus() {
+    vector<Metric *> metrics;
+    vector<int64_t> values;
+    {
+        lock_guard<mutex> lck(getMutex());
+        metrics = getMetrics();
+        values.resize(kMaxSlots);
+        for (size_t i = 0; i < kMaxSlots; ++i) {
+            values[i] = getRetiredShard().slots[i].load(memory_order_relaxed);
+        }
+        for (auto shard : getShards()) {
+            for (size_t i = 0; i < kMaxSlots; ++i) {
+                values[i] += shard->slots[i].load(memory_order_relaxed);
+            }
+        }
+    }
+    if (metrics.size() >= kMaxSlots) {
+        metrics.resize(kMaxSlots - 1);
+    }
+
+    // 同名指标(不同标签)按首次注册的顺序归为一组
+    // Metrics with the same name (and different labels) are grouped in the order they were first registered
+    vector<string> names;
+    unordered_map<string, vector<Metric *>> groups;
+    for (auto metric : metrics) {
+        auto &group = groups[metric->_name];
+        if (group.empty()) {
+            names.emplace_back(metric->_name);
+        }
+        group.emplace_back(metric);
+    }
+
+    string ret;
+    for (auto &name : names) {
+        auto &group = groups[name];
+        ret.append("# HELP ").append(name).append(" ").append(group.front()->_help).append("\n");
+        ret.append("# TYPE ").append(name).append(group.front()->_type == Counter ? " counter\n" : " gauge\n");
+        for (auto metric : group) {
+            ret.append(name);
+            if (*metric->_labels) {
+                ret.append("{").append(metric->_labels).append("}");
+            }
+            ret.append(" ").append(to_string(values[metric->_index])).append("\n");
+        }
+    }
+    return ret;
+}
+
+ProtocolMetrics::ProtocolMetrics(const char *labels)
+    : packets_in("zlm_packets_in_total", "Media packets received", Metric::Counter, labels)
+    , bytes_in("zlm_bytes_in_total", "Bytes received", Metric::Counter, labels)
+    , packets_out("zlm_packets_out_total", "Media packets sent", Metric::Counter, labels)
+    , bytes_out("zlm_bytes_out_total", "Bytes sent", Metric::Counter, labels) {}
+
+namespace Metrics {
+ProtocolMetrics rtsp("protocol=\"rtsp\"");
+ProtocolMetrics rtmp("protocol=\"rtmp\"");
+ProtocolMetrics http("protocol=\"http\"");
+ProtocolMetrics rtp("protocol=\"rtp\"");
+ProtocolMetrics webrtc("protocol=\"webrtc\"");
+ProtocolMetrics srt("protocol=\"srt\"");
+Metric dropped_ssrc_mismatch("zlm_dropped_packets_total", "Packets dropped", Metric::Counter, "reason=\"ssrc_mismatch\"");
+Metric dropped_sort_overflow("zlm_dropped_packets_total", "Packets dropped", Metric::Counter, "reason=\"sort_overflow\"");
+Metric nack_retransmits_webrtc("zlm_nack_retransmits_total", "Packets retransmitted for nack requests", Metric::Counter, "protocol=\"webrtc\"");
+Metric nack_retransmits_srt("zlm_nack_retransmits_total", "Packets retransmitted for nack requests", Metric::Counter, "protocol=\"srt\"");
+} // namespace Metrics
+
+} // namespace mediakit
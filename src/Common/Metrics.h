@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_METRICS_H
+#define ZLMEDIAKIT_METRICS_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * 按线程分片的统计指标
+ * 每个线程拥有独立的计数槽位，热路径上只修改本线程的槽位(无锁、无原子读改写、无内存分配、无跨线程缓存行争用)，读取时汇总所有线程
+ * 指标对象必须为静态存储期(全局或函数内静态变量)
+ * Statistics metric sharded per thread
+ * Every thread owns its own counter slots, the hot path only touches the slots of its own thread (no lock, no atomic read-modify-write,
+ * no allocation and no cache line contention between threads), they are summed over all threads when read
+ * Metric objects must have static storage duration (global or function local static variables)
+ */
+class Metric {
+public:
+    enum Type { Counter, Gauge };
+
+    // 每个线程的槽位个数，即最多可注册的指标个数
+    // Slots per thread, i.e. max number of metrics that can be registered
+    static constexpr size_t kMaxSlots = 256;
+
+    /**
+     * 构造并注册指标
+     * @param name prometheus指标名
+     * @param help 指标说明
+     * @param type 计数器(只增)或仪表(可增减)
+     * @param labels prometheus标签，例如 protocol="rtsp"
+     * Construct and register a metric
+     * @param name Prometheus metric name
+     * @param help Metric description
+     * @param type Counter (only increases) or gauge (increases and decreases)
+     * @param labels Prometheus labels, such as protocol="rtsp"
+     */
+    Metric(const char *name, const char *help, Type type = Counter, const char *labels = "");
+    Metric(const Metric &) = delete;
+    Metric &operator=(const Metric &) = delete;
+
+    /**
+     * 增加指标值，仪表类型可以传入负数
+     * Increase the metric value, gauges accept negative values
+     */
+    void add(int64_t value = 1) {
+        auto &slot = getShard()[_index];
+        if (s_retired) {
+            // 线程分片已销毁，写入的是所有已退出线程共享的分片，必须原子累加
+            // The thread shard is gone, the shard shared by all exited threads is written, so it must be an atomic add
+            slot.fetch_add(value, std::memory_order_relaxed);
+            return;
+        }
+        slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    /**
+     * 获取所有线程汇总后的指标值
+     * Get the metric value summed over all threads
+     */
+    int64_t value() const;
+
+    /**
+     * 以prometheus文本格式导出所有指标
+     * Export all metrics in the prometheus text format
+     */
+    static std::string toPrometheus();
+
+private:
+    friend class ThreadMetricShard;
+
+    static std::atomic<int64_t> *getShard() {
+        auto shard = s_shard;
+        return shard ? shard : createShard();
+    }
+
+    static std::atomic<int64_t> *createShard();
+
+private:
+    Type _type;
+    size_t _index;
+    const char *_name;
+    const char *_help;
+    const char *_labels;
+    static thread_local std::atomic<int64_t> *s_shard;
+    static thread_local bool s_retired;
+};
+
+/**
+ * 对象个数统计，用于替代toolkit::ObjectStatistic，构造析构只修改本线程的计数
+ * Object count statistic replacing toolkit::ObjectStatistic, construction and destruction only touch the counter of the current thread
+ */
+template <typename C>
+class ObjectCounter {
+public:
+    ObjectCounter() { getMetric().add(1); }
+    ObjectCounter(const ObjectCounter &) { getMetric().add(1); }
+    ObjectCounter &operator=(const ObjectCounter &) { return *this; }
+    ~ObjectCounter() { getMetric().add(-1); }
+
+    static size_t count() {
+        auto ret = getMetric().value();
+        return ret > 0 ? (size_t)ret : 0;
+    }
+
+private:
+    static Metric &getMetric();
+};
+
+// 在mediakit命名空间内实现对象个数统计
+// Implement the object count statistic inside the mediakit namespace
+#define ObjectCounterImp(Type)                                                                                                                       \
+    template <>                                                                                                                                      \
+    Metric &ObjectCounter<Type>::getMetric() {                                                                                                       \
+        static Metric s_metric("zlm_objects", "Number of live objects", Metric::Gauge, "type=\"" #Type "\"");                                      \
+        return s_metric;                                                                                                                             \
+    }
+
+/**
+ * 每种协议的收发统计
+ * Receive and send statistics of a protocol
+ */
+class ProtocolMetrics {
+public:
+    /**
+     * @param labels prometheus标签，例如 protocol="rtsp"
+     * @param labels Prometheus labels, such as protocol="rtsp"
+     */
+    ProtocolMetrics(const char *labels);
+
+    // 收到的媒体包个数
+    // Media packets received
+    Metric packets_in;
+    // 收到的字节数
+    // Bytes received
+    Metric bytes_in;
+    // 发送的媒体包个数
+    // Media packets sent
+    Metric packets_out;
+    // 发送的字节数
+    // Bytes sent
+    Metric bytes_out;
+};
+
+/**
+ * 热路径上的全局统计指标
+ * Global metrics updated on the hot path
+ */
+namespace Metrics {
+// 各协议的收发统计
+// Receive and send statistics of each protocol
+extern ProtocolMetrics rtsp;
+extern ProtocolMetrics rtmp;
+extern ProtocolMetrics http;
+extern ProtocolMetrics rtp;
+extern ProtocolMetrics webrtc;
+extern ProtocolMetrics srt;
+// 因ssrc不匹配丢弃的rtp包
+// Rtp packets dropped because of a mismatched ssrc
+extern Metric dropped_ssrc_mismatch;
+// 排序缓存溢出(乱序过多或等待超时)丢弃的rtp包
+// Rtp packets dropped because the sort cache overflowed (too much disorder or waited too long)
+extern Metric dropped_sort_overflow;
+// nack请求触发的重传包
+// Packets retransmitted for nack requests
+extern Metric nack_retransmits_webrtc;
+extern Metric nack_retransmits_srt;
+} // namespace Metrics
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_METRICS_H
@@ -11,13 +11,14 @@
 #include <math.h>
 #include "Common/config.h"
 #include "MultiMediaSourceMuxer.h"
+#include "GopCacheBudget.h"
 #include "Thread/WorkThreadPool.h"
 
 using namespace std;
 using namespace toolkit;
 
-namespace toolkit {
-    StatisticImp(mediakit::MultiMediaSourceMuxer);
+namespace mediakit {
+    ObjectCounterImp(MultiMediaSourceMuxer)
 }
 
 namespace mediakit {
@@ -615,6 +616,96 @@ std::shared_ptr<MultiMediaSourceMuxer> MultiMediaSourceMuxer::getMuxer(MediaSour
     return const_cast<MultiMediaSourceMuxer*>(this)->shared_from_this();
 }
 
+std::list<Frame::Ptr> MultiMediaSourceMuxer::getLastGop() const {
+    std::list<Frame::Ptr> gop;
+    _ring->flushGop([&](const Frame::Ptr &frame) { gop.emplace_back(frame); });
+
+    // 只保留最后一个gop(从最后一组配置帧/关键帧开始)
+    // Only keep the last gop (starting from the last group of config/key frames)
+    auto start = gop.end();
+    bool last_key = false;
+    for (auto it = gop.begin(); it != gop.end(); ++it) {
+        auto &frame = *it;
+        if (frame->getTrackType() != TrackVideo) {
+            continue;
+        }
+        auto key = frame->keyFrame() || frame->configFrame();
+        if (key && !last_key) {
+            start = it;
+        }
+        if (!frame->dropAble()) {
+            last_key = key;
+        }
+    }
+    if (start != gop.end()) {
+        gop.erase(gop.begin(), start);
+    }
+    return gop;
+}
+
+bool MultiMediaSourceMuxer::rebuildGopCache(MediaSource &sender) {
+    if (!_ring) {
+        return false;
+    }
+    auto gop = getLastGop();
+    if (gop.empty()) {
+        return false;
+    }
+
+    auto tracks = MediaSink::getTracks();
+    if (_rtsp && _rtsp->rebuildGopCache(sender, tracks, gop)) {
+        return true;
+    }
+    if (_rtmp && _rtmp->rebuildGopCache(sender, tracks, gop)) {
+        return true;
+    }
+    if (_ts && _ts->rebuildGopCache(sender, tracks, gop)) {
+        return true;
+    }
+    // fmp4复用器会重置时间戳与分片序号，无法与直播数据衔接，等待下一个关键帧
+    // The fmp4 muxer resets the timestamps and fragment sequence, it can not be spliced with the live data, wait for the next key frame
+    return false;
+}
+
+void MultiMediaSourceMuxer::onReaderChanged(MediaSource &sender, int size) {
+    if (size && _demand_seed) {
+        seedGop();
+    }
+    MediaSourceEventInterceptor::onReaderChanged(sender, size);
+}
+
+template <typename Muxer>
+static void addGopSeeder(vector<pair<DemandGopSeeder *, MediaSinkInterface *> > &seeders, const std::shared_ptr<Muxer> &muxer) {
+    if (muxer && muxer->needSeedGop()) {
+        seeders.emplace_back(muxer.get(), muxer.get());
+    }
+}
+
+void MultiMediaSourceMuxer::seedGop() {
+    vector<pair<DemandGopSeeder *, MediaSinkInterface *> > seeders;
+    addGopSeeder(seeders, _rtmp);
+    addGopSeeder(seeders, _rtsp);
+    addGopSeeder(seeders, _ts);
+    addGopSeeder(seeders, _fmp4);
+    addGopSeeder(seeders, _hls);
+    addGopSeeder(seeders, _hls_fmp4);
+    if (seeders.empty()) {
+        return;
+    }
+    // 复用器在归属线程中激活，与帧输入在同一线程，填充的gop与后续直播帧无缝衔接
+    // The muxer is activated in the owner thread, the same thread frames are input in, so the seeded gop is followed seamlessly by live frames
+    MediaCost::Scope scope(_cost, MediaCost::kMux);
+    auto gop = getLastGop();
+    vector<Frame::Ptr> frames(gop.begin(), gop.end());
+    for (auto &seeder : seeders) {
+        seeder.first->onSeedGop();
+        if (!frames.empty()) {
+            seeder.second->inputFrames(frames.data(), frames.size());
+        }
+    }
+    DebugL << "seed " << frames.size() << " frames to protocols generated on demand: " << shortUrl();
+}
+
 bool MultiMediaSourceMuxer::onTrackReady(const Track::Ptr &track) {
     auto &stamp = _stamps[track->getIndex()];
     if (_dur_sec > 0.01) {
@@ -696,6 +787,21 @@ void MultiMediaSourceMuxer::onAllTrackReady() {
     }
 #endif
 
+    GET_CONFIG(size_t, gop_cache_max_mb, General::kGopCacheMaxMB);
+    if (gop_cache_max_mb) {
+        // 协议gop缓存可能被淘汰，保留帧级gop缓存用于重建
+        // Protocol gop caches may be evicted, keep the frame level gop cache to rebuild them
+        createGopCacheIfNeed(1);
+        GopCacheBudget::Instance();
+    }
+
+    if (_option.demand_seed_gop && (_option.hls_demand || _option.rtsp_demand || _option.rtmp_demand || _option.ts_demand || _option.fmp4_demand)) {
+        // 按需生成的协议被首个播放者激活时用帧级gop缓存填充
+        // Protocols generated on demand are seeded from the frame level gop cache when activated by the first player
+        createGopCacheIfNeed(1);
+        _demand_seed = true;
+    }
+
     Stamp *first = nullptr;
     for (auto &pr : _stamps) {
         if (!first) {
@@ -760,54 +866,90 @@ bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
     return _paced_sender ? _paced_sender->inputFrame(frame) : onTrackFrame_l(frame);
 }
 
-bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
-    auto frame = frame_in;
+bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame) {
+    return onTrackFrames_l(&frame, 1);
+}
+
+bool MultiMediaSourceMuxer::onTrackFrames(const Frame::Ptr *frames, size_t size) {
+    if (_option.modify_stamp != ProtocolOption::kModifyStampOff) {
+        // 时间戳不采用原始的绝对时间戳，须逐帧按顺序修改
+        // Timestamp does not use the original absolute timestamp, it must be modified frame by frame in order
+        _stamped_frames.clear();
+        _stamped_frames.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            _stamped_frames.emplace_back(std::make_shared<FrameStamp>(frames[i], _stamps[frames[i]->getIndex()], _option.modify_stamp));
+        }
+        frames = _stamped_frames.data();
+    }
+    bool ret = false;
+    if (_paced_sender) {
+        for (size_t i = 0; i < size; ++i) {
+            ret = _paced_sender->inputFrame(frames[i]) ? true : ret;
+        }
+    } else {
+        ret = onTrackFrames_l(frames, size);
+    }
+    _stamped_frames.clear();
+    return ret;
+}
+
+bool MultiMediaSourceMuxer::onTrackFrames_l(const Frame::Ptr *frames, size_t size) {
+    MediaCost::Scope scope(_cost, MediaCost::kMux);
     bool ret = false;
     if (_rtmp) {
-        ret = _rtmp->inputFrame(frame) ? true : ret;
+        ret = _rtmp->inputFrames(frames, size) ? true : ret;
     }
     if (_rtsp) {
-        ret = _rtsp->inputFrame(frame) ? true : ret;
+        ret = _rtsp->inputFrames(frames, size) ? true : ret;
     }
     if (_ts) {
-        ret = _ts->inputFrame(frame) ? true : ret;
+        ret = _ts->inputFrames(frames, size) ? true : ret;
     }
 
     if (_hls) {
-        ret = _hls->inputFrame(frame) ? true : ret;
+        ret = _hls->inputFrames(frames, size) ? true : ret;
     }
 
     if (_hls_fmp4) {
-        ret = _hls_fmp4->inputFrame(frame) ? true : ret;
+        ret = _hls_fmp4->inputFrames(frames, size) ? true : ret;
     }
 
     if (_mp4) {
-        ret = _mp4->inputFrame(frame) ? true : ret;
+        ret = _mp4->inputFrames(frames, size) ? true : ret;
     }
     if (_fmp4) {
-        ret = _fmp4->inputFrame(frame) ? true : ret;
+        ret = _fmp4->inputFrames(frames, size) ? true : ret;
     }
     if (_ring) {
-        // 此场景由于直接转发，可能存在切换线程引起的数据被缓存在管道，所以需要CacheAbleFrame  [AUTO-TRANSLATED:528afbb7]
-        // In this scenario, due to direct forwarding, there may be data cached in the pipeline due to thread switching, so CacheAbleFrame is needed
-        frame = Frame::getCacheAbleFrame(frame);
-        if (frame->getTrackType() == TrackVideo) {
-            // 视频时，遇到第一帧配置帧或关键帧则标记为gop开始处  [AUTO-TRANSLATED:66247aa8]
-            // When it is a video, if the first frame configuration frame or key frame is encountered, it is marked as the beginning of the GOP
-            auto video_key_pos = frame->keyFrame() || frame->configFrame();
-            _ring->write(frame, video_key_pos && !_video_key_pos);
-            if (!frame->dropAble()) {
-                _video_key_pos = video_key_pos;
-            }
-        } else {
-            // 没有视频时，设置is_key为true，目的是关闭gop缓存  [AUTO-TRANSLATED:f3223755]
-            // When there is no video, set is_key to true to disable gop caching
-            _ring->write(frame, !haveVideo());
+        MediaCost::Scope fanout(_cost, MediaCost::kFanout);
+        for (size_t i = 0; i < size; ++i) {
+            writeGopCache(frames[i]);
         }
     }
     return ret;
 }
 
+void MultiMediaSourceMuxer::writeGopCache(const Frame::Ptr &frame_in) {
+    // 此场景由于直接转发，可能存在切换线程引起的数据被缓存在管道，所以需要CacheAbleFrame  [AUTO-TRANSLATED:528afbb7]
+    // In this scenario, due to direct forwarding, there may be data cached in the pipeline due to thread switching, so CacheAbleFrame is needed
+    auto frame = Frame::getCacheAbleFrame(frame_in);
+    if (frame->getTrackType() == TrackVideo) {
+        // 视频时，遇到第一帧配置帧或关键帧则标记为gop开始处  [AUTO-TRANSLATED:66247aa8]
+        // When it is a video, if the first frame configuration frame or key frame is encountered, it is marked as the beginning of the GOP
+        auto video_key_pos = frame->keyFrame() || frame->configFrame();
+        _cost.onCache(frame->size(), video_key_pos && !_video_key_pos);
+        _ring->write(frame, video_key_pos && !_video_key_pos);
+        if (!frame->dropAble()) {
+            _video_key_pos = video_key_pos;
+        }
+    } else {
+        // 没有视频时，设置is_key为true，目的是关闭gop缓存  [AUTO-TRANSLATED:f3223755]
+        // When there is no video, set is_key to true to disable gop caching
+        _cost.onCache(frame->size(), !haveVideo());
+        _ring->write(frame, !haveVideo());
+    }
+}
+
 bool MultiMediaSourceMuxer::isEnabled(){
     GET_CONFIG(uint32_t, stream_none_reader_delay_ms, General::kStreamNoneReaderDelayMS);
     if (!_is_enable || _last_check.elapsedTime() > stream_none_reader_delay_ms) {
@@ -820,6 +962,9 @@ bool MultiMediaSourceMuxer::isEnabled(){
                      (_ts ? _ts->isEnabled() : false) ||
                      (_fmp4 ? _fmp4->isEnabled() : false) ||
                      (_ring ? (bool)_ring->readerCount() : false)  ||
+                     // 帧级gop缓存需持续更新，以便填充按需生成的协议
+                     // The frame level gop cache must keep updating to seed protocols generated on demand
+                     _demand_seed ||
                      (_hls ? _hls->isEnabled() : false) ||
                      (_hls_fmp4 ? _hls_fmp4->isEnabled() : false) ||
                      _mp4;
@@ -205,8 +205,23 @@ public:
      */
     std::shared_ptr<MultiMediaSourceMuxer> getMuxer(MediaSource &sender) const override;
 
+    /**
+     * 从帧级gop缓存重建被淘汰的协议gop缓存
+     * Rebuild the evicted protocol gop cache from the frame level gop cache
+     */
+    bool rebuildGopCache(MediaSource &sender) override;
+
+    /**
+     * 观看人数变化，按需生成的协议被激活时用帧级gop缓存填充
+     * Reader count changed, protocols generated on demand are seeded from the frame level gop cache when activated
+     */
+    void onReaderChanged(MediaSource &sender, int size) override;
+
     const ProtocolOption &getOption() const;
     const MediaTuple &getMediaTuple() const;
+    // 获取复用与gop缓存的开销统计
+    // Get the cost accounting of muxing and the gop cache
+    MediaCost &getCost() { return _cost; }
     std::string shortUrl() const;
 #if defined(ENABLE_RTPPROXY)
     void forEachRtpSender(const std::function<void(const std::string &ssrc, const RtpSender &sender)> &cb) const;
@@ -245,20 +260,32 @@ protected:
     bool onTrackFrame(const Frame::Ptr &frame) override;
     bool onTrackFrame_l(const Frame::Ptr &frame);
 
+    /**
+     * 批量输出帧，每个协议复用器每批只调用一次
+     * Output a batch of frames, every protocol muxer is called once per batch
+     */
+    bool onTrackFrames(const Frame::Ptr *frames, size_t size) override;
+    bool onTrackFrames_l(const Frame::Ptr *frames, size_t size);
+
 private:
     void createGopCacheIfNeed(size_t gop_count);
+    std::list<Frame::Ptr> getLastGop() const;
+    void seedGop();
+    void writeGopCache(const Frame::Ptr &frame);
     std::shared_ptr<MediaSinkInterface> makeRecorder(MediaSource &sender, Recorder::type type);
 
 private:
     bool _is_enable = false;
     bool _create_in_poller = false;
     bool _video_key_pos = false;
+    bool _demand_seed = false;
     float _dur_sec;
     std::shared_ptr<class FramePacedSender> _paced_sender;
     MediaTuple _tuple;
     ProtocolOption _option;
     toolkit::Ticker _last_check;
     std::unordered_map<int, Stamp> _stamps;
+    std::vector<Frame::Ptr> _stamped_frames;
     std::weak_ptr<Listener> _track_listener;
 #if defined(ENABLE_RTPPROXY)
     std::unordered_multimap<std::string, std::tuple<RingType::RingReader::Ptr, std::weak_ptr<RtpSender>>> _rtp_sender;
@@ -272,10 +299,13 @@ private:
     HlsFMP4Recorder::Ptr _hls_fmp4;
     toolkit::EventPoller::Ptr _poller;
     RingType::Ptr _ring;
+    // _ring为帧级gop缓存
+    // _ring is the frame level gop cache
+    MediaCost _cost { true };
 
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     // Object count statistics
-    toolkit::ObjectStatistic<MultiMediaSourceMuxer> _statistic;
+    ObjectCounter<MultiMediaSourceMuxer> _statistic;
 };
 
 }//namespace mediakit
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "PacketArena.h"
+#include "Metrics.h"
+
+using namespace std;
+
+namespace mediakit {
+
+constexpr size_t PacketArenaBase::kClassCount;
+
+static constexpr size_t kClassSize[PacketArenaBase::kClassCount] = { 0, 512, 2 * 1024, 8 * 1024, 32 * 1024, 128 * 1024, 512 * 1024 };
+// 超过该容量的对象不缓存
+// Objects with a larger capacity are not cached
+static constexpr size_t kMaxCachedCapacity = 1024 * 1024;
+// 每个线程每个级别缓存的内存上限
+// Memory limit cached per thread per class
+static constexpr size_t kMaxCachedBytes = 1024 * 1024;
+
+// 各容量级别的统计指标，热路径上只修改本线程的分片
+// Metrics of each capacity class, the hot path only touches the shard of its own thread
+struct ArenaMetrics {
+    ArenaMetrics(const char *labels)
+        : obtain("zlm_packet_arena_obtains_total", "Packet arena obtains", Metric::Counter, labels)
+        , hit("zlm_packet_arena_hits_total", "Packet arena obtains served from the arena", Metric::Counter, labels)
+        , fallback("zlm_packet_arena_fallbacks_total", "Packet arena fresh allocations because the arena was empty", Metric::Counter, labels)
+        , recycle("zlm_packet_arena_recycles_total", "Packet arena releases cached into the arena", Metric::Counter, labels)
+        , drop("zlm_packet_arena_drops_total", "Packet arena releases freed directly", Metric::Counter, labels)
+        , live_bytes("zlm_packet_arena_live_bytes", "Bytes of idle memory kept alive in the packet arena", Metric::Gauge, labels) {}
+
+    Metric obtain;
+    Metric hit;
+    Metric fallback;
+    Metric recycle;
+    Metric drop;
+    Metric live_bytes;
+};
+
+static ArenaMetrics s_metrics[PacketArenaBase::kClassCount] = {
+    { "class=\"0\"" }, { "class=\"512\"" }, { "class=\"2k\"" }, { "class=\"8k\"" }, { "class=\"32k\"" }, { "class=\"128k\"" }, { "class=\"512k\"" }
+};
+
+size_t PacketArenaBase::floorClass(size_t capacity) {
+    if (capacity > kMaxCachedCapacity) {
+        return kClassCount;
+    }
+    for (size_t i = kClassCount - 1; i > 0; --i) {
+        if (kClassSize[i] <= capacity) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+size_t PacketArenaBase::maxCachedCount(size_t cls) {
+    auto count = kMaxCachedBytes / MAX(kClassSize[cls], (size_t)4 * 1024);
+    return MAX(count, (size_t)2);
+}
+
+void PacketArenaBase::initCounters() {
+    // 创建本线程的指标分片
+    // Create the metric shard of this thread
+    s_metrics[0].obtain.add(0);
+}
+
+void PacketArenaBase::onObtain(size_t cls, bool hit, size_t capacity) {
+    auto &metrics = s_metrics[cls];
+    metrics.obtain.add();
+    if (hit) {
+        metrics.hit.add();
+        metrics.live_bytes.add(-(int64_t)capacity);
+    } else {
+        metrics.fallback.add();
+    }
+}
+
+void PacketArenaBase::onRecycle(size_t cls, bool cached, size_t capacity) {
+    auto &metrics = s_metrics[cls];
+    if (cached) {
+        metrics.recycle.add();
+        metrics.live_bytes.add(capacity);
+    } else {
+        metrics.drop.add();
+    }
+}
+
+void PacketArenaBase::onFree(size_t cls, size_t capacity) {
+    s_metrics[cls].live_bytes.add(-(int64_t)capacity);
+}
+
+vector<PacketArenaBase::Statistic> PacketArenaBase::getStatistic() {
+    vector<Statistic> ret(kClassCount);
+    for (size_t i = 0; i < kClassCount; ++i) {
+        auto &metrics = s_metrics[i];
+        ret[i] = Statistic { kClassSize[i],
+                             (uint64_t)metrics.obtain.value(),
+                             (uint64_t)metrics.hit.value(),
+                             (uint64_t)metrics.fallback.value(),
+                             (uint64_t)metrics.recycle.value(),
+                             (uint64_t)metrics.drop.value(),
+                             metrics.live_bytes.value() };
+    }
+    return ret;
+}
+
+} // namespace mediakit
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_PACKETARENA_H
+#define ZLMEDIAKIT_PACKETARENA_H
+
+#include <memory>
+#include <vector>
+#include "Common/config.h"
+
+namespace mediakit {
+
+/**
+ * 包内存池的容量分级与统计
+ * Capacity classes and statistics of the packet arena
+ */
+class PacketArenaBase {
+public:
+    // 容量分级个数
+    // Number of capacity classes
+    static constexpr size_t kClassCount = 7;
+
+    struct Statistic {
+        // 该级别的最小容量
+        // Min capacity of this class
+        size_t class_size;
+        // 申请次数
+        // Number of obtains
+        uint64_t obtain;
+        // 从内存池复用的次数
+        // Number of obtains served from the arena
+        uint64_t hit;
+        // 内存池为空时新分配的次数
+        // Number of fresh allocations because the arena was empty
+        uint64_t fallback;
+        // 释放时缓存进内存池的次数
+        // Number of releases cached into the arena
+        uint64_t recycle;
+        // 释放时因内存池已满或容量过大而直接释放的次数
+        // Number of releases freed directly because the arena was full or the capacity was too large
+        uint64_t drop;
+        // 内存池中缓存的空闲内存字节数
+        // Bytes of idle memory kept alive in the arena
+        int64_t live_bytes;
+    };
+
+    /**
+     * 获取所有线程汇总的各容量级别统计
+     * Get the statistics of each capacity class summed over all threads
+     */
+    static std::vector<Statistic> getStatistic();
+
+protected:
+    // 容量所属的级别：容量不大于capacity的最大级别，容量过大不缓存时返回kClassCount
+    // Class of a capacity: the largest class whose size is not greater than capacity, kClassCount if it is too large to cache
+    static size_t floorClass(size_t capacity);
+    // 每个线程每个级别最多缓存的对象个数
+    // Max objects cached per thread per class
+    static size_t maxCachedCount(size_t cls);
+
+    // 确保本线程的统计计数器先于内存池创建(从而晚于其析构)
+    // Make sure the counters of this thread are created before (and thus destroyed after) the arena caches
+    static void initCounters();
+    static void onObtain(size_t cls, bool hit, size_t capacity);
+    static void onRecycle(size_t cls, bool cached, size_t capacity);
+    static void onFree(size_t cls, size_t capacity);
+};
+
+/**
+ * 包对象的容量获取与重置方式，默认使用getCapacity()与clear()
+ * How to get the capacity of a packet object and reset it, getCapacity() and clear() by default
+ */
+template <typename C>
+struct PacketArenaTraits {
+    static size_t capacity(const C &obj) { return obj.getCapacity(); }
+    static void reset(C &obj) { obj.clear(); }
+};
+
+/**
+ * 每线程(每EventPoller)的包内存池
+ * 对象释放时按其缓存容量分级缓存在释放线程中(环形缓冲读取器释放包时即回收到其所在线程)，申请时按期望容量复用，避免热路径上的堆分配
+ * Per thread (per EventPoller) packet arena
+ * A released object is cached by the capacity class of its buffer in the releasing thread (packets are recycled into the thread
+ * of the ring reader that releases them), and reused by the expected capacity, avoiding heap allocations on the hot path
+ */
+template <typename C>
+class PacketArena : public PacketArenaBase {
+public:
+    using Ptr = std::shared_ptr<C>;
+
+    /**
+     * 申请对象
+     * @param capacity 期望的缓存容量，0代表未知
+     * Obtain an object
+     * @param capacity Expected buffer capacity, 0 means unknown
+     */
+    static Ptr obtain(size_t capacity = 0) {
+        GET_CONFIG(bool, enable, General::kPacketArena);
+        if (!enable) {
+            return Ptr(new C);
+        }
+        auto cls = floorClass(capacity);
+        auto &cache = getCache();
+        C *obj = nullptr;
+        if (!capacity) {
+            // 未知容量时从最小级别开始找任意空闲对象
+            // With unknown capacity take any idle object starting from the smallest class
+            for (auto &free_list : cache.free_list) {
+                if ((obj = take(free_list))) {
+                    break;
+                }
+            }
+        } else if (cls < kClassCount) {
+            // 优先使用同级别中容量足够的对象，其次是高一级的对象，最后才用同级别容量不足的对象(只需扩容缓存)
+            // Prefer an object of the same class that is large enough, then one from the next class,
+            // and finally a smaller one of the same class (only its buffer needs to grow)
+            auto &free_list = cache.free_list[cls];
+            if (!free_list.empty() && PacketArenaTraits<C>::capacity(*free_list.back()) >= capacity) {
+                obj = take(free_list);
+            }
+            if (!obj && cls + 1 < kClassCount) {
+                obj = take(cache.free_list[cls + 1]);
+            }
+            if (!obj) {
+                obj = take(free_list);
+            }
+        }
+        onObtain(MIN(cls, kClassCount - 1), obj != nullptr, obj ? PacketArenaTraits<C>::capacity(*obj) : 0);
+        if (!obj) {
+            obj = new C;
+        }
+        return Ptr(obj, [](C *ptr) { recycle(ptr); });
+    }
+
+private:
+    struct Cache {
+        std::vector<C *> free_list[kClassCount];
+
+        Cache() { initCounters(); }
+
+        ~Cache() {
+            s_destroyed = true;
+            for (size_t i = 0; i < kClassCount; ++i) {
+                for (auto obj : free_list[i]) {
+                    onFree(i, PacketArenaTraits<C>::capacity(*obj));
+                    delete obj;
+                }
+            }
+        }
+    };
+
+    static Cache &getCache() {
+        static thread_local Cache s_cache;
+        return s_cache;
+    }
+
+    static C *take(std::vector<C *> &free_list) {
+        if (free_list.empty()) {
+            return nullptr;
+        }
+        auto ret = free_list.back();
+        free_list.pop_back();
+        return ret;
+    }
+
+    static void recycle(C *ptr) {
+        if (s_destroyed) {
+            // 线程正在退出
+            // The thread is exiting
+            delete ptr;
+            return;
+        }
+        PacketArenaTraits<C>::reset(*ptr);
+        auto capacity = PacketArenaTraits<C>::capacity(*ptr);
+        auto cls = floorClass(capacity);
+        if (cls >= kClassCount) {
+            onRecycle(kClassCount - 1, false, capacity);
+            delete ptr;
+            return;
+        }
+        auto &free_list = getCache().free_list[cls];
+        if (free_list.size() >= maxCachedCount(cls)) {
+            onRecycle(cls, false, capacity);
+            delete ptr;
+            return;
+        }
+        onRecycle(cls, true, capacity);
+        free_list.emplace_back(ptr);
+    }
+
+private:
+    static thread_local bool s_destroyed;
+};
+
+template <typename C>
+thread_local bool PacketArena<C>::s_destroyed = false;
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_PACKETARENA_H
@@ -11,22 +11,100 @@
 #ifndef ZLMEDIAKIT_PACKET_CACHE_H_
 #define ZLMEDIAKIT_PACKET_CACHE_H_
 
+#include <atomic>
 #include "Common/config.h"
+#include "Common/PacketArena.h"
 #include "Util/List.h"
 
 namespace mediakit {
+
+// 包缓存列表回收进内存池时清空，及时释放其中的包
+// The packet list is cleared when recycled into the arena, releasing the packets in it promptly
+template <typename T>
+struct PacketArenaTraits<toolkit::List<T> > {
+    static size_t capacity(const toolkit::List<T> &) { return 0; }
+    static void reset(toolkit::List<T> &obj) { obj.clear(); }
+};
+
 // / 缓存刷新策略类  [AUTO-TRANSLATED:bd941d15]
 // / Cache refresh strategy class
 class FlushPolicy {
 public:
+    struct Statistic {
+        // 合并写刷新次数
+        // Number of merge write flushes
+        uint64_t flushes;
+        // 刷新的包总数
+        // Total number of packets flushed
+        uint64_t packets;
+    };
+
     bool isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size);
 
+    /**
+     * 获取当前合并写时长，单位毫秒，小于等于0代表不合并写
+     * Get the current merge write window in milliseconds, no merge write if it is not greater than 0
+     */
+    int getMergeWriteMS() const;
+
+    // 以下接口供自适应策略使用，默认策略忽略之
+    // The following hooks are used by the adaptive policy, the default policy ignores them
+    void onPacket(size_t bytes, uint64_t stamp) {}
+    void setReaderCount(int size) {}
+    void setMergeWriteMS(int ms) {}
+
+    /**
+     * 记录一次刷新，用于统计平均每次合并写的包数
+     * Record a flush, used for the average packets per merge write
+     */
+    static void onFlushed(size_t packets);
+
+    /**
+     * 获取全局的合并写统计
+     * Get the global merge write statistics
+     */
+    static Statistic getStatistic();
+
+protected:
+    bool isFlushAble_l(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size, int merge_ms);
+
 private:
     // 音视频的最后时间戳  [AUTO-TRANSLATED:957d18ed]
     // Last timestamp of audio and video
     uint64_t _last_stamp[2] = { 0, 0 };
 };
 
+/**
+ * 自适应合并写策略
+ * 只有一个观看者时不合并写(逐帧刷新)以获得最低延时；观看者越多、码率越高，合并写时长越长(最大general.mergeWriteMaxMS)，
+ * 以减少系统调用与环形缓冲分发次数；ProtocolOption::merge_write_ms不小于0时按流固定合并写时长
+ * Adaptive merge write policy
+ * With a single reader nothing is merged (flush per frame) for the lowest latency; the window grows with the reader count
+ * and bitrate (up to general.mergeWriteMaxMS) to save syscalls and ring dispatches; a non-negative
+ * ProtocolOption::merge_write_ms fixes the window for the stream
+ */
+class AdaptiveFlushPolicy : public FlushPolicy {
+public:
+    bool isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size);
+    int getMergeWriteMS() const;
+    void onPacket(size_t bytes, uint64_t stamp);
+    void setReaderCount(int size) { _reader_count = size; }
+    void setMergeWriteMS(int ms) { _merge_write_ms = ms; }
+
+private:
+    // 按流设置的合并写时长，-1代表使用全局配置
+    // Merge write window set per stream, -1 means following the global config
+    std::atomic<int> _merge_write_ms { -1 };
+    // 环形缓冲回调线程中修改
+    // Modified in the ring buffer callback thread
+    std::atomic<int> _reader_count { 0 };
+    // 码率估算，单位kbps
+    // Bitrate estimation, in kbps
+    uint64_t _bitrate_kbps = 0;
+    uint64_t _window_stamp = 0;
+    uint64_t _window_bytes = 0;
+};
+
 // / 合并写缓存模板  [AUTO-TRANSLATED:25cde944]
 // / Merge write cache template
 // / \tparam packet 包类型  [AUTO-TRANSLATED:43085d9b]
@@ -38,11 +116,12 @@ private:
 template<typename packet, typename policy = FlushPolicy, typename packet_list = toolkit::List<std::shared_ptr<packet> > >
 class PacketCache {
 public:
-    PacketCache() { _cache = std::make_shared<packet_list>(); }
+    PacketCache() { _cache = PacketArena<packet_list>::obtain(); }
 
     virtual ~PacketCache() = default;
 
     void inputPacket(uint64_t stamp, bool is_video, std::shared_ptr<packet> pkt, bool key_pos) {
+        _policy.onPacket(pkt->size(), stamp);
         bool flag = flushImmediatelyWhenCloseMerge();
         if (!flag && _policy.isFlushAble(is_video, key_pos, stamp, _cache->size())) {
             flush();
@@ -64,8 +143,11 @@ public:
         if (_cache->empty()) {
             return;
         }
+        policy::onFlushed(_cache->size());
         onFlush(std::move(_cache), _key_pos);
-        _cache = std::make_shared<packet_list>();
+        // 列表被所有环形缓冲读取器释放后回收到内存池复用
+        // The list is recycled into the arena after all ring readers release it
+        _cache = PacketArena<packet_list>::obtain();
         _key_pos = false;
     }
 
@@ -73,6 +155,22 @@ public:
         _cache->clear();
     }
 
+    /**
+     * 设置该流的合并写时长，-1代表使用全局配置
+     * Set the merge write window of this stream, -1 means following the global config
+     */
+    void setMergeWriteMS(int ms) {
+        _policy.setMergeWriteMS(ms);
+    }
+
+    /**
+     * 观看人数变化，供自适应策略使用
+     * Reader count changed, used by the adaptive policy
+     */
+    void setReaderCount(int size) {
+        _policy.setReaderCount(size);
+    }
+
     virtual void onFlush(std::shared_ptr<packet_list>, bool key_pos) = 0;
 
 private:
@@ -86,9 +184,8 @@ private:
         // 但是却对性能提升很大，这样做还是比较划算的  [AUTO-TRANSLATED:80eab719]
         // But it greatly improves performance, so it is still worthwhile to do so.
 
-        GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
         GET_CONFIG(int, rtspLowLatency, Rtsp::kLowLatency);
-        return std::is_same<packet, RtpPacket>::value ? rtspLowLatency : (mergeWriteMS <= 0);
+        return std::is_same<packet, RtpPacket>::value ? rtspLowLatency : (_policy.getMergeWriteMS() <= 0);
     }
 
 private:
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include "RingFanoutMonitor.h"
+#include "Common/config.h"
+#include "Util/util.h"
+#include "Poller/EventPoller.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+struct PollerFanoutCounter {
+    string name;
+    atomic<uint64_t> probes { 0 };
+    atomic<int64_t> pending { 0 };
+    atomic<uint64_t> last_delay_us { 0 };
+    atomic<uint64_t> max_delay_us { 0 };
+};
+
+static mutex s_mtx;
+static unordered_map<EventPoller *, shared_ptr<PollerFanoutCounter> > s_counters;
+
+static shared_ptr<PollerFanoutCounter> getCounter(const EventPoller::Ptr &poller) {
+    lock_guard<mutex> lck(s_mtx);
+    auto &ret = s_counters[poller.get()];
+    if (!ret) {
+        ret = std::make_shared<PollerFanoutCounter>();
+        ret->name = poller->getThreadName();
+    }
+    return ret;
+}
+
+void RingFanoutMonitor::onRingWrite() {
+    GET_CONFIG(uint32_t, probeMS, General::kRingFanoutProbeMS);
+    if (!probeMS) {
+        return;
+    }
+    // 每个发布线程独立限频
+    // Rate limited per publisher thread
+    static thread_local uint64_t s_last_probe = 0;
+    auto now = getCurrentMicrosecond(true);
+    if (now < s_last_probe + probeMS * 1000) {
+        return;
+    }
+    s_last_probe = now;
+
+    EventPollerPool::Instance().for_each([now](const TaskExecutor::Ptr &executor) {
+        auto poller = std::static_pointer_cast<EventPoller>(executor);
+        auto counter = getCounter(poller);
+        ++counter->probes;
+        ++counter->pending;
+        poller->async([counter, now]() {
+            --counter->pending;
+            auto delay = getCurrentMicrosecond(true) - now;
+            counter->last_delay_us = delay;
+            auto max_delay = counter->max_delay_us.load();
+            while (delay > max_delay && !counter->max_delay_us.compare_exchange_weak(max_delay, delay)) {}
+        }, false);
+    });
+}
+
+vector<RingFanoutMonitor::Statistic> RingFanoutMonitor::getStatistic() {
+    vector<Statistic> ret;
+    lock_guard<mutex> lck(s_mtx);
+    for (auto &pr : s_counters) {
+        auto &counter = *pr.second;
+        ret.emplace_back(Statistic { counter.name, counter.probes.load(), counter.pending.load(), counter.last_delay_us.load(),
+                                     counter.max_delay_us.exchange(0) });
+    }
+    return ret;
+}
+
+} // namespace mediakit
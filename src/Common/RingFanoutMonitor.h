@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_RINGFANOUTMONITOR_H
+#define ZLMEDIAKIT_RINGFANOUTMONITOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * 环形缓冲分发队列监控
+ * 环形缓冲每次写入时，对每个有读取器的EventPoller只切换一次线程(RingReaderDispatcher)，再由该线程分发给本线程的所有读取器；
+ * 热门流观看者很多时，各EventPoller任务队列中积压的分发任务决定了播放延时。
+ * 本类在媒体源合并写刷新时(按发布线程限频)向每个EventPoller投递一个探测任务，它与分发任务在同一队列中排队，
+ * 由此统计每个EventPoller的排队任务数与排队时延
+ * Ring buffer fan-out queue monitor
+ * On every ring write there is only one thread hop per EventPoller that has readers (RingReaderDispatcher), that thread
+ * then dispatches to all its local readers; for a hot stream with many viewers, the dispatch tasks queued in each
+ * EventPoller decide the playback latency.
+ * When a media source flushes (rate limited per publisher thread), this class posts a probe task to every EventPoller,
+ * which is queued behind the dispatch tasks, to measure the queue depth and the queuing delay of each EventPoller
+ */
+class RingFanoutMonitor {
+public:
+    struct Statistic {
+        // EventPoller线程名
+        // EventPoller thread name
+        std::string poller;
+        // 已投递的探测任务数
+        // Number of probe tasks posted
+        uint64_t probes;
+        // 尚在队列中未执行的探测任务数
+        // Number of probe tasks still queued
+        int64_t pending;
+        // 最近一次探测的排队时延，单位微秒
+        // Queuing delay of the last probe, in microseconds
+        uint64_t last_delay_us;
+        // 上次获取统计以来的最大排队时延，单位微秒
+        // Max queuing delay since the statistics were last read, in microseconds
+        uint64_t max_delay_us;
+    };
+
+    /**
+     * 媒体源向环形缓冲写入时调用，按general.ringFanoutProbeMS限频投递探测任务
+     * Called when a media source writes to its ring, probe tasks are posted at most once per general.ringFanoutProbeMS
+     */
+    static void onRingWrite();
+
+    /**
+     * 获取每个EventPoller的分发队列统计
+     * Get the fan-out queue statistics of every EventPoller
+     */
+    static std::vector<Statistic> getStatistic();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_RINGFANOUTMONITOR_H
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "UdpBatchReceiver.h"
+#include "Common/Metrics.h"
+#include "Util/uv_errno.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+static Metric s_datagrams("zlm_udp_batch_recv_datagrams_total", "Udp datagrams received by batch");
+static Metric s_batches("zlm_udp_batch_recv_batches_total", "Batches of udp batch receiving");
+
+UdpBatchReceiver::~UdpBatchReceiver() {
+    for (auto &sock : _sockets) {
+        // 去除循环引用
+        // Remove circular references
+        sock->setOnMultiRead(nullptr);
+    }
+}
+
+void UdpBatchReceiver::start(uint16_t port, const string &host, int recv_buf, const onCreateShardCB &cb) {
+    EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+        auto poller = static_pointer_cast<EventPoller>(executor);
+        auto sock = Socket::createSocket(poller, false);
+        // 所有socket都开启SO_REUSEPORT绑定同一端口，由内核按来源地址哈希分流
+        // All sockets bind the same port with SO_REUSEPORT, the kernel shards them by the source address hash
+        if (!sock->bindUdpSock(port, host, true)) {
+            throw std::runtime_error(StrPrinter << "绑定udp端口 " << host << ":" << port << " 失败:" << get_uv_errmsg(true));
+        }
+        // 随机端口时，其他socket复用第一个socket的端口
+        // With a random port, the other sockets reuse the port of the first one
+        port = sock->get_local_port();
+        if (recv_buf > 0) {
+            SockUtil::setRecvBuf(sock->rawFD(), recv_buf);
+        }
+
+        auto on_batch = cb(poller);
+        weak_ptr<Socket> weak_sock = sock;
+        sock->setOnMultiRead([weak_sock, on_batch](Buffer::Ptr *buf, struct sockaddr_storage *addr, size_t count) {
+            auto strong_sock = weak_sock.lock();
+            if (!strong_sock) {
+                return;
+            }
+            s_datagrams.add(count);
+            s_batches.add();
+            on_batch(strong_sock, buf, addr, count);
+        });
+        _sockets.emplace_back(std::move(sock));
+    });
+}
+
+uint16_t UdpBatchReceiver::getPort() const {
+    return _sockets.empty() ? 0 : _sockets.front()->get_local_port();
+}
+
+UdpBatchReceiver::Statistic UdpBatchReceiver::getStatistic() {
+    return Statistic { (uint64_t)s_datagrams.value(), (uint64_t)s_batches.value() };
+}
+
+} // namespace mediakit
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDPBATCHRECEIVER_H
+#define ZLMEDIAKIT_UDPBATCHRECEIVER_H
+
+#include <vector>
+#include <functional>
+#include "Network/Socket.h"
+
+namespace mediakit {
+
+/**
+ * udp批量接收器
+ * 每个EventPoller线程绑定一个SO_REUSEPORT的udp socket，由内核按来源地址把数据分派到固定的socket；
+ * 每个socket通过recvmmsg批量读取数据，并把整批数据一次交给上层处理，免去逐包分发的开销
+ * Udp batch receiver
+ * Binds one SO_REUSEPORT udp socket per EventPoller thread, the kernel steers datagrams to a fixed socket by source address;
+ * every socket reads datagrams in batches with recvmmsg and hands the whole batch to the upper layer at once,
+ * avoiding the per-packet dispatch cost
+ */
+class UdpBatchReceiver {
+public:
+    using Ptr = std::shared_ptr<UdpBatchReceiver>;
+
+    /**
+     * 批量数据回调，在socket所属的poller线程触发
+     * @param sock 收到数据的socket
+     * @param buf 数据包数组
+     * @param addr 来源地址数组
+     * @param count 数据包个数
+     * Batch data callback, triggered in the poller thread the socket belongs to
+     * @param sock The socket receiving the data
+     * @param buf Datagram array
+     * @param addr Source address array
+     * @param count Number of datagrams
+     */
+    using onBatchCB = std::function<void(const toolkit::Socket::Ptr &sock, toolkit::Buffer::Ptr *buf, struct sockaddr_storage *addr, size_t count)>;
+
+    /**
+     * 创建分片回调，每个poller线程的socket调用一次，返回该socket专属的批量数据回调
+     * Create shard callback, called once per poller thread socket, returns the batch data callback dedicated to that socket
+     */
+    using onCreateShardCB = std::function<onBatchCB(const toolkit::EventPoller::Ptr &poller)>;
+
+    struct Statistic {
+        // 收到的udp包个数
+        // Number of udp datagrams received
+        uint64_t datagrams;
+        // 收到的批次个数
+        // Number of batches received
+        uint64_t batches;
+    };
+
+    ~UdpBatchReceiver();
+
+    /**
+     * 开始监听，失败时抛异常
+     * @param port 本地端口，0时为随机端口
+     * @param host 绑定的本地网卡ip
+     * @param recv_buf socket接收缓存大小，小于等于0时不设置
+     * @param cb 创建分片回调
+     * Start listening, throws an exception on failure
+     * @param port Local port, 0 for a random port
+     * @param host Local network interface ip to bind
+     * @param recv_buf Socket receive buffer size, not set when it is less than or equal to 0
+     * @param cb Create shard callback
+     */
+    void start(uint16_t port, const std::string &host, int recv_buf, const onCreateShardCB &cb);
+
+    /**
+     * 获取绑定的本地端口
+     * Get the bound local port
+     */
+    uint16_t getPort() const;
+
+    /**
+     * 获取全局的批量接收统计
+     * Get the global batch receive statistics
+     */
+    static Statistic getStatistic();
+
+private:
+    std::vector<toolkit::Socket::Ptr> _sockets;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDPBATCHRECEIVER_H
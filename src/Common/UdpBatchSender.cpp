@@ -0,0 +1,199 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include "UdpBatchSender.h"
+#include "Util/uv_errno.h"
+#include "Common/config.h"
+#include "Common/Metrics.h"
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 单次GSO最大分段个数与最大负载，参考内核UDP_MAX_SEGMENTS与ip包最大长度
+// Max segments and payload of one GSO send, see kernel UDP_MAX_SEGMENTS and the max ip packet size
+static constexpr size_t kMaxGSOSegments = 64;
+static constexpr size_t kMaxGSOBytes = 65000;
+
+static Metric s_packets("zlm_udp_batch_send_packets_total", "Udp packets sent by batch");
+static Metric s_syscalls("zlm_udp_batch_send_syscalls_total", "Syscalls of udp batch sending");
+static Metric s_gso_packets("zlm_udp_gso_packets_total", "Udp packets sent by GSO");
+// 内核或网卡不支持GSO时，全局关闭之
+// Globally disable GSO once the kernel or nic is found not to support it
+static atomic<bool> s_gso_unsupported { false };
+
+void UdpBatchSender::input(Buffer::Ptr buf) {
+    _batch.emplace_back(std::move(buf));
+}
+
+void UdpBatchSender::flush(const Socket::Ptr &sock, struct sockaddr *addr, int addr_len) {
+    if (_batch.empty()) {
+        return;
+    }
+    if (!sock) {
+        _batch.clear();
+        return;
+    }
+
+    auto size = _batch.size();
+    s_packets.add(size);
+
+    // 是否有通过Socket合并写但还未flush的包
+    // Whether there are packets queued to the Socket merged write but not flushed yet
+    bool queued = false;
+    size_t i = 0;
+    while (i < size) {
+        // 找出连续大小一致的一段包，最后一个包可以更小
+        // Find a run of equal-size packets, the last one may be smaller
+        auto seg_size = _batch[i]->size();
+        auto bytes = seg_size;
+        auto j = i + 1;
+        while (j < size && j - i < kMaxGSOSegments && bytes + seg_size <= kMaxGSOBytes && _batch[j]->size() == seg_size) {
+            bytes += seg_size;
+            ++j;
+        }
+        if (j < size && j - i < kMaxGSOSegments && bytes + _batch[j]->size() <= kMaxGSOBytes && _batch[j]->size() < seg_size) {
+            ++j;
+        }
+
+        if (j - i > 1) {
+            if (queued) {
+                // 先发送之前排队的包，保证包顺序
+                // Send previously queued packets first to keep the packet order
+                sock->flushAll();
+                s_syscalls.add();
+                queued = false;
+            }
+            auto ret = sendByGSO(sock, addr, addr_len, i, j);
+            if (ret == kFatal) {
+                _batch.clear();
+                return;
+            }
+            if (ret == kSent) {
+                s_syscalls.add();
+                s_gso_packets.add(j - i);
+                i = j;
+                continue;
+            }
+        }
+
+        for (; i < j; ++i) {
+            sock->send(std::move(_batch[i]), addr, addr_len, false);
+        }
+        queued = true;
+    }
+
+    if (queued) {
+        sock->flushAll();
+        s_syscalls.add();
+    }
+    _batch.clear();
+}
+
+UdpBatchSender::SendResult UdpBatchSender::sendByGSO(const Socket::Ptr &sock, struct sockaddr *addr, int addr_len, size_t begin, size_t end) {
+#if defined(__linux__)
+    GET_CONFIG(bool, enable_gso, Rtp::kUdpGSO);
+    // Socket还有未发出的数据时不能绕过它直接发送，否则会乱序
+    // Bypassing the Socket while it still holds unsent data would reorder packets
+    if (!enable_gso || s_gso_unsupported || sock->isSocketBusy() || sock->getSendBufferCount()) {
+        return kFallback;
+    }
+    if (!addr) {
+        addr = (struct sockaddr *)sock->get_peer_addr();
+        if (!addr) {
+            return kFallback;
+        }
+        addr_len = SockUtil::get_sock_len(addr);
+    }
+
+    // 把一段包拷贝到连续内存，由内核按分段大小切分
+    // Copy the run into contiguous memory, the kernel splits it by the segment size
+    static thread_local string s_buffer;
+    s_buffer.clear();
+    for (auto i = begin; i < end; ++i) {
+        s_buffer.append(_batch[i]->data(), _batch[i]->size());
+    }
+
+    uint16_t seg_size = _batch[begin]->size();
+    char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+    struct iovec iov;
+    iov.iov_base = (void *)s_buffer.data();
+    iov.iov_len = s_buffer.size();
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = addr;
+    msg.msg_namelen = addr_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cmsg), &seg_size, sizeof(seg_size));
+
+    auto ret = sendmsg(sock->rawFD(), &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (ret >= 0) {
+        _gso_total_bytes += ret;
+        _gso_speed += ret;
+        return kSent;
+    }
+    auto err = errno;
+    switch (err) {
+        case EINVAL:
+        case EIO:
+        case ENOPROTOOPT:
+        case EOPNOTSUPP:
+            s_gso_unsupported = true;
+            WarnL << "udp gso is not supported, fallback to sendmmsg: " << get_uv_errmsg(true);
+            return kFallback;
+        case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+        case EINTR:
+        case ENOBUFS:
+        // 对端不可达由icmp触发，udp socket仍然可用
+        // Unreachable peers are signalled by icmp, the udp socket is still usable
+        case ECONNREFUSED:
+        case EHOSTUNREACH:
+        case ENETUNREACH:
+            // 交给Socket合并写排队发送
+            // Let the Socket merged write queue them
+            return kFallback;
+        default:
+            // socket本身出错，通过Socket的错误回调通知上层，与Socket自身发送失败的处理一致
+            // The socket itself failed, report it to the upper layer through the Socket error callback, as the Socket does for its own send failures
+            sock->emitErr(SockException(Err_other, StrPrinter << "udp gso send failed: " << get_uv_errmsg(true), err));
+            return kFatal;
+    }
+#else
+    return kFallback;
+#endif
+}
+
+UdpBatchSender::Statistic UdpBatchSender::getStatistic() {
+    return Statistic { (uint64_t)s_packets.value(), (uint64_t)s_syscalls.value(), (uint64_t)s_gso_packets.value() };
+}
+
+} // namespace mediakit
@@ -0,0 +1,96 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDPBATCHSENDER_H
+#define ZLMEDIAKIT_UDPBATCHSENDER_H
+
+#include <vector>
+#include "Network/Socket.h"
+
+namespace mediakit {
+
+/**
+ * udp批量发送器
+ * 先缓存一批udp包，flush时连续大小一致的包在内核支持时使用UDP_SEGMENT(GSO)一次系统调用发出，
+ * 其他包交给Socket合并写(linux下为sendmmsg)
+ * Udp batch sender
+ * Buffers a batch of udp packets; on flush, runs of equal-size packets are sent with one UDP_SEGMENT (GSO)
+ * syscall when the kernel supports it, the others go through the Socket merged write (sendmmsg on linux)
+ */
+class UdpBatchSender {
+public:
+    struct Statistic {
+        // 发送的udp包个数
+        // Number of udp packets sent
+        uint64_t packets;
+        // 发送批次(系统调用)次数
+        // Number of send batches (syscalls)
+        uint64_t syscalls;
+        // 通过GSO发送的udp包个数
+        // Number of udp packets sent by GSO
+        uint64_t gso_packets;
+    };
+
+    /**
+     * 缓存一个待发送的udp包
+     * Buffer a udp packet to be sent
+     */
+    void input(toolkit::Buffer::Ptr buf);
+
+    /**
+     * 发送所有缓存的udp包
+     * @param sock udp socket
+     * @param addr 目标地址，为空时发送到socket绑定的对端地址
+     * @param addr_len 目标地址长度
+     * Send all buffered udp packets
+     * @param sock udp socket
+     * @param addr Destination address, the peer address bound on the socket is used when it is null
+     * @param addr_len Destination address length
+     */
+    void flush(const toolkit::Socket::Ptr &sock, struct sockaddr *addr = nullptr, int addr_len = 0);
+
+    /**
+     * 获取全局的批量发送统计
+     * Get the global batch send statistics
+     */
+    static Statistic getStatistic();
+
+    /**
+     * 获取通过GSO发送的速率与总字节数
+     * GSO直接调用sendmsg，不经过Socket的发送统计，上层需要与Socket的统计相加
+     * Get the speed and total bytes sent by GSO
+     * GSO calls sendmsg directly and bypasses the Socket send statistics, callers add these to the Socket ones
+     */
+    size_t getSendSpeed() const { return _gso_speed.getSpeed(); }
+    size_t getSendTotalBytes() const { return _gso_total_bytes; }
+
+private:
+    enum SendResult {
+        // 已通过GSO发出
+        // Sent by GSO
+        kSent,
+        // 未发送，交给Socket合并写
+        // Not sent, left to the Socket merged write
+        kFallback,
+        // socket出错，已通过Socket错误回调通知上层
+        // The socket failed and the error was reported through the Socket error callback
+        kFatal
+    };
+
+    SendResult sendByGSO(const toolkit::Socket::Ptr &sock, struct sockaddr *addr, int addr_len, size_t begin, size_t end);
+
+private:
+    size_t _gso_total_bytes = 0;
+    mutable toolkit::BytesSpeed _gso_speed;
+    std::vector<toolkit::Buffer::Ptr> _batch;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDPBATCHSENDER_H
@@ -88,6 +88,12 @@ const string kWaitAddTrackMS = GENERAL_FIELD "wait_add_track_ms";
 const string kUnreadyFrameCache = GENERAL_FIELD "unready_frame_cache";
 const string kBroadcastPlayerCountChanged = GENERAL_FIELD "broadcast_player_count_changed";
 const string kListenIP = GENERAL_FIELD "listen_ip";
+const string kPacketArena = GENERAL_FIELD "packet_arena";
+const string kMergeWriteAdaptive = GENERAL_FIELD "mergeWriteAdaptive";
+const string kMergeWriteMaxMS = GENERAL_FIELD "mergeWriteMaxMS";
+const string kRingFanoutProbeMS = GENERAL_FIELD "ringFanoutProbeMS";
+const string kEnableKTls = GENERAL_FIELD "enableKTls";
+const string kGopCacheMaxMB = GENERAL_FIELD "gopCacheMaxMB";
 
 static onceToken token([]() {
     mINI::Instance()[kFlowThreshold] = 1024;
@@ -105,6 +111,12 @@ static onceToken token([]() {
     mINI::Instance()[kUnreadyFrameCache] = 100;
     mINI::Instance()[kBroadcastPlayerCountChanged] = 0;
     mINI::Instance()[kListenIP] = "::";
+    mINI::Instance()[kPacketArena] = 1;
+    mINI::Instance()[kMergeWriteAdaptive] = 0;
+    mINI::Instance()[kMergeWriteMaxMS] = 300;
+    mINI::Instance()[kRingFanoutProbeMS] = 1000;
+    mINI::Instance()[kEnableKTls] = 0;
+    mINI::Instance()[kGopCacheMaxMB] = 0;
 });
 
 } // namespace General
@@ -116,6 +128,7 @@ const string kAddMuteAudio = string(kFieldName) + "add_mute_audio";
 const string kAutoClose = string(kFieldName) + "auto_close";
 const string kContinuePushMS = string(kFieldName) + "continue_push_ms";
 const string kPacedSenderMS = string(kFieldName) + "paced_sender_ms";
+const string kMergeWriteMS = string(kFieldName) + "merge_write_ms";
 
 const string kEnableHls = string(kFieldName) + "enable_hls";
 const string kEnableHlsFmp4 = string(kFieldName) + "enable_hls_fmp4";
@@ -136,6 +149,7 @@ const string kRtspDemand = string(kFieldName) + "rtsp_demand";
 const string kRtmpDemand = string(kFieldName) + "rtmp_demand";
 const string kTSDemand = string(kFieldName) + "ts_demand";
 const string kFMP4Demand = string(kFieldName) + "fmp4_demand";
+const string kDemandSeedGop = string(kFieldName) + "demand_seed_gop";
 
 static onceToken token([]() {
     mINI::Instance()[kModifyStamp] = (int)ProtocolOption::kModifyStampRelative;
@@ -143,6 +157,7 @@ static onceToken token([]() {
     mINI::Instance()[kAddMuteAudio] = 1;
     mINI::Instance()[kContinuePushMS] = 15000;
     mINI::Instance()[kPacedSenderMS] = 0;
+    mINI::Instance()[kMergeWriteMS] = -1;
     mINI::Instance()[kAutoClose] = 0;
 
     mINI::Instance()[kEnableHls] = 1;
@@ -164,6 +179,7 @@ static onceToken token([]() {
     mINI::Instance()[kRtmpDemand] = 0;
     mINI::Instance()[kTSDemand] = 0;
     mINI::Instance()[kFMP4Demand] = 0;
+    mINI::Instance()[kDemandSeedGop] = 0;
 });
 } // !Protocol
 
@@ -183,6 +199,7 @@ const string kForbidCacheSuffix = HTTP_FIELD "forbidCacheSuffix";
 const string kForwardedIpHeader = HTTP_FIELD "forwarded_ip_header";
 const string kAllowCrossDomains = HTTP_FIELD "allow_cross_domains";
 const string kAllowIPRange = HTTP_FIELD "allow_ip_range";
+const string kIoUring = HTTP_FIELD "ioUring";
 
 static onceToken token([]() {
     mINI::Instance()[kSendBufSize] = 64 * 1024;
@@ -207,6 +224,7 @@ static onceToken token([]() {
     mINI::Instance()[kForwardedIpHeader] = "";
     mINI::Instance()[kAllowCrossDomains] = 1;
     mINI::Instance()[kAllowIPRange] = "::1,127.0.0.1,172.16.0.0-172.31.255.255,192.168.0.0-192.168.255.255,10.0.0.0-10.255.255.255";
+    mINI::Instance()[kIoUring] = 1;
 });
 
 } // namespace Http
@@ -251,12 +269,14 @@ const string kHandshakeSecond = RTMP_FIELD "handshakeSecond";
 const string kKeepAliveSecond = RTMP_FIELD "keepAliveSecond";
 const string kDirectProxy = RTMP_FIELD "directProxy";
 const string kEnhanced = RTMP_FIELD "enhanced";
+const string kFlvShareMux = RTMP_FIELD "flvShareMux";
 
 static onceToken token([]() {
     mINI::Instance()[kHandshakeSecond] = 15;
     mINI::Instance()[kKeepAliveSecond] = 15;
     mINI::Instance()[kDirectProxy] = 1;
     mINI::Instance()[kEnhanced] = 1;
+    mINI::Instance()[kFlvShareMux] = 1;
 });
 } // namespace Rtmp
 
@@ -273,6 +293,8 @@ const string kAudioMtuSize = RTP_FIELD "audioMtuSize";
 const string kRtpMaxSize = RTP_FIELD "rtpMaxSize";
 const string kLowLatency = RTP_FIELD "lowLatency";
 const string kH264StapA = RTP_FIELD "h264_stap_a";
+const string kUdpGSO = RTP_FIELD "udpGSO";
+const string kAdaptiveJitterMS = RTP_FIELD "adaptiveJitterMS";
 
 static onceToken token([]() {
     mINI::Instance()[kVideoMtuSize] = 1400;
@@ -280,6 +302,8 @@ static onceToken token([]() {
     mINI::Instance()[kRtpMaxSize] = 10;
     mINI::Instance()[kLowLatency] = 0;
     mINI::Instance()[kH264StapA] = 1;
+    mINI::Instance()[kUdpGSO] = 0;
+    mINI::Instance()[kAdaptiveJitterMS] = 0;
 });
 } // namespace Rtp
 
@@ -338,6 +362,9 @@ const string kFileBufSize = HLS_FIELD "fileBufSize";
 const string kBroadcastRecordTs = HLS_FIELD "broadcastRecordTs";
 const string kDeleteDelaySec = HLS_FIELD "deleteDelaySec";
 const string kFastRegister = HLS_FIELD "fastRegister";
+const string kMemoryMode = HLS_FIELD "memoryMode";
+const string kMemoryMaxMB = HLS_FIELD "memoryMaxMB";
+const string kPartDuration = HLS_FIELD "partDur";
 
 static onceToken token([]() {
     mINI::Instance()[kSegmentDuration] = 2;
@@ -349,6 +376,9 @@ static onceToken token([]() {
     mINI::Instance()[kBroadcastRecordTs] = false;
     mINI::Instance()[kDeleteDelaySec] = 10;
     mINI::Instance()[kFastRegister] = false;
+    mINI::Instance()[kMemoryMode] = false;
+    mINI::Instance()[kMemoryMaxMB] = 1024;
+    mINI::Instance()[kPartDuration] = 0;
 });
 } // namespace Hls
 
@@ -367,6 +397,10 @@ const string kGopCache = RTP_PROXY_FIELD "gop_cache";
 const string kRtpG711DurMs = RTP_PROXY_FIELD "rtp_g711_dur_ms";
 const string kUdpRecvSocketBuffer = RTP_PROXY_FIELD "udp_recv_socket_buffer";
 const std::string kMergeFrame = RTP_PROXY_FIELD "merge_frame";
+const string kUdpBatchRecv = RTP_PROXY_FIELD "udp_batch_recv";
+const string kDemuxWorkers = RTP_PROXY_FIELD "demux_workers";
+const string kRedPT = RTP_PROXY_FIELD "red_pt";
+const string kUlpfecPT = RTP_PROXY_FIELD "ulpfec_pt";
 
 static onceToken token([]() {
     mINI::Instance()[kDumpDir] = "";
@@ -380,6 +414,10 @@ static onceToken token([]() {
     mINI::Instance()[kRtpG711DurMs] = 100;
     mINI::Instance()[kUdpRecvSocketBuffer] = 4 * 1024 * 1024;
     mINI::Instance()[kMergeFrame] = 1;
+    mINI::Instance()[kUdpBatchRecv] = 0;
+    mINI::Instance()[kDemuxWorkers] = 0;
+    mINI::Instance()[kRedPT] = 0;
+    mINI::Instance()[kUlpfecPT] = 0;
 });
 } // namespace RtpProxy
 
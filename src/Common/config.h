@@ -262,6 +262,26 @@ extern const std::string kBroadcastPlayerCountChanged;
 // 绑定的本地网卡ip  [AUTO-TRANSLATED:daa90832]
 // Bound local network card ip
 extern const std::string kListenIP;
+// 是否启用每线程的包内存池(RtmpPacket/RtpPacket/合并帧等按容量分级回收复用)
+// Whether to enable the per-thread packet arena (RtmpPacket/RtpPacket/merged frames etc. are recycled by capacity class)
+extern const std::string kPacketArena;
+// 是否根据观看人数与码率自适应调整合并写时长，开启后mergeWriteMS不再生效
+// Whether to adapt the merge write window to the reader count and bitrate, mergeWriteMS is ignored when enabled
+extern const std::string kMergeWriteAdaptive;
+// 自适应合并写的最大时长，单位毫秒
+// Max adaptive merge write window, in milliseconds
+extern const std::string kMergeWriteMaxMS;
+// 环形缓冲分发队列探测间隔，单位毫秒，置0关闭
+// Ring buffer fan-out queue probe interval, in milliseconds, set to 0 to disable
+extern const std::string kRingFanoutProbeMS;
+// 是否在ssl握手完成后开启内核TLS(kTLS)发送卸载，加密套件、协议版本或内核不支持时继续使用OpenSSL加密
+// Whether to enable kernel TLS (kTLS) transmit offload after the ssl handshake,
+// OpenSSL encryption goes on if the cipher, protocol version or kernel is not supported
+extern const std::string kEnableKTls;
+// 所有流的gop缓存总内存预算，单位MB，置0不限制；超出时按最近最少使用的顺序淘汰无人观看的流的协议gop缓存
+// Memory budget of the gop caches of all streams, in MB, 0 means unlimited; when exceeded the protocol gop caches are evicted
+// in least recently used order, streams without readers first
+extern const std::string kGopCacheMaxMB;
 } // namespace General
 
 namespace Protocol {
@@ -290,6 +310,9 @@ extern const std::string kContinuePushMS;
 // 该配置开启后可以解决一些流发送不平滑导致zlmediakit转发也不平滑的问题  [AUTO-TRANSLATED:0f2b1657]
 // Enabling this configuration can solve some problems where the stream is not sent smoothly, resulting in ZLMediaKit forwarding not being smooth
 extern const std::string kPacedSenderMS;
+// 合并写时长，单位毫秒，-1代表使用general.mergeWriteMS或自适应合并写，0代表不合并写
+// Merge write window, in milliseconds, -1 means following general.mergeWriteMS or the adaptive policy, 0 means no merge write
+extern const std::string kMergeWriteMS;
 
 // 是否开启转换为hls(mpegts)  [AUTO-TRANSLATED:bfc1167a]
 // Whether to enable conversion to HLS (MPEGTS)
@@ -334,6 +357,12 @@ extern const std::string kRtspDemand;
 extern const std::string kRtmpDemand;
 extern const std::string kTSDemand;
 extern const std::string kFMP4Demand;
+// 按需生成的协议被首个播放者激活时，是否用帧级gop缓存填充，使首个播放者秒开
+// 开启后即使无人观看也会持续解复用推流(但不转协议)，并缓存一个gop的帧
+// Whether protocols generated on demand are seeded from the frame level gop cache when activated by the first player,
+// so that the first player starts instantly. When enabled the pushed stream is always demuxed (but not muxed) even without readers,
+// and one gop of frames is cached
+extern const std::string kDemandSeedGop;
 } // !Protocol
 
 // //////////HTTP配置///////////  [AUTO-TRANSLATED:a281d694]
@@ -375,6 +404,9 @@ extern const std::string kAllowCrossDomains;
 // 允许访问http api和http文件索引的ip地址范围白名单，置空情况下不做限制  [AUTO-TRANSLATED:ab939863]
 // Whitelist of IP address ranges allowed to access HTTP API and HTTP file index. No restrictions are imposed when empty
 extern const std::string kAllowIPRange;
+// http文件服务器是否使用io_uring异步读文件(需要编译时开启ENABLE_IO_URING)
+// Whether the http file server reads files asynchronously with io_uring (ENABLE_IO_URING is required at build time)
+extern const std::string kIoUring;
 } // namespace Http
 
 // //////////SHELL配置///////////  [AUTO-TRANSLATED:f023ec45]
@@ -436,6 +468,9 @@ extern const std::string kDirectProxy;
 // h265-rtmp是否采用增强型(或者国内扩展)  [AUTO-TRANSLATED:4a52d042]
 // Whether h265-rtmp uses enhanced (or domestic extension)
 extern const std::string kEnhanced;
+// http-flv/ws-flv播放器是否共享同一个flv复用源(flv tag只封装一次)
+// Whether http-flv/ws-flv players share one flv muxing source (flv tags are framed only once)
+extern const std::string kFlvShareMux;
 } // namespace Rtmp
 
 // //////////RTP配置///////////  [AUTO-TRANSLATED:23cbcb86]
@@ -456,6 +491,13 @@ extern const std::string kLowLatency;
 // H264 rtp打包模式是否采用stap-a模式(为了在老版本浏览器上兼容webrtc)还是采用Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:30632378]
 // Whether H264 RTP packaging mode uses stap-a mode (for compatibility with webrtc on older browsers) or Single NAL unit packet per H.264 mode
 extern const std::string kH264StapA;
+// udp发送rtp时，连续大小一致的rtp是否使用UDP_SEGMENT(GSO)合并为一次系统调用，内核不支持时自动回退为sendmmsg
+// Whether runs of equal-size rtp are sent with one UDP_SEGMENT (GSO) syscall over udp, falls back to sendmmsg when unsupported
+extern const std::string kUdpGSO;
+// 推流(rtsp推流、国标)rtp排序窗口是否自适应，非0时为最短等待丢失包的时长(毫秒)，等待时长随观测到的乱序延时与深度调整
+// Whether the rtp sorting window of publishers (rtsp push, gb28181) is adaptive, when not 0 it is the min time (ms) waited for a lost packet,
+// the waiting time follows the observed reordering delay and depth
+extern const std::string kAdaptiveJitterMS;
 } // namespace Rtp
 
 // //////////组播配置///////////  [AUTO-TRANSLATED:dc39b9d6]
@@ -525,6 +567,15 @@ extern const std::string kDeleteDelaySec;
 // 如果设置为1，则第一个切片长度强制设置为1个GOP  [AUTO-TRANSLATED:fbbb651d]
 // If set to 1, the length of the first slice is forced to be 1 GOP
 extern const std::string kFastRegister;
+// 直播hls切片与m3u8是否只保存在内存中并直接从内存回复http请求，开启segKeep时切片会异步落盘
+// Whether live hls segments and m3u8 are kept only in memory and served from memory, segments are written to disk asynchronously when segKeep is on
+extern const std::string kMemoryMode;
+// 内存模式下所有hls切片最多占用的内存(MB)，超过后新切片改为写磁盘，0为不限制
+// Max memory (MB) taken by all hls segments in memory mode, new segments are written to disk once exceeded, 0 for no limit
+extern const std::string kMemoryMaxMB;
+// 低延迟hls(LL-HLS)分片(part)时长，单位秒，0为关闭低延迟hls
+// Duration of low latency hls (LL-HLS) partial segments in seconds, 0 disables LL-HLS
+extern const std::string kPartDuration;
 } // namespace Hls
 
 // //////////Rtp代理相关配置///////////  [AUTO-TRANSLATED:7b285587]
@@ -565,6 +616,17 @@ extern const std::string kRtpG711DurMs;
 extern const std::string kUdpRecvSocketBuffer;
 // ps/ts解析后是否等待下一帧以判断本帧是否完整，开启后提高兼容性，但是可能增加延时
 extern const std::string kMergeFrame;
+// 单端口模式下是否批量接收udp数据(每个poller线程一个SO_REUSEPORT socket, recvmmsg批量读取并按批分发)
+// Whether to receive udp data in batches in single port mode (one SO_REUSEPORT socket per poller thread, batched recvmmsg reads dispatched per batch)
+extern const std::string kUdpBatchRecv;
+// 单端口模式下按ssrc把ps/ts解复用分散到多少个poller线程，0为关闭(在收到数据的线程处理)，开启后同时启用批量接收
+// Number of poller threads the ps/ts demuxing is spread over by ssrc in single port mode, 0 to disable (handled by the receiving thread),
+// batch receiving is enabled along with it
+extern const std::string kDemuxWorkers;
+// 国标推流red(rfc2198)与ulpfec(rfc5109)负载的pt，0为未使用
+// Payload types of red (rfc2198) and ulpfec (rfc5109) in gb28181 streams, 0 means unused
+extern const std::string kRedPT;
+extern const std::string kUlpfecPT;
 } // namespace RtpProxy
 
 /**
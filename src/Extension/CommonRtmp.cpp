@@ -26,7 +26,7 @@ bool CommonRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
     if (!_audio_flv_flags) {
         _audio_flv_flags = getAudioRtmpFlags(getTrack());
     }
-    auto rtmp = RtmpPacket::create();
+    auto rtmp = RtmpPacket::create(frame->size() - frame->prefixSize() + 1);
     // header
     rtmp->buffer.push_back(_audio_flv_flags);
     // data
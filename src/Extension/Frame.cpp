@@ -12,6 +12,7 @@
 #include "Common/Parser.h"
 #include "Common/Stamp.h"
 #include "Common/MediaSource.h"
+#include "Common/PacketArena.h"
 
 #if defined(ENABLE_MP4)
 #include "mov-format.h"
@@ -24,9 +25,9 @@
 using namespace std;
 using namespace toolkit;
 
-namespace toolkit {
-    StatisticImp(mediakit::Frame);
-    StatisticImp(mediakit::FrameImp);
+namespace mediakit {
+    ObjectCounterImp(Frame)
+    ObjectCounterImp(FrameImp)
 }
 
 namespace mediakit{
@@ -259,6 +260,18 @@ static bool isNeedMerge(CodecId codec){
     }
 }
 
+template <>
+struct PacketArenaTraits<FrameImp> {
+    static size_t capacity(const FrameImp &obj) { return obj._buffer.capacity(); }
+    static void reset(FrameImp &obj) {
+        obj._buffer.clear();
+        obj._codec_id = CodecInvalid;
+        obj._prefix_size = 0;
+        obj._dts = 0;
+        obj._pts = 0;
+    }
+};
+
 bool FrameMerger::inputFrame(const Frame::Ptr &frame, onOutput cb, BufferLikeString *buffer) {
     if (frame && !isNeedMerge(frame->getCodecId())) {
         cb(frame->dts(), frame->pts(), Frame::getCacheAbleFrame(frame), true);
@@ -272,12 +285,17 @@ bool FrameMerger::inputFrame(const Frame::Ptr &frame, onOutput cb, BufferLikeStr
         if (_frame_cache.size() != 1 || _type == mp4_nal_size || buffer) {
             // 在MP4模式下，一帧数据也需要在前添加nalu_size  [AUTO-TRANSLATED:4a7e5c20]
             // In MP4 mode, a frame of data also needs to add nalu_size in front.
-            BufferLikeString tmp;
-            BufferLikeString &merged = buffer ? *buffer : tmp;
-
+            FrameImp::Ptr pooled;
             if (!buffer) {
-                tmp.reserve(back->size() + 1024);
+                // 合并缓存从包内存池申请，帧被释放后回收复用
+                // The merge buffer is obtained from the packet arena, and recycled after the frame is released
+                pooled = PacketArena<FrameImp>::obtain(back->size() + 1024);
+                pooled->_buffer.reserve(back->size() + 1024);
+                pooled->_codec_id = back->getCodecId();
+                pooled->_dts = back->dts();
+                pooled->_pts = back->pts();
             }
+            BufferLikeString &merged = buffer ? *buffer : pooled->_buffer;
 
             _frame_cache.for_each([&](const Frame::Ptr &frame) {
                 doMerge(merged, frame);
@@ -285,7 +303,11 @@ bool FrameMerger::inputFrame(const Frame::Ptr &frame, onOutput cb, BufferLikeStr
                     have_key_frame = true;
                 }
             });
-            merged_frame = std::make_shared<BufferOffset<BufferLikeString> >(buffer ? merged : std::move(merged));
+            if (buffer) {
+                merged_frame = std::make_shared<BufferOffset<BufferLikeString> >(merged);
+            } else {
+                merged_frame = std::move(pooled);
+            }
         }
         cb(back->dts(), back->pts(), merged_frame, have_key_frame);
         _frame_cache.clear();
@@ -13,10 +13,13 @@
 
 #include <map>
 #include <mutex>
+#include <vector>
 #include <functional>
 #include "Util/List.h"
 #include "Util/TimeTicker.h"
+#include "Util/onceToken.h"
 #include "Common/Stamp.h"
+#include "Common/Metrics.h"
 #include "Network/Buffer.h"
 
 namespace mediakit {
@@ -306,9 +309,14 @@ public:
 private:
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     // Object count statistics
-    toolkit::ObjectStatistic<Frame> _statistic;
+    ObjectCounter<Frame> _statistic;
 };
 
+template <typename C>
+class PacketArena;
+template <typename C>
+struct PacketArenaTraits;
+
 class FrameImp : public Frame {
 public:
     using Ptr = std::shared_ptr<FrameImp>;
@@ -350,13 +358,19 @@ public:
 private:
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     // Object count statistics
-    toolkit::ObjectStatistic<FrameImp> _statistic;
+    ObjectCounter<FrameImp> _statistic;
 
 protected:
     friend class toolkit::ResourcePool_l<FrameImp>;
+    friend class PacketArena<FrameImp>;
     FrameImp() = default;
 };
 
+// FrameImp的缓存容量与重置方式，特化定义在Frame.cpp
+// Capacity and reset of a FrameImp in the packet arena, the specialization is defined in Frame.cpp
+template <>
+struct PacketArenaTraits<FrameImp>;
+
 // 包装一个指针成不可缓存的frame  [AUTO-TRANSLATED:c3e5d65e]
 // Wrap a pointer into a non-cacheable frame
 class FrameFromPtr : public Frame {
@@ -683,6 +697,18 @@ public:
      */
     virtual bool inputFrame(const Frame::Ptr &frame) = 0;
 
+    /**
+     * 批量写入帧数据，默认逐帧写入；帧数组仅在调用期间有效
+     * Write a batch of frames, they are written one by one by default; the frame array is only valid during the call
+     */
+    virtual bool inputFrames(const Frame::Ptr *frames, size_t size) {
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = inputFrame(frames[i]) ? true : ret;
+        }
+        return ret;
+    }
+
     /**
      * 刷新输出所有frame缓存
      * Flush all frame caches in the output
@@ -692,6 +718,94 @@ public:
     virtual void flush() {};
 };
 
+/**
+ * 帧批量写入器，begin后输入的帧被缓存，flush时通过inputFrames一次性写入下级；未begin时直接透传
+ * 用于一次输入产生多帧的场景(例如一次收到多个rtmp包)，减少下级逐帧的虚函数调用
+ * Frame batch writer, frames input after begin are cached and written to the next writer at once via inputFrames when flushed;
+ * they are passed through directly when not begun.
+ * Used when one input produces multiple frames (such as multiple rtmp packets received at once), to save per frame virtual calls downstream
+ */
+class FrameBatchWriter : public FrameWriterInterface {
+public:
+    using Ptr = std::shared_ptr<FrameBatchWriter>;
+
+    FrameBatchWriter(FrameWriterInterface::Ptr writer) : _writer(std::move(writer)) {}
+
+    /**
+     * 开始缓存帧
+     * Start caching frames
+     */
+    void begin() {
+        _batching = true;
+    }
+
+    /**
+     * 停止缓存但不写入，已缓存的帧在下次flush或透传时写入
+     * Stop caching without writing, the cached frames are written at the next flush or pass through
+     */
+    void end() {
+        _batching = false;
+    }
+
+    /**
+     * 设置当前输入帧的来源缓存，不可缓存的帧若引用该缓存，持有该缓存即可延迟使用，无需拷贝
+     * Set the source buffer of the frames being input, a non-cacheable frame referencing it can be kept by holding the buffer, without a copy
+     */
+    void setOwner(toolkit::Buffer::Ptr owner) {
+        _owner = std::move(owner);
+    }
+
+    bool inputFrame(const Frame::Ptr &frame) override {
+        if (_batching) {
+            if (frame->cacheAble()) {
+                _frames.emplace_back(frame);
+                return true;
+            }
+            if (_owner && frame->data() >= _owner->data() && frame->data() + frame->size() <= _owner->data() + _owner->size()) {
+                _frames.emplace_back(std::make_shared<FrameCacheAble>(frame, false, _owner));
+                return true;
+            }
+        }
+        // 未知来源的不可缓存帧不做拷贝，先写入已缓存的帧以保持帧序，再直接透传
+        // A non-cacheable frame of unknown source is not copied, the cached frames are written first to keep the order, then it is passed through
+        writeFrames();
+        return _writer->inputFrame(frame);
+    }
+
+    /**
+     * 批量写入缓存的帧并停止缓存
+     * Write the cached frames as a batch and stop caching
+     */
+    void flush() override {
+        _batching = false;
+        writeFrames();
+    }
+
+private:
+    void writeFrames() {
+        if (_frames.empty()) {
+            return;
+        }
+        std::vector<Frame::Ptr> frames;
+        frames.swap(_frames);
+        toolkit::onceToken token(nullptr, [&]() {
+            // 复用内存
+            // Reuse the memory
+            frames.clear();
+            if (_frames.empty()) {
+                _frames.swap(frames);
+            }
+        });
+        _writer->inputFrames(frames.data(), frames.size());
+    }
+
+private:
+    bool _batching = false;
+    toolkit::Buffer::Ptr _owner;
+    FrameWriterInterface::Ptr _writer;
+    std::vector<Frame::Ptr> _frames;
+};
+
 /**
  * 支持代理转发的帧环形缓存
  * Frame circular buffer that supports proxy forwarding
@@ -13,6 +13,8 @@
 
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/RingFanoutMonitor.h"
+#include "Http/WebSocketSplitter.h"
 #include "Util/RingBuffer.h"
 
 #define FMP4_GOP_SIZE 512
@@ -21,7 +23,7 @@ namespace mediakit {
 
 // FMP4直播数据包  [AUTO-TRANSLATED:64f8a1d1]
 // FMP4 Live Data Packet
-class FMP4Packet : public toolkit::BufferString{
+class FMP4Packet : public toolkit::BufferString, public WebSocketFrameCache {
 public:
     using Ptr = std::shared_ptr<FMP4Packet>;
 
@@ -34,11 +36,14 @@ public:
 
 // FMP4直播源  [AUTO-TRANSLATED:15c43604]
 // FMP4 Live Source
-class FMP4MediaSource final : public MediaSource, public toolkit::RingDelegate<FMP4Packet::Ptr>, private PacketCache<FMP4Packet>{
+class FMP4MediaSource final : public MediaSource, public toolkit::RingDelegate<FMP4Packet::Ptr>, private PacketCache<FMP4Packet, AdaptiveFlushPolicy>{
 public:
     using Ptr = std::shared_ptr<FMP4MediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<FMP4Packet::Ptr> >;
     using RingType = toolkit::RingBuffer<RingDataType>;
+    // 设置该流的合并写时长(ProtocolOption::merge_write_ms)
+    // Set the merge write window of this stream (ProtocolOption::merge_write_ms)
+    using PacketCache<FMP4Packet, AdaptiveFlushPolicy>::setMergeWriteMS;
 
     FMP4MediaSource(const MediaTuple& tuple,
                     int ring_size = FMP4_GOP_SIZE) : MediaSource(FMP4_SCHEMA, tuple), _ring_size(ring_size) {}
@@ -118,7 +123,7 @@ public:
         }
         _speed[TrackVideo] += packet->size();
         auto stamp = packet->time_stamp;
-        PacketCache<FMP4Packet>::inputPacket(stamp, true, std::move(packet), key);
+        PacketCache<FMP4Packet, AdaptiveFlushPolicy>::inputPacket(stamp, true, std::move(packet), key);
     }
 
     /**
@@ -128,8 +133,9 @@ public:
      * [AUTO-TRANSLATED:d863f8c9]
      */
     void clearCache() override {
-        PacketCache<FMP4Packet>::clearCache();
+        PacketCache<FMP4Packet, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
+        _cost.onClearCache();
     }
 
 private:
@@ -140,6 +146,7 @@ private:
             if (!strong_self) {
                 return;
             }
+            strong_self->setReaderCount(size);
             strong_self->onReaderChanged(size);
         });
         if (!_init_segment.empty()) {
@@ -158,9 +165,12 @@ private:
      * [AUTO-TRANSLATED:6e93913e]
      */
     void onFlush(std::shared_ptr<toolkit::List<FMP4Packet::Ptr> > packet_list, bool key_pos) override {
-        // 如果不存在视频，那么就没有存在GOP缓存的意义，所以确保一直清空GOP缓存  [AUTO-TRANSLATED:66208f94]
-        // If there is no video, then there is no meaning to the existence of GOP cache, so make sure to clear the GOP cache all the time
-        _ring->write(std::move(packet_list), _have_video ? key_pos : true);
+        MediaCost::Scope scope(_cost, MediaCost::kFanout);
+        key_pos = onGopCacheWrite(*_ring, MediaCost::getBytes(*packet_list), _have_video, key_pos, _ring_size);
+        _ring->write(std::move(packet_list), key_pos);
+        if (_ring->readerCount()) {
+            RingFanoutMonitor::onRingWrite();
+        }
     }
 
 private:
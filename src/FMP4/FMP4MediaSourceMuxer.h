@@ -16,7 +16,7 @@
 
 namespace mediakit {
 
-class FMP4MediaSourceMuxer final : public MP4MuxerMemory, public MediaSourceEventInterceptor,
+class FMP4MediaSourceMuxer final : public MP4MuxerMemory, public MediaSourceEventInterceptor, public DemandGopSeeder,
                                    public std::enable_shared_from_this<FMP4MediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<FMP4MediaSourceMuxer>;
@@ -24,6 +24,7 @@ public:
     FMP4MediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) {
         _option = option;
         _media_src = std::make_shared<FMP4MediaSource>(tuple);
+        _media_src->setMergeWriteMS(option.merge_write_ms);
     }
 
     ~FMP4MediaSourceMuxer() override {
@@ -44,6 +45,7 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
+        onDemandReaderChanged(_option.fmp4_demand, _enabled, size);
         _enabled = _option.fmp4_demand ? size : true;
         if (!size && _option.fmp4_demand) {
             _clear_cache = true;
@@ -52,14 +54,22 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
+        return inputFrames(&frame, 1);
+    }
+
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override {
         if (_clear_cache && _option.fmp4_demand) {
             _clear_cache = false;
             _media_src->clearCache();
         }
-        if (_enabled || !_option.fmp4_demand) {
-            return MP4MuxerMemory::inputFrame(frame);
+        if (!_enabled && _option.fmp4_demand) {
+            return false;
+        }
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = MP4MuxerMemory::inputFrame(frames[i]) ? true : ret;
         }
-        return false;
+        return ret;
     }
 
     bool isEnabled() {
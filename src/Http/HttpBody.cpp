@@ -27,6 +27,8 @@
 #include "HttpBody.h"
 #include "HttpClient.h"
 #include "Common/macros.h"
+#include "Common/config.h"
+#include "Common/IoUringReader.h"
 
 using namespace std;
 using namespace toolkit;
@@ -201,6 +203,16 @@ HttpFileBody::HttpFileBody(const string &file_path, bool use_mmap) {
         return;
     }
 
+#if defined(ENABLE_IO_URING)
+    GET_CONFIG(bool, io_uring, Http::kIoUring);
+    // 使用io_uring异步读文件时不再mmap，避免冷数据的缺页中断阻塞poller线程
+    // No mmap when files are read asynchronously with io_uring, so page faults of cold data no longer block the poller thread
+    _use_io_uring = io_uring && IoUringReader::isSupported();
+    if (_use_io_uring) {
+        use_mmap = false;
+    }
+#endif
+
     if (use_mmap ) {
         _map_addr = getSharedMmap(file_path, _read_to);       
     }
@@ -312,6 +324,37 @@ Buffer::Ptr HttpFileBody::readData(size_t size) {
     return ret;
 }
 
+void HttpFileBody::readDataAsync(size_t size, const function<void(const Buffer::Ptr &buf)> &cb) {
+#if defined(ENABLE_IO_URING)
+    size = (size_t)(MIN(remainSize(), (int64_t)size));
+    auto reader = (_use_io_uring && _fp && size) ? IoUringReader::getCurrent() : nullptr;
+    if (reader) {
+        auto self = static_pointer_cast<HttpFileBody>(shared_from_this());
+        reader->read(fileno(_fp.get()), _file_offset, size, [self, size, cb](const Buffer::Ptr &buf, int err) {
+            if (buf) {
+                self->_file_offset += buf->size();
+                cb(buf);
+                return;
+            }
+            if (err == EBUSY) {
+                // 提交队列已满，退回同步读取
+                // The submission queue is full, fall back to a synchronous read
+                fseek64(self->_fp.get(), self->_file_offset, SEEK_SET);
+                cb(self->readData(size));
+                return;
+            }
+            // 读取文件异常，文件真实长度小于声明长度
+            // File reading exception, the actual length of the file is less than the declared length
+            WarnL << "read file err:" << (err ? strerror(err) : "end of file");
+            self->_file_offset = self->_read_to;
+            cb(nullptr);
+        });
+        return;
+    }
+#endif
+    HttpBody::readDataAsync(size, cb);
+}
+
 //////////////////////////////////////////////////////////////////
 
 HttpMultiFormBody::HttpMultiFormBody(const HttpArgs &args, const string &filePath, const string &boundary) {
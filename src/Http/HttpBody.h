@@ -163,9 +163,11 @@ public:
 
     int64_t remainSize() override;
     toolkit::Buffer::Ptr readData(size_t size) override;
+    void readDataAsync(size_t size, const std::function<void(const toolkit::Buffer::Ptr &buf)> &cb) override;
     int sendFile(int fd) override;
 
 private:
+    bool _use_io_uring = false;
     int64_t _read_to = 0;
     uint64_t _file_offset = 0;
     std::shared_ptr<FILE> _fp;
@@ -468,6 +468,73 @@ static string pathCat(const string &a, const string &b){
     return a + '/' + b;
 }
 
+/**
+ * 查找内存hls切片(hls.memoryMode开启时)
+ * @param media_info http url信息
+ * @param file_path 文件绝对路径
+ * @param segment_name 切片相对m3u8文件所在目录的路径
+ * @return 切片不在内存中时返回nullptr
+ * Find the in-memory hls segment (when hls.memoryMode or low latency hls is on)
+ * @param media_info http url information
+ * @param file_path Absolute file path
+ * @param segment_name Segment path relative to the directory of the m3u8 file
+ * @return nullptr if the segment is not in memory
+ */
+static HlsMediaSource::Ptr findHlsMemorySegment(const MediaInfo &media_info, const string &file_path, string &segment_name) {
+    GET_CONFIG(bool, memory_mode, Hls::kMemoryMode);
+    GET_CONFIG(float, part_duration, Hls::kPartDuration);
+    if (!memory_mode && part_duration <= 0) {
+        return nullptr;
+    }
+    // 切片位于m3u8所在目录的"日期/小时/"子目录下，init.mp4与延迟m3u8位于m3u8所在目录
+    // Segments are under the "date/hour/" sub directory of the m3u8 directory, init.mp4 and the delay m3u8 are in the m3u8 directory
+    string schema;
+    size_t depth;
+    if (end_with(file_path, "/init.mp4") || end_with(file_path, ".fmp4_delay.m3u8")) {
+        schema = HLS_FMP4_SCHEMA;
+        depth = 1;
+    } else if (end_with(file_path, "_delay.m3u8")) {
+        schema = HLS_SCHEMA;
+        depth = 1;
+    } else if (end_with(file_path, ".mp4")) {
+        schema = HLS_FMP4_SCHEMA;
+        depth = 3;
+    } else if (end_with(file_path, ".ts")) {
+        schema = HLS_SCHEMA;
+        depth = 3;
+    } else {
+        return nullptr;
+    }
+
+    auto &stream = media_info.stream;
+    auto pos = stream.size();
+    for (size_t i = 0; i < depth; ++i) {
+        if (pos == 0 || (pos = stream.rfind('/', pos - 1)) == string::npos) {
+            return nullptr;
+        }
+    }
+    auto hls = dynamic_pointer_cast<HlsMediaSource>(MediaSource::find(schema, media_info.vhost, media_info.app, stream.substr(0, pos)));
+    if (!hls) {
+        return nullptr;
+    }
+    segment_name = stream.substr(pos + 1);
+    // 低延迟hls预加载提示的分片也视为存在，请求会被挂起直到分片生成
+    // The low latency hls preload hint part is also treated as existing, its request is held until the part is generated
+    return hls->hasSegment(segment_name) ? hls : nullptr;
+}
+
+/**
+ * 查找内存hls的m3u8(hls.memoryMode开启时m3u8不写磁盘)
+ * Find the m3u8 of in-memory hls (the m3u8 is not written to disk when hls.memoryMode is on)
+ */
+static HlsMediaSource::Ptr findHlsMemoryPlaylist(const MediaInfo &media_info) {
+    GET_CONFIG(bool, memory_mode, Hls::kMemoryMode);
+    if (!memory_mode) {
+        return nullptr;
+    }
+    return dynamic_pointer_cast<HlsMediaSource>(MediaSource::find(media_info.schema, media_info.vhost, media_info.app, media_info.stream));
+}
+
 /**
  * 访问文件
  * @param sender 事件触发者
@@ -486,7 +553,9 @@ static string pathCat(const string &a, const string &b){
  */
 static void accessFile(Session &sender, const Parser &parser, const MediaInfo &media_info, const string &file_path, const HttpFileManager::invoker &cb) {
     bool is_hls = end_with(file_path, kHlsSuffix) || end_with(file_path, kHlsFMP4Suffix);
-    if (!is_hls && !File::fileExist(file_path)) {
+    string segment_name;
+    auto memory_src = is_hls ? nullptr : findHlsMemorySegment(media_info, file_path, segment_name);
+    if (!is_hls && !memory_src && !File::fileExist(file_path)) {
         // 文件不存在且不是hls,那么直接返回404  [AUTO-TRANSLATED:7aae578b]
         // The file does not exist and is not hls, so directly return 404
         sendNotFound(cb);
@@ -504,10 +573,29 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
         }
     }
 
+    // 低延迟hls阻塞请求与增量m3u8请求参数
+    // Low latency hls blocking request and delta m3u8 request params
+    int64_t hls_msn = -1;
+    int hls_part = -1;
+    bool hls_skip = false;
+    if (is_hls) {
+        auto &args = parser.getUrlArgs();
+        auto it = args.find("_HLS_msn");
+        if (it != args.end() && !it->second.empty()) {
+            hls_msn = atoll(it->second.data());
+            it = args.find("_HLS_part");
+            if (it != args.end() && !it->second.empty()) {
+                hls_part = atoi(it->second.data());
+            }
+        }
+        it = args.find("_HLS_skip");
+        hls_skip = it != args.end() && (it->second == "YES" || it->second == "v2");
+    }
+
     weak_ptr<Session> weakSession = static_pointer_cast<Session>(sender.shared_from_this());
     // 判断是否有权限访问该文件  [AUTO-TRANSLATED:b7f595f5]
     // Determine whether you have permission to access this file
-    canAccessPath(sender, parser, media_info, false, [cb, file_path, parser, is_hls, media_info, weakSession](const string &err_msg, const HttpServerCookie::Ptr &cookie) {
+    canAccessPath(sender, parser, media_info, false, [cb, file_path, parser, is_hls, media_info, weakSession, memory_src, segment_name, hls_msn, hls_part, hls_skip](const string &err_msg, const HttpServerCookie::Ptr &cookie) {
         auto strongSession = weakSession.lock();
         if (!strongSession) {
             // http客户端已经断开，不需要回复  [AUTO-TRANSLATED:9a252e21]
@@ -552,13 +640,54 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
             invoker.responseFile(parser.getHeader(), httpHeader, file_content.empty() ? file_path : file_content, !is_hls && !is_forbid_cache, file_content.empty());
         };
 
+        // 从内存获取m3u8索引文件(而不是从文件系统)
+        // Get the m3u8 index file from memory (instead of from the file system)
+        auto response_index = [response_file, cb, file_path, parser, hls_msn, hls_part, hls_skip](const HlsMediaSource::Ptr &src, const HttpServerCookie::Ptr &cookie) {
+            if (hls_msn >= 0 || hls_skip) {
+                // 低延迟hls阻塞请求，m3u8更新到指定切片或分片后再回复
+                // Low latency hls blocking request, replied after the m3u8 is updated to the requested segment or part
+                src->getIndexFile(hls_msn, hls_part, hls_skip, [response_file, file_path, cookie, cb, parser](const string &file) {
+                    response_file(cookie, cb, file_path, parser, file);
+                });
+                return;
+            }
+            response_file(cookie, cb, file_path, parser, src->getIndexFile());
+        };
+
+        if (memory_src) {
+            // 直接从内存回复hls切片，多个播放器共享同一份数据；预加载提示的分片会等待其生成后再回复
+            // Reply the hls segment directly from memory, all players share the same data; the preload hint part is replied after it is generated
+            memory_src->getSegment(segment_name, [cb, cookie, file_path](const Buffer::Ptr &memory_segment) {
+                if (!memory_segment) {
+                    sendNotFound(cb);
+                    return;
+                }
+                StrCaseMap httpHeader;
+                if (cookie) {
+                    auto &attach = cookie->getAttach<HttpCookieAttachment>();
+                    httpHeader["Set-Cookie"] = cookie->getCookie(attach._path);
+                    if (attach._hls_data) {
+                        attach._hls_data->addByteUsage(memory_segment->size());
+                    }
+                }
+                cb(200, HttpFileManager::getContentType(file_path.data()), httpHeader, std::make_shared<HttpBufferBody>(memory_segment));
+            });
+            return;
+        }
+
         if (!is_hls || !cookie) {
             // 不是hls或访问m3u8文件不带cookie, 直接回复文件或404  [AUTO-TRANSLATED:64e5d19b]
             // Not hls or accessing m3u8 files without cookies, directly reply to the file or 404
-            response_file(cookie, cb, file_path, parser);
             if (is_hls) {
                 WarnL << "access m3u8 file without cookie:" << file_path;
+                // 内存hls模式下磁盘上没有m3u8
+                // There is no m3u8 on disk in memory hls mode
+                if (auto memory_hls = findHlsMemoryPlaylist(media_info)) {
+                    response_index(memory_hls, cookie);
+                    return;
+                }
             }
+            response_file(cookie, cb, file_path, parser);
             return;
         }
 
@@ -567,19 +696,25 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
         if (src) {
             // 直接从内存获取m3u8索引文件(而不是从文件系统)  [AUTO-TRANSLATED:c772e342]
             // Get the m3u8 index file directly from memory (instead of from the file system)
-            response_file(cookie, cb, file_path, parser, src->getIndexFile());
+            response_index(src, cookie);
             return;
         }
         if (attach._find_src && attach._find_src_ticker.elapsedTime() < kFindSrcIntervalSecond * 1000) {
             // 最近已经查找过MediaSource了，为了防止频繁查找导致占用全局互斥锁的问题，我们尝试直接从磁盘返回hls索引文件  [AUTO-TRANSLATED:a33d5e4d]
             // MediaSource has been searched recently, in order to prevent frequent searches from occupying the global mutex, we try to return the hls index file directly from the disk
+            // 内存hls模式下磁盘上没有m3u8，只能从内存查找
+            // In memory hls mode there is no m3u8 on disk, so it can only be looked up in memory
+            if (auto memory_hls = findHlsMemoryPlaylist(media_info)) {
+                response_index(memory_hls, cookie);
+                return;
+            }
             response_file(cookie, cb, file_path, parser);
             return;
         }
 
         // hls流可能未注册，MediaSource::findAsync可以触发not_found事件，然后再按需推拉流  [AUTO-TRANSLATED:f4acd717]
         // The hls stream may not be registered, MediaSource::findAsync can trigger the not_found event, and then push and pull the stream on demand
-        MediaSource::findAsync(media_info, strongSession, [response_file, cookie, cb, file_path, parser](const MediaSource::Ptr &src) {
+        MediaSource::findAsync(media_info, strongSession, [response_file, cookie, cb, file_path, parser, hls_msn, hls_part, hls_skip](const MediaSource::Ptr &src) {
             auto hls = dynamic_pointer_cast<HlsMediaSource>(src);
             if (!hls) {
                 // 流不在线  [AUTO-TRANSLATED:5a6a5695]
@@ -603,7 +738,7 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
 
             // m3u8文件可能不存在, 等待m3u8索引文件按需生成  [AUTO-TRANSLATED:0dbd4df2]
             // The m3u8 file may not exist, wait for the m3u8 index file to be generated on demand
-            hls->getIndexFile([response_file, file_path, cookie, cb, parser](const string &file) {
+            hls->getIndexFile(hls_msn, hls_part, hls_skip, [response_file, file_path, cookie, cb, parser](const string &file) {
                 response_file(cookie, cb, file_path, parser, file);
             });
         });
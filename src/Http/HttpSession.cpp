@@ -12,6 +12,7 @@
 #include <sys/stat.h>
 #include <algorithm>
 #include "Common/config.h"
+#include "Common/Metrics.h"
 #include "Common/strCoding.h"
 #include "HttpSession.h"
 #include "HttpConst.h"
@@ -164,6 +165,7 @@ void HttpSession::onRecvContent(const char *data, size_t len) {
 
 void HttpSession::onRecv(const Buffer::Ptr &pBuf) {
     _ticker.resetTime();
+    Metrics::http.bytes_in.add(pBuf->size());
     input(pBuf->data(), pBuf->size());
 }
 
@@ -628,6 +630,9 @@ public:
 private:
     static void onRequestData(const AsyncSenderData::Ptr &data, const std::shared_ptr<HttpSession> &session, const Buffer::Ptr &sendBuf) {
         session->_ticker.resetTime();
+        if (sendBuf) {
+            Metrics::http.bytes_out.add(sendBuf->size());
+        }
         if (sendBuf && session->send(sendBuf) != -1) {
             // 文件还未读完，还需要继续发送  [AUTO-TRANSLATED:c454ca1a]
             // The file has not been read completely, and needs to be sent continuously
@@ -736,6 +741,7 @@ void HttpSession::sendResponse(int code,
         str += "\r\n";
     }
     str += "\r\n";
+    Metrics::http.bytes_out.add(str.size());
     SockSender::send(std::move(str));
     _ticker.resetTime();
 
@@ -848,8 +854,18 @@ void HttpSession::onWrite(const Buffer::Ptr &buffer, bool flush) {
     }
 
     _ticker.resetTime();
+    Metrics::http.packets_out.add();
     if (!_live_over_websocket) {
         _total_bytes_usage += buffer->size();
+        Metrics::http.bytes_out.add(buffer->size());
+        send(buffer);
+    } else if (auto cache = dynamic_cast<const WebSocketFrameCache *>(buffer.get())) {
+        // 环形缓冲中的共享数据包，所有ws播放器复用同一个帧头，帧头与负载作为两个缓存直接发送
+        // Shared ring packet, all ws players reuse the same frame header, the header and the payload are sent as two buffers directly
+        auto &frame_header = cache->getBinaryFrameHeader(buffer->size());
+        _total_bytes_usage += frame_header->size() + buffer->size();
+        Metrics::http.bytes_out.add(frame_header->size() + buffer->size());
+        send(frame_header);
         send(buffer);
     } else {
         WebSocketHeader header;
@@ -869,6 +885,7 @@ void HttpSession::onWrite(const Buffer::Ptr &buffer, bool flush) {
 
 void HttpSession::onWebSocketEncodeData(Buffer::Ptr buffer) {
     _total_bytes_usage += buffer->size();
+    Metrics::http.bytes_out.add(buffer->size());
     send(std::move(buffer));
 }
 
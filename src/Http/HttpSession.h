@@ -13,6 +13,7 @@
 
 #include <functional>
 #include "Network/Session.h"
+#include "Common/KTls.h"
 #include "Rtmp/FlvMuxer.h"
 #include "HttpRequestSplitter.h"
 #include "WebSocketSplitter.h"
@@ -180,7 +181,7 @@ private:
     std::function<bool (const char *data,size_t len) > _on_recv_body;
 };
 
-using HttpsSession = toolkit::SessionWithSSL<HttpSession>;
+using HttpsSession = SessionWithKTls<HttpSession>;
 
 } /* namespace mediakit */
 
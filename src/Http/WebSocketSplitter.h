@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include "Network/Buffer.h"
 
 // websocket组合包最大不得超过4MB(防止内存爆炸)  [AUTO-TRANSLATED:99c11a1d]
@@ -85,6 +86,29 @@ private:
     WebSocketHeader::Type _head_type;
 };
 
+/**
+ * 服务器端websocket二进制帧头的共享缓存
+ * 环形缓冲中的数据包继承该类后，其帧头(fin、BINARY、无掩码)只在第一个ws播放器发送时生成一次，
+ * 其他ws播放器直接复用该帧头与负载发送，无需逐连接重新编码
+ * Shared cache of the server side websocket binary frame header
+ * After a ring packet inherits this class, its frame header (fin, BINARY, unmasked) is generated only once when the first ws player
+ * sends it, other ws players reuse the header and the payload directly, so there is no per connection encoding any more
+ */
+class WebSocketFrameCache {
+public:
+    /**
+     * 获取服务器端二进制帧头，线程安全
+     * @param payload_len 负载长度，同一个数据包必须相同
+     * Get the server side binary frame header, thread safe
+     * @param payload_len Payload length, must be the same for the same packet
+     */
+    const toolkit::Buffer::Ptr &getBinaryFrameHeader(size_t payload_len) const;
+
+private:
+    mutable std::once_flag _once;
+    mutable toolkit::Buffer::Ptr _header;
+};
+
 class WebSocketSplitter : public WebSocketHeader{
 public:
     /**
@@ -115,6 +139,18 @@ public:
      */
     void encode(const WebSocketHeader &header,const toolkit::Buffer::Ptr &buffer);
 
+    /**
+     * 编码数据包头
+     * @param header 数据头
+     * @param len 负载长度
+     * @param out 编码后的数据包头
+     * Encode a data packet header
+     * @param header Data header
+     * @param len Payload length
+     * @param out Encoded data packet header
+     */
+    static void encodeHeader(const WebSocketHeader &header, uint64_t len, std::string &out);
+
 protected:
     /**
      * 收到一个webSocket数据包包头，后续将继续触发onWebSocketDecodePayload回调
@@ -23,6 +23,30 @@ HlsMaker::HlsMaker(bool is_fmp4, float seg_duration, uint32_t seg_number, bool s
     _seg_number = seg_number;
     _seg_duration = seg_duration;
     _seg_keep = seg_keep;
+    GET_CONFIG(float, partDuration, Hls::kPartDuration);
+    // 只有直播hls才支持低延迟hls
+    // Only live hls supports low latency hls
+    _part_duration = seg_number && partDuration > 0 ? partDuration : 0;
+}
+
+// 分片名为切片名加上分片序号，例如 12-30_5.part2.ts?params
+// The part name is the segment name plus the part index, e.g. 12-30_5.part2.ts?params
+static string makePartName(const string &segment_name, size_t part_index) {
+    auto params_pos = segment_name.find('?');
+    auto path = segment_name.substr(0, params_pos);
+    auto dot_pos = path.rfind('.');
+    if (dot_pos == string::npos) {
+        dot_pos = path.size();
+    }
+    auto ret = path.substr(0, dot_pos) + ".part" + to_string(part_index) + path.substr(dot_pos);
+    if (params_pos != string::npos) {
+        ret += segment_name.substr(params_pos);
+    }
+    return ret;
+}
+
+static string stripParams(const string &uri) {
+    return uri.substr(0, uri.find('?'));
 }
 
 void HlsMaker::makeIndexFile(bool include_delay, bool eof) {
@@ -87,6 +111,118 @@ void HlsMaker::makeIndexFile(bool include_delay, bool eof) {
     onWriteHls(index_str, include_delay);
 }
 
+void HlsMaker::makeLowLatencyIndexFile(bool eof) {
+    std::deque<std::tuple<int, std::string>> temp(_seg_dur_list);
+    while (temp.size() > _seg_number) {
+        temp.pop_front();
+    }
+    int maxSegmentDuration = _seg_duration * 1000;
+    for (auto &tp : temp) {
+        maxSegmentDuration = MAX(maxSegmentDuration, std::get<0>(tp));
+    }
+    auto target_duration = (maxSegmentDuration + 999) / 1000;
+    // 正在生成的切片序号，也就是已经完成的切片个数
+    // Sequence number of the segment in progress, which is also the number of finished segments
+    uint64_t msn = _last_file_name.empty() ? _file_index : _file_index - 1;
+    uint64_t index_seq = msn > temp.size() ? msn - temp.size() : 0;
+
+    auto write_parts = [](stringstream &ss, const std::vector<PartInfo> &parts) {
+        for (auto &part : parts) {
+            ss << "#EXT-X-PART:DURATION=" << part.duration / 1000.0 << ",URI=\"" << part.uri << "\"";
+            if (part.independent) {
+                ss << ",INDEPENDENT=YES";
+            }
+            ss << "\n";
+        }
+    };
+
+    // 增量m3u8可以跳过距离末尾超过CAN-SKIP-UNTIL的切片
+    // The delta m3u8 may skip the segments older than CAN-SKIP-UNTIL from the end
+    uint64_t skip_until = target_duration * 6 * 1000;
+    uint64_t remain = 0;
+    for (auto &tp : temp) {
+        remain += std::get<0>(tp);
+    }
+    for (auto &part : _cur_parts) {
+        remain += part.duration;
+    }
+    size_t skipped = 0;
+    for (auto &tp : temp) {
+        remain -= std::get<0>(tp);
+        if (remain < skip_until) {
+            break;
+        }
+        ++skipped;
+    }
+
+    stringstream head;
+    head << std::fixed << std::setprecision(3);
+    head << "#EXTM3U\n"
+         << "#EXT-X-VERSION:9\n"
+         << "#EXT-X-TARGETDURATION:" << target_duration << "\n"
+         << "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" << _part_duration * 3
+         << ",CAN-SKIP-UNTIL=" << (float)(skip_until / 1000) << "\n"
+         << "#EXT-X-PART-INF:PART-TARGET=" << _part_duration << "\n"
+         << "#EXT-X-MEDIA-SEQUENCE:" << index_seq << "\n";
+    if (_is_fmp4) {
+        head << "#EXT-X-MAP:URI=\"init.mp4\"\n";
+    }
+
+    stringstream full, delta;
+    full << std::fixed << std::setprecision(3);
+    delta << std::fixed << std::setprecision(3);
+    if (skipped) {
+        delta << "#EXT-X-SKIP:SKIPPED-SEGMENTS=" << skipped << "\n";
+    }
+    // 只有最近几个切片列出分片
+    // Only the latest segments list their parts
+    auto part_offset = (int64_t)temp.size() - (int64_t)_seg_part_list.size();
+    for (size_t i = 0; i < temp.size(); ++i) {
+        stringstream ss;
+        ss << std::fixed << std::setprecision(3);
+        if ((int64_t)i >= part_offset) {
+            write_parts(ss, _seg_part_list[i - part_offset]);
+        }
+        ss << "#EXTINF:" << std::get<0>(temp[i]) / 1000.0 << ",\n" << std::get<1>(temp[i]) << "\n";
+        auto item = ss.str();
+        full << item;
+        if (i >= skipped) {
+            delta << item;
+        }
+    }
+
+    stringstream tail;
+    tail << std::fixed << std::setprecision(3);
+    write_parts(tail, _cur_parts);
+    string preload_hint;
+    if (eof) {
+        tail << "#EXT-X-ENDLIST\n";
+    } else if (!_last_file_name.empty()) {
+        // 提示播放器提前请求下一个分片，该请求会被阻塞直到分片生成
+        // Hint the player to request the next part in advance, the request is held until the part is generated
+        auto uri = makePartName(_last_file_name, _cur_parts.size());
+        tail << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" << uri << "\"\n";
+        preload_hint = stripParams(uri);
+    }
+
+    auto head_str = head.str();
+    auto tail_str = tail.str();
+    onWriteLowLatencyHls(head_str + full.str() + tail_str, skipped ? head_str + delta.str() + tail_str : "", msn,
+                         (int)_cur_parts.size() - 1, preload_hint);
+}
+
+void HlsMaker::flushPart(uint64_t end_timestamp) {
+    if (!_part_has_data) {
+        return;
+    }
+    auto uri = makePartName(_last_file_name, _cur_parts.size());
+    onFlushPart(stripParams(uri));
+    auto duration = end_timestamp > _part_start_timestamp ? end_timestamp - _part_start_timestamp : 1;
+    _cur_parts.emplace_back(PartInfo { duration, std::move(uri), _part_independent });
+    _part_start_timestamp = end_timestamp;
+    _part_has_data = false;
+}
+
 void HlsMaker::inputInitSegment(const char *data, size_t len) {
     if (!_is_fmp4) {
         throw std::invalid_argument("Only fmp4-hls can input init segment");
@@ -101,6 +237,7 @@ void HlsMaker::inputData(const char *data, size_t len, uint64_t timestamp, bool
             // Timestamp has been rolled back, slice duration is recalculated
             WarnL << "Timestamp reduce: " << _last_timestamp << " -> " << timestamp;
             _last_seg_timestamp = _last_timestamp = timestamp;
+            _part_start_timestamp = MIN(_part_start_timestamp, timestamp);
         }
         if (is_idr_fast_packet) {
             // 尝试切片ts  [AUTO-TRANSLATED:62264109]
@@ -108,6 +245,18 @@ void HlsMaker::inputData(const char *data, size_t len, uint64_t timestamp, bool
             addNewSegment(timestamp);
         }
         if (!_last_file_name.empty()) {
+            if (_part_duration > 0) {
+                // 预估写入本数据后分片的时长，超过分片目标时长则先结束当前分片
+                // Estimate the part duration after writing this data, finish the current part first if it exceeds the part target
+                if (_part_has_data && timestamp * 2 - _last_timestamp - _part_start_timestamp > _part_duration * 1000) {
+                    flushPart(timestamp);
+                    makeLowLatencyIndexFile(false);
+                }
+                if (!_part_has_data) {
+                    _part_has_data = true;
+                    _part_independent = is_idr_fast_packet;
+                }
+            }
             // 存在切片才写入ts数据  [AUTO-TRANSLATED:ddd46115]
             // Write ts data only if there are slices
             onWriteSegment(data, len);
@@ -156,6 +305,13 @@ void HlsMaker::addNewSegment(uint64_t stamp) {
     // 记录本次切片的起始时间戳  [AUTO-TRANSLATED:8eb776e9]
     // Record the starting timestamp of this slice
     _last_seg_timestamp = _last_timestamp ? _last_timestamp : stamp;
+    if (_part_duration > 0) {
+        _part_start_timestamp = _last_seg_timestamp;
+        _part_has_data = false;
+        // 更新预加载提示为新切片的第一个分片
+        // Update the preload hint to the first part of the new segment
+        makeLowLatencyIndexFile(false);
+    }
 }
 
 void HlsMaker::flushLastSegment(bool eof){
@@ -171,6 +327,14 @@ void HlsMaker::flushLastSegment(bool eof){
     if (seg_dur <= 0) {
         seg_dur = 100;
     }
+    if (_part_duration > 0) {
+        flushPart(_last_timestamp);
+        _seg_part_list.emplace_back(std::move(_cur_parts));
+        _cur_parts.clear();
+        while (_seg_part_list.size() > kPartSegmentNum) {
+            _seg_part_list.pop_front();
+        }
+    }
     _seg_dur_list.emplace_back(seg_dur, std::move(_last_file_name));
     delOldSegment();
     // 先flush ts切片，否则可能存在ts文件未写入完毕就被访问的情况  [AUTO-TRANSLATED:f8d6dc87]
@@ -184,6 +348,9 @@ void HlsMaker::flushLastSegment(bool eof){
     if (segDelay) {
         makeIndexFile(true, eof);
     }
+    if (_part_duration > 0) {
+        makeLowLatencyIndexFile(eof);
+    }
 }
 
 bool HlsMaker::isLive() const {
@@ -198,12 +365,24 @@ bool HlsMaker::isFmp4() const {
     return _is_fmp4;
 }
 
+uint32_t HlsMaker::getSegmentNumber() const {
+    return _seg_number;
+}
+
+bool HlsMaker::isLowLatency() const {
+    return _part_duration > 0;
+}
+
 void HlsMaker::clear() {
     _file_index = 0;
     _last_timestamp = 0;
     _last_seg_timestamp = 0;
     _seg_dur_list.clear();
     _last_file_name.clear();
+    _part_has_data = false;
+    _part_start_timestamp = 0;
+    _cur_parts.clear();
+    _seg_part_list.clear();
 }
 
 }//namespace mediakit
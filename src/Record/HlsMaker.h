@@ -14,6 +14,7 @@
 #include <string>
 #include <deque>
 #include <tuple>
+#include <vector>
 #include <cstdint>
 
 namespace mediakit {
@@ -87,6 +88,18 @@ public:
      */
     bool isFmp4() const;
 
+    /**
+     * m3u8索引中保留的切片个数
+     * Number of segments kept in the m3u8 index
+     */
+    uint32_t getSegmentNumber() const;
+
+    /**
+     * 是否开启低延迟hls(LL-HLS)
+     * Whether low latency hls (LL-HLS) is enabled
+     */
+    bool isLowLatency() const;
+
     /**
      * 清空记录
      * Clear records
@@ -96,6 +109,10 @@ public:
     void clear();
 
 protected:
+    // 低延迟hls m3u8中列出分片的已完成切片个数
+    // Number of finished segments whose parts are listed in the low latency hls m3u8
+    static constexpr size_t kPartSegmentNum = 3;
+
     /**
      * 创建ts切片文件回调
      * @param index
@@ -160,6 +177,30 @@ protected:
      */
     virtual void onFlushLastSegment(uint64_t duration_ms) {};
 
+    /**
+     * 低延迟hls分片(part)写入完成回调，分片数据为上次回调以来onWriteSegment写入的数据
+     * @param name 分片相对m3u8文件所在目录的路径(不含url参数)
+     * Low latency hls partial segment finished callback, the part data is what onWriteSegment wrote since the last callback
+     * @param name Part path relative to the directory of the m3u8 file (without url params)
+     */
+    virtual void onFlushPart(const std::string &name) {};
+
+    /**
+     * 写低延迟hls m3u8回调
+     * @param index 完整m3u8
+     * @param delta 增量m3u8(带EXT-X-SKIP)，没有可跳过的切片时为空
+     * @param msn 正在生成的切片序号
+     * @param part 正在生成的切片中最后一个完成的分片序号，-1代表还没有分片
+     * @param preload_hint 预加载提示的分片路径(不含url参数)，可能为空
+     * Write low latency hls m3u8 callback
+     * @param index Full m3u8
+     * @param delta Delta m3u8 (with EXT-X-SKIP), empty if no segment can be skipped
+     * @param msn Media sequence number of the segment in progress
+     * @param part Index of the last finished part of the segment in progress, -1 if there is none yet
+     * @param preload_hint Path of the preload hint part (without url params), may be empty
+     */
+    virtual void onWriteLowLatencyHls(const std::string &index, const std::string &delta, uint64_t msn, int part, const std::string &preload_hint) {};
+
     /**
      * 关闭上个ts切片并且写入m3u8索引
      * @param eof HLS直播是否已结束
@@ -181,6 +222,20 @@ private:
      */
     void makeIndexFile(bool include_delay, bool eof = false);
 
+    /**
+     * 生成低延迟hls m3u8
+     * Generate the low latency hls m3u8
+     */
+    void makeLowLatencyIndexFile(bool eof);
+
+    /**
+     * 结束当前分片
+     * @param end_timestamp 分片结束时间戳
+     * Finish the current part
+     * @param end_timestamp End timestamp of the part
+     */
+    void flushPart(uint64_t end_timestamp);
+
     /**
      * 删除旧的ts切片
      * Delete old ts segments
@@ -209,6 +264,24 @@ private:
     uint64_t _file_index = 0;
     std::string _last_file_name;
     std::deque<std::tuple<int,std::string> > _seg_dur_list;
+
+    struct PartInfo {
+        uint64_t duration;
+        std::string uri;
+        bool independent;
+    };
+    // 分片目标时长(秒)，0代表关闭低延迟hls
+    // Part target duration in seconds, 0 means low latency hls is disabled
+    float _part_duration = 0;
+    bool _part_has_data = false;
+    bool _part_independent = false;
+    uint64_t _part_start_timestamp = 0;
+    // 正在生成的切片的分片
+    // Parts of the segment in progress
+    std::vector<PartInfo> _cur_parts;
+    // 最近几个已完成切片的分片，与_seg_dur_list尾部对齐
+    // Parts of the latest finished segments, aligned with the tail of _seg_dur_list
+    std::deque<std::vector<PartInfo> > _seg_part_list;
 };
 
 }//namespace mediakit
@@ -16,6 +16,7 @@
 #include "Util/uv_errno.h"
 #include "Util/File.h"
 #include "Common/config.h"
+#include "Thread/WorkThreadPool.h"
 
 using namespace std;
 using namespace toolkit;
@@ -40,6 +41,12 @@ HlsMakerImp::HlsMakerImp(bool is_fmp4, const string &m3u8_file, const string &pa
     _buf_size = bufSize;
     _file_buf.reset(new char[bufSize], [](char *ptr) { delete[] ptr; });
     _info.folder = _path_prefix;
+    _hls_delay_name = _path_hls_delay.substr(_path_hls_delay.rfind('/') + 1);
+
+    GET_CONFIG(bool, memory_mode, Hls::kMemoryMode);
+    // 只有直播hls才保存在内存中，点播(segNum=0)的切片会一直增长
+    // Only live hls is kept in memory, segments of vod (segNum=0) keep growing
+    _memory_mode = memory_mode && isLive();
 }
 
 HlsMakerImp::~HlsMakerImp() {
@@ -102,6 +109,14 @@ void HlsMakerImp::clearCache(bool immediately, bool eof) {
     clear();
     _file = nullptr;
     _segment_file_paths.clear();
+    _segment_in_memory = false;
+    _segment_data.clear();
+    _memory_segments.clear();
+    _part_data.clear();
+    _part_names.clear();
+    if (_media_src) {
+        _media_src->clearSegments();
+    }
 }
 
 /** 写入该目录的init.mp4文件以及m3u8文件 **/
@@ -144,6 +159,25 @@ void HlsMakerImp::saveCurrentDir() {
     File::saveFile(index_str, _path_prefix + "/" + _current_dir + (isFmp4() ? "vod.fmp4.m3u8" : "vod.m3u8"));
 }
 
+bool HlsMakerImp::exceedMemoryLimit(size_t pending) {
+    GET_CONFIG(uint32_t, memory_max_mb, Hls::kMemoryMaxMB);
+    return memory_max_mb && HlsMediaSource::getSegmentsMemory() + pending >= ((uint64_t)memory_max_mb << 20);
+}
+
+void HlsMakerImp::spillSegmentToFile() {
+    _segment_in_memory = false;
+    // 内存模式下写磁盘的切片也需要删除
+    // Segments written to disk in memory mode also need to be deleted
+    _segment_file_paths.emplace(_segment_index, _info.file_path);
+    _file = makeFile(_info.file_path, true);
+    if (_file) {
+        fwrite(_segment_data.data(), _segment_data.size(), 1, _file.get());
+    } else {
+        WarnL << "Create file failed," << _info.file_path << " " << get_uv_errmsg();
+    }
+    _segment_data = string();
+}
+
 string HlsMakerImp::onOpenSegment(uint64_t index) {
     string segment_name, segment_path;
     {
@@ -153,7 +187,7 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
         auto current_dir = strDate + "/" + strHour + "/";
         segment_name = current_dir + strTime + "_" + std::to_string(index) + (isFmp4() ? ".mp4" : ".ts");
         segment_path = _path_prefix + "/" + segment_name;
-        if (isLive()) {
+        if (isLive() && !_memory_mode) {
             // 直播
             _segment_file_paths.emplace(index, segment_path);
         }
@@ -165,7 +199,38 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
             _current_dir = std::move(current_dir);
         }
     }
-    _file = makeFile(segment_path, true);
+
+    if (isLowLatency()) {
+        _part_data.clear();
+        _part_names.emplace_back();
+        // 分片在m3u8中被移除后多保留一个切片的时长，防止播放器下载时已被删除
+        // Keep parts one more segment after they are removed from the m3u8, so players can still download them
+        while (_part_names.size() > kPartSegmentNum + 2) {
+            if (_media_src) {
+                for (auto &name : _part_names.front()) {
+                    _media_src->delSegment(name);
+                }
+            }
+            _part_names.pop_front();
+        }
+    }
+
+    // 内存占用超过上限后，新切片改为写磁盘
+    // New segments are written to disk once the memory usage exceeds the limit
+    _segment_index = index;
+    _segment_in_memory = _memory_mode && !exceedMemoryLimit(0);
+    if (_segment_in_memory) {
+        _file = nullptr;
+        _segment_data.clear();
+        _segment_data.reserve(_last_segment_size);
+    } else {
+        if (_memory_mode) {
+            // 内存模式下写磁盘的切片也需要删除
+            // Segments written to disk in memory mode also need to be deleted
+            _segment_file_paths.emplace(index, segment_path);
+        }
+        _file = makeFile(segment_path, true);
+    }
 
     // 保存本切片的元数据  [AUTO-TRANSLATED:64e6f692]
     // Save metadata for this slice
@@ -174,7 +239,7 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
     _info.file_path = segment_path;
     _info.url = _info.app + "/" + _info.stream + "/" + segment_name;
 
-    if (!_file) {
+    if (!_file && !_segment_in_memory) {
         WarnL << "Create file failed," << segment_path << " " << get_uv_errmsg();
     }
     if (_params.empty()) {
@@ -196,6 +261,14 @@ void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
     if (!isLive() || isKeep()) {
         _current_dir_init_file.assign(data, len);
     }
+    if (_memory_mode) {
+        if (_media_src) {
+            _media_src->addSegment("init.mp4", std::make_shared<BufferString>(string(data, len)));
+        }
+        if (!isKeep()) {
+            return;
+        }
+    }
     string init_seg_path = _path_prefix + "/init.mp4";
     auto file = makeFile(init_seg_path);
     if (file) {
@@ -207,21 +280,46 @@ void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
 }
 
 void HlsMakerImp::onWriteSegment(const char *data, size_t len) {
-    if (_file) {
+    if (_segment_in_memory) {
+        _segment_data.append(data, len);
+        if (exceedMemoryLimit(_segment_data.size())) {
+            // 切片生成过程中内存占用超过上限，剩余部分改为写磁盘
+            // The memory limit was exceeded while the segment was being generated, the rest of it goes to disk
+            spillSegmentToFile();
+        }
+    } else if (_file) {
         fwrite(data, len, 1, _file.get());
     }
+    if (isLowLatency()) {
+        _part_data.append(data, len);
+    }
     if (_media_src) {
         _media_src->onSegmentSize(len);
     }
 }
 
 void HlsMakerImp::onWriteHls(const std::string &data, bool include_delay) {
+    if (_memory_mode) {
+        // m3u8只保存在内存中
+        // The m3u8 is kept only in memory
+        if (!_media_src) {
+            return;
+        }
+        if (include_delay) {
+            _media_src->addSegment(_hls_delay_name, std::make_shared<BufferString>(data));
+        } else if (!isLowLatency()) {
+            _media_src->setIndexFile(data);
+        }
+        return;
+    }
     auto path = include_delay ? _path_hls_delay : _path_hls;
     auto hls = makeFile(path);
     if (hls) {
         fwrite(data.data(), data.size(), 1, hls.get());
         hls.reset();
-        if (_media_src && !include_delay) {
+        // 低延迟hls的m3u8由onWriteLowLatencyHls设置
+        // The low latency hls m3u8 is set by onWriteLowLatencyHls
+        if (_media_src && !include_delay && !isLowLatency()) {
             _media_src->setIndexFile(data);
         }
     } else {
@@ -233,15 +331,85 @@ void HlsMakerImp::onFlushLastSegment(uint64_t duration_ms) {
     // 关闭并flush文件到磁盘  [AUTO-TRANSLATED:9798ec4d]
     // Close and flush file to disk
     _file = nullptr;
+    if (_segment_in_memory) {
+        _info.time_len = duration_ms / 1000.0f;
+        onFlushMemorySegment();
+    } else {
+        GET_CONFIG(bool, broadcastRecordTs, Hls::kBroadcastRecordTs);
+        if (broadcastRecordTs) {
+            _info.time_len = duration_ms / 1000.0f;
+            _info.file_size = File::fileSize(_info.file_path.data());
+            NOTICE_EMIT(BroadcastRecordTsArgs, Broadcast::kBroadcastRecordTs, _info);
+        }
+    }
     if (!isLive() || isKeep()) {
         _current_dir_seg_list.emplace_back(duration_ms, _info.file_name.erase(0, _current_dir.size()));
     }
-    GET_CONFIG(bool, broadcastRecordTs, Hls::kBroadcastRecordTs);
-    if (broadcastRecordTs) {
-        _info.time_len = duration_ms / 1000.0f;
-        _info.file_size = File::fileSize(_info.file_path.data());
-        NOTICE_EMIT(BroadcastRecordTsArgs, Broadcast::kBroadcastRecordTs, _info);
+}
+
+void HlsMakerImp::onFlushPart(const std::string &name) {
+    // 分片只保存在内存中
+    // Parts are kept only in memory
+    auto buf = std::make_shared<BufferString>(std::move(_part_data));
+    _part_data = string();
+    if (_part_names.empty()) {
+        return;
+    }
+    _part_names.back().emplace_back(name);
+    if (_media_src) {
+        _media_src->addSegment(name, std::move(buf));
+    }
+}
+
+void HlsMakerImp::onWriteLowLatencyHls(const std::string &index, const std::string &delta, uint64_t msn, int part, const std::string &preload_hint) {
+    if (_media_src) {
+        _media_src->setIndexFile(index, delta, msn, part, preload_hint);
+    }
+}
+
+void HlsMakerImp::onFlushMemorySegment() {
+    _segment_in_memory = false;
+    _last_segment_size = _segment_data.size();
+    auto buf = std::make_shared<BufferString>(std::move(_segment_data));
+    _segment_data = string();
+    if (_media_src) {
+        _media_src->addSegment(_info.file_name, buf);
+    }
+    _memory_segments.emplace_back(_info.file_name);
+
+    // 内存中保留的切片个数与磁盘模式一致(m3u8中的切片加上segDelay与segRetain个)
+    // Keep as many segments in memory as the disk mode does (the ones in the m3u8 plus segDelay and segRetain)
+    GET_CONFIG(uint32_t, segDelay, Hls::kSegmentDelay);
+    GET_CONFIG(uint32_t, segRetain, Hls::kSegmentRetain);
+    while (_memory_segments.size() > getSegmentNumber() + segDelay + segRetain + 1) {
+        if (_media_src) {
+            _media_src->delSegment(_memory_segments.front());
+        }
+        _memory_segments.pop_front();
     }
+
+    if (!isKeep()) {
+        // 切片不落盘，也就不广播录制完成事件
+        // The segment is not written to disk, so no record event is broadcast
+        return;
+    }
+    // 保留切片时异步写入磁盘，写入完毕后再广播录制完成事件
+    // When keeping segments, write it to disk asynchronously and broadcast the record event after it is written
+    auto info = _info;
+    WorkThreadPool::Instance().getPoller()->async([buf, info]() mutable {
+        auto file = File::create_file(info.file_path.data(), "wb");
+        if (!file) {
+            WarnL << "Create file failed," << info.file_path << " " << get_uv_errmsg();
+            return;
+        }
+        fwrite(buf->data(), buf->size(), 1, file);
+        fclose(file);
+        GET_CONFIG(bool, broadcastRecordTs, Hls::kBroadcastRecordTs);
+        if (broadcastRecordTs) {
+            info.file_size = buf->size();
+            NOTICE_EMIT(BroadcastRecordTsArgs, Broadcast::kBroadcastRecordTs, info);
+        }
+    }, false);
 }
 
 std::shared_ptr<FILE> HlsMakerImp::makeFile(const string &file, bool setbuf) {
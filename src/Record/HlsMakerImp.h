@@ -59,14 +59,31 @@ protected:
     void onWriteSegment(const char *data, size_t len) override;
     void onWriteHls(const std::string &data, bool include_delay) override;
     void onFlushLastSegment(uint64_t duration_ms) override;
+    void onFlushPart(const std::string &name) override;
+    void onWriteLowLatencyHls(const std::string &index, const std::string &delta, uint64_t msn, int part, const std::string &preload_hint) override;
 
 private:
     std::shared_ptr<FILE> makeFile(const std::string &file,bool setbuf = false);
     void clearCache(bool immediately, bool eof);
     void saveCurrentDir();
+    void onFlushMemorySegment();
+    void spillSegmentToFile();
+    // 内存切片总占用加上pending字节后是否达到hls.memoryMaxMB
+    // Whether the in-memory segments plus pending bytes reach hls.memoryMaxMB
+    static bool exceedMemoryLimit(size_t pending);
 
 private:
     int _buf_size;
+    // 直播hls是否只保存在内存中
+    // Whether live hls is kept only in memory
+    bool _memory_mode = false;
+    // 当前切片是否写入内存
+    // Whether the current segment is written to memory
+    bool _segment_in_memory = false;
+    uint64_t _segment_index = 0;
+    size_t _last_segment_size = 0;
+    std::string _segment_data;
+    std::string _hls_delay_name;
     std::string _params;
     std::string _path_hls;
     std::string _path_hls_delay;
@@ -81,6 +98,13 @@ private:
     toolkit::EventPoller::Ptr _poller;
     std::map<uint64_t/*index*/,std::string/*file_path*/> _segment_file_paths;
     std::deque<std::tuple<int,std::string> > _current_dir_seg_list;
+    std::deque<std::string> _memory_segments;
+    // 低延迟hls正在生成的分片数据
+    // Data of the low latency hls part in progress
+    std::string _part_data;
+    // 每个切片的低延迟hls分片名
+    // Low latency hls part names of each segment
+    std::deque<std::vector<std::string> > _part_names;
 };
 
 }//namespace mediakit
@@ -10,11 +10,24 @@
 
 #include "HlsMediaSource.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Util/util.h"
 
 using namespace toolkit;
 
 namespace mediakit {
 
+// 所有hls源内存切片占用的总字节数
+// Total bytes taken by the in-memory segments of all hls sources
+static Metric s_segments_bytes("zlm_hls_memory_segments_bytes", "Bytes taken by the in-memory hls segments", Metric::Gauge);
+
+// 阻塞请求最多挂起3倍切片时长
+// A blocking request is held for at most 3 segment durations
+static uint64_t maxBlockMS() {
+    GET_CONFIG(float, segDur, Hls::kSegmentDuration);
+    return MAX(segDur, 1.0f) * 3 * 1000;
+}
+
 class SockInfoImp : public SockInfo {
 public:
     using Ptr = std::shared_ptr<SockInfoImp>;
@@ -104,30 +117,168 @@ HlsMediaSource::Ptr HlsCookieData::getMediaSource() const {
     return _src.lock();
 }
 
+HlsMediaSource::~HlsMediaSource() {
+    clearSegments();
+    // 回复所有挂起的阻塞请求
+    // Reply all the pending blocking requests
+    decltype(_blocking_list) blocking_list;
+    std::string index_file;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        blocking_list.swap(_blocking_list);
+        index_file = _index_file;
+    }
+    for (auto &req : blocking_list) {
+        req.cb(index_file);
+    }
+}
+
+void HlsMediaSource::createRing() {
+    if (_ring) {
+        return;
+    }
+    std::weak_ptr<HlsMediaSource> weakSelf = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
+    auto lam = [weakSelf](int size) {
+        auto strongSelf = weakSelf.lock();
+        if (!strongSelf) {
+            return;
+        }
+        strongSelf->onReaderChanged(size);
+    };
+    _ring = std::make_shared<RingType>(0, std::move(lam));
+    regist();
+}
+
 void HlsMediaSource::setIndexFile(std::string index_file)
 {
-    if (!_ring) {
-        std::weak_ptr<HlsMediaSource> weakSelf = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
-        auto lam = [weakSelf](int size) {
-            auto strongSelf = weakSelf.lock();
-            if (!strongSelf) {
-                return;
-            }
-            strongSelf->onReaderChanged(size);
-        };
-        _ring = std::make_shared<RingType>(0, std::move(lam));
-        regist();
-    }
+    createRing();
 
     // 赋值m3u8索引文件内容  [AUTO-TRANSLATED:c11882b5]
     // Assign m3u8 index file content
     std::lock_guard<std::mutex> lck(_mtx_index);
     _index_file = std::move(index_file);
+    _low_latency = false;
+    _msn = 0;
+    _part = -1;
+    _delta_index_file.clear();
 
     if (!_index_file.empty()) {
         _list_cb.for_each([&](const std::function<void(const std::string& str)>& cb) { cb(_index_file); });
         _list_cb.clear();
+        // 未开启低延迟hls，阻塞请求直接回复
+        // Low latency hls is off, reply the blocking requests directly
+        for (auto &req : _blocking_list) {
+            req.cb(_index_file);
+        }
+        _blocking_list.clear();
+    }
+}
+
+void HlsMediaSource::setIndexFile(std::string index_file, std::string delta_file, uint64_t msn, int part, std::string preload_hint) {
+    createRing();
+
+    std::list<std::function<void(const Buffer::Ptr &)>> expired_waiters;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_segment);
+        if (_preload_hint != preload_hint) {
+            // 预加载提示变更，等待旧提示分片且该分片未生成的请求不会再被满足
+            // The preload hint changed, requests waiting for the old hint part that was never generated can no longer be satisfied
+            _preload_hint = std::move(preload_hint);
+            for (auto it = _segment_waiters.begin(); it != _segment_waiters.end();) {
+                if (it->name == _preload_hint) {
+                    ++it;
+                    continue;
+                }
+                expired_waiters.emplace_back(std::move(it->cb));
+                it = _segment_waiters.erase(it);
+            }
+        }
+    }
+    for (auto &cb : expired_waiters) {
+        cb(nullptr);
+    }
+
+    auto max_block_ms = maxBlockMS();
+    auto now = getCurrentMillisecond();
+
+    std::list<std::pair<std::function<void(const std::string &)>, bool>> ready_list;
+    std::string full, delta;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        _low_latency = true;
+        _index_file = std::move(index_file);
+        _delta_index_file = std::move(delta_file);
+        _msn = msn;
+        _part = part;
+
+        _list_cb.for_each([&](const std::function<void(const std::string& str)>& cb) { cb(_index_file); });
+        _list_cb.clear();
+
+        for (auto it = _blocking_list.begin(); it != _blocking_list.end();) {
+            if (!isIndexReady(it->msn, it->part) && now - it->create_ms < max_block_ms) {
+                ++it;
+                continue;
+            }
+            ready_list.emplace_back(std::move(it->cb), it->skip);
+            it = _blocking_list.erase(it);
+        }
+        if (!ready_list.empty()) {
+            full = _index_file;
+            delta = _delta_index_file.empty() ? _index_file : _delta_index_file;
+        }
+    }
+    // 在锁外回复，防止回调中访问本对象导致死锁
+    // Reply outside the lock, in case the callback accesses this object and deadlocks
+    for (auto &pr : ready_list) {
+        pr.first(pr.second ? delta : full);
+    }
+}
+
+bool HlsMediaSource::isIndexReady(int64_t msn, int part) const {
+    if (_index_file.empty()) {
+        return false;
     }
+    if (!_low_latency || msn < 0) {
+        return true;
+    }
+    if ((uint64_t)msn > _msn + 2) {
+        // 请求的切片太超前，直接回复当前m3u8
+        // The requested segment is too far ahead, reply the current m3u8 directly
+        return true;
+    }
+    if (part < 0) {
+        // 等待整个切片完成
+        // Wait for the whole segment to be finished
+        return (uint64_t)msn < _msn;
+    }
+    return (uint64_t)msn < _msn || ((uint64_t)msn == _msn && part <= _part);
+}
+
+void HlsMediaSource::getIndexFile(int64_t msn, int part, bool skip, std::function<void(const std::string &str)> cb) {
+    if (msn < 0 && !skip) {
+        getIndexFile(std::move(cb));
+        return;
+    }
+    std::string index_file;
+    bool held = false;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        if (!isIndexReady(msn, part)) {
+            // 挂起请求，直到指定切片或分片生成
+            // Hold the request until the requested segment or part is generated
+            _blocking_list.emplace_back(BlockingRequest { msn, part, skip, getCurrentMillisecond(), std::move(cb) });
+            held = true;
+        } else {
+            index_file = skip && !_delta_index_file.empty() ? _delta_index_file : _index_file;
+        }
+    }
+    if (held) {
+        // 请求已挂起，确保其在切片停止更新时也能超时
+        // The request is held, make sure it still expires when the segments stop updating
+        startExpireTask();
+        return;
+    }
+    cb(index_file);
 }
 
 void HlsMediaSource::getIndexFile(std::function<void(const std::string& str)> cb)
@@ -142,4 +293,170 @@ void HlsMediaSource::getIndexFile(std::function<void(const std::string& str)> cb
     _list_cb.emplace_back(std::move(cb));
 }
 
+void HlsMediaSource::addSegment(const std::string &name, Buffer::Ptr buf) {
+    s_segments_bytes.add(buf->size());
+    std::list<std::function<void(const Buffer::Ptr &)>> waiters;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_segment);
+        auto &ref = _segments[name];
+        if (ref) {
+            s_segments_bytes.add(-(int64_t)ref->size());
+        }
+        ref = buf;
+        for (auto it = _segment_waiters.begin(); it != _segment_waiters.end();) {
+            if (it->name != name) {
+                ++it;
+                continue;
+            }
+            waiters.emplace_back(std::move(it->cb));
+            it = _segment_waiters.erase(it);
+        }
+    }
+    for (auto &cb : waiters) {
+        cb(buf);
+    }
+}
+
+void HlsMediaSource::delSegment(const std::string &name) {
+    std::lock_guard<std::mutex> lck(_mtx_segment);
+    auto it = _segments.find(name);
+    if (it == _segments.end()) {
+        return;
+    }
+    s_segments_bytes.add(-(int64_t)it->second->size());
+    _segments.erase(it);
+}
+
+void HlsMediaSource::clearSegments() {
+    decltype(_segment_waiters) waiters;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_segment);
+        for (auto &pr : _segments) {
+            s_segments_bytes.add(-(int64_t)pr.second->size());
+        }
+        _segments.clear();
+        _preload_hint.clear();
+        waiters.swap(_segment_waiters);
+    }
+    for (auto &waiter : waiters) {
+        waiter.cb(nullptr);
+    }
+}
+
+Buffer::Ptr HlsMediaSource::getSegment(const std::string &name) const {
+    std::lock_guard<std::mutex> lck(_mtx_segment);
+    auto it = _segments.find(name);
+    return it == _segments.end() ? nullptr : it->second;
+}
+
+bool HlsMediaSource::hasSegment(const std::string &name) const {
+    std::lock_guard<std::mutex> lck(_mtx_segment);
+    return _segments.find(name) != _segments.end() || (!_preload_hint.empty() && name == _preload_hint);
+}
+
+void HlsMediaSource::getSegment(const std::string &name, std::function<void(const Buffer::Ptr &buf)> cb) {
+    Buffer::Ptr buf;
+    bool held = false;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_segment);
+        auto it = _segments.find(name);
+        if (it != _segments.end()) {
+            buf = it->second;
+        } else if (!_preload_hint.empty() && name == _preload_hint) {
+            // 预加载提示的分片，等待其生成
+            // The preload hint part, wait for it to be generated
+            _segment_waiters.emplace_back(SegmentWaiter { name, getCurrentMillisecond(), std::move(cb) });
+            held = true;
+        }
+    }
+    if (held) {
+        startExpireTask();
+        return;
+    }
+    cb(buf);
+}
+
+void HlsMediaSource::startExpireTask() {
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        if (_expire_task_running) {
+            return;
+        }
+        _expire_task_running = true;
+    }
+    EventPoller::Ptr poller;
+    try {
+        poller = getOwnerPoller();
+    } catch (std::exception &) {
+        poller = EventPollerPool::Instance().getPoller();
+    }
+    std::weak_ptr<HlsMediaSource> weak_self = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
+    // 切片停止更新时(推流卡顿或断开)，setIndexFile不再触发，由该定时任务回复超时的阻塞请求
+    // When the segments stop updating (stalled or lost publisher) setIndexFile is no longer called, this task replies the expired blocking requests
+    poller->doDelayTask(500, [weak_self]() -> uint64_t {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        return strong_self->onExpireTask() ? 500 : 0;
+    });
+}
+
+bool HlsMediaSource::onExpireTask() {
+    auto max_block_ms = maxBlockMS();
+    auto now = getCurrentMillisecond();
+
+    std::list<std::function<void(const Buffer::Ptr &)>> expired_waiters;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_segment);
+        for (auto it = _segment_waiters.begin(); it != _segment_waiters.end();) {
+            if (now - it->create_ms < max_block_ms) {
+                ++it;
+                continue;
+            }
+            expired_waiters.emplace_back(std::move(it->cb));
+            it = _segment_waiters.erase(it);
+        }
+    }
+    for (auto &cb : expired_waiters) {
+        cb(nullptr);
+    }
+
+    std::list<std::pair<std::function<void(const std::string &)>, bool>> expired_list;
+    std::string full, delta;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        for (auto it = _blocking_list.begin(); it != _blocking_list.end();) {
+            if (now - it->create_ms < max_block_ms) {
+                ++it;
+                continue;
+            }
+            expired_list.emplace_back(std::move(it->cb), it->skip);
+            it = _blocking_list.erase(it);
+        }
+        full = _index_file;
+        delta = _delta_index_file.empty() ? _index_file : _delta_index_file;
+    }
+    // 超时的阻塞请求回复当前m3u8
+    // Reply the current m3u8 to the expired blocking requests
+    for (auto &pr : expired_list) {
+        pr.first(pr.second ? delta : full);
+    }
+
+    // 两个列表都为空时停止定时任务，判断与清除标记在同一把锁内完成，防止与新挂起的请求竞争
+    // Stop when both lists are empty, checked and cleared under the same locks so a newly held request can not be missed
+    std::lock_guard<std::mutex> lck_index(_mtx_index);
+    std::lock_guard<std::mutex> lck_segment(_mtx_segment);
+    if (_blocking_list.empty() && _segment_waiters.empty()) {
+        _expire_task_running = false;
+        return false;
+    }
+    return true;
+}
+
+uint64_t HlsMediaSource::getSegmentsMemory() {
+    auto ret = s_segments_bytes.value();
+    return ret > 0 ? (uint64_t)ret : 0;
+}
+
 } // namespace mediakit
@@ -16,6 +16,7 @@
 #include "Util/RingBuffer.h"
 #include "Network/Session.h"
 #include <atomic>
+#include <unordered_map>
 
 namespace mediakit {
 
@@ -27,6 +28,7 @@ public:
     using Ptr = std::shared_ptr<HlsMediaSource>;
 
     HlsMediaSource(const std::string &schema, const MediaTuple &tuple) : MediaSource(schema, tuple) {}
+    ~HlsMediaSource() override;
 
     /**
      * 	获取媒体源的环形缓冲
@@ -60,6 +62,36 @@ public:
      */
     void getIndexFile(std::function<void(const std::string &str)> cb);
 
+    /**
+     * 设置低延迟hls m3u8索引文件内容，并回复满足条件的阻塞请求
+     * @param index_file 完整m3u8
+     * @param delta_file 增量m3u8，为空时增量请求也回复完整m3u8
+     * @param msn 正在生成的切片序号
+     * @param part 正在生成的切片中最后一个完成的分片序号，-1代表还没有分片
+     * @param preload_hint 预加载提示的分片路径，对其请求会被阻塞直到分片生成
+     * Set the low latency hls m3u8 index file content, and reply the blocking requests that are satisfied
+     * @param index_file Full m3u8
+     * @param delta_file Delta m3u8, the full m3u8 is replied to delta requests when it is empty
+     * @param msn Media sequence number of the segment in progress
+     * @param part Index of the last finished part of the segment in progress, -1 if there is none yet
+     * @param preload_hint Path of the preload hint part, requests to it are held until the part is generated
+     */
+    void setIndexFile(std::string index_file, std::string delta_file, uint64_t msn, int part, std::string preload_hint);
+
+    /**
+     * 异步获取低延迟hls m3u8文件(_HLS_msn/_HLS_part/_HLS_skip)
+     * 指定的切片或分片生成前请求会被挂起，不需要轮询
+     * @param msn 请求的切片序号，-1代表不阻塞
+     * @param part 请求的分片序号，-1代表等待整个切片
+     * @param skip 是否请求增量m3u8
+     * Asynchronously get the low latency hls m3u8 file (_HLS_msn/_HLS_part/_HLS_skip)
+     * The request is held without polling until the requested segment or part is generated
+     * @param msn Requested media sequence number, -1 for no blocking
+     * @param part Requested part index, -1 to wait for the whole segment
+     * @param skip Whether the delta m3u8 is requested
+     */
+    void getIndexFile(int64_t msn, int part, bool skip, std::function<void(const std::string &str)> cb);
+
     /**
      * 同步获取m3u8文件
      * Synchronously get the m3u8 file
@@ -74,16 +106,99 @@ public:
 
     void onSegmentSize(size_t bytes) { _speed[TrackVideo] += bytes; }
 
+    /**
+     * 添加内存切片(hls.memoryMode开启时使用)
+     * @param name 切片相对m3u8文件所在目录的路径
+     * @param buf 切片数据
+     * Add an in-memory segment (used when hls.memoryMode is on)
+     * @param name Segment path relative to the directory of the m3u8 file
+     * @param buf Segment data
+     */
+    void addSegment(const std::string &name, toolkit::Buffer::Ptr buf);
+
+    /**
+     * 删除内存切片
+     * Delete an in-memory segment
+     */
+    void delSegment(const std::string &name);
+
+    /**
+     * 清空内存切片
+     * Clear all in-memory segments
+     */
+    void clearSegments();
+
+    /**
+     * 获取内存切片，不存在时返回nullptr
+     * Get an in-memory segment, returns nullptr if it does not exist
+     */
+    toolkit::Buffer::Ptr getSegment(const std::string &name) const;
+
+    /**
+     * 内存切片是否存在或者为预加载提示的分片
+     * Whether the in-memory segment exists or is the preload hint part
+     */
+    bool hasSegment(const std::string &name) const;
+
+    /**
+     * 异步获取内存切片，预加载提示的分片会等待其生成，不存在时回调nullptr
+     * Asynchronously get an in-memory segment, waits for the preload hint part to be generated, nullptr is called back if it does not exist
+     */
+    void getSegment(const std::string &name, std::function<void(const toolkit::Buffer::Ptr &buf)> cb);
+
+    /**
+     * 获取所有hls源内存切片占用的总字节数
+     * Get the total bytes taken by the in-memory segments of all hls sources
+     */
+    static uint64_t getSegmentsMemory();
+
     void getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
                        const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) override {
         _ring->getInfoList(cb, on_change);
     }
 
 private:
+    void createRing();
+    bool isIndexReady(int64_t msn, int part) const;
+    void startExpireTask();
+    bool onExpireTask();
+
+private:
+    struct BlockingRequest {
+        int64_t msn;
+        int part;
+        bool skip;
+        uint64_t create_ms;
+        std::function<void(const std::string &)> cb;
+    };
+
+    struct SegmentWaiter {
+        std::string name;
+        uint64_t create_ms;
+        std::function<void(const toolkit::Buffer::Ptr &)> cb;
+    };
+
     RingType::Ptr _ring;
     std::string _index_file;
     mutable std::mutex _mtx_index;
     toolkit::List<std::function<void(const std::string &)>> _list_cb;
+    mutable std::mutex _mtx_segment;
+    std::unordered_map<std::string, toolkit::Buffer::Ptr> _segments;
+
+    // 低延迟hls相关状态，由_mtx_index保护
+    // Low latency hls states, protected by _mtx_index
+    bool _low_latency = false;
+    uint64_t _msn = 0;
+    int _part = -1;
+    std::string _delta_index_file;
+    std::list<BlockingRequest> _blocking_list;
+    // 超时定时任务是否在运行，由_mtx_index保护
+    // Whether the expire task is running, protected by _mtx_index
+    bool _expire_task_running = false;
+    // 预加载提示分片以及等待其生成的请求，由_mtx_segment保护
+    // Preload hint part and the requests waiting for it, protected by _mtx_segment
+    std::string _preload_hint;
+    std::list<SegmentWaiter> _segment_waiters;
 };
 
 class HlsCookieData {
@@ -19,7 +19,7 @@
 namespace mediakit {
 
 template <typename Muxer>
-class HlsRecorderBase : public MediaSourceEventInterceptor, public Muxer, public std::enable_shared_from_this<HlsRecorderBase<Muxer> > {
+class HlsRecorderBase : public MediaSourceEventInterceptor, public DemandGopSeeder, public Muxer, public std::enable_shared_from_this<HlsRecorderBase<Muxer> > {
 public:
     HlsRecorderBase(bool is_fmp4, const std::string &m3u8_file, const std::string &params, const ProtocolOption &option) {
         GET_CONFIG(uint32_t, hlsNum, Hls::kSegmentNum);
@@ -48,6 +48,7 @@ public:
     void onReaderChanged(MediaSource &sender, int size) override {
         // hls保留切片个数为0时代表为hls录制(不删除切片)，那么不管有无观看者都一直生成hls  [AUTO-TRANSLATED:55709255]
         // When the number of hls slices is 0, it means hls recording (not deleting slices), so hls is generated all the time regardless of whether there are viewers
+        onDemandReaderChanged(_option.hls_demand, _enabled, size);
         _enabled = _option.hls_demand ? (_hls->isLive() ? size : true) : true;
         if (!size && _hls->isLive() && _option.hls_demand) {
             // hls直播时，如果无人观看就删除视频缓存，目的是为了防止视频跳跃  [AUTO-TRANSLATED:1d875c6a]
@@ -58,6 +59,10 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
+        return inputFrames(&frame, 1);
+    }
+
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override {
         if (_clear_cache && _option.hls_demand) {
             _clear_cache = false;
             // 清空旧的m3u8索引文件于ts切片  [AUTO-TRANSLATED:a4ce0664]
@@ -65,10 +70,14 @@ public:
             _hls->clearCache();
             _hls->getMediaSource()->setIndexFile("");
         }
-        if (_enabled || !_option.hls_demand) {
-            return Muxer::inputFrame(frame);
+        if (!_enabled && _option.hls_demand) {
+            return false;
+        }
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = Muxer::inputFrame(frames[i]) ? true : ret;
         }
-        return false;
+        return ret;
     }
 
     bool isEnabled() {
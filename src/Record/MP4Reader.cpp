@@ -87,15 +87,19 @@ bool MP4Reader::readSample() {
 
     bool keyFrame = false;
     bool eof = false;
+    std::vector<Frame::Ptr> frames;
     while (!eof && _last_dts < getCurrentStamp()) {
         auto frame = _demuxer->readFrame(keyFrame, eof);
         if (!frame) {
             continue;
         }
         _last_dts = frame->dts();
-        if (_muxer) {
-            _muxer->inputFrame(frame);
-        }
+        frames.emplace_back(std::move(frame));
+    }
+    // 本次读取的帧批量输入复用器
+    // Frames read this time are input into the muxer as a batch
+    if (_muxer && !frames.empty()) {
+        _muxer->inputFrames(frames.data(), frames.size());
     }
 
     GET_CONFIG(bool, file_repeat, Record::kFileRepeat);
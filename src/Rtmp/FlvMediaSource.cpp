@@ -0,0 +1,160 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "FlvMediaSource.h"
+#include "Rtmp/utils.h"
+#include "Network/sockutil.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+FlvTag::Ptr FlvTag::create(uint8_t type, const Buffer &data, uint32_t time_stamp) {
+    RtmpTagHeader header;
+    header.type = type;
+    set_be24(header.data_size, (uint32_t) data.size());
+    header.timestamp_ex = (time_stamp >> 24) & 0xff;
+    set_be24(header.timestamp, time_stamp & 0xFFFFFF);
+    uint32_t tag_size = htonl((uint32_t) (data.size() + sizeof(header)));
+
+    // tag头、tag数据与PreviousTagSize合并为一个缓存，播放器每个tag只需发送一次
+    // The tag header, the tag data and the PreviousTagSize are merged into one buffer, players send each tag only once
+    auto buffer = BufferRaw::create();
+    buffer->setCapacity(sizeof(header) + data.size() + 4);
+    buffer->setSize(sizeof(header) + data.size() + 4);
+    auto ptr = buffer->data();
+    memcpy(ptr, &header, sizeof(header));
+    memcpy(ptr + sizeof(header), data.data(), data.size());
+    memcpy(ptr + sizeof(header) + data.size(), &tag_size, 4);
+
+    auto ret = std::make_shared<FlvTag>(std::move(buffer));
+    ret->time_stamp = time_stamp;
+    return ret;
+}
+
+FlvMediaSource::FlvMediaSource(const RtmpMediaSource::Ptr &src, int ring_size) {
+    _src = src;
+    std::weak_ptr<RtmpMediaSource> weak_src = src;
+    _ring = std::make_shared<RingType>(ring_size, [weak_src](int size) {
+        auto src = weak_src.lock();
+        if (!src) {
+            return;
+        }
+        // flv播放器个数变化时通知rtmp源
+        // Notify the rtmp source when the number of flv players changes
+        src->onFlvReaderChanged();
+    });
+}
+
+void FlvMediaSource::start(const EventPoller::Ptr &poller) {
+    auto src = _src.lock();
+    if (!src || !src->getRing()) {
+        onDetach();
+        return;
+    }
+    std::weak_ptr<FlvMediaSource> weak_self = shared_from_this();
+    _reader = src->getRing()->attach(poller);
+    _reader->setDetachCB([weak_self]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->onDetach();
+    });
+    // 附着时会先收到rtmp源的GOP缓存，所以中途创建的flv复用源同样可以秒开
+    // The GOP cache of the rtmp source is received first after attaching, so players can still start instantly
+    _reader->setReadCB([weak_self](const RtmpMediaSource::RingDataType &pkt_list) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->onRead(pkt_list);
+    });
+}
+
+void FlvMediaSource::onRead(const RtmpMediaSource::RingDataType &pkt_list) {
+    auto tag_list = std::make_shared<List<FlvTag::Ptr> >();
+    bool key_pos = false;
+    pkt_list->for_each([&](const RtmpPacket::Ptr &pkt) {
+        if (pkt->type_id == MSG_VIDEO) {
+            _have_video = true;
+            key_pos = key_pos || pkt->isVideoKeyFrame();
+        }
+        tag_list->emplace_back(FlvTag::create(pkt->type_id, *pkt, pkt->time_stamp));
+    });
+
+    RingType::Ptr ring;
+    {
+        lock_guard<mutex> lck(_mtx);
+        ring = _ring;
+    }
+    if (ring) {
+        // 与rtmp源一致，没有视频时一直清空GOP缓存
+        // The same as the rtmp source, the GOP cache is always cleared without video
+        ring->write(std::move(tag_list), _have_video ? key_pos : true);
+    }
+}
+
+void FlvMediaSource::onDetach() {
+    RingType::Ptr ring;
+    {
+        lock_guard<mutex> lck(_mtx);
+        ring = std::move(_ring);
+    }
+    // 环形缓冲释放后所有flv播放器都会收到detach事件
+    // All flv players receive the detach event after the ring is released
+    ring = nullptr;
+}
+
+FlvMediaSource::RingType::RingReader::Ptr FlvMediaSource::attach(const EventPoller::Ptr &poller) {
+    RingType::Ptr ring;
+    {
+        lock_guard<mutex> lck(_mtx);
+        ring = _ring;
+    }
+    if (!ring) {
+        return nullptr;
+    }
+    // 附着时环形缓冲会同步回调播放器个数变化，不能持有_mtx
+    // The ring calls back the reader count change synchronously while attaching, _mtx must not be held
+    auto ret = ring->attach(poller);
+    lock_guard<mutex> lck(_mtx);
+    _attached = true;
+    return ret;
+}
+
+void FlvMediaSource::getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
+                                   const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) {
+    RingType::Ptr ring;
+    {
+        lock_guard<mutex> lck(_mtx);
+        ring = _ring;
+    }
+    if (!ring) {
+        cb(std::list<toolkit::Any>());
+        return;
+    }
+    ring->getInfoList(cb, on_change);
+}
+
+int FlvMediaSource::readerCount() {
+    lock_guard<mutex> lck(_mtx);
+    if (!_ring) {
+        return 0;
+    }
+    // 复用源附着rtmp源后、首个播放器附着前，由复用源代表该播放器计数，
+    // 否则rtmp源观看人数会短暂变为0并触发无人观看关闭流程
+    // Between attaching to the rtmp source and the first player attaching, the muxing source stands in for that player,
+    // otherwise the reader count of the rtmp source drops to 0 for a moment and may trigger the no-reader close
+    return _attached ? _ring->readerCount() : MAX(_ring->readerCount(), 1);
+}
+
+} // namespace mediakit
@@ -0,0 +1,108 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_FLVMEDIASOURCE_H
+#define ZLMEDIAKIT_FLVMEDIASOURCE_H
+
+#include <mutex>
+#include "Rtmp/RtmpMediaSource.h"
+#include "Http/WebSocketSplitter.h"
+#include "Poller/EventPoller.h"
+
+namespace mediakit {
+
+// 封装好的flv tag，包含tag头、tag数据与PreviousTagSize
+// Pre-framed flv tag, including the tag header, the tag data and the PreviousTagSize
+class FlvTag : public toolkit::BufferOffset<toolkit::Buffer::Ptr>, public WebSocketFrameCache {
+public:
+    using Ptr = std::shared_ptr<FlvTag>;
+
+    template<typename ...ARGS>
+    FlvTag(ARGS && ...args) : BufferOffset<Buffer::Ptr>(std::forward<ARGS>(args)...) {};
+
+    /**
+     * 封装flv tag
+     * @param type tag类型
+     * @param data tag数据
+     * @param time_stamp 时间戳
+     * Make a flv tag
+     * @param type Tag type
+     * @param data Tag data
+     * @param time_stamp Timestamp
+     */
+    static Ptr create(uint8_t type, const toolkit::Buffer &data, uint32_t time_stamp);
+
+public:
+    uint32_t time_stamp = 0;
+};
+
+/**
+ * 共享的flv复用源
+ * 每个rtmp源最多一个，在有http-flv/ws-flv播放器时创建，作为一个读取器从rtmp源环形缓冲读取rtmp包并只封装一次flv tag，
+ * 再写入自身的环形缓冲供所有flv播放器共享，播放器只需各自发送flv头、metadata与config帧，避免每个播放器重复封装
+ * 最后一个播放器断开后自动释放
+ * Shared flv muxing source
+ * There is at most one per rtmp source, it is created when there are http-flv/ws-flv players. As a reader of the rtmp source ring,
+ * it reads the rtmp packets and frames the flv tags only once, then writes them into its own ring shared by all flv players,
+ * each player only sends its own flv header, metadata and config frames, so the players no longer mux per connection
+ * It is released automatically after the last player disconnects
+ */
+class FlvMediaSource : public std::enable_shared_from_this<FlvMediaSource> {
+public:
+    using Ptr = std::shared_ptr<FlvMediaSource>;
+    using RingDataType = std::shared_ptr<toolkit::List<FlvTag::Ptr> >;
+    using RingType = toolkit::RingBuffer<RingDataType>;
+
+    FlvMediaSource(const RtmpMediaSource::Ptr &src, int ring_size);
+
+    /**
+     * 开始从rtmp源读取数据
+     * @param poller 复用所在线程
+     * Start reading from the rtmp source
+     * @param poller Thread of the muxing
+     */
+    void start(const toolkit::EventPoller::Ptr &poller);
+
+    /**
+     * 播放器附着到环形缓冲，rtmp源已经释放时返回nullptr
+     * Attach a player to the ring, return nullptr if the rtmp source has been released
+     */
+    RingType::RingReader::Ptr attach(const toolkit::EventPoller::Ptr &poller);
+
+    /**
+     * 获取播放器列表
+     * Get the player list
+     */
+    void getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
+                       const std::function<toolkit::Any(toolkit::Any &&info)> &on_change);
+
+    /**
+     * 获取播放器个数，首个播放器附着前计为1
+     * Get the number of players, it counts as 1 before the first player attaches
+     */
+    int readerCount();
+
+private:
+    void onRead(const RtmpMediaSource::RingDataType &pkt_list);
+    void onDetach();
+
+private:
+    bool _have_video = false;
+    // 是否已有播放器附着过，由_mtx保护
+    // Whether any player has attached, protected by _mtx
+    bool _attached = false;
+    std::weak_ptr<RtmpMediaSource> _src;
+    RtmpMediaSource::RingType::RingReader::Ptr _reader;
+    std::mutex _mtx;
+    RingType::Ptr _ring;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_FLVMEDIASOURCE_H
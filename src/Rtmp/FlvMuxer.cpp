@@ -42,9 +42,12 @@ void FlvMuxer::start(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr
     }
 
     onWriteFlvHeader(media);
+    media->pause(false);
+    if (startShared(poller, media, start_pts)) {
+        return;
+    }
 
     std::weak_ptr<FlvMuxer> weak_self = getSharedPtr();
-    media->pause(false);
     _ring_reader = media->getRing()->attach(poller);
     _ring_reader->setGetInfoCB([weak_self]() {
         Any ret;
@@ -80,6 +83,58 @@ void FlvMuxer::start(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr
     });
 }
 
+bool FlvMuxer::startShared(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr &media, uint32_t start_pts) {
+    GET_CONFIG(bool, share_mux, Rtmp::kFlvShareMux);
+    if (!share_mux) {
+        return false;
+    }
+    auto flv_src = media->getFlvSource(poller);
+    auto reader = flv_src ? flv_src->attach(poller) : nullptr;
+    if (!reader) {
+        return false;
+    }
+    _flv_src = std::move(flv_src);
+    _flv_reader = std::move(reader);
+
+    std::weak_ptr<FlvMuxer> weak_self = getSharedPtr();
+    _flv_reader->setGetInfoCB([weak_self]() {
+        Any ret;
+        ret.set(dynamic_pointer_cast<Session>(weak_self.lock()));
+        return ret;
+    });
+    _flv_reader->setDetachCB([weak_self]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->onDetach();
+    });
+
+    bool check = start_pts > 0;
+    _flv_reader->setReadCB([weak_self, start_pts, check](const FlvMediaSource::RingDataType &tag_list) mutable {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+
+        // flv tag已经封装好，直接发送
+        // The flv tags are already framed, just send them
+        size_t i = 0;
+        auto size = tag_list->size();
+        tag_list->for_each([&](const FlvTag::Ptr &tag) {
+            if (check) {
+                if (tag->time_stamp < start_pts) {
+                    ++i;
+                    return;
+                }
+                check = false;
+            }
+            strong_self->onWrite(tag, ++i == size);
+        });
+    });
+    return true;
+}
+
 BufferRaw::Ptr FlvMuxer::obtainBuffer() {
     return _packet_pool.obtain2();
 }
@@ -153,8 +208,10 @@ void FlvMuxer::onWriteRtmp(const RtmpPacket::Ptr &pkt, bool flush) {
 }
 
 void FlvMuxer::stop() {
-    if (_ring_reader) {
+    if (_ring_reader || _flv_reader) {
         _ring_reader.reset();
+        _flv_reader.reset();
+        _flv_src.reset();
         onDetach();
     }
 }
@@ -13,6 +13,7 @@
 
 #include "Rtmp/Rtmp.h"
 #include "Rtmp/RtmpMediaSource.h"
+#include "Rtmp/FlvMediaSource.h"
 #include "Poller/EventPoller.h"
 
 namespace mediakit {
@@ -36,12 +37,15 @@ private:
     void onWriteRtmp(const RtmpPacket::Ptr &pkt, bool flush);
     void onWriteFlvTag(const RtmpPacket::Ptr &pkt, uint32_t time_stamp, bool flush);
     void onWriteFlvTag(uint8_t type, const toolkit::Buffer::Ptr &buffer, uint32_t time_stamp, bool flush);
+    bool startShared(const toolkit::EventPoller::Ptr &poller, const RtmpMediaSource::Ptr &media, uint32_t start_pts);
     toolkit::BufferRaw::Ptr obtainBuffer(const void *data, size_t len);
     toolkit::BufferRaw::Ptr obtainBuffer();
 
 private:
     toolkit::ResourcePool<toolkit::BufferRaw> _packet_pool;
     RtmpMediaSource::RingType::RingReader::Ptr _ring_reader;
+    FlvMediaSource::Ptr _flv_src;
+    FlvMediaSource::RingType::RingReader::Ptr _flv_reader;
 };
 
 class FlvRecorder : public FlvMuxer , public std::enable_shared_from_this<FlvRecorder>{
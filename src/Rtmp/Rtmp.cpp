@@ -10,6 +10,7 @@
 
 #include "Rtmp.h"
 #include "Common/config.h"
+#include "Common/PacketArena.h"
 #include "Extension/Factory.h"
 
 namespace mediakit {
@@ -154,18 +155,14 @@ void Metadata::addTrack(AMFValue &metadata, const Track::Ptr &track) {
     new_metadata->getMetadata().object_for_each([&](const std::string &key, const AMFValue &value) { metadata.set(key, value); });
 }
 
-RtmpPacket::Ptr RtmpPacket::create() {
-#if 0
-    static ResourcePool<RtmpPacket> packet_pool;
-    static onceToken token([]() {
-        packet_pool.setSize(1024);
-    });
-    auto ret = packet_pool.obtain2();
-    ret->clear();
+RtmpPacket::Ptr RtmpPacket::create(size_t capacity) {
+    // 包释放时已经clear，保留了缓存容量
+    // The packet was cleared when released, keeping its buffer capacity
+    auto ret = PacketArena<RtmpPacket>::obtain(capacity);
+    if (capacity) {
+        ret->buffer.reserve(capacity);
+    }
     return ret;
-#else
-    return Ptr(new RtmpPacket);
-#endif
 }
 
 void RtmpPacket::clear() {
@@ -350,6 +347,6 @@ CodecId parseVideoRtmpPacket(const uint8_t *data, size_t size, RtmpPacketInfo *i
 
 } // namespace mediakit
 
-namespace toolkit {
-StatisticImp(mediakit::RtmpPacket);
+namespace mediakit {
+ObjectCounterImp(RtmpPacket)
 }
\ No newline at end of file
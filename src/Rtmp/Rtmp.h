@@ -171,6 +171,9 @@ struct RtmpVideoHeaderClassic {
 
 #pragma pack(pop)
 
+template <typename C>
+class PacketArena;
+
 class RtmpPacket : public toolkit::Buffer{
 public:
     friend class RtmpProtocol;
@@ -185,7 +188,13 @@ public:
     toolkit::BufferLikeString buffer;
 
 public:
-    static Ptr create();
+    /**
+     * 从包内存池申请rtmp包
+     * @param capacity 预分配的缓存大小，0代表未知
+     * Obtain an rtmp packet from the packet arena
+     * @param capacity Buffer size to reserve, 0 means unknown
+     */
+    static Ptr create(size_t capacity = 0);
 
     char *data() const override{
         return (char*)buffer.data();
@@ -193,6 +202,9 @@ public:
     size_t size() const override {
         return buffer.size();
     }
+    size_t getCapacity() const {
+        return buffer.capacity();
+    }
 
     void clear();
 
@@ -215,6 +227,7 @@ public:
 
 private:
     friend class toolkit::ResourcePool_l<RtmpPacket>;
+    friend class PacketArena<RtmpPacket>;
     RtmpPacket(){
         clear();
     }
@@ -224,7 +237,7 @@ private:
 private:
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     // Object count statistics
-    toolkit::ObjectStatistic<RtmpPacket> _statistic;
+    ObjectCounter<RtmpPacket> _statistic;
 };
 
 /**
@@ -20,12 +20,15 @@
 #include "Rtmp.h"
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/RingFanoutMonitor.h"
 #include "Util/RingBuffer.h"
 
 #define RTMP_GOP_SIZE 512
 
 namespace mediakit {
 
+class FlvMediaSource;
+
 /**
  * rtmp媒体源的数据抽象
  * rtmp有关键的三要素，分别是metadata、config帧，普通帧
@@ -40,11 +43,14 @@ namespace mediakit {
  
  * [AUTO-TRANSLATED:72d515c8]
  */
-class RtmpMediaSource : public MediaSource, public toolkit::RingDelegate<RtmpPacket::Ptr>, private PacketCache<RtmpPacket>{
+class RtmpMediaSource : public MediaSource, public toolkit::RingDelegate<RtmpPacket::Ptr>, private PacketCache<RtmpPacket, AdaptiveFlushPolicy>{
 public:
     using Ptr = std::shared_ptr<RtmpMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<RtmpPacket::Ptr> >;
     using RingType = toolkit::RingBuffer<RingDataType>;
+    // 设置该流的合并写时长(ProtocolOption::merge_write_ms)
+    // Set the merge write window of this stream (ProtocolOption::merge_write_ms)
+    using PacketCache<RtmpPacket, AdaptiveFlushPolicy>::setMergeWriteMS;
 
     /**
      * 构造函数
@@ -80,10 +86,12 @@ public:
         return _ring;
     }
 
+    /**
+     * 获取播放器列表，包括共享flv复用源的播放器
+     * Get the player list, including the players of the shared flv muxing source
+     */
     void getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
-                       const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) override {
-        _ring->getInfoList(cb, on_change);
-    }
+                       const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) override;
 
     /**
      * 获取播放器个数
@@ -93,9 +101,15 @@ public:
      
      * [AUTO-TRANSLATED:0ba31e32]
      */
-    int readerCount() override {
-        return _ring ? _ring->readerCount() : 0;
-    }
+    int readerCount() override;
+
+    /**
+     * 获取共享的flv复用源，不存在时创建，必须在poller线程中调用
+     * @param poller 创建时flv复用所在线程
+     * Get the shared flv muxing source, create it if it does not exist, must be called in the poller thread
+     * @param poller Thread of the flv muxing when it is created
+     */
+    std::shared_ptr<FlvMediaSource> getFlvSource(const toolkit::EventPoller::Ptr &poller);
 
     /**
      * 获取metadata
@@ -152,8 +166,29 @@ public:
     uint32_t getTimeStamp(TrackType trackType) override;
 
     void clearCache() override{
-        PacketCache<RtmpPacket>::clearCache();
+        PacketCache<RtmpPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
+        _cost.onClearCache();
+    }
+
+    /**
+     * 用重建的gop恢复被淘汰的gop缓存，在写入线程中调用
+     * @param gop 从帧级gop缓存重新生成的rtmp包
+     * Restore the evicted gop cache with a rebuilt gop, called in the writer thread
+     * @param gop Rtmp packets regenerated from the frame level gop cache
+     */
+    void restoreGopCache(RingDataType gop) {
+        // 先输出合并写缓存中的包，重建的gop紧接其后
+        // Output the packets in the merge write cache first, the rebuilt gop follows them
+        flush();
+        if (!_ring || _ring->readerCount() || gop->empty()) {
+            // 已有播放器(含共享flv复用源)时不能写入重建的gop(会重复收到)，从下一个关键帧开始恢复缓存
+            // The rebuilt gop can not be written with players (including the shared flv muxing source) attached,
+            // they would receive it twice, caching resumes from the next key frame
+            return;
+        }
+        _cost.onCache(MediaCost::getBytes(*gop), true, _ring_size);
+        _ring->write(std::move(gop), true);
     }
 
     bool haveVideo() const {
@@ -176,11 +211,19 @@ private:
      * [AUTO-TRANSLATED:581fe3a4]
     */
     void onFlush(std::shared_ptr<toolkit::List<RtmpPacket::Ptr> > rtmp_list, bool key_pos) override {
-        // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
-        // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
-        _ring->write(std::move(rtmp_list), _have_video ? key_pos : true);
+        MediaCost::Scope scope(_cost, MediaCost::kFanout);
+        key_pos = onGopCacheWrite(*_ring, MediaCost::getBytes(*rtmp_list), _have_video, key_pos, _ring_size);
+        _ring->write(std::move(rtmp_list), key_pos);
+        if (_ring->readerCount()) {
+            RingFanoutMonitor::onRingWrite();
+        }
     }
 
+    friend class FlvMediaSource;
+    // 共享flv复用源的播放器个数变化
+    // The number of players of the shared flv muxing source changed
+    void onFlvReaderChanged();
+
 private:
     bool _have_video = false;
     bool _have_audio = false;
@@ -191,6 +234,7 @@ private:
 
     mutable std::recursive_mutex _mtx;
     std::unordered_map<int, RtmpPacket::Ptr> _config_frame_map;
+    std::weak_ptr<FlvMediaSource> _flv_src;
 };
 
 } /* namespace mediakit */
@@ -1,5 +1,6 @@
 ﻿#include "RtmpDemuxer.h"
 #include "RtmpMediaSourceImp.h"
+#include "FlvMediaSource.h"
 
 namespace mediakit {
 
@@ -74,6 +75,10 @@ void RtmpMediaSource::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
             if (!strong_self) {
                 return;
             }
+            // 共享flv复用源也是该环形缓冲的读取器，需要换算为其播放器个数
+            // The shared flv muxing source is also a reader of this ring, it is replaced by the number of its players
+            size = strong_self->readerCount();
+            strong_self->setReaderCount(size);
             strong_self->onReaderChanged(size);
         };
 
@@ -88,7 +93,61 @@ void RtmpMediaSource::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
     }
     bool key = pkt->isVideoKeyFrame();
     auto stamp = pkt->time_stamp;
-    PacketCache<RtmpPacket>::inputPacket(stamp, is_video, std::move(pkt), key);
+    PacketCache<RtmpPacket, AdaptiveFlushPolicy>::inputPacket(stamp, is_video, std::move(pkt), key);
+}
+
+int RtmpMediaSource::readerCount() {
+    int ret = _ring ? _ring->readerCount() : 0;
+    std::shared_ptr<FlvMediaSource> flv_src;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        flv_src = _flv_src.lock();
+    }
+    if (flv_src) {
+        // 以flv播放器个数代替共享flv复用源本身
+        // Replace the shared flv muxing source itself with the number of its players
+        ret += flv_src->readerCount() - 1;
+    }
+    return MAX(ret, 0);
+}
+
+void RtmpMediaSource::getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
+                                    const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) {
+    std::shared_ptr<FlvMediaSource> flv_src;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        flv_src = _flv_src.lock();
+    }
+    if (!flv_src) {
+        _ring->getInfoList(cb, on_change);
+        return;
+    }
+    // 共享flv复用源本身没有设置播放器信息，只需合并两个环形缓冲的播放器列表
+    // The shared flv muxing source itself has no player info, just merge the player lists of the two rings
+    _ring->getInfoList([flv_src, cb, on_change](const std::list<toolkit::Any> &info_list) {
+        flv_src->getPlayerList([info_list, cb](const std::list<toolkit::Any> &flv_list) {
+            auto ret = info_list;
+            ret.insert(ret.end(), flv_list.begin(), flv_list.end());
+            cb(ret);
+        }, on_change);
+    }, on_change);
+}
+
+std::shared_ptr<FlvMediaSource> RtmpMediaSource::getFlvSource(const toolkit::EventPoller::Ptr &poller) {
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+    auto ret = _flv_src.lock();
+    if (!ret && _ring) {
+        ret = std::make_shared<FlvMediaSource>(std::static_pointer_cast<RtmpMediaSource>(shared_from_this()), _ring_size);
+        _flv_src = ret;
+        ret->start(poller);
+    }
+    return ret;
+}
+
+void RtmpMediaSource::onFlvReaderChanged() {
+    auto size = readerCount();
+    setReaderCount(size);
+    onReaderChanged(size);
 }
 
 RtmpMediaSourceImp::RtmpMediaSourceImp(const MediaTuple &tuple, int ringSize)
@@ -111,7 +170,16 @@ void RtmpMediaSourceImp::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
     if (!_all_track_ready || _muxer->isEnabled()) {
         // 未获取到所有Track后，或者开启转协议，那么需要解复用rtmp  [AUTO-TRANSLATED:76f6f56e]
         // If all Tracks are not obtained, or protocol conversion is enabled, then demultiplexing rtmp is required
+        MediaCost::Scope scope(_cost, MediaCost::kDemux);
+        if (_batch) {
+            // 部分rtmp解码器输出的帧直接引用rtmp包，批量写入时持有rtmp包即可
+            // Some rtmp decoders output frames referencing the rtmp packet directly, holding the packet is enough for the batch
+            _batch->setOwner(pkt);
+        }
         _demuxer->inputRtmp(pkt);
+        if (_batch) {
+            _batch->setOwner(nullptr);
+        }
     }
     GET_CONFIG(bool, directProxy, Rtmp::kDirectProxy);
     if (directProxy) {
@@ -129,23 +197,27 @@ void RtmpMediaSourceImp::setProtocolOption(const ProtocolOption &option) {
     GET_CONFIG(bool, direct_proxy, Rtmp::kDirectProxy);
     _option = option;
     _option.enable_rtmp = !direct_proxy;
+    // 直接代理时推流源本身即为rtmp播放源
+    // With direct proxy the published source itself is the rtmp source for players
+    setMergeWriteMS(option.merge_write_ms);
     _muxer = std::make_shared<MultiMediaSourceMuxer>(_tuple, _demuxer->getDuration(), _option);
     _muxer->setMediaListener(getListener());
     _muxer->setTrackListener(std::static_pointer_cast<RtmpMediaSourceImp>(shared_from_this()));
     // 让_muxer对象拦截一部分事件(比如说录像相关事件)  [AUTO-TRANSLATED:7d27c400]
     // Let the _muxer object intercept some events (such as recording related events)
     MediaSource::setListener(_muxer);
+    _batch = std::make_shared<FrameBatchWriter>(_muxer);
 
     for (auto &track : _demuxer->getTracks(false)) {
         _muxer->addTrack(track);
-        track->addDelegate(_muxer);
+        track->addDelegate(_batch);
     }
 }
 
 bool RtmpMediaSourceImp::addTrack(const Track::Ptr &track) {
     if (_muxer) {
         if (_muxer->addTrack(track)) {
-            track->addDelegate(_muxer);
+            track->addDelegate(_batch);
             return true;
         }
     }
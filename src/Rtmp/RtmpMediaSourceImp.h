@@ -80,6 +80,32 @@ public:
         return _option;
     }
 
+    /**
+     * 开始批量输入解复用出的帧，直到flushFrames，用于一次收到多个rtmp包时
+     * Start inputting the demuxed frames as a batch until flushFrames, used when multiple rtmp packets are received at once
+     */
+    void beginFrames() {
+        if (_batch) {
+            _batch->begin();
+        }
+    }
+
+    /**
+     * 结束批量输入但不写入，用于解析异常时
+     * End the batch input without writing, used when parsing throws
+     */
+    void endFrames() {
+        if (_batch) {
+            _batch->end();
+        }
+    }
+
+    void flushFrames() {
+        if (_batch) {
+            _batch->flush();
+        }
+    }
+
     /**
      * _demuxer触发的添加Track事件
      * _demuxer triggered add Track event
@@ -124,7 +150,7 @@ private:
     AMFValue _metadata;
     RtmpDemuxer::Ptr _demuxer;
     MultiMediaSourceMuxer::Ptr _muxer;
-
+    FrameBatchWriter::Ptr _batch;
 };
 } /* namespace mediakit */
 
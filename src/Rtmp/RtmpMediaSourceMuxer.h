@@ -13,10 +13,11 @@
 
 #include "RtmpMuxer.h"
 #include "Rtmp/RtmpMediaSource.h"
+#include "Common/GopCacheBudget.h"
 
 namespace mediakit {
 
-class RtmpMediaSourceMuxer final : public RtmpMuxer, public MediaSourceEventInterceptor,
+class RtmpMediaSourceMuxer final : public RtmpMuxer, public MediaSourceEventInterceptor, public DemandGopSeeder,
                                    public std::enable_shared_from_this<RtmpMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<RtmpMediaSourceMuxer>;
@@ -26,6 +27,8 @@ public:
                          const TitleMeta::Ptr &title = nullptr) : RtmpMuxer(title) {
         _option = option;
         _media_src = std::make_shared<RtmpMediaSource>(tuple);
+        _media_src->setMergeWriteMS(option.merge_write_ms);
+        _media_src->setGopCacheRebuildable();
         getRtmpRing()->setDelegate(_media_src);
     }
 
@@ -57,6 +60,7 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
+        onDemandReaderChanged(_option.rtmp_demand, _enabled, size);
         _enabled = _option.rtmp_demand ? size : true;
         if (!size && _option.rtmp_demand) {
             _clear_cache = true;
@@ -65,14 +69,22 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
+        return inputFrames(&frame, 1);
+    }
+
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override {
         if (_clear_cache && _option.rtmp_demand) {
             _clear_cache = false;
             _media_src->clearCache();
         }
-        if (_enabled || !_option.rtmp_demand) {
-            return RtmpMuxer::inputFrame(frame);
+        if (!_enabled && _option.rtmp_demand) {
+            return false;
         }
-        return false;
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = RtmpMuxer::inputFrame(frames[i]) ? true : ret;
+        }
+        return ret;
     }
 
     bool isEnabled() {
@@ -81,6 +93,39 @@ public:
         return _option.rtmp_demand ? (_clear_cache ? true : _enabled) : true;
     }
 
+    /**
+     * 从帧级gop缓存重建被淘汰的rtmp gop缓存，在归属线程中调用
+     * @param sender 被淘汰gop缓存的媒体源
+     * @param tracks 所有就绪的track
+     * @param gop 帧级gop缓存中最后一个gop的帧
+     * Rebuild the evicted rtmp gop cache from the frame level gop cache, called in the owner thread
+     * @param sender Media source whose gop cache was evicted
+     * @param tracks All ready tracks
+     * @param gop Frames of the last gop in the frame level gop cache
+     */
+    bool rebuildGopCache(MediaSource &sender, const std::vector<Track::Ptr> &tracks, const std::list<Frame::Ptr> &gop) {
+        if (&sender != _media_src.get()) {
+            return false;
+        }
+        // 用独立的复用器重新生成rtmp包，不影响直播复用器的状态
+        // Regenerate rtmp packets with a separate muxer so the state of the live muxer is not touched
+        RtmpMuxer muxer(nullptr);
+        auto collector = std::make_shared<GopCollector<RtmpPacket> >();
+        muxer.getRtmpRing()->setDelegate(collector);
+        for (auto &track : tracks) {
+            muxer.addTrack(track);
+        }
+        for (auto &frame : gop) {
+            muxer.inputFrame(frame);
+        }
+        // config包由播放器开始播放时单独发送
+        // Config packets are sent separately when a player starts playing
+        auto rebuilt = collector->getGop();
+        rebuilt->remove_if([](const RtmpPacket::Ptr &pkt) { return pkt->isConfigFrame(); });
+        _media_src->restoreGopCache(std::move(rebuilt));
+        return true;
+    }
+
 private:
     bool _enabled = true;
     bool _clear_cache = false;
@@ -10,6 +10,7 @@
 
 #include "RtmpSession.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
 #include "Util/onceToken.h"
 
 using namespace std;
@@ -67,7 +68,26 @@ void RtmpSession::onManager() {
 void RtmpSession::onRecv(const Buffer::Ptr &buf) {
     _ticker.resetTime();
     _total_bytes += buf->size();
-    onParseRtmp(buf->data(), buf->size());
+    Metrics::rtmp.bytes_in.add(buf->size());
+    // 一次收到的多个rtmp包解复用出的帧批量输入复用器
+    // Frames demuxed from the rtmp packets received at once are input into the muxer as a batch
+    auto push_src = _push_src;
+    if (push_src) {
+        push_src->beginFrames();
+    }
+    {
+        // onParseRtmp可能抛异常，确保批量输入状态被结束
+        // onParseRtmp may throw, make sure the batch input state is ended
+        onceToken token(nullptr, [&]() {
+            if (push_src) {
+                push_src->endFrames();
+            }
+        });
+        onParseRtmp(buf->data(), buf->size());
+    }
+    if (push_src) {
+        push_src->flushFrames();
+    }
 }
 
 void RtmpSession::onCmd_connect(AMFDecoder &dec) {
@@ -562,6 +582,7 @@ void RtmpSession::onRtmpChunk(RtmpPacket::Ptr packet) {
             }
             _push_config_packets.clear();
         }
+        Metrics::rtmp.packets_in.add();
         _push_src->onWrite(std::move(packet));
         break;
     }
@@ -587,6 +608,7 @@ void RtmpSession::onCmd_seek(AMFDecoder &dec) {
 }
 
 void RtmpSession::onSendMedia(const RtmpPacket::Ptr &pkt) {
+    Metrics::rtmp.packets_out.add();
     sendRtmp(pkt->type_id, pkt->stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
 }
 
@@ -19,6 +19,7 @@
 #include "RtmpMediaSourceImp.h"
 #include "Util/TimeTicker.h"
 #include "Network/Session.h"
+#include "Common/KTls.h"
 
 namespace mediakit {
 
@@ -54,6 +55,7 @@ private:
     void onSendMedia(const RtmpPacket::Ptr &pkt);
     void onSendRawData(toolkit::Buffer::Ptr buffer) override{
         _total_bytes += buffer->size();
+        Metrics::rtmp.bytes_out.add(buffer->size());
         send(std::move(buffer));
     }
     void onRtmpChunk(RtmpPacket::Ptr chunk_data) override;
@@ -118,7 +120,7 @@ private:
  
  * [AUTO-TRANSLATED:21d167ba]
  */
-using RtmpSessionWithSSL = toolkit::SessionWithSSL<RtmpSession>;
+using RtmpSessionWithSSL = SessionWithKTls<RtmpSession>;
 
 } /* namespace mediakit */
 #endif /* SRC_RTMP_RTMPSESSION_H_ */
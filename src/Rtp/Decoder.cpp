@@ -66,10 +66,37 @@ void DecoderImp::flush() {
     for (auto &pr : _tracks) {
         pr.second.second.flush();
     }
+    flushFrames();
 }
 
 ssize_t DecoderImp::input(const uint8_t *data, size_t bytes){
-    return _decoder->input(data, bytes);
+    ssize_t ret;
+    {
+        _batching = true;
+        // 解复用可能抛异常，确保批量状态被结束
+        // Demuxing may throw, make sure the batch state is ended
+        toolkit::onceToken token(nullptr, [&]() { _batching = false; });
+        ret = _decoder->input(data, bytes);
+    }
+    flushFrames();
+    return ret;
+}
+
+void DecoderImp::flushFrames() {
+    if (_frames.empty()) {
+        return;
+    }
+    std::vector<Frame::Ptr> frames;
+    frames.swap(_frames);
+    toolkit::onceToken token(nullptr, [&]() {
+        // 复用内存
+        // Reuse the memory
+        frames.clear();
+        if (_frames.empty()) {
+            _frames.swap(frames);
+        }
+    });
+    _sink->inputFrames(frames.data(), frames.size());
 }
 
 DecoderImp::DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink){
@@ -161,10 +188,19 @@ void DecoderImp::onTrack(int index, const Track::Ptr &track) {
 }
 
 void DecoderImp::onFrame(int index, const Frame::Ptr &frame) {
-    if (frame) {
-        frame->setIndex(index);
-        _sink->inputFrame(frame);
+    if (!frame) {
+        return;
+    }
+    frame->setIndex(index);
+    if (_batching && frame->cacheAble()) {
+        _frames.emplace_back(frame);
+        return;
     }
+    // 不可缓存的帧引用解复用器内部缓存，不做拷贝，先写入已缓存的帧以保持帧序，再直接写入
+    // A non-cacheable frame references the demuxer internal buffer, it is not copied,
+    // the cached frames are written first to keep the order, then it is written directly
+    flushFrames();
+    _sink->inputFrame(frame);
 }
 
 }//namespace mediakit
@@ -50,6 +50,7 @@ public:
 protected:
     void onTrack(int index, const Track::Ptr &track);
     void onFrame(int index, const Frame::Ptr &frame);
+    void flushFrames();
 
 private:
     DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink);
@@ -60,8 +61,14 @@ private:
     bool _finished = false;
     bool _have_video = false;
     bool _last_is_keyframe = false;
+    // 是否处于一次输入的解复用中
+    // Whether demuxing one input is in progress
+    bool _batching = false;
     Decoder::Ptr _decoder;
     MediaSinkInterface *_sink;
+    // 一次输入解复用出的帧，输入结束后批量写入
+    // Frames demuxed from one input, they are written as a batch when the input ends
+    std::vector<Frame::Ptr> _frames;
     class FrameMergerImp : public FrameMerger {
     public:
         FrameMergerImp() : FrameMerger(FrameMerger::none) {}
@@ -16,6 +16,7 @@
 #include "Util/File.h"
 #include "Common/config.h"
 #include "Rtsp/RtpReceiver.h"
+#include "Rtsp/RtpFec.h"
 #include "Rtsp/Rtsp.h"
 
 using namespace std;
@@ -40,6 +41,14 @@ public:
         // GB28181推流不支持ntp时间戳  [AUTO-TRANSLATED:f661f052]
         // GB28181 streaming does not support ntp timestamps
         setNtpStamp(0, 0);
+
+        GET_CONFIG(uint32_t, red_pt, RtpProxy::kRedPT);
+        GET_CONFIG(uint32_t, ulpfec_pt, RtpProxy::kUlpfecPT);
+        GET_CONFIG(uint32_t, adaptive_jitter_ms, Rtp::kAdaptiveJitterMS);
+        if (red_pt || ulpfec_pt) {
+            setFecPayloadType(red_pt ? red_pt : 0xFF, ulpfec_pt ? ulpfec_pt : 0xFF);
+        }
+        setAdaptive(adaptive_jitter_ms);
     }
 
     bool inputRtp(TrackType type, uint8_t *ptr, size_t len) {
@@ -73,9 +82,30 @@ bool GB28181Process::inputRtp(bool, const char *data, size_t data_len) {
     GET_CONFIG(uint32_t, h265_pt, RtpProxy::kH265PT);
     GET_CONFIG(uint32_t, ps_pt, RtpProxy::kPSPT);
     GET_CONFIG(uint32_t, opus_pt, RtpProxy::kOpusPT);
+    GET_CONFIG(uint32_t, red_pt, RtpProxy::kRedPT);
+    GET_CONFIG(uint32_t, ulpfec_pt, RtpProxy::kUlpfecPT);
 
     RtpHeader *header = (RtpHeader *)data;
     auto pt = header->pt;
+    if (red_pt && pt == red_pt) {
+        // red包交给其主负载对应的接收器解封装
+        // Red packets are decapsulated by the receiver of their primary block
+        auto primary_pt = RtpFecReceiver::getRedPrimaryPT((uint8_t *)data, data_len);
+        if (primary_pt < 0 || (uint32_t)primary_pt == red_pt || (uint32_t)primary_pt == ulpfec_pt) {
+            return false;
+        }
+        pt = primary_pt;
+    } else if (ulpfec_pt && pt == ulpfec_pt) {
+        // ulpfec包交给相同ssrc的接收器用于恢复
+        // Ulpfec packets go to the receiver with the same ssrc for recovery
+        auto ssrc = ntohl(header->ssrc);
+        for (auto &pr : _rtp_receiver) {
+            if (pr.second->getSSRC() == ssrc) {
+                return pr.second->inputRtp(TrackVideo, (unsigned char *)data, data_len);
+            }
+        }
+        return false;
+    }
     auto &ref = _rtp_receiver[pt];
     if (!ref) {
         if (_rtp_receiver.size() > 2) {
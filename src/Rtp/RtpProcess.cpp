@@ -13,6 +13,7 @@
 #include "RtpProcess.h"
 #include "Util/File.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
 
 using namespace std;
 using namespace toolkit;
@@ -25,8 +26,9 @@ static constexpr size_t kMaxCachedFrameMS = 10 * 1000;
 
 namespace mediakit {
 
-RtpProcess::Ptr RtpProcess::createProcess(const MediaTuple &tuple) {
+RtpProcess::Ptr RtpProcess::createProcess(const MediaTuple &tuple, EventPoller::Ptr poller) {
     RtpProcess::Ptr ret(new RtpProcess(tuple));
+    ret->_poller = std::move(poller);
     ret->createTimer();
     return ret;
 }
@@ -96,7 +98,7 @@ void RtpProcess::createTimer() {
         }
         strongSelf->onManager();
         return true;
-    }, EventPollerPool::Instance().getPoller());
+    }, _poller ? _poller : EventPollerPool::Instance().getPoller());
 }
 
 bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data, size_t len, const struct sockaddr *addr, uint64_t *dts_out) {
@@ -107,6 +109,8 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
     if (!_auth_err.empty()) {
         throw toolkit::SockException(toolkit::Err_other, _auth_err);
     }
+    Metrics::rtp.packets_in.add();
+    Metrics::rtp.bytes_in.add(len);
     auto header = (RtpHeader *) data;
     if (_sock != sock) {
         // 第一次运行本函数  [AUTO-TRANSLATED:a1d7ac17]
@@ -142,7 +146,15 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
         return false;
     }
 
-    bool ret = _process ? _process->inputRtp(is_udp, data, len) : false;
+    bool ret = false;
+    if (_muxer) {
+        // 统计ps/ts解复用开销(包括其同步触发的复用与分发，计时器会扣除嵌套部分)
+        // Account the ps/ts demuxing cost (the muxing and fan-out it triggers synchronously are taken out by the nested timers)
+        MediaCost::Scope scope(_muxer->getCost(), MediaCost::kDemux);
+        ret = _process->inputRtp(is_udp, data, len);
+    } else {
+        ret = _process->inputRtp(is_udp, data, len);
+    }
     if (dts_out) {
         *dts_out = _dts;
     }
@@ -171,6 +183,17 @@ bool RtpProcess::inputFrame(const Frame::Ptr &frame) {
     return true;
 }
 
+bool RtpProcess::inputFrames(const Frame::Ptr *frames, size_t size) {
+    if (!_muxer || _save_file_video || !size) {
+        // 未就绪或需要保存视频时逐帧处理
+        // Frames are handled one by one when not ready or the video needs to be saved
+        return MediaSinkInterface::inputFrames(frames, size);
+    }
+    _dts = frames[size - 1]->dts();
+    _last_frame_time.resetTime();
+    return _muxer->inputFrames(frames, size);
+}
+
 bool RtpProcess::addTrack(const Track::Ptr &track) {
     if (_muxer) {
         return _muxer->addTrack(track);
@@ -330,6 +353,9 @@ bool RtpProcess::close(mediakit::MediaSource &sender) {
 }
 
 toolkit::EventPoller::Ptr RtpProcess::getOwnerPoller(MediaSource &sender) {
+    if (_poller) {
+        return _poller;
+    }
     if (_sock) {
         return _sock->getPoller();
     }
@@ -25,7 +25,15 @@ public:
     using Ptr = std::shared_ptr<RtpProcess>;
     using onDetachCB = std::function<void(const toolkit::SockException &ex)>;
 
-    static Ptr createProcess(const MediaTuple &tuple);
+    /**
+     * 创建rtp处理器
+     * @param tuple 流标识
+     * @param poller 处理器所属的poller线程，为空时为接收rtp的socket所属的poller线程
+     * Create an rtp processor
+     * @param tuple Stream identifier
+     * @param poller The poller thread owning the processor, the poller of the socket receiving the rtp when null
+     */
+    static Ptr createProcess(const MediaTuple &tuple, toolkit::EventPoller::Ptr poller = nullptr);
     ~RtpProcess();
     enum OnlyTrack { kAll = 0, kOnlyAudio = 1, kOnlyVideo = 2 };
 
@@ -105,6 +113,7 @@ public:
 
 protected:
     bool inputFrame(const Frame::Ptr &frame) override;
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override;
     bool addTrack(const Track::Ptr & track) override;
     void addTrackCompleted() override;
     void resetTracks() override {};
@@ -144,6 +153,7 @@ private:
     ProcessInterface::Ptr _process;
     MultiMediaSourceMuxer::Ptr _muxer;
     toolkit::Timer::Ptr _timer;
+    toolkit::EventPoller::Ptr _poller;
     toolkit::Ticker _last_check_alive;
     std::recursive_mutex _func_mtx;
     toolkit::Ticker _cache_ticker;
@@ -16,6 +16,7 @@
 #include "Util/uv_errno.h"
 #include "RtpCache.h"
 #include "Rtcp/RtcpContext.h"
+#include "Common/Metrics.h"
 
 using namespace std;
 using namespace toolkit;
@@ -420,15 +421,20 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
 
     auto send_func = [this](const shared_ptr<List<Buffer::Ptr>> &rtp_list) {
         size_t i = 0;
+        size_t bytes = 0;
         auto size = rtp_list->size();
         rtp_list->for_each([&](Buffer::Ptr &packet) {
+            bytes += packet->size();
             switch (_args.con_type) {
                 case MediaSourceEvent::SendRtpArgs::kUdpActive:
                 case MediaSourceEvent::SendRtpArgs::kUdpPassive: {
                     onSendRtpUdp(packet, i == 0);
                     // udp模式，rtp over tcp前4个字节可以忽略  [AUTO-TRANSLATED:5d648f4b]
                     // UDP mode, the first 4 bytes of rtp over tcp can be ignored
-                    _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                    _rtp_batch.input(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize));
+                    if (++i == size) {
+                        _rtp_batch.flush(_socket_rtp);
+                    }
                     break;
                 }
                 case MediaSourceEvent::SendRtpArgs::kTcpActive:
@@ -455,6 +461,8 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
                 _origin_socket->enableRecv(false);
             }
         });
+        Metrics::rtp.packets_out.add(size);
+        Metrics::rtp.bytes_out.add(bytes);
     };
     if (_args.con_type != MediaSourceEvent::SendRtpArgs::kVoiceTalk) {
         weak_ptr<RtpSender> weak_self = shared_from_this();
@@ -479,7 +487,7 @@ void RtpSender::setOnClose(std::function<void(const toolkit::SockException &ex)>
 }
 
 size_t RtpSender::getSendSpeed() const {
-    size_t ret = 0;
+    size_t ret = _rtp_batch.getSendSpeed();
     if (_socket_rtp) {
         ret += _socket_rtp->getSendSpeed();
     }
@@ -512,7 +520,7 @@ size_t RtpSender::getRecvTotalBytes() const {
 }
 
 size_t RtpSender::getSendTotalBytes() const {
-    size_t ret = 0;
+    size_t ret = _rtp_batch.getSendTotalBytes();
     if (_socket_rtp) {
         ret += _socket_rtp->getSendTotalBytes();
     }
@@ -9,11 +9,14 @@
  */
 
 #if defined(ENABLE_RTPPROXY)
+#include <unordered_map>
 #include "Util/uv_errno.h"
 #include "RtpServer.h"
 #include "RtpProcess.h"
 #include "Rtcp/RtcpContext.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Common/UdpBatchReceiver.h"
 
 using namespace std;
 using namespace toolkit;
@@ -134,6 +137,169 @@ private:
     std::shared_ptr<struct sockaddr_storage> _rtcp_addr;
 };
 
+// 单端口批量接收模式下的rtp分发器，每个工作线程一个实例，按ssrc把整批数据分发给RtpProcess
+// 只在所属poller线程访问，无需加锁
+// Rtp dispatcher of the single port batch receive mode, one instance per worker thread,
+// dispatches the whole batch to RtpProcess by ssrc; only accessed in its own poller thread, so no lock is needed
+class RtpBatchDispatcher : public std::enable_shared_from_this<RtpBatchDispatcher> {
+public:
+    using Ptr = std::shared_ptr<RtpBatchDispatcher>;
+
+    RtpBatchDispatcher(MediaTuple tuple, int only_track, EventPoller::Ptr poller) {
+        _tuple = std::move(tuple);
+        _only_track = only_track;
+        _poller = std::move(poller);
+    }
+
+    void inputBatch(const Socket::Ptr &sock, Buffer::Ptr *buf, struct sockaddr_storage *addr, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            inputRtp(sock, buf[i]->data(), buf[i]->size(), addr[i]);
+        }
+    }
+
+private:
+    void inputRtp(const Socket::Ptr &sock, const char *data, size_t len, const struct sockaddr_storage &addr) {
+        uint32_t ssrc = 0;
+        if (!isRtp(data, len) || !getSSRC(data, len, ssrc)) {
+            // 忽略非rtp数据
+            // Ignore non-rtp data
+            return;
+        }
+        // 同一批次内的包大多来自同一设备，先比较上个包的ssrc以免查表
+        // Most datagrams of a batch come from the same device, compare with the ssrc of the previous one to skip the lookup
+        if (!_last_process || ssrc != _last_ssrc) {
+            _last_ssrc = ssrc;
+            _last_process = getProcess(ssrc);
+        }
+        try {
+            _last_process->inputRtp(false, sock, data, len, (struct sockaddr *)&addr);
+        } catch (std::exception &ex) {
+            WarnL << "rtp process " << printSSRC(ssrc) << " error: " << ex.what();
+            _processes.erase(ssrc);
+            _last_process = nullptr;
+        }
+    }
+
+    RtpProcess::Ptr getProcess(uint32_t ssrc) {
+        auto &ref = _processes[ssrc];
+        if (ref) {
+            return ref;
+        }
+        auto tuple = _tuple;
+        // 未指定流id就使用ssrc为流id
+        // Use ssrc as stream id if stream id is not specified
+        tuple.stream = printSSRC(ssrc);
+        // 处理器的定时器与onDetach回调都在本线程执行，与_processes的访问不冲突
+        // The timer and the onDetach callback of the processor run in this thread, so they do not race with _processes
+        ref = RtpProcess::createProcess(tuple, _poller);
+        ref->setOnlyTrack((RtpProcess::OnlyTrack)_only_track);
+        weak_ptr<RtpBatchDispatcher> weak_self = shared_from_this();
+        weak_ptr<RtpProcess> weak_process = ref;
+        ref->setOnDetach([weak_self, weak_process, ssrc](const SockException &ex) {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
+            }
+            auto it = strong_self->_processes.find(ssrc);
+            if (it != strong_self->_processes.end() && it->second == weak_process.lock()) {
+                strong_self->_processes.erase(it);
+                if (strong_self->_last_ssrc == ssrc) {
+                    strong_self->_last_process = nullptr;
+                }
+            }
+        });
+        return ref;
+    }
+
+private:
+    int _only_track = 0;
+    uint32_t _last_ssrc = 0;
+    MediaTuple _tuple;
+    EventPoller::Ptr _poller;
+    RtpProcess::Ptr _last_process;
+    std::unordered_map<uint32_t, RtpProcess::Ptr> _processes;
+};
+
+// 单端口批量接收模式下的rtp路由器，解析rtp头后按ssrc哈希把数据转交给固定的工作线程，
+// 使各流的ps/ts解复用、分帧与复用分散到多个poller线程，而不是全部在收到数据的线程处理(例如多个设备经同一网关推流时)
+// 同一ssrc总是交给同一个分发器，即使其数据经不同的SO_REUSEPORT socket到达也只会创建一个RtpProcess
+// 每个接收socket一个实例，只在所属poller线程访问
+// Rtp router of the single port batch receive mode, after parsing the rtp header the data is handed to a fixed worker thread by ssrc hash,
+// so the ps/ts demuxing, frame splitting and muxing of the streams spread over several poller threads instead of all running
+// on the thread that received the data (e.g. when many devices publish through the same gateway)
+// One ssrc always goes to the same dispatcher, so only one RtpProcess is created even if its data arrives on different SO_REUSEPORT sockets
+// One instance per receiving socket, only accessed in its own poller thread
+class RtpDemuxRouter {
+public:
+    using Ptr = std::shared_ptr<RtpDemuxRouter>;
+
+    struct Worker {
+        EventPoller::Ptr poller;
+        RtpBatchDispatcher::Ptr dispatcher;
+    };
+    using WorkerList = std::vector<Worker>;
+
+    RtpDemuxRouter(EventPoller::Ptr poller, std::shared_ptr<WorkerList> workers) {
+        _poller = std::move(poller);
+        _workers = std::move(workers);
+        _batches.resize(_workers->size());
+    }
+
+    void inputBatch(const Socket::Ptr &sock, Buffer::Ptr *buf, struct sockaddr_storage *addr, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t ssrc = 0;
+            if (!isRtp(buf[i]->data(), buf[i]->size()) || !getSSRC(buf[i]->data(), buf[i]->size(), ssrc)) {
+                continue;
+            }
+            // 乘法哈希打散相近的ssrc(国标ssrc多为连续的十进制编号)
+            // Multiplicative hashing spreads close ssrcs (gb28181 ssrcs are mostly consecutive decimal numbers)
+            auto &batch = _batches[((ssrc * 2654435761u) >> 16) % _batches.size()];
+            // 取走缓存的所有权，接收缓存会重新分配，数据可以安全地交给其他线程
+            // Take ownership of the buffer, the receive buffer is reallocated so the data can be handed to other threads safely
+            batch.buf.emplace_back(std::move(buf[i]));
+            batch.addr.emplace_back(addr[i]);
+        }
+
+        Batch *local = nullptr;
+        for (size_t i = 0; i < _batches.size(); ++i) {
+            auto &batch = _batches[i];
+            if (batch.buf.empty()) {
+                continue;
+            }
+            auto &worker = (*_workers)[i];
+            if (worker.poller == _poller) {
+                local = &batch;
+                continue;
+            }
+            // 每个工作线程每批只切换一次线程
+            // Only one thread switch per worker thread per batch
+            auto task = std::make_shared<Batch>(std::move(batch));
+            batch = Batch();
+            auto dispatcher = worker.dispatcher;
+            worker.poller->async([dispatcher, sock, task]() {
+                dispatcher->inputBatch(sock, task->buf.data(), task->addr.data(), task->buf.size());
+            }, false);
+        }
+        if (local) {
+            // 先投递给其他线程再处理本线程负责的流，让各线程并行
+            // Posted to the other threads first, then the streams of this thread are handled, so the threads run in parallel
+            (*_workers)[local - _batches.data()].dispatcher->inputBatch(sock, local->buf.data(), local->addr.data(), local->buf.size());
+            local->buf.clear();
+            local->addr.clear();
+        }
+    }
+
+private:
+    struct Batch {
+        std::vector<Buffer::Ptr> buf;
+        std::vector<struct sockaddr_storage> addr;
+    };
+
+    EventPoller::Ptr _poller;
+    std::shared_ptr<WorkerList> _workers;
+    std::vector<Batch> _batches;
+};
+
 void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTuple &tuple, TcpMode tcp_mode, bool re_use_port, uint32_t ssrc, int only_track, bool multiplex) {
     // 创建udp服务器  [AUTO-TRANSLATED:99619428]
     // Create UDP server
@@ -160,10 +326,13 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
     // Set UDP socket read cache
     GET_CONFIG(int, udpRecvSocketBuffer, RtpProxy::kUdpRecvSocketBuffer);
     SockUtil::setRecvBuf(rtp_socket->rawFD(), udpRecvSocketBuffer);
+    GET_CONFIG(bool, udpBatchRecv, RtpProxy::kUdpBatchRecv);
+    GET_CONFIG(size_t, demuxWorkers, RtpProxy::kDemuxWorkers);
 
     // 创建udp服务器  [AUTO-TRANSLATED:99619428]
     // Create UDP server
     UdpServer::Ptr udp_server;
+    UdpBatchReceiver::Ptr udp_batch;
     RtcpHelper::Ptr helper;
     // 增加了多路复用判断，如果多路复用为true，就走else逻辑，同时保留了原来stream_id为空走else逻辑  [AUTO-TRANSLATED:114690b1]
     // Added multiplexing judgment. If multiplexing is true, then go to the else logic, while retaining the original stream_id is empty to go to the else logic
@@ -182,6 +351,7 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
             auto ssrc = *ssrc_ptr;
             if (ssrc && rtp_ssrc != ssrc) {
                 WarnL << "ssrc mismatched, rtp dropped: " << rtp_ssrc << " != " << ssrc;
+                Metrics::dropped_ssrc_mismatch.add();
             } else {
                 if (!bind_peer_addr) {
                     // 绑定对方ip+端口，防止多个设备或一个设备多次推流从而日志报ssrc不匹配问题  [AUTO-TRANSLATED:f27dd373]
@@ -192,6 +362,28 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
                 helper->onRecvRtp(rtp_socket, buf, addr);
             }
         });
+    } else if (tuple.stream.empty() && (udpBatchRecv || demuxWorkers)) {
+        // 单端口多线程批量接收多个流，每个poller线程一个socket，根据ssrc区分流
+        // Single port multi-threaded batch reception of multiple streams, one socket per poller thread, streams are distinguished by ssrc
+        // 内核按来源地址分流，同一ssrc可能经不同socket到达(如设备更换了源端口)，所以总是按ssrc路由，
+        // 未指定demux_workers时每个poller线程一个分发器
+        // The kernel spreads by source address, one ssrc may arrive on different sockets (e.g. the device changed its source port),
+        // so it is always routed by ssrc; without demux_workers there is one dispatcher per poller thread
+        auto workers = std::make_shared<RtpDemuxRouter::WorkerList>();
+        EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            if (!demuxWorkers || workers->size() < demuxWorkers) {
+                auto worker_poller = static_pointer_cast<EventPoller>(executor);
+                workers->emplace_back(RtpDemuxRouter::Worker { worker_poller, std::make_shared<RtpBatchDispatcher>(tuple, only_track, worker_poller) });
+            }
+        });
+        udp_batch = std::make_shared<UdpBatchReceiver>();
+        udp_batch->start(local_port, local_ip, udpRecvSocketBuffer, [workers](const EventPoller::Ptr &poller) -> UdpBatchReceiver::onBatchCB {
+            auto router = std::make_shared<RtpDemuxRouter>(poller, workers);
+            return [router](const Socket::Ptr &sock, Buffer::Ptr *buf, struct sockaddr_storage *addr, size_t count) {
+                router->inputBatch(sock, buf, addr, count);
+            };
+        });
+        rtp_socket = nullptr;
     } else {
         // 单端口多线程接收多个流，根据ssrc区分流  [AUTO-TRANSLATED:e11c3ca8]
         // Single-port multi-threaded reception of multiple streams, distinguishing streams based on SSRC
@@ -237,6 +429,7 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
 
     _tcp_server = tcp_server;
     _udp_server = udp_server;
+    _udp_batch = udp_batch;
     _rtp_socket = rtp_socket;
     _rtcp_helper = helper;
     _tcp_mode = tcp_mode;
@@ -249,6 +442,9 @@ void RtpServer::setOnDetach(RtpProcess::onDetachCB cb) {
 }
 
 uint16_t RtpServer::getPort() {
+    if (_udp_batch) {
+        return _udp_batch->getPort();
+    }
     return _udp_server ? _udp_server->getPort() : _rtp_socket->get_local_port();
 }
 
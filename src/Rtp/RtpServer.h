@@ -21,6 +21,7 @@
 namespace mediakit {
 
 class RtcpHelper;
+class UdpBatchReceiver;
 
 /**
  * RTP服务器，支持UDP/TCP
@@ -108,6 +109,7 @@ private:
 protected:
     toolkit::Socket::Ptr _rtp_socket;
     toolkit::UdpServer::Ptr _udp_server;
+    std::shared_ptr<UdpBatchReceiver> _udp_batch;
     toolkit::TcpServer::Ptr _tcp_server;
     std::shared_ptr<uint32_t> _ssrc;
     std::shared_ptr<RtcpHelper> _rtcp_helper;
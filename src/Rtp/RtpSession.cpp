@@ -15,6 +15,7 @@
 #include "Rtsp/Rtsp.h"
 #include "Rtsp/RtpReceiver.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
 
 using namespace std;
 using namespace toolkit;
@@ -136,6 +137,7 @@ void RtpSession::onRtpPacket(const char *data, size_t len) {
         getSSRC(data, len, rtp_ssrc);
         if (rtp_ssrc != _ssrc) {
             WarnP(this) << "ssrc mismatched, rtp dropped: " << rtp_ssrc << " != " << _ssrc;
+            Metrics::dropped_ssrc_mismatch.add();
             return;
         }
         _process->inputRtp(false, getSock(), data, len, (struct sockaddr *)&_addr);
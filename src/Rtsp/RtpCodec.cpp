@@ -14,8 +14,7 @@ namespace mediakit{
 
 RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bool mark, uint64_t stamp) {
     uint16_t payload_len = (uint16_t) (len + RtpPacket::kRtpHeaderSize);
-    auto rtp = RtpPacket::create();
-    rtp->setCapacity(payload_len + RtpPacket::kRtpTcpHeaderSize);
+    auto rtp = RtpPacket::create(payload_len + RtpPacket::kRtpTcpHeaderSize);
     rtp->setSize(payload_len + RtpPacket::kRtpTcpHeaderSize);
     rtp->sample_rate = _sample_rate;
     rtp->type = type;
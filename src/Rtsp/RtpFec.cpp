@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstring>
+#include "RtpFec.h"
+#include "Common/Metrics.h"
+
+using namespace std;
+
+namespace mediakit {
+
+// 保存的最近媒体包个数，须为2的幂且大于ulpfec最大保护范围(48个包)
+// Number of recent media packets kept, must be a power of 2 and larger than the max ulpfec protection range (48 packets)
+static constexpr size_t kHistorySize = 128;
+static constexpr size_t kMaxPending = 16;
+// ulpfec头长度与level 0头长度(短掩码/长掩码)
+// Length of the ulpfec header and the level 0 header (short mask / long mask)
+static constexpr size_t kFecHeaderSize = 10;
+static constexpr size_t kLevelHeaderSize = 4;
+static constexpr size_t kLevelHeaderSizeLong = 8;
+static constexpr size_t kMaskBits = 48;
+
+static inline uint16_t loadBE16(const uint8_t *ptr) {
+    return (ptr[0] << 8) | ptr[1];
+}
+
+static inline uint32_t loadBE32(const uint8_t *ptr) {
+    return ((uint32_t)ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+}
+
+static inline void saveBE16(uint8_t *ptr, uint16_t val) {
+    ptr[0] = val >> 8;
+    ptr[1] = val & 0xFF;
+}
+
+static inline void saveBE32(uint8_t *ptr, uint32_t val) {
+    ptr[0] = val >> 24;
+    ptr[1] = (val >> 16) & 0xFF;
+    ptr[2] = (val >> 8) & 0xFF;
+    ptr[3] = val & 0xFF;
+}
+
+// 以原包的rtp头(含csrc、ext，去掉padding)生成新的rtp包
+// Build a new rtp packet with the rtp header of the original packet (csrc and ext included, padding removed)
+static string makePacket(const uint8_t *ptr, size_t header_len, uint8_t pt, bool mark, uint16_t seq, uint32_t stamp, const uint8_t *payload, size_t size) {
+    string ret;
+    ret.reserve(header_len + size);
+    ret.append((const char *)ptr, header_len);
+    ret.append((const char *)payload, size);
+    auto data = (uint8_t *)&ret[0];
+    data[0] &= ~0x20;
+    data[1] = (mark ? 0x80 : 0) | (pt & 0x7F);
+    saveBE16(data + 2, seq);
+    saveBE32(data + 4, stamp);
+    return ret;
+}
+
+static Metric s_red_recovered("zlm_fec_recovered_packets_total", "Lost rtp packets recovered by fec", Metric::Counter, "type=\"red\"");
+static Metric s_ulpfec_recovered("zlm_fec_recovered_packets_total", "Lost rtp packets recovered by fec", Metric::Counter, "type=\"ulpfec\"");
+
+RtpFecReceiver::RtpFecReceiver(uint8_t red_pt, uint8_t ulpfec_pt) {
+    _red_pt = red_pt;
+    _ulpfec_pt = ulpfec_pt;
+    _history.resize(kHistorySize);
+}
+
+void RtpFecReceiver::inputFec(const uint8_t *ptr, size_t len) {
+    auto header = (RtpHeader *)ptr;
+    if (len < RtpPacket::kRtpHeaderSize || header->version != RtpPacket::kRtpVersion || header->getPayloadSize(len) <= 0) {
+        return;
+    }
+    if (header->pt == _red_pt) {
+        inputRed(ptr, len);
+    } else {
+        inputUlpfec(ptr, len);
+    }
+}
+
+void RtpFecReceiver::inputRed(const uint8_t *ptr, size_t len) {
+    auto header = (RtpHeader *)ptr;
+    auto payload = header->getPayloadData();
+    auto size = (size_t)header->getPayloadSize(len);
+    auto header_len = (size_t)(payload - ptr);
+    auto seq = ntohs(header->seq);
+    auto stamp = ntohl(header->stamp);
+
+    // 冗余块头为4个字节(F、pt、时间戳偏移、块长度)，主负载块头为1个字节
+    // Redundant block headers are 4 bytes (F, pt, timestamp offset, block length), the primary block header is 1 byte
+    struct Block {
+        uint8_t pt;
+        uint32_t stamp_offset;
+        size_t size;
+    };
+    Block blocks[16];
+    size_t count = 0;
+    size_t offset = 0;
+    size_t blocks_size = 0;
+    while (offset < size && (payload[offset] & 0x80)) {
+        if (offset + 4 > size || count == sizeof(blocks) / sizeof(blocks[0]) - 1) {
+            return;
+        }
+        auto &block = blocks[count++];
+        block.pt = payload[offset] & 0x7F;
+        block.stamp_offset = (loadBE16(payload + offset + 1) >> 2);
+        block.size = loadBE16(payload + offset + 2) & 0x3FF;
+        blocks_size += block.size;
+        offset += 4;
+    }
+    if (offset >= size || offset + 1 + blocks_size > size) {
+        // 非法的red包
+        // Invalid red packet
+        return;
+    }
+    auto primary_pt = payload[offset] & 0x7F;
+    auto block_ptr = payload + offset + 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        auto &block = blocks[i];
+        // 冗余块没有seq，按其在主负载之前的位置推算
+        // Redundant blocks carry no seq, it is derived from their position before the primary block
+        uint16_t block_seq = seq - (count - i);
+        // 只输出未收到的包，比历史记录更早的包无法判断是否已收到，忽略之
+        // Only output packets not received yet, packets older than the history cannot be checked and are ignored
+        bool too_old = _started && static_cast<uint16_t>(_latest_seq - block_seq) >= kHistorySize
+            && static_cast<uint16_t>(block_seq - _latest_seq) >= 0x8000;
+        if (block.size && block.pt != _red_pt && !too_old && !hasPacket(block_seq)) {
+            auto packet = makePacket(ptr, header_len, block.pt, false, block_seq, stamp - block.stamp_offset, block_ptr, block.size);
+            if (block.pt == _ulpfec_pt) {
+                inputUlpfec((uint8_t *)packet.data(), packet.size());
+            } else {
+                s_red_recovered.add();
+                _output.emplace_back(std::move(packet));
+            }
+        }
+        block_ptr += block.size;
+    }
+
+    auto primary_size = size - (block_ptr - payload);
+    if (!primary_size || primary_pt == _red_pt) {
+        return;
+    }
+    auto packet = makePacket(ptr, header_len, primary_pt, header->mark, seq, stamp, block_ptr, primary_size);
+    if (primary_pt == _ulpfec_pt) {
+        inputUlpfec((uint8_t *)packet.data(), packet.size());
+    } else {
+        _output.emplace_back(std::move(packet));
+    }
+}
+
+void RtpFecReceiver::inputUlpfec(const uint8_t *ptr, size_t len) {
+    auto header = (RtpHeader *)ptr;
+    auto payload = header->getPayloadData();
+    auto size = header->getPayloadSize(len);
+    if (size < (ssize_t)(kFecHeaderSize + kLevelHeaderSize) || (payload[0] & 0x80)) {
+        // E标志位为扩展保留，必须为0
+        // The E flag is reserved for extension and must be 0
+        return;
+    }
+    bool long_mask = payload[0] & 0x40;
+    auto level_header_size = long_mask ? kLevelHeaderSizeLong : kLevelHeaderSize;
+    if (size < (ssize_t)(kFecHeaderSize + level_header_size)) {
+        return;
+    }
+    auto level = payload + kFecHeaderSize;
+    auto protection_len = loadBE16(level);
+    if (size < (ssize_t)(kFecHeaderSize + level_header_size + protection_len)) {
+        return;
+    }
+
+    PendingFec fec;
+    fec.seq_base = loadBE16(payload + 2);
+    // 掩码统一按48位保存，最高位对应seq_base
+    // Masks are kept as 48 bits, the most significant bit maps to seq_base
+    fec.mask = (uint64_t)loadBE16(level + 2) << 32;
+    if (long_mask) {
+        fec.mask |= loadBE32(level + 4);
+    }
+    // 只保存fec头、level 0头与其负载，不含rtp头
+    // Only keep the fec header, the level 0 header and its payload, without the rtp header
+    fec.fec.assign((const char *)payload, kFecHeaderSize + level_header_size + protection_len);
+    // 恢复出的包沿用fec包的ssrc
+    // The recovered packet reuses the ssrc of the fec packet
+    fec.fec.append((const char *)&header->ssrc, 4);
+
+    if (!tryRecover(fec)) {
+        _pending.emplace_back(std::move(fec));
+        if (_pending.size() > kMaxPending) {
+            _pending.pop_front();
+        }
+    }
+}
+
+void RtpFecReceiver::inputMedia(const RtpPacket::Ptr &rtp) {
+    auto seq = rtp->getSeq();
+    if (!_started || static_cast<uint16_t>(seq - _latest_seq) < 0x8000) {
+        _started = true;
+        _latest_seq = seq;
+    }
+    _history[seq & (kHistorySize - 1)] = rtp;
+
+    for (auto it = _pending.begin(); it != _pending.end();) {
+        if (static_cast<uint16_t>(_latest_seq - it->seq_base) >= kHistorySize - kMaskBits) {
+            // 保护的包已移出历史记录，无法再恢复
+            // The protected packets have left the history and can no longer be recovered
+            it = _pending.erase(it);
+            continue;
+        }
+        if (tryRecover(*it)) {
+            // 每次最多恢复一个包，恢复出的包重新输入后再尝试其他fec包，防止重复恢复
+            // Recover at most one packet at a time, other fec packets are tried after the recovered one is input, to avoid recovering it twice
+            _pending.erase(it);
+            break;
+        }
+        ++it;
+    }
+}
+
+bool RtpFecReceiver::popPacket(string &out) {
+    if (_output.empty()) {
+        return false;
+    }
+    out = std::move(_output.front());
+    _output.pop_front();
+    return true;
+}
+
+int RtpFecReceiver::getRedPrimaryPT(const uint8_t *ptr, size_t len) {
+    auto header = (RtpHeader *)ptr;
+    if (len < RtpPacket::kRtpHeaderSize || header->getPayloadSize(len) <= 0) {
+        return -1;
+    }
+    auto payload = header->getPayloadData();
+    auto size = (size_t)header->getPayloadSize(len);
+    size_t offset = 0;
+    while (offset < size && (payload[offset] & 0x80)) {
+        offset += 4;
+    }
+    return offset < size ? payload[offset] & 0x7F : -1;
+}
+
+bool RtpFecReceiver::hasPacket(uint16_t seq) const {
+    auto &rtp = _history[seq & (kHistorySize - 1)];
+    return rtp && rtp->getSeq() == seq;
+}
+
+bool RtpFecReceiver::tryRecover(const PendingFec &fec) {
+    size_t lost = 0;
+    uint16_t lost_seq = 0;
+    for (size_t i = 0; i < kMaskBits; ++i) {
+        if (!((fec.mask >> (kMaskBits - 1 - i)) & 1)) {
+            continue;
+        }
+        uint16_t seq = fec.seq_base + i;
+        if (!hasPacket(seq)) {
+            lost_seq = seq;
+            if (++lost > 1) {
+                return false;
+            }
+        }
+    }
+    if (lost) {
+        recover(fec, lost_seq);
+    }
+    return true;
+}
+
+void RtpFecReceiver::recover(const PendingFec &fec, uint16_t lost_seq) {
+    auto fec_header = (const uint8_t *)fec.fec.data();
+    auto level_header_size = (fec_header[0] & 0x40) ? kLevelHeaderSizeLong : kLevelHeaderSize;
+    auto protection_len = loadBE16(fec_header + kFecHeaderSize);
+    auto fec_payload = fec_header + kFecHeaderSize + level_header_size;
+
+    // 异或fec头与所有收到的被保护包，得到丢失包的rtp头字段、长度与负载
+    // Xor the fec header with all received protected packets to get the rtp header fields, length and payload of the lost packet
+    uint8_t bits[2] = { fec_header[0], fec_header[1] };
+    uint32_t stamp = loadBE32(fec_header + 4);
+    uint16_t length = loadBE16(fec_header + 8);
+    string ret(RtpPacket::kRtpHeaderSize + protection_len, '\0');
+    auto data = (uint8_t *)&ret[0];
+    auto payload = data + RtpPacket::kRtpHeaderSize;
+    memcpy(payload, fec_payload, protection_len);
+
+    for (size_t i = 0; i < kMaskBits; ++i) {
+        if (!((fec.mask >> (kMaskBits - 1 - i)) & 1)) {
+            continue;
+        }
+        uint16_t seq = fec.seq_base + i;
+        if (seq == lost_seq) {
+            continue;
+        }
+        auto &rtp = _history[seq & (kHistorySize - 1)];
+        auto ptr = (const uint8_t *)rtp->data() + RtpPacket::kRtpTcpHeaderSize;
+        auto len = rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+        bits[0] ^= ptr[0];
+        bits[1] ^= ptr[1];
+        stamp ^= loadBE32(ptr + 4);
+        length ^= (uint16_t)(len - RtpPacket::kRtpHeaderSize);
+        auto size = (std::min<size_t>)(len - RtpPacket::kRtpHeaderSize, protection_len);
+        for (size_t j = 0; j < size; ++j) {
+            payload[j] ^= ptr[RtpPacket::kRtpHeaderSize + j];
+        }
+    }
+    if (length > protection_len) {
+        // 丢失包超出保护长度的部分无法恢复
+        // The part of the lost packet beyond the protection length cannot be recovered
+        return;
+    }
+
+    data[0] = (RtpPacket::kRtpVersion << 6) | (bits[0] & 0x3F);
+    data[1] = bits[1];
+    saveBE16(data + 2, lost_seq);
+    saveBE32(data + 4, stamp);
+    memcpy(data + 8, fec_header + fec.fec.size() - 4, 4);
+    ret.resize(RtpPacket::kRtpHeaderSize + length);
+    s_ulpfec_recovered.add();
+    _output.emplace_back(std::move(ret));
+}
+
+} // namespace mediakit
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_RTPFEC_H
+#define ZLMEDIAKIT_RTPFEC_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Rtsp/Rtsp.h"
+
+namespace mediakit {
+
+/**
+ * 推流端rtp冗余恢复，支持red(rfc2198)解封装与ulpfec(rfc5109)异或恢复
+ * red包解封装出主负载与冗余负载，ulpfec包在其保护的包中恰好丢失一个时恢复该包；
+ * 解封装或恢复出的rtp包通过popPacket取出，由调用者重新走正常的rtp输入流程
+ * Publisher side rtp redundancy recovery, supports red (rfc2198) decapsulation and ulpfec (rfc5109) xor recovery
+ * Red packets are split into their primary and redundant blocks, an ulpfec packet recovers the packet it protects when exactly one of them is lost;
+ * the decapsulated or recovered rtp packets are fetched with popPacket and fed back into the normal rtp input path by the caller
+ */
+class RtpFecReceiver {
+public:
+    using Ptr = std::shared_ptr<RtpFecReceiver>;
+
+    /**
+     * @param red_pt red负载的pt，0xff代表未使用
+     * @param ulpfec_pt ulpfec负载的pt，0xff代表未使用
+     * @param red_pt Payload type of red, 0xff means unused
+     * @param ulpfec_pt Payload type of ulpfec, 0xff means unused
+     */
+    RtpFecReceiver(uint8_t red_pt, uint8_t ulpfec_pt);
+
+    /**
+     * 判断是否为red或ulpfec包
+     * Whether it is a red or ulpfec packet
+     */
+    bool isFecPayload(uint8_t pt) const { return pt == _red_pt || pt == _ulpfec_pt; }
+
+    /**
+     * 输入red或ulpfec包
+     * Input a red or ulpfec packet
+     */
+    void inputFec(const uint8_t *ptr, size_t len);
+
+    /**
+     * 输入已通过校验的媒体包，用于ulpfec恢复
+     * Input a media packet that passed validation, used by ulpfec recovery
+     */
+    void inputMedia(const RtpPacket::Ptr &rtp);
+
+    /**
+     * 取出一个解封装或恢复出的rtp包
+     * Fetch a decapsulated or recovered rtp packet
+     */
+    bool popPacket(std::string &out);
+
+    /**
+     * 获取red包主负载的pt，非法时返回-1
+     * Get the payload type of the primary block of a red packet, -1 when invalid
+     */
+    static int getRedPrimaryPT(const uint8_t *ptr, size_t len);
+
+private:
+    struct PendingFec {
+        uint16_t seq_base;
+        uint64_t mask;
+        std::string fec;
+    };
+
+    void inputRed(const uint8_t *ptr, size_t len);
+    void inputUlpfec(const uint8_t *ptr, size_t len);
+    // 尝试用fec包恢复，返回false代表需要继续等待媒体包
+    // Try to recover with the fec packet, false means it should wait for more media packets
+    bool tryRecover(const PendingFec &fec);
+    void recover(const PendingFec &fec, uint16_t lost_seq);
+    bool hasPacket(uint16_t seq) const;
+
+private:
+    uint8_t _red_pt;
+    uint8_t _ulpfec_pt;
+    bool _started = false;
+    // 最近输入的媒体包seq
+    // Seq of the most recent media packet
+    uint16_t _latest_seq = 0;
+    // 按seq索引的最近媒体包
+    // Recent media packets indexed by seq
+    std::vector<RtpPacket::Ptr> _history;
+    // 等待媒体包的fec包
+    // Fec packets waiting for media packets
+    std::deque<PendingFec> _pending;
+    // 待取出的rtp包
+    // Rtp packets to be fetched
+    std::deque<std::string> _output;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_RTPFEC_H
@@ -10,6 +10,7 @@
 
 #include "Common/config.h"
 #include "RtpReceiver.h"
+#include "RtpFec.h"
 
 namespace mediakit {
 
@@ -26,10 +27,40 @@ uint32_t RtpTrack::getSSRC() const {
 void RtpTrack::clear() {
     _ssrc = 0;
     _ssrc_alive.resetTime();
-    PacketSortor<RtpPacket::Ptr>::clear();
+    RtpPacketSortor::clear();
 }
 
 RtpPacket::Ptr RtpTrack::inputRtp(TrackType type, int sample_rate, uint8_t *ptr, size_t len) {
+    if (!_fec) {
+        return inputRtp_l(type, sample_rate, ptr, len);
+    }
+    RtpPacket::Ptr ret;
+    if (len >= RtpPacket::kRtpHeaderSize && _fec->isFecPayload(((RtpHeader *)ptr)->pt)) {
+        _fec->inputFec(ptr, len);
+    } else if ((ret = inputRtp_l(type, sample_rate, ptr, len))) {
+        _fec->inputMedia(ret);
+    }
+    // red解封装或ulpfec恢复出的包走正常的输入流程，恢复出的包也可能参与后续恢复
+    // Packets decapsulated from red or recovered by ulpfec go through the normal input path, and may take part in further recovery
+    std::string packet;
+    while (_fec->popPacket(packet)) {
+        RtpPacket::Ptr rtp;
+        try {
+            rtp = inputRtp_l(type, sample_rate, (uint8_t *)&packet[0], packet.size());
+        } catch (BadRtpException &ex) {
+            // 恢复出的包非法时丢弃，不影响推流
+            // Drop an invalid recovered packet without breaking the publisher
+            WarnL << "drop invalid recovered rtp: " << ex.what();
+        }
+        if (rtp) {
+            _fec->inputMedia(rtp);
+            ret = std::move(rtp);
+        }
+    }
+    return ret;
+}
+
+RtpPacket::Ptr RtpTrack::inputRtp_l(TrackType type, int sample_rate, uint8_t *ptr, size_t len) {
     if (len < RtpPacket::kRtpHeaderSize) {
         throw BadRtpException("rtp size less than 12");
     }
@@ -80,6 +111,7 @@ RtpPacket::Ptr RtpTrack::inputRtp(TrackType type, int sample_rate, uint8_t *ptr,
             // 接收正确ssrc的rtp在10秒内，那么我们认为存在多路rtp,忽略掉ssrc不匹配的rtp  [AUTO-TRANSLATED:2f98c2b5]
             // If the RTP with the correct SSRC is received within 10 seconds, we consider it to be multi-path RTP, and ignore the RTP with mismatched SSRC
             WarnL << "ssrc mismatch, rtp dropped:" << ssrc << " != " << _ssrc;
+            Metrics::dropped_ssrc_mismatch.add();
             return nullptr;
         }
         InfoL << "rtp ssrc changed:" << _ssrc << " -> " << ssrc;
@@ -87,10 +119,9 @@ RtpPacket::Ptr RtpTrack::inputRtp(TrackType type, int sample_rate, uint8_t *ptr,
         _ssrc_alive.resetTime();
     }
 
-    auto rtp = RtpPacket::create();
     // 需要添加4个字节的rtp over tcp头  [AUTO-TRANSLATED:a37d639b]
     // Need to add 4 bytes of RTP over TCP header
-    rtp->setCapacity(RtpPacket::kRtpTcpHeaderSize + len);
+    auto rtp = RtpPacket::create(RtpPacket::kRtpTcpHeaderSize + len);
     rtp->setSize(RtpPacket::kRtpTcpHeaderSize + len);
     rtp->sample_rate = sample_rate;
     rtp->type = type;
@@ -130,6 +161,14 @@ void RtpTrack::setPayloadType(uint8_t pt) {
     _pt = pt;
 }
 
+void RtpTrack::setFecPayloadType(uint8_t red_pt, uint8_t ulpfec_pt) {
+    if (red_pt == 0xFF && ulpfec_pt == 0xFF) {
+        _fec = nullptr;
+        return;
+    }
+    _fec = std::make_shared<RtpFecReceiver>(red_pt, ulpfec_pt);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////
 
 void RtpTrackImp::setOnSorted(OnSorted cb) {
@@ -14,6 +14,8 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include "Rtsp/Rtsp.h"
 #include "Extension/Frame.h"
 // for NtpStamp
@@ -22,7 +24,19 @@
 
 namespace mediakit {
 
-template<typename T, typename SEQ = uint16_t>
+class RtpFecReceiver;
+
+/**
+ * rtp排序器
+ * @tparam T 包类型
+ * @tparam SEQ 序列号类型
+ * @tparam kRingWindow 为false时基于std::map排序，为true时基于按seq索引的定长环形窗口排序(见下方特化)
+ * Rtp sorter
+ * @tparam T Packet type
+ * @tparam SEQ Sequence number type
+ * @tparam kRingWindow Sorts with std::map when false, with a fixed-size seq-indexed ring window when true (see the specialization below)
+ */
+template<typename T, typename SEQ = uint16_t, bool kRingWindow = false>
 class PacketSortor {
 public:
     static constexpr SEQ SEQ_MAX = (std::numeric_limits<SEQ>::max)();
@@ -156,6 +170,7 @@ private:
         // Delete packets that are too far away from next_seq
         for (auto it = _pkt_sort_cache_map.begin(); it != _pkt_sort_cache_map.end();) {
             if (distance(it->first) > _max_distance) {
+                Metrics::dropped_sort_overflow.add();
                 it = _pkt_sort_cache_map.erase(it);
             } else {
                 ++it;
@@ -173,7 +188,11 @@ private:
         if (!mayLooped(_next_seq, _next_seq)) {
             // 无回环风险, 清空 < next_seq的值  [AUTO-TRANSLATED:10c77bf9]
             // No loop risk, clear values less than next_seq
+            auto size = _pkt_sort_cache_map.size();
             it = _pkt_sort_cache_map.erase(_pkt_sort_cache_map.begin(), it);
+            if (size != _pkt_sort_cache_map.size()) {
+                Metrics::dropped_sort_overflow.add(size - _pkt_sort_cache_map.size());
+            }
         }
 
         while (it != _pkt_sort_cache_map.end()) {
@@ -241,7 +260,360 @@ private:
     std::function<void(SEQ seq, T packet)> _cb;
 };
 
-class RtpTrack : public PacketSortor<RtpPacket::Ptr> {
+/**
+ * 基于环形窗口的rtp排序器
+ * 缓存的包按seq对窗口大小取模直接定位，无需节点分配与树平衡；包按顺序到达时直接输出，不经过缓存
+ * Ring window based rtp sorter
+ * Cached packets are located directly by seq modulo the window size, with no node allocation or tree rebalancing;
+ * packets arriving in order are output directly without touching the cache
+ */
+template<typename T, typename SEQ>
+class PacketSortor<T, SEQ, true> {
+public:
+    static constexpr SEQ SEQ_MAX = (std::numeric_limits<SEQ>::max)();
+
+    PacketSortor() { resizeWindow(); }
+    virtual ~PacketSortor() = default;
+
+    void setOnSort(std::function<void(SEQ seq, T packet)> cb) { _cb = std::move(cb); }
+
+    /**
+     * 清空状态
+     * Clear the state
+     */
+    void clear() {
+        _started = false;
+        _ticker.resetTime();
+        for (auto &slot : _window) {
+            slot = Slot();
+        }
+        _size = 0;
+        _skipped_count = 0;
+        _pkt_drop_cache.clear();
+    }
+
+    /**
+     * 获取排序缓存长度
+     * Get the length of the sorting cache
+     */
+    size_t getJitterSize() const { return _size; }
+
+    /**
+     * 输入并排序
+     * @param seq 序列号
+     * @param packet 包负载
+     * Input and sort
+     * @param seq Sequence number
+     * @param packet Packet payload
+     */
+    void sortPacket(SEQ seq, T packet) {
+        _latest_seq = seq;
+        if (!_started) {
+            // 记录第一个seq
+            // Record the first seq
+            _started = true;
+            _next_seq = seq;
+        }
+        if (seq == _next_seq) {
+            if (_adaptive_min_ms) {
+                adapt();
+            }
+            // 收到下一个seq，缓存为空时直接输出
+            // Receive the next seq, output it directly when the cache is empty
+            output(seq, std::move(packet));
+            if (_size) {
+                flushPacket();
+            }
+            if (!_pkt_drop_cache.empty()) {
+                // 按序包已到达，回退包不再可能是seq重置，直接丢弃
+                // An in-order packet arrived, the rollback packets can no longer be a seq reset, drop them
+                Metrics::dropped_sort_overflow.add(_pkt_drop_cache.size());
+                _pkt_drop_cache.clear();
+            }
+            return;
+        }
+
+        auto ahead = static_cast<SEQ>(seq - _next_seq);
+        if (ahead > SEQ_MAX >> 1) {
+            // seq回退包(按回环距离计算在next_seq之前)
+            // Seq rollback packet (before next_seq by wraparound distance)
+            if (_adaptive_min_ms && isSkipped(seq)) {
+                // 该包在等待超时被当作丢包后才到达，说明窗口太小
+                // The packet arrived after it was given up as lost, the window is too small
+                _wait_ms = (std::min)(_wait_ms * 2, _max_buffer_ms);
+                _wait_size = (std::min)(_wait_size * 2, _max_buffer_size);
+                // 同一次放弃只扩大一次窗口
+                // Grow the window only once per give-up
+                _skipped_count = 0;
+            }
+            _pkt_drop_cache.emplace_back(seq, std::move(packet));
+            if (_pkt_drop_cache.size() > _max_distance || _ticker.elapsedTime() > _max_buffer_ms) {
+                // seq回退包太多，可能源端重置seq计数器，输出旧数据后以新seq计数器重新排序
+                // Too many seq rollback packets, the source may reset the seq counter, output the old data and restart sorting with the new counter
+                resetByDropCache();
+            }
+            return;
+        }
+
+        while (ahead > _max_distance && _size) {
+            // 超出窗口，丢包无法恢复，逐个输出最近的缓存包直到该包落入窗口
+            // Out of the window, packet loss cannot be recovered, output the nearest cached packets until this one fits in the window
+            forceFlush();
+            ahead = static_cast<SEQ>(seq - _next_seq);
+        }
+        if (ahead > _max_distance || ahead == 0) {
+            // 缓存已空但seq跳跃仍然太大，从该包重新开始
+            // The cache is empty but the seq jump is still too large, restart from this packet
+            output(seq, std::move(packet));
+            flushPacket();
+            return;
+        }
+
+        auto &slot = _window[seq & _mask];
+        if (slot.valid) {
+            // 重复包
+            // Duplicate packet
+            return;
+        }
+        slot.valid = true;
+        slot.seq = seq;
+        slot.packet = std::move(packet);
+        ++_size;
+
+        if (_adaptive_min_ms ? (_size > _wait_size || _ticker.elapsedTime() > _wait_ms)
+                             : (_size > _max_buffer_size || _ticker.elapsedTime() > _max_buffer_ms)) {
+            forceFlush();
+        }
+    }
+
+    void flush() { flushWindow(); }
+
+    void setParams(size_t max_buffer_size, size_t max_buffer_ms, size_t max_distance) {
+        flushWindow();
+        _max_buffer_size = max_buffer_size;
+        _max_buffer_ms = max_buffer_ms;
+        _max_distance = (std::min<size_t>)(max_distance, SEQ_MAX >> 1);
+        resizeWindow();
+        setAdaptive(_adaptive_min_ms);
+    }
+
+    /**
+     * 开启自适应排序窗口
+     * 等待丢失包的时长与缓存包个数不再固定为最大值，而是根据实际观测到的乱序延时与乱序深度动态调整，
+     * 包迟到(已被当作丢包输出后才到达)时窗口翻倍，之后缓慢回落，上限仍为setParams设置的最大值
+     * @param min_ms 最短等待时长，单位毫秒，0为关闭
+     * Enable the adaptive sorting window
+     * The time waited for a lost packet and the number of cached packets are no longer fixed at the maximum, but follow the observed
+     * reordering delay and depth; the window doubles when a packet arrives late (after it was given up as lost) and then slowly shrinks,
+     * the upper bounds are still the maximums set by setParams
+     * @param min_ms Minimum waiting time in milliseconds, 0 to disable
+     */
+    void setAdaptive(size_t min_ms) {
+        _adaptive_min_ms = (std::min)(min_ms, _max_buffer_ms);
+        _wait_ms = _adaptive_min_ms;
+        _wait_size = (std::min)(kMinWaitSize, _max_buffer_size);
+        _adapt_count = 0;
+    }
+
+    /**
+     * 获取自适应排序窗口当前的等待时长，未开启时为最大等待时长
+     * Get the current waiting time of the adaptive sorting window, the max waiting time when it is disabled
+     */
+    size_t getJitterMS() const { return _adaptive_min_ms ? _wait_ms : _max_buffer_ms; }
+
+private:
+    struct Slot {
+        bool valid = false;
+        SEQ seq = 0;
+        T packet;
+    };
+
+    // 自适应窗口的最小缓存包个数，覆盖ulpfec最大保护范围(48个包)
+    // Min cached packets of the adaptive window, covers the max ulpfec protection range (48 packets)
+    static constexpr size_t kMinWaitSize = 64;
+    // 每收到这么多个按序包，自适应窗口回落1/8
+    // The adaptive window shrinks by 1/8 every this many in-order packets
+    static constexpr size_t kAdaptDecayCount = 512;
+
+    void adapt() {
+        if (_size) {
+            // 空洞被填补，按本次等待时长与期间缓存的包个数扩大窗口(留50%余量)
+            // A hole was filled, grow the window by the time waited and the packets cached meanwhile (with 50% headroom)
+            size_t wait_ms = _adaptive_min_ms + static_cast<size_t>(_ticker.elapsedTime()) * 3 / 2;
+            auto wait_size = _size * 3 / 2;
+            _wait_ms = (std::min)((std::max)(_wait_ms, wait_ms), _max_buffer_ms);
+            _wait_size = (std::min)((std::max)(_wait_size, wait_size), _max_buffer_size);
+        }
+        if (++_adapt_count < kAdaptDecayCount) {
+            return;
+        }
+        _adapt_count = 0;
+        _wait_ms = (std::max)(_wait_ms - _wait_ms / 8, _adaptive_min_ms);
+        _wait_size = (std::max)(_wait_size - _wait_size / 8, (std::min)(kMinWaitSize, _max_buffer_size));
+    }
+
+    void resizeWindow() {
+        // 窗口大小为不小于max_distance + 1的2的幂，窗口内的包seq不会冲突
+        // The window size is a power of 2 not less than max_distance + 1, so seqs in the window never collide
+        size_t capacity = 1;
+        while (capacity <= _max_distance) {
+            capacity <<= 1;
+        }
+        _window.clear();
+        _window.resize(capacity);
+        _mask = capacity - 1;
+        _size = 0;
+    }
+
+    void forceFlush() {
+        if (!_size) {
+            return;
+        }
+        // 寻找next_seq之后最近的包，丢包无法恢复，把这个包当做next_seq
+        // Find the nearest packet after next_seq, packet loss cannot be recovered, treat this packet as next_seq
+        for (size_t i = 1; i <= _mask; ++i) {
+            auto &slot = _window[static_cast<SEQ>(_next_seq + i) & _mask];
+            if (slot.valid) {
+                popSlot(slot);
+                break;
+            }
+        }
+        flushPacket();
+    }
+
+    void flushWindow() {
+        while (_size) {
+            forceFlush();
+        }
+    }
+
+    void flushPacket() {
+        while (_size) {
+            // 找到下一个包
+            // Find the next packet
+            auto &slot = _window[_next_seq & _mask];
+            if (!slot.valid || slot.seq != _next_seq) {
+                break;
+            }
+            popSlot(slot);
+        }
+    }
+
+    void resetByDropCache() {
+        flushWindow();
+        auto drop_cache = std::move(_pkt_drop_cache);
+        _pkt_drop_cache.clear();
+        std::stable_sort(drop_cache.begin(), drop_cache.end(), [](const std::pair<SEQ, T> &a, const std::pair<SEQ, T> &b) {
+            return a.first < b.first;
+        });
+        auto it = drop_cache.begin();
+        output(it->first, std::move(it->second));
+        for (++it; it != drop_cache.end(); ++it) {
+            auto ahead = static_cast<SEQ>(it->first - _next_seq);
+            if (ahead > _max_distance) {
+                Metrics::dropped_sort_overflow.add();
+                continue;
+            }
+            auto &slot = _window[it->first & _mask];
+            if (!slot.valid) {
+                slot.valid = true;
+                slot.seq = it->first;
+                slot.packet = std::move(it->second);
+                ++_size;
+            }
+        }
+        flushPacket();
+    }
+
+    void popSlot(Slot &slot) {
+        slot.valid = false;
+        --_size;
+        output(slot.seq, std::move(slot.packet));
+        slot.packet = T();
+    }
+
+    // 是否在最近一次被当作丢包跳过的seq范围内
+    // Whether the seq is in the range most recently given up as lost
+    bool isSkipped(SEQ seq) const {
+        return _skipped_count && static_cast<SEQ>(seq - _skipped_begin) < _skipped_count;
+    }
+
+    void output(SEQ seq, T packet) {
+        if (seq != _next_seq) {
+            WarnL << "packet dropped: " << _next_seq << " -> " << static_cast<SEQ>(seq - 1)
+                  << ", latest seq: " << _latest_seq
+                  << ", jitter buffer size: " << _size
+                  << ", jitter buffer ms: " << _ticker.elapsedTime();
+            // seq跳跃过大时是重新开始排序，不是等待超时放弃
+            // A seq jump that is too large restarts the sorting, it is not a give-up after waiting
+            auto skipped = static_cast<SEQ>(seq - _next_seq);
+            _skipped_begin = _next_seq;
+            _skipped_count = skipped <= _max_distance ? skipped : 0;
+        }
+        _next_seq = static_cast<SEQ>(seq + 1);
+        _cb(seq, std::move(packet));
+        _ticker.resetTime();
+    }
+
+private:
+    bool _started = false;
+    // 排序缓存最大保存数据长度，单位毫秒
+    // Maximum data length of sorting cache, unit: milliseconds
+    size_t _max_buffer_ms = 1000;
+    // 排序缓存最大保存数据个数
+    // Maximum number of data in sorting cache
+    size_t _max_buffer_size = 1024;
+    // seq最大跳跃距离
+    // Maximum seq jump distance
+    size_t _max_distance = 256;
+    // 自适应窗口的最短等待时长，0为关闭
+    // Min waiting time of the adaptive window, 0 means disabled
+    size_t _adaptive_min_ms = 0;
+    // 自适应窗口当前的等待时长与缓存包个数上限
+    // Current waiting time and cached packet limit of the adaptive window
+    size_t _wait_ms = 0;
+    size_t _wait_size = 0;
+    size_t _adapt_count = 0;
+    // 窗口中缓存的包个数
+    // Number of packets cached in the window
+    size_t _size = 0;
+    // 窗口大小减一，用于seq取模
+    // Window size minus one, used for seq modulo
+    size_t _mask = 0;
+    // 记录上次output至今的时间
+    // Record the time since the last output
+    toolkit::Ticker _ticker;
+    // 最近输入的seq
+    // The most recently input seq
+    SEQ _latest_seq = 0;
+    // 下次应该输出的SEQ
+    // The next SEQ to be output
+    SEQ _next_seq = 0;
+    // 最近一次被当作丢包跳过的seq范围[_skipped_begin, _skipped_begin + _skipped_count)
+    // The seq range most recently given up as lost, [_skipped_begin, _skipped_begin + _skipped_count)
+    SEQ _skipped_begin = 0;
+    SEQ _skipped_count = 0;
+    // 按seq索引的环形排序窗口
+    // Seq-indexed ring sorting window
+    std::vector<Slot> _window;
+    // 预丢弃包列表
+    // Pre-discard packet list
+    std::vector<std::pair<SEQ, T>> _pkt_drop_cache;
+    // 回调
+    // Callback
+    std::function<void(SEQ seq, T packet)> _cb;
+};
+
+template<typename T, typename SEQ>
+constexpr size_t PacketSortor<T, SEQ, true>::kMinWaitSize;
+template<typename T, typename SEQ>
+constexpr size_t PacketSortor<T, SEQ, true>::kAdaptDecayCount;
+
+// rtp包绝大多数按顺序到达，使用环形窗口排序器
+// Rtp packets arrive in order most of the time, use the ring window sorter
+using RtpPacketSortor = PacketSortor<RtpPacket::Ptr, uint16_t, true>;
+
+class RtpTrack : public RtpPacketSortor {
 public:
     class BadRtpException : public std::invalid_argument {
     public:
@@ -257,16 +629,30 @@ public:
     void setNtpStamp(uint32_t rtp_stamp, uint64_t ntp_stamp_ms);
     void setPayloadType(uint8_t pt);
 
+    /**
+     * 设置red与ulpfec负载的pt，设置后解封装red包并用ulpfec包恢复丢失的包
+     * @param red_pt red负载的pt，0xff代表未使用
+     * @param ulpfec_pt ulpfec负载的pt，0xff代表未使用
+     * Set the payload types of red and ulpfec, red packets are then decapsulated and lost packets are recovered with ulpfec packets
+     * @param red_pt Payload type of red, 0xff means unused
+     * @param ulpfec_pt Payload type of ulpfec, 0xff means unused
+     */
+    void setFecPayloadType(uint8_t red_pt, uint8_t ulpfec_pt);
+
 protected:
     virtual void onRtpSorted(RtpPacket::Ptr rtp) {}
     virtual void onBeforeRtpSorted(const RtpPacket::Ptr &rtp) {}
 
+private:
+    RtpPacket::Ptr inputRtp_l(TrackType type, int sample_rate, uint8_t *ptr, size_t len);
+
 private:
     bool _disable_ntp = false;
     uint8_t _pt = 0xFF;
     uint32_t _ssrc = 0;
     toolkit::Ticker _ssrc_alive;
     NtpStamp _ntp_stamp;
+    std::shared_ptr<RtpFecReceiver> _fec;
 };
 
 class RtpTrackImp : public RtpTrack{
@@ -351,6 +737,16 @@ public:
         _track[index].setPayloadType(pt);
     }
 
+    void setFecPayloadType(int index, uint8_t red_pt, uint8_t ulpfec_pt) {
+        assert(index < kCount && index >= 0);
+        _track[index].setFecPayloadType(red_pt, ulpfec_pt);
+    }
+
+    void setAdaptiveJitter(int index, size_t min_ms) {
+        assert(index < kCount && index >= 0);
+        _track[index].setAdaptive(min_ms);
+    }
+
     void clear() {
         for (auto &track : _track) {
             track.clear();
@@ -15,6 +15,7 @@
 #include "Network/Socket.h"
 #include "Common/Parser.h"
 #include "Common/config.h"
+#include "Common/PacketArena.h"
 #include "Extension/Track.h"
 #include "Extension/Factory.h"
 
@@ -253,6 +254,16 @@ void SdpParser::load(const string &sdp) {
             char codec[16] = { 0 };
 
             sscanf(rtpmap.data(), "%d", &pt);
+            if (2 == sscanf(rtpmap.data(), "%d %15[^/]", &pt, codec) && (!strcasecmp(codec, "red") || !strcasecmp(codec, "ulpfec"))) {
+                // red/ulpfec冗余负载，不作为该track的编码
+                // Red/ulpfec redundancy payloads, not the codec of this track
+                (!strcasecmp(codec, "red") ? track._red_pt : track._ulpfec_pt) = pt;
+                if (track._pt == pt) {
+                    track._pt = 0xff;
+                }
+                it = track._attr.erase(it);
+                continue;
+            }
             if (track._pt != pt && track._pt != 0xff) {
                 // pt不匹配  [AUTO-TRANSLATED:ce7abb0a]
                 // pt mismatch
@@ -260,6 +271,7 @@ void SdpParser::load(const string &sdp) {
                 continue;
             }
             if (4 == sscanf(rtpmap.data(), "%d %15[^/]/%d/%d", &pt, codec, &samplerate, &channel)) {
+                track._pt = pt;
                 track._codec = codec;
                 track._samplerate = samplerate;
                 track._channel = channel;
@@ -689,18 +701,26 @@ size_t RtpPacket::getPayloadSize() const {
     return getHeader()->getPayloadSize(size() - kRtpTcpHeaderSize);
 }
 
-RtpPacket::Ptr RtpPacket::create() {
-#if 0
-    static ResourcePool<RtpPacket> packet_pool;
-    static onceToken token([]() {
-        packet_pool.setSize(1024);
-    });
-    auto ret = packet_pool.obtain2();
-    ret->setSize(0);
+template <>
+struct PacketArenaTraits<RtpPacket> {
+    static size_t capacity(const RtpPacket &obj) { return obj.getCapacity(); }
+    static void reset(RtpPacket &obj) {
+        // 复用的包不得携带上一次使用的元数据
+        // A recycled packet must not carry the metadata of its previous use
+        obj.setSize(0);
+        obj.type = TrackInvalid;
+        obj.sample_rate = 0;
+        obj.ntp_stamp = 0;
+        obj.track_index = 0;
+    }
+};
+
+RtpPacket::Ptr RtpPacket::create(size_t capacity) {
+    auto ret = PacketArena<RtpPacket>::obtain(capacity);
+    if (capacity) {
+        ret->setCapacity(capacity);
+    }
     return ret;
-#else
-    return Ptr(new RtpPacket);
-#endif
 }
 
 /**
@@ -763,6 +783,6 @@ DefaultSdp::DefaultSdp(int payload_type, const Track &track)
 
 } // namespace mediakit
 
-namespace toolkit {
-StatisticImp(mediakit::RtpPacket);
+namespace mediakit {
+ObjectCounterImp(RtpPacket)
 }
\ No newline at end of file
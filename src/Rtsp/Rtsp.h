@@ -157,6 +157,11 @@ private:
 
 // 此rtp为rtp over tcp形式，需要忽略前4个字节  [AUTO-TRANSLATED:ceb00f83]
 // This rtp is in the form of rtp over tcp, the first 4 bytes need to be ignored
+template <typename C>
+class PacketArena;
+template <typename C>
+struct PacketArenaTraits;
+
 class RtpPacket : public toolkit::BufferRaw {
 public:
     using Ptr = std::shared_ptr<RtpPacket>;
@@ -200,18 +205,31 @@ public:
 
     int track_index;
 
-    static Ptr create();
+    /**
+     * 从包内存池申请rtp包
+     * @param capacity 预分配的缓存大小(包括rtp over tcp头)，0代表未知
+     * Obtain an rtp packet from the packet arena
+     * @param capacity Buffer size to reserve (including the rtp over tcp header), 0 means unknown
+     */
+    static Ptr create(size_t capacity = 0);
 
 private:
     friend class toolkit::ResourcePool_l<RtpPacket>;
+    friend class PacketArena<RtpPacket>;
     RtpPacket() = default;
 
 private:
     // 对象个数统计  [AUTO-TRANSLATED:f4a012d0]
     // Object Count Statistics
-    toolkit::ObjectStatistic<RtpPacket> _statistic;
+    ObjectCounter<RtpPacket> _statistic;
 };
 
+// RtpPacket回收进包内存池时需要清除元数据，特化定义在Rtsp.cpp，此处声明以免其他编译单元使用默认实现
+// A RtpPacket must drop its metadata when recycled into the packet arena; the specialization is defined in Rtsp.cpp
+// and declared here so no other translation unit falls back to the primary template
+template <>
+struct PacketArenaTraits<RtpPacket>;
+
 class RtpPayload {
 public:
     static int getClockRate(int pt);
@@ -247,6 +265,10 @@ public:
 
 public:
     int _pt = 0xff;
+    // red(rfc2198)与ulpfec(rfc5109)负载的pt，0xff为未使用
+    // Payload types of red (rfc2198) and ulpfec (rfc5109), 0xff means unused
+    int _red_pt = 0xff;
+    int _ulpfec_pt = 0xff;
     int _channel = 0;
     int _samplerate = 0;
     TrackType _type;
@@ -17,6 +17,7 @@
 #include <functional>
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/RingFanoutMonitor.h"
 #include "Util/RingBuffer.h"
 
 #define RTP_GOP_SIZE 512
@@ -35,11 +36,14 @@ namespace mediakit {
  
  * [AUTO-TRANSLATED:e04eee56]
  */
-class RtspMediaSource : public MediaSource, public toolkit::RingDelegate<RtpPacket::Ptr>, private PacketCache<RtpPacket> {
+class RtspMediaSource : public MediaSource, public toolkit::RingDelegate<RtpPacket::Ptr>, private PacketCache<RtpPacket, AdaptiveFlushPolicy> {
 public:
     using Ptr = std::shared_ptr<RtspMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<RtpPacket::Ptr> >;
     using RingType = toolkit::RingBuffer<RingDataType>;
+    // 设置该流的合并写时长(ProtocolOption::merge_write_ms)
+    // Set the merge write window of this stream (ProtocolOption::merge_write_ms)
+    using PacketCache<RtpPacket, AdaptiveFlushPolicy>::setMergeWriteMS;
 
     /**
      * 构造函数
@@ -178,10 +182,19 @@ public:
     void onWrite(RtpPacket::Ptr rtp, bool keyPos) override;
 
     void clearCache() override{
-        PacketCache<RtpPacket>::clearCache();
+        PacketCache<RtpPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
+        _cost.onClearCache();
     }
 
+    /**
+     * 用重建的gop恢复被淘汰的gop缓存，在写入线程中调用
+     * @param gop 从帧级gop缓存重新生成的rtp包
+     * Restore the evicted gop cache with a rebuilt gop, called in the writer thread
+     * @param gop Rtp packets regenerated from the frame level gop cache
+     */
+    void restoreGopCache(RingDataType gop);
+
 private:
     /**
      * 批量flush rtp包时触发该函数
@@ -194,9 +207,12 @@ private:
      * [AUTO-TRANSLATED:612c574b]
      */
     void onFlush(std::shared_ptr<toolkit::List<RtpPacket::Ptr> > rtp_list, bool key_pos) override {
-        // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
-        // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
-        _ring->write(std::move(rtp_list), _have_video ? key_pos : true);
+        MediaCost::Scope scope(_cost, MediaCost::kFanout);
+        key_pos = onGopCacheWrite(*_ring, MediaCost::getBytes(*rtp_list), _have_video, key_pos, _ring_size);
+        _ring->write(std::move(rtp_list), key_pos);
+        if (_ring->readerCount()) {
+            RingFanoutMonitor::onRingWrite();
+        }
     }
 
 private:
@@ -205,6 +221,9 @@ private:
     std::string _sdp;
     RingType::Ptr _ring;
     SdpTrack::Ptr _tracks[TrackMax];
+    // 每个轨道最近写入的rtp，重建gop时用于衔接序号
+    // The rtp written last of each track, used to align the seq of a rebuilt gop
+    RtpPacket::Ptr _last_rtp[TrackMax];
 };
 
 } /* namespace mediakit */
@@ -61,6 +61,7 @@ void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
         track->_time_stamp = rtp->getStamp() * uint64_t(1000) / rtp->sample_rate;
         track->_ssrc = rtp->getSSRC();
     }
+    _last_rtp[rtp->type] = rtp;
     if (!_ring) {
         std::weak_ptr<RtspMediaSource> weakSelf = std::static_pointer_cast<RtspMediaSource>(shared_from_this());
         auto lam = [weakSelf](int size) {
@@ -68,6 +69,7 @@ void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
             if (!strongSelf) {
                 return;
             }
+            strongSelf->setReaderCount(size);
             strongSelf->onReaderChanged(size);
         };
         // GOP默认缓冲512组RTP包，每组RTP包时间戳相同(如果开启合并写了，那么每组为合并写时间内的RTP包),  [AUTO-TRANSLATED:dc09b92e]
@@ -80,7 +82,35 @@ void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
         }
     }
    
-    PacketCache<RtpPacket>::inputPacket(stamp, is_video, std::move(rtp), keyPos);
+    PacketCache<RtpPacket, AdaptiveFlushPolicy>::inputPacket(stamp, is_video, std::move(rtp), keyPos);
+}
+
+void RtspMediaSource::restoreGopCache(RingDataType gop) {
+    // 先输出合并写缓存中的rtp，重建的gop紧接其后
+    // Output the rtp in the merge write cache first, the rebuilt gop follows it
+    flush();
+    if (!_ring || _ring->readerCount() || gop->empty()) {
+        // 已有播放器时不能写入重建的gop(会重复收到)，从下一个关键帧开始恢复缓存
+        // The rebuilt gop can not be written with players attached (they would receive it twice), caching resumes from the next key frame
+        return;
+    }
+    // 每个轨道重建的最后一个rtp即最近写入的rtp，据此衔接序号、ssrc与ntp时间戳
+    // The last rebuilt rtp of each track is the rtp written last, the seq, ssrc and ntp stamp are aligned with it
+    size_t count[TrackMax] = { 0 };
+    size_t index[TrackMax] = { 0 };
+    gop->for_each([&](const RtpPacket::Ptr &rtp) { ++count[rtp->type]; });
+    gop->for_each([&](const RtpPacket::Ptr &rtp) {
+        auto &last = _last_rtp[rtp->type];
+        if (!last) {
+            return;
+        }
+        auto header = rtp->getHeader();
+        header->seq = htons((uint16_t)(last->getSeq() - (count[rtp->type] - 1 - index[rtp->type]++)));
+        header->ssrc = htonl(last->getSSRC());
+        rtp->ntp_stamp = last->ntp_stamp - (int64_t)(int32_t)(last->getStamp() - rtp->getStamp()) * 1000 / (int64_t)rtp->sample_rate;
+    });
+    _cost.onCache(MediaCost::getBytes(*gop), true, _ring_size);
+    _ring->write(std::move(gop), true);
 }
 
 RtspMediaSourceImp::RtspMediaSourceImp(const MediaTuple& tuple, int ringSize): RtspMediaSource(tuple, ringSize)
@@ -109,6 +139,7 @@ void RtspMediaSourceImp::onWrite(RtpPacket::Ptr rtp, bool key_pos)
     } else {
         // 需要解复用rtp  [AUTO-TRANSLATED:0deaf9f1]
         // Need to demultiplex rtp
+        MediaCost::Scope scope(_cost, MediaCost::kDemux);
         key_pos = _demuxer->inputRtp(rtp);
     }
     GET_CONFIG(bool, directProxy, Rtsp::kDirectProxy);
@@ -128,6 +159,9 @@ void RtspMediaSourceImp::setProtocolOption(const ProtocolOption &option)
     // This leads to the inability of rtc to play, so it is recommended to turn off direct proxy mode when rtsp pushes the stream and rtc plays
     _option = option;
     _option.enable_rtsp = !direct_proxy;
+    // 直接代理时推流源本身即为rtsp播放源
+    // With direct proxy the published source itself is the rtsp source for players
+    setMergeWriteMS(option.merge_write_ms);
     _muxer = std::make_shared<MultiMediaSourceMuxer>(_tuple, _demuxer->getDuration(), _option);
     _muxer->setMediaListener(getListener());
     _muxer->setTrackListener(std::static_pointer_cast<RtspMediaSourceImp>(shared_from_this()));
@@ -13,10 +13,11 @@
 
 #include "RtspMuxer.h"
 #include "Rtsp/RtspMediaSource.h"
+#include "Common/GopCacheBudget.h"
 
 namespace mediakit {
 
-class RtspMediaSourceMuxer final : public RtspMuxer, public MediaSourceEventInterceptor,
+class RtspMediaSourceMuxer final : public RtspMuxer, public MediaSourceEventInterceptor, public DemandGopSeeder,
                                    public std::enable_shared_from_this<RtspMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<RtspMediaSourceMuxer>;
@@ -26,6 +27,8 @@ public:
                          const TitleSdp::Ptr &title = nullptr) : RtspMuxer(title) {
         _option = option;
         _media_src = std::make_shared<RtspMediaSource>(tuple);
+        _media_src->setMergeWriteMS(option.merge_write_ms);
+        _media_src->setGopCacheRebuildable();
         getRtpRing()->setDelegate(_media_src);
     }
 
@@ -56,6 +59,7 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
+        onDemandReaderChanged(_option.rtsp_demand, _enabled, size);
         _enabled = _option.rtsp_demand ? size : true;
         if (!size && _option.rtsp_demand) {
             _clear_cache = true;
@@ -64,14 +68,24 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
+        return inputFrames(&frame, 1);
+    }
+
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override {
         if (_clear_cache && _option.rtsp_demand) {
             _clear_cache = false;
             _media_src->clearCache();
         }
-        if (_enabled || !_option.rtsp_demand) {
-            return RtspMuxer::inputFrame(frame);
+        if (!_enabled && _option.rtsp_demand) {
+            return false;
         }
-        return false;
+        // 按需检查每批只做一次，逐帧直接调用复用器实现
+        // The on demand check is done once per batch, frames are input into the muxer implementation directly
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = RtspMuxer::inputFrame(frames[i]) ? true : ret;
+        }
+        return ret;
     }
 
     bool isEnabled() {
@@ -80,6 +94,35 @@ public:
         return _option.rtsp_demand ? (_clear_cache ? true : _enabled) : true;
     }
 
+    /**
+     * 从帧级gop缓存重建被淘汰的rtsp gop缓存，在归属线程中调用
+     * @param sender 被淘汰gop缓存的媒体源
+     * @param tracks 所有就绪的track
+     * @param gop 帧级gop缓存中最后一个gop的帧
+     * Rebuild the evicted rtsp gop cache from the frame level gop cache, called in the owner thread
+     * @param sender Media source whose gop cache was evicted
+     * @param tracks All ready tracks
+     * @param gop Frames of the last gop in the frame level gop cache
+     */
+    bool rebuildGopCache(MediaSource &sender, const std::vector<Track::Ptr> &tracks, const std::list<Frame::Ptr> &gop) {
+        if (&sender != _media_src.get()) {
+            return false;
+        }
+        // 用独立的复用器重新生成rtp，不影响直播复用器的状态，序号与ssrc由媒体源衔接
+        // Regenerate rtp with a separate muxer so the state of the live muxer is not touched, the media source aligns the seq and ssrc
+        RtspMuxer muxer;
+        auto collector = std::make_shared<GopCollector<RtpPacket> >();
+        muxer.getRtpRing()->setDelegate(collector);
+        for (auto &track : tracks) {
+            muxer.addTrack(track);
+        }
+        for (auto &frame : gop) {
+            muxer.inputFrame(frame);
+        }
+        _media_src->restoreGopCache(collector->getGop());
+        return true;
+    }
+
 private:
     bool _enabled = true;
     bool _clear_cache = false;
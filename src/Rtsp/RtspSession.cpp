@@ -11,6 +11,7 @@
 #include <atomic>
 #include <iomanip>
 #include "Common/config.h"
+#include "Common/Metrics.h"
 #include "UDPServer.h"
 #include "RtspSession.h"
 #include "Util/MD5.h"
@@ -117,6 +118,7 @@ void RtspSession::onManager() {
 void RtspSession::onRecv(const Buffer::Ptr &buf) {
     _alive_ticker.resetTime();
     _bytes_usage += buf->size();
+    Metrics::rtsp.bytes_in.add(buf->size());
     if (_on_recv) {
         //http poster的请求数据转发给http getter处理
         _on_recv(buf);
@@ -167,6 +169,7 @@ void RtspSession::onWholeRtspPacket(Parser &parser) {
 void RtspSession::onRtpPacket(const char *data, size_t len) {
     uint8_t interleaved = data[1];
     if (interleaved % 2 == 0) {
+        Metrics::rtsp.packets_in.add();
         CHECK(len > RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize);
         RtpHeader *header = (RtpHeader *)(data + RtpPacket::kRtpTcpHeaderSize);
         auto track_idx = getTrackIndexByPT(header->pt);
@@ -265,8 +268,13 @@ void RtspSession::handleReq_ANNOUNCE(const Parser &parser) {
             return;
         }
         _rtcp_context.clear();
-        for (auto &track : _sdp_track) {
+        GET_CONFIG(uint32_t, adaptive_jitter_ms, Rtp::kAdaptiveJitterMS);
+        for (size_t i = 0; i < _sdp_track.size(); ++i) {
             _rtcp_context.emplace_back(std::make_shared<RtcpContextForRecv>());
+            // sdp中声明了red/ulpfec时，在排序前解封装red并恢复丢失的包
+            // When red/ulpfec are declared in the sdp, decapsulate red and recover lost packets before sorting
+            setFecPayloadType(i, _sdp_track[i]->_red_pt, _sdp_track[i]->_ulpfec_pt);
+            setAdaptiveJitter(i, adaptive_jitter_ms);
         }
 
         if (!_push_src) {
@@ -984,6 +992,8 @@ void RtspSession::onRcvPeerUdpData(int interleaved, const Buffer::Ptr &buf, cons
     if (interleaved % 2 == 0) {
         if (_push_src) {
             //这是rtsp推流上来的rtp包
+            Metrics::rtsp.packets_in.add();
+            Metrics::rtsp.bytes_in.add(buf->size());
             auto &ref = _sdp_track[interleaved / 2];
             handleOneRtp(interleaved / 2, ref->_type, ref->_samplerate, (uint8_t *) buf->data(), buf->size());
         } else if (!_udp_connected_flags.count(interleaved)) {
@@ -1109,6 +1119,7 @@ ssize_t RtspSession::send(Buffer::Ptr pkt){
 //		DebugP(this) << pkt->data();
 //	}
     _bytes_usage += pkt->size();
+    Metrics::rtsp.bytes_out.add(pkt->size());
     return Session::send(std::move(pkt));
 }
 
@@ -1128,7 +1139,8 @@ bool RtspSession::sendRtspResponse(const string &res_code, const std::initialize
 
 int RtspSession::getTrackIndexByPT(int pt) const {
     for (size_t i = 0; i < _sdp_track.size(); ++i) {
-        if (pt == _sdp_track[i]->_pt) {
+        auto &track = _sdp_track[i];
+        if (pt == track->_pt || pt == track->_red_pt || pt == track->_ulpfec_pt) {
             return i;
         }
     }
@@ -1240,6 +1252,7 @@ void RtspSession::updateRtcpContext(const RtpPacket::Ptr &rtp){
 }
 
 void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
+    size_t packets = 0;
     switch (_rtp_type) {
         case Rtsp::RTP_TCP: {
             setSendFlushFlag(false);
@@ -1247,6 +1260,7 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
                 if (_target_play_track == TrackInvalid || _target_play_track == rtp->type) {
                     updateRtcpContext(rtp);
                     send(rtp);
+                    ++packets;
                 }
             });
             flushAll();
@@ -1267,19 +1281,20 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
                         return;
                     }
                     _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
-                    sock->send(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize), nullptr, 0, false);
+                    Metrics::rtsp.bytes_out.add(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+                    ++packets;
+                    _rtp_batch[rtp->type].input(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize));
                 }
             });
-            for (auto &sock : rtp_socks) {
-                if (sock) {
-                    sock->flushAll();
-                }
+            for (auto i = 0; i < 2; ++i) {
+                _rtp_batch[i].flush(rtp_socks[i]);
             }
         }
             break;
         default:
             break;
     }
+    Metrics::rtsp.packets_out.add(packets);
 }
 
 void RtspSession::setSocketFlags(){
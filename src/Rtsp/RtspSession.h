@@ -21,6 +21,8 @@
 #include "RtspMediaSource.h"
 #include "RtspMediaSourceImp.h"
 #include "RtpMultiCaster.h"
+#include "Common/UdpBatchSender.h"
+#include "Common/KTls.h"
 
 namespace mediakit {
 
@@ -249,6 +251,9 @@ private:
     // RTP端口,trackid idx 为数组下标  [AUTO-TRANSLATED:77c186bb]
     // RTP port, trackid idx is the array index
     toolkit::Socket::Ptr _rtp_socks[2];
+    // RTP批量发送器,下标0表示视频，1表示音频
+    // RTP batch sender, index 0 is video, 1 is audio
+    UdpBatchSender _rtp_batch[2];
     // RTCP端口,trackid idx 为数组下标  [AUTO-TRANSLATED:446a7861]
     // RTCP port, trackid idx is the array index
     toolkit::Socket::Ptr _rtcp_socks[2];
@@ -278,7 +283,7 @@ private:
  
  * [AUTO-TRANSLATED:7d1eed83]
  */
-using RtspSessionWithSSL = toolkit::SessionWithSSL<RtspSession>;
+using RtspSessionWithSSL = SessionWithKTls<RtspSession>;
 
 } /* namespace mediakit */
 
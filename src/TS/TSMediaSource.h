@@ -13,6 +13,8 @@
 
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/RingFanoutMonitor.h"
+#include "Http/WebSocketSplitter.h"
 #include "Util/RingBuffer.h"
 
 #define TS_GOP_SIZE 512
@@ -21,7 +23,7 @@ namespace mediakit {
 
 // TS直播数据包  [AUTO-TRANSLATED:02fb2e8e]
 // TS Live Data Packet
-class TSPacket : public toolkit::BufferOffset<toolkit::Buffer::Ptr>{
+class TSPacket : public toolkit::BufferOffset<toolkit::Buffer::Ptr>, public WebSocketFrameCache {
 public:
     using Ptr = std::shared_ptr<TSPacket>;
 
@@ -34,11 +36,14 @@ public:
 
 // TS直播源  [AUTO-TRANSLATED:0d25ead6]
 // TS Live Source
-class TSMediaSource final : public MediaSource, public toolkit::RingDelegate<TSPacket::Ptr>, private PacketCache<TSPacket>{
+class TSMediaSource final : public MediaSource, public toolkit::RingDelegate<TSPacket::Ptr>, private PacketCache<TSPacket, AdaptiveFlushPolicy>{
 public:
     using Ptr = std::shared_ptr<TSMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<TSPacket::Ptr> >;
     using RingType = toolkit::RingBuffer<RingDataType>;
+    // 设置该流的合并写时长(ProtocolOption::merge_write_ms)
+    // Set the merge write window of this stream (ProtocolOption::merge_write_ms)
+    using PacketCache<TSPacket, AdaptiveFlushPolicy>::setMergeWriteMS;
 
     TSMediaSource(const MediaTuple& tuple, int ring_size = TS_GOP_SIZE): MediaSource(TS_SCHEMA, tuple), _ring_size(ring_size) {}
 
@@ -94,7 +99,7 @@ public:
             _have_video = true;
         }
         auto stamp = packet->time_stamp;
-        PacketCache<TSPacket>::inputPacket(stamp, true, std::move(packet), key);
+        PacketCache<TSPacket, AdaptiveFlushPolicy>::inputPacket(stamp, true, std::move(packet), key);
     }
 
     /**
@@ -104,8 +109,28 @@ public:
      * [AUTO-TRANSLATED:d863f8c9]
      */
     void clearCache() override {
-        PacketCache<TSPacket>::clearCache();
+        PacketCache<TSPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
+        _cost.onClearCache();
+    }
+
+    /**
+     * 用重建的gop恢复被淘汰的gop缓存，在写入线程中调用
+     * @param gop 从帧级gop缓存重新生成的ts包
+     * Restore the evicted gop cache with a rebuilt gop, called in the writer thread
+     * @param gop Ts packets regenerated from the frame level gop cache
+     */
+    void restoreGopCache(RingDataType gop) {
+        // 先输出合并写缓存中的包，重建的gop紧接其后
+        // Output the packets in the merge write cache first, the rebuilt gop follows them
+        flush();
+        if (!_ring || _ring->readerCount() || gop->empty()) {
+            // 已有播放器时不能写入重建的gop(会重复收到)，从下一个关键帧开始恢复缓存
+            // The rebuilt gop can not be written with players attached (they would receive it twice), caching resumes from the next key frame
+            return;
+        }
+        _cost.onCache(MediaCost::getBytes(*gop), true, _ring_size);
+        _ring->write(std::move(gop), true);
     }
 
 private:
@@ -116,6 +141,7 @@ private:
             if (!strong_self) {
                 return;
             }
+            strong_self->setReaderCount(size);
             strong_self->onReaderChanged(size);
         });
         // 注册媒体源  [AUTO-TRANSLATED:b87b5ac4]
@@ -134,9 +160,12 @@ private:
      * [AUTO-TRANSLATED:6e93913e]
      */
     void onFlush(std::shared_ptr<toolkit::List<TSPacket::Ptr> > packet_list, bool key_pos) override {
-        // 如果不存在视频，那么就没有存在GOP缓存的意义，所以确保一直清空GOP缓存  [AUTO-TRANSLATED:66208f94]
-        // If there is no video, then there is no meaning to the existence of GOP cache, so make sure to clear the GOP cache all the time
-        _ring->write(std::move(packet_list), _have_video ? key_pos : true);
+        MediaCost::Scope scope(_cost, MediaCost::kFanout);
+        key_pos = onGopCacheWrite(*_ring, MediaCost::getBytes(*packet_list), _have_video, key_pos, _ring_size);
+        _ring->write(std::move(packet_list), key_pos);
+        if (_ring->readerCount()) {
+            RingFanoutMonitor::onRingWrite();
+        }
     }
 
 private:
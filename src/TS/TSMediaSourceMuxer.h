@@ -16,7 +16,33 @@
 
 namespace mediakit {
 
-class TSMediaSourceMuxer final : public MpegMuxer, public MediaSourceEventInterceptor,
+/**
+ * 重建ts gop缓存用的复用器，收集其输出的ts包
+ * Muxer used to rebuild the ts gop cache, it collects the ts packets it outputs
+ */
+class TSGopMuxer final : public MpegMuxer {
+public:
+    TSGopMuxer() : MpegMuxer(false) {}
+
+    const TSMediaSource::RingDataType &getGop() const {
+        return _gop;
+    }
+
+protected:
+    void onWrite(std::shared_ptr<toolkit::Buffer> buffer, uint64_t timestamp, bool key_pos) override {
+        if (!buffer) {
+            return;
+        }
+        auto packet = std::make_shared<TSPacket>(std::move(buffer));
+        packet->time_stamp = timestamp;
+        _gop->emplace_back(std::move(packet));
+    }
+
+private:
+    TSMediaSource::RingDataType _gop = std::make_shared<toolkit::List<TSPacket::Ptr> >();
+};
+
+class TSMediaSourceMuxer final : public MpegMuxer, public MediaSourceEventInterceptor, public DemandGopSeeder,
                                  public std::enable_shared_from_this<TSMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<TSMediaSourceMuxer>;
@@ -24,6 +50,8 @@ public:
     TSMediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) : MpegMuxer(false) {
         _option = option;
         _media_src = std::make_shared<TSMediaSource>(tuple);
+        _media_src->setMergeWriteMS(option.merge_write_ms);
+        _media_src->setGopCacheRebuildable();
     }
 
     ~TSMediaSourceMuxer() override {
@@ -44,6 +72,7 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
+        onDemandReaderChanged(_option.ts_demand, _enabled, size);
         _enabled = _option.ts_demand ? size : true;
         if (!size && _option.ts_demand) {
             _clear_cache = true;
@@ -52,14 +81,22 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
+        return inputFrames(&frame, 1);
+    }
+
+    bool inputFrames(const Frame::Ptr *frames, size_t size) override {
         if (_clear_cache && _option.ts_demand) {
             _clear_cache = false;
             _media_src->clearCache();
         }
-        if (_enabled || !_option.ts_demand) {
-            return MpegMuxer::inputFrame(frame);
+        if (!_enabled && _option.ts_demand) {
+            return false;
         }
-        return false;
+        bool ret = false;
+        for (size_t i = 0; i < size; ++i) {
+            ret = MpegMuxer::inputFrame(frames[i]) ? true : ret;
+        }
+        return ret;
     }
 
     bool isEnabled() {
@@ -68,6 +105,34 @@ public:
         return _option.ts_demand ? (_clear_cache ? true : _enabled) : true;
     }
 
+    /**
+     * 从帧级gop缓存重建被淘汰的ts gop缓存，在归属线程中调用
+     * @param sender 被淘汰gop缓存的媒体源
+     * @param tracks 所有就绪的track
+     * @param gop 帧级gop缓存中最后一个gop的帧
+     * Rebuild the evicted ts gop cache from the frame level gop cache, called in the owner thread
+     * @param sender Media source whose gop cache was evicted
+     * @param tracks All ready tracks
+     * @param gop Frames of the last gop in the frame level gop cache
+     */
+    bool rebuildGopCache(MediaSource &sender, const std::vector<Track::Ptr> &tracks, const std::list<Frame::Ptr> &gop) {
+        if (&sender != _media_src.get()) {
+            return false;
+        }
+        // 用独立的复用器重新生成ts包，不影响直播复用器的状态(时间戳即帧时间戳，连续计数器不连续由播放器容忍)
+        // Regenerate ts packets with a separate muxer so the state of the live muxer is not touched
+        // (the timestamps are the frame timestamps, players tolerate the continuity counter discontinuity)
+        TSGopMuxer muxer;
+        for (auto &track : tracks) {
+            muxer.addTrack(track);
+        }
+        for (auto &frame : gop) {
+            muxer.inputFrame(frame);
+        }
+        _media_src->restoreGopCache(muxer.getGop());
+        return true;
+    }
+
 protected:
     void onWrite(std::shared_ptr<toolkit::Buffer> buffer, uint64_t timestamp, bool key_pos) override {
         if (!buffer) {
@@ -152,118 +152,6 @@ static bool aes_unwrap(const uint8_t* in, int in_len, uint8_t* out, int* outLen,
 #endif
 }
 
-/**
- * @brief: aes ctr 加密
- * @param [in]: in 待加密的数据
- * @param [in]: in_len 待加密的数据长度
- * @param [out]: out 加密后输出的数据
- * @param [out]: outLen 加密后输出的数据长度
- * @param [in]: key 密钥
- * @param [in]: key_len 密钥长度
- * @param [in]: iv iv向量(16byte)
- * @return : true: 成功，false: 失败
-**/
-static bool aes_ctr_encrypt(const uint8_t* in, int in_len, uint8_t* out, int* outLen, uint8_t* key, int key_len, uint8_t* iv) {
-
-#if defined(ENABLE_OPENSSL)
-    EVP_CIPHER_CTX* ctx = NULL;
-
-   *outLen = 0;
-
-    do {
-        if (!(ctx = EVP_CIPHER_CTX_new())) {
-            WarnL << "EVP_CIPHER_CTX_new fail";
-            break;
-        }
-
-        if (1 != EVP_EncryptInit_ex(ctx, aes_key_len_mapping_ctr_cipher(key_len), NULL, key, iv)) {
-            WarnL << "EVP_EncryptInit_ex fail";
-            break;
-        }
-
-        int len1 = 0;
-        if (1 != EVP_EncryptUpdate(ctx, (uint8_t*)out, &len1, (uint8_t*)in, in_len)) {
-            WarnL << "EVP_EncryptUpdate fail";
-            break;
-        }
-
-        int len2 = 0;
-        if (1 != EVP_EncryptFinal_ex(ctx, (uint8_t*)out + len1, &len2)) {
-            WarnL << "EVP_EncryptFinal_ex fail";
-            break;
-        }
-
-        *outLen = len1 + len2;
-    } while (0);
-
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-
-    return *outLen != 0;
-#else
-    return false;
-#endif
-}
-
-
-/**
- * @brief: aes ctr 解密
- * @param [in]: in 待解密的数据
- * @param [in]: in_len 待解密的数据长度
- * @param [out]: out 解密后输出的数据
- * @param [out]: outLen 解密后输出的数据长度
- * @param [in]: key 密钥
- * @param [in]: key_len 密钥长度
- * @param [in]: iv iv向量(16byte)
- * @return : true: 成功，false: 失败
-**/
-static bool aes_ctr_decrypt(const uint8_t* in, int in_len, uint8_t* out, int* outLen, uint8_t* key, int key_len, uint8_t* iv) {
-
-#if defined(ENABLE_OPENSSL)
-    EVP_CIPHER_CTX* ctx = NULL;
-
-    *outLen = 0;
-
-    do {
-
-        if (!(ctx = EVP_CIPHER_CTX_new())) {
-            WarnL << "EVP_CIPHER_CTX_new fail";
-            break;
-        }
-
-        if (1 != EVP_DecryptInit_ex(ctx, aes_key_len_mapping_ctr_cipher(key_len), NULL, key, iv)) {
-            WarnL << "EVP_DecryptInit_ex fail";
-            break;
-        }
-
-        int len1 = 0;
-        if (1 != EVP_DecryptUpdate(ctx, (uint8_t*)out, &len1, (uint8_t*)in, in_len)) {
-            WarnL << "EVP_DecryptUpdate fail";
-            break;
-        }
-
-        int len2 = 0;
-        if (1 != EVP_DecryptFinal_ex(ctx, (uint8_t*)out + len1, &len2)) {
-            WarnL << "EVP_DecryptFinal_ex fail";
-            break;
-        }
-
-        *outLen = len1 + len2;
-    } while (0);
-
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-
-    return *outLen != 0;
-
-#else
-    return false;
-#endif
-}
-
-
 ///////////////////////////////////////////////////
 // CryptoContext
 CryptoContext::CryptoContext(const std::string& passparase, uint8_t kk, KeyMaterial::Ptr packet) :
@@ -344,18 +232,13 @@ bool CryptoContext::generateKEK() {
 #endif
 }
 
-BufferLikeString::Ptr CryptoContext::generateIv(uint32_t pkt_seq_no) {
-    auto iv = std::make_shared<BufferLikeString>();
-    iv->resize(128 /8);
-
+void CryptoContext::generateIv(uint32_t pkt_seq_no, uint8_t iv[16]) {
     uint8_t* saltData = (uint8_t*)_salt.data();
-    uint8_t* ivData = (uint8_t*)iv->data();
-    memset((void*)ivData, 0, iv->size());
-    memcpy((void*)(ivData + 10), (void*)&pkt_seq_no, 4);
+    memset((void*)iv, 0, 128 / 8);
+    memcpy((void*)(iv + 10), (void*)&pkt_seq_no, 4);
     for (size_t i = 0; i < std::min<size_t>(_salt.size(), (size_t)112 /8); ++i) {
-        ivData[i] ^= saltData[i];
+        iv[i] ^= saltData[i];
     }
-    return iv;
 }
 
 ///////////////////////////////////////////////////
@@ -363,32 +246,62 @@ BufferLikeString::Ptr CryptoContext::generateIv(uint32_t pkt_seq_no) {
 
 AesCtrCryptoContext::AesCtrCryptoContext(const std::string& passparase, uint8_t kk, KeyMaterial::Ptr packet) :
     CryptoContext(passparase, kk, packet) {
+    initCipher();
 }
 
-BufferLikeString::Ptr AesCtrCryptoContext::encrypt(uint32_t pkt_seq_no, const char *buf, int len) {
-    auto iv = generateIv(htonl(pkt_seq_no));
-    auto payload = std::make_shared<BufferLikeString>();
-    int size = (len + 15) /16 * 16 + 8;
-    payload->resize(size);
-    auto ret = aes_ctr_encrypt((const uint8_t*)buf, len, (uint8_t*)payload->data(), &size, (uint8_t*)_sek.data(), _sek.size(), (uint8_t*)iv->data());
-    if (!ret) {
-        return nullptr;
+void AesCtrCryptoContext::refresh() {
+    CryptoContext::refresh();
+    initCipher();
+}
+
+void AesCtrCryptoContext::initCipher() {
+#if defined(ENABLE_OPENSSL)
+    _cipher_ctx.reset(EVP_CIPHER_CTX_new(), [](EVP_CIPHER_CTX *ctx) {
+        if (ctx) {
+            EVP_CIPHER_CTX_free(ctx);
+        }
+    });
+    if (!_cipher_ctx) {
+        WarnL << "EVP_CIPHER_CTX_new fail";
+        return;
+    }
+    if (1 != EVP_EncryptInit_ex(_cipher_ctx.get(), aes_key_len_mapping_ctr_cipher(_sek.size()), NULL, (uint8_t*)_sek.data(), NULL)) {
+        WarnL << "EVP_EncryptInit_ex fail";
+        _cipher_ctx = nullptr;
     }
-    payload->resize(size);
-    return payload;
+#endif
 }
 
-BufferLikeString::Ptr AesCtrCryptoContext::decrypt(uint32_t pkt_seq_no, const char *buf, int len) {
-    auto iv = generateIv(htonl(pkt_seq_no));
-    auto payload = std::make_shared<BufferLikeString>();
-    int size = len;
-    payload->resize(size);
-    auto ret = aes_ctr_decrypt((const uint8_t*)buf, len, (uint8_t*)payload->data(), &size, (uint8_t*)_sek.data(), _sek.size(), (uint8_t*)iv->data());
-    if (!ret) {
-        return nullptr;
+bool AesCtrCryptoContext::crypt(uint32_t pkt_seq_no, char *buf, int len) {
+#if defined(ENABLE_OPENSSL)
+    if (!_cipher_ctx) {
+        return false;
+    }
+    uint8_t iv[128 / 8];
+    generateIv(htonl(pkt_seq_no), iv);
+    // ctr模式加密与解密相同，只设置iv时保留已扩展的密钥并重置计数器
+    // Ctr encryption and decryption are the same, setting only the iv keeps the expanded key and resets the counter
+    if (1 != EVP_EncryptInit_ex(_cipher_ctx.get(), NULL, NULL, NULL, iv)) {
+        WarnL << "EVP_EncryptInit_ex fail";
+        return false;
+    }
+    int size = 0;
+    if (1 != EVP_EncryptUpdate(_cipher_ctx.get(), (uint8_t*)buf, &size, (uint8_t*)buf, len)) {
+        WarnL << "EVP_EncryptUpdate fail";
+        return false;
     }
-    payload->resize(size);
-    return payload;
+    return size == len;
+#else
+    return false;
+#endif
+}
+
+bool AesCtrCryptoContext::encrypt(uint32_t pkt_seq_no, char *buf, int len) {
+    return crypt(pkt_seq_no, buf, len);
+}
+
+bool AesCtrCryptoContext::decrypt(uint32_t pkt_seq_no, char *buf, int len) {
+    return crypt(pkt_seq_no, buf, len);
 }
 
 ///////////////////////////////////////////////////
@@ -465,7 +378,7 @@ bool Crypto::loadFromKeyMaterial(KeyMaterial::Ptr packet) {
     return true;
 }
 
-BufferLikeString::Ptr Crypto::encrypt(DataPacket::Ptr pkt, const char *buf, int len) {
+bool Crypto::encrypt(DataPacket::Ptr pkt) {
     _pkt_count++;
 
     //refresh
@@ -481,15 +394,14 @@ BufferLikeString::Ptr Crypto::encrypt(DataPacket::Ptr pkt, const char *buf, int
     }
  
     pkt->KK = _ctx_pair[_ctx_idx]->_kk;
-    return _ctx_pair[_ctx_idx]->encrypt(pkt->packet_seq_number, buf, len);
+    pkt->storeToHeader();
+    return _ctx_pair[_ctx_idx]->encrypt(pkt->packet_seq_number, pkt->payloadData(), pkt->payloadSize());
 }
 
-BufferLikeString::Ptr Crypto::decrypt(DataPacket::Ptr pkt, const char *buf, int len) {
+bool Crypto::decrypt(DataPacket::Ptr pkt) {
     CryptoContext::Ptr _ctx;
     if (pkt->KK == KeyMaterial::KEY_BASED_ENCRYPTION_NO_SEK) {
-        auto payload = std::make_shared<BufferLikeString>();
-        payload->assign(buf, len);
-        return payload;
+        return true;
     } else if (pkt->KK == KeyMaterial::KEY_BASED_ENCRYPTION_EVEN_SEK) {
         _ctx = _ctx_pair[0];
     } else if (pkt->KK == KeyMaterial::KEY_BASED_ENCRYPTION_ODD_SEK) {
@@ -498,10 +410,10 @@ BufferLikeString::Ptr Crypto::decrypt(DataPacket::Ptr pkt, const char *buf, int
 
     if (!_ctx) {
         WarnL << "not has effective KeyMaterial with kk: " << pkt->KK;
-        return nullptr;
+        return false;
     }
 
-    return _ctx->decrypt(pkt->packet_seq_number, buf, len);
+    return _ctx->decrypt(pkt->packet_seq_number, pkt->payloadData(), pkt->payloadSize());
 }
 
 } // namespace SRT
@@ -11,6 +11,8 @@
 #include "HSExt.hpp"
 #include "Packet.hpp"
 
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
 namespace SRT {
 
 class CryptoContext : public std::enable_shared_from_this<CryptoContext> {
@@ -22,14 +24,18 @@ public:
     virtual void refresh();
     virtual std::string generateWarppedKey();
 
-    virtual BufferLikeString::Ptr encrypt(uint32_t pkt_seq_no, const char *buf, int len) = 0;
-    virtual BufferLikeString::Ptr decrypt(uint32_t pkt_seq_no, const char *buf, int len) = 0;
+    /**
+     * 原地加解密
+     * Encrypt or decrypt in place
+     */
+    virtual bool encrypt(uint32_t pkt_seq_no, char *buf, int len) = 0;
+    virtual bool decrypt(uint32_t pkt_seq_no, char *buf, int len) = 0;
     virtual uint8_t getCipher() const = 0;
 
 protected:
     virtual void loadFromKeyMaterial(KeyMaterial::Ptr packet);
     virtual bool generateKEK();
-    BufferLikeString::Ptr generateIv(uint32_t pkt_seq_no);
+    void generateIv(uint32_t pkt_seq_no, uint8_t iv[16]);
 
 private:
 
@@ -48,6 +54,10 @@ public:
     BufferLikeString _sek;
 };
 
+/**
+ * aes ctr加解密，密钥扩展只在生成或加载密钥时做一次，之后每个包只重置计数器初值
+ * Aes ctr encryption, the key is expanded once when it is generated or loaded, after that only the initial counter is reset per packet
+ */
 class AesCtrCryptoContext : public CryptoContext {
 public:
     using Ptr = std::shared_ptr<AesCtrCryptoContext>;
@@ -58,9 +68,16 @@ public:
         return KeyMaterial::CIPHER_AES_CTR;
     }
 
-    BufferLikeString::Ptr encrypt(uint32_t pkt_seq_no, const char *buf, int len) override;
-    BufferLikeString::Ptr decrypt(uint32_t pkt_seq_no, const char *buf, int len) override;
+    void refresh() override;
+    bool encrypt(uint32_t pkt_seq_no, char *buf, int len) override;
+    bool decrypt(uint32_t pkt_seq_no, char *buf, int len) override;
+
+private:
+    void initCipher();
+    bool crypt(uint32_t pkt_seq_no, char *buf, int len);
 
+private:
+    std::shared_ptr<EVP_CIPHER_CTX> _cipher_ctx;
 };
 
 
@@ -88,8 +105,16 @@ public:
     CryptoContext::Ptr  _ctx_pair[2];    /* Even(0)/Odd(1) crypto contexts */
     uint32_t _ctx_idx = 0;
 
-    BufferLikeString::Ptr encrypt(DataPacket::Ptr pkt, const char *buf, int len);
-    BufferLikeString::Ptr decrypt(DataPacket::Ptr pkt, const char *buf, int len);
+    /**
+     * 原地加密已打包好的数据包负载，并把所用密钥写入包头
+     * Encrypt the payload of a packed data packet in place, and store the key used into its header
+     */
+    bool encrypt(DataPacket::Ptr pkt);
+    /**
+     * 原地解密数据包负载
+     * Decrypt the payload of a data packet in place
+     */
+    bool decrypt(DataPacket::Ptr pkt);
 
 private:
 
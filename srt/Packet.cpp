@@ -55,13 +55,6 @@ bool DataPacket::loadFromData(uint8_t *buf, size_t len) {
     return true;
 }
 
-bool DataPacket::reloadPayload(uint8_t *buf, size_t len) {
-    _data->setCapacity(len + HEADER_SIZE);
-    _data->setSize(len + HEADER_SIZE);
-    memcpy(_data->data() + HEADER_SIZE, buf, len);
-    return true;
-}
-
 bool DataPacket::storeToHeader() {
     if (!_data || _data->size() < HEADER_SIZE) {
         WarnL << "data size less " << HEADER_SIZE;
@@ -57,7 +57,6 @@ public:
     static bool isDataPacket(uint8_t *buf, size_t len);
     static uint32_t getSocketID(uint8_t *buf, size_t len);
     bool loadFromData(uint8_t *buf, size_t len);
-    bool reloadPayload(uint8_t *buf, size_t len);
     bool storeToData(uint8_t *buf, size_t len);
     bool storeToHeader();
 
@@ -1,5 +1,9 @@
 ﻿#include "PacketQueue.hpp"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace SRT {
 
 static inline bool isSeqEdge(uint32_t seq, uint32_t cap) {
@@ -24,6 +28,19 @@ static inline bool isSeqCycle(uint32_t first, uint32_t second) {
     }
 }
 
+static inline int countTrailingZero(uint64_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    if (_BitScanForward(&index, (uint32_t)mask)) {
+        return (int)index;
+    }
+    _BitScanForward(&index, (uint32_t)(mask >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
 static inline bool isTSCycle(uint32_t first, uint32_t second) {
     uint32_t diff;
     if (first > second) {
@@ -243,43 +260,70 @@ PacketRecvQueue::PacketRecvQueue(uint32_t max_size, uint32_t init_seq, uint32_t
     , _pkt_latency(latency)
     , _pkt_expected_seq(init_seq)
     , _srt_flag(flag)
-    , _pkt_buf(max_size) {}
+    , _pkt_buf(max_size)
+    , _pkt_bits((max_size + 63) / 64) {}
 
 bool  PacketRecvQueue::TLPKTDrop(){
     return (_srt_flag&HSExtMessage::HS_EXT_MSG_TLPKTDROP) && (_srt_flag &HSExtMessage::HS_EXT_MSG_TSBPDRCV);
 }
+void PacketRecvQueue::setPkt(uint32_t pos, DataPacket::Ptr pkt) {
+    _pkt_buf[pos] = std::move(pkt);
+    _pkt_bits[pos >> 6] |= (uint64_t)1 << (pos & 63);
+    _size++;
+}
+
+DataPacket::Ptr PacketRecvQueue::takePkt(uint32_t pos) {
+    _pkt_bits[pos >> 6] &= ~((uint64_t)1 << (pos & 63));
+    _size--;
+    return std::move(_pkt_buf[pos]);
+}
+
+void PacketRecvQueue::moveStart(uint32_t count) {
+    _start = (_start + count) % _pkt_cap;
+    _pkt_expected_seq = genExpectedSeq(_pkt_expected_seq + count);
+}
+
+uint32_t PacketRecvQueue::findSlot(uint32_t offset, uint32_t count, bool present) const {
+    while (offset < count) {
+        auto pos = (_start + offset) % _pkt_cap;
+        auto bit = pos & 63;
+        auto word = present ? _pkt_bits[pos >> 6] : ~_pkt_bits[pos >> 6];
+        word >>= bit;
+        // 本次检查的位数不超过当前字、环形缓冲末尾与count
+        // Bits checked this round stop at the end of the word, the end of the circular buffer and count
+        auto n = std::min<uint32_t>(64 - bit, std::min<uint32_t>(_pkt_cap - pos, count - offset));
+        if (n < 64) {
+            word &= ((uint64_t)1 << n) - 1;
+        }
+        if (word) {
+            return offset + countTrailingZero(word);
+        }
+        offset += n;
+    }
+    return count;
+}
+
 bool PacketRecvQueue::inputPacket(DataPacket::Ptr pkt, std::list<DataPacket::Ptr> &out) {
     // TraceL << dump() << " seq:" << pkt->packet_seq_number;
-    while (_size > 0 && _start == _end) {
+    if (_size > 0 && _start == _end) {
         if (_pkt_buf[_start]) {
-            out.push_back(_pkt_buf[_start]);
-            _size--;
-            _pkt_buf[_start] = nullptr;
+            out.push_back(takePkt(_start));
         }
-        _start = (_start + 1) % _pkt_cap;
-        _pkt_expected_seq = genExpectedSeq(_pkt_expected_seq + 1);
+        moveStart(1);
     }
 
-    tryInsertPkt(pkt);
+    tryInsertPkt(std::move(pkt));
 
-    DataPacket::Ptr it = _pkt_buf[_start];
-    while (it) {
-        out.push_back(it);
-        _size--;
-        _pkt_buf[_start] = nullptr;
-        _pkt_expected_seq = genExpectedSeq(_pkt_expected_seq + 1);
-        _start = (_start + 1) % _pkt_cap;
-        it = _pkt_buf[_start];
-    }
-    while (timeLatency() > _pkt_latency && TLPKTDrop()) {
-        it = _pkt_buf[_start];
-        if (it) {
-            _pkt_buf[_start] = nullptr;
-            out.push_back(it);
-            _size--;
-        }
-        _pkt_expected_seq = genExpectedSeq(_pkt_expected_seq + 1);
-        _start = (_start + 1) % _pkt_cap;
+    while (_pkt_buf[_start]) {
+        out.push_back(takePkt(_start));
+        moveStart(1);
+    }
+    while (TLPKTDrop() && timeLatency() > _pkt_latency) {
+        // 跳过队首缺失的包，输出最早收到的包
+        // Skip the missing packets at the head and output the earliest received one
+        moveStart(findSlot(0, _pkt_cap, true));
+        out.push_back(takePkt(_start));
+        moveStart(1);
     }
     return true;
 }
@@ -316,27 +360,13 @@ std::list<PacketQueueInterface::LostPair> PacketRecvQueue::getLostSeq() {
         return re;
     }
 
-    LostPair lost;
-    uint32_t steup = 0;
-    bool finish = true;
-
-    for (uint32_t i = _start; i != _end;) {
-        if (!_pkt_buf[i]) {
-            if (finish) {
-                finish = false;
-                lost.first = _pkt_expected_seq + steup;
-                lost.second = genExpectedSeq(lost.first + 1);
-            } else {
-                lost.second = genExpectedSeq(_pkt_expected_seq + steup + 1);
-            }
-        } else {
-            if (!finish) {
-                finish = true;
-                re.push_back(lost);
-            }
-        }
-        i = (i + 1) % _pkt_cap;
-        steup++;
+    // _end之前的位置一定已收到，缺失区间总是以已收到的包结束
+    // The position before _end is always received, so every missing range ends with a received packet
+    uint32_t count = (_end + _pkt_cap - _start) % _pkt_cap;
+    for (auto offset = findSlot(0, count, false); offset < count; offset = findSlot(offset, count, false)) {
+        auto end = findSlot(offset, count, true);
+        re.emplace_back(genExpectedSeq(_pkt_expected_seq + offset), genExpectedSeq(_pkt_expected_seq + end));
+        offset = end;
     }
     return re;
 }
@@ -419,13 +449,8 @@ bool PacketRecvQueue::drop(uint32_t first, uint32_t last, std::list<DataPacket::
         return false;
     }
 
-    for (uint32_t i = 0; i < diff; i++) {
-        auto pos = (i + _start) % _pkt_cap;
-        if (_pkt_buf[pos]) {
-            out.push_back(_pkt_buf[pos]);
-            _pkt_buf[pos] = nullptr;
-            _size--;
-        }
+    for (auto offset = findSlot(0, diff, true); offset < diff; offset = findSlot(offset + 1, diff, true)) {
+        out.push_back(takePkt((_start + offset) % _pkt_cap));
     }
 
     _pkt_expected_seq = genExpectedSeq(last + 1);
@@ -440,13 +465,11 @@ bool PacketRecvQueue::drop(uint32_t first, uint32_t last, std::list<DataPacket::
 void PacketRecvQueue::insertToCycleBuf(DataPacket::Ptr pkt, uint32_t diff) {
     auto pos = (_start + diff) % _pkt_cap;
 
-    if (!_pkt_buf[pos]) {
-        _size++;
-    } else {
+    if (_pkt_buf[pos]) {
         // WarnL << "repate packet " << pkt->packet_seq_number;
         return;
     }
-    _pkt_buf[pos] = pkt;
+    setPkt(pos, std::move(pkt));
 
     if (_start <= _end && pos >= _end) {
         _end = (pos + 1) % _pkt_cap;
@@ -506,13 +529,7 @@ DataPacket::Ptr PacketRecvQueue::getFirst() {
         return nullptr;
     }
 
-    uint32_t i = _start;
-    while (1) {
-        if (_pkt_buf[i]) {
-            return _pkt_buf[i];
-        }
-        i = (i + 1) % _pkt_cap;
-    }
+    return _pkt_buf[(_start + findSlot(0, _pkt_cap, true)) % _pkt_cap];
 }
 DataPacket::Ptr PacketRecvQueue::getLast() {
     if (_size <= 0) {
@@ -61,6 +61,12 @@ private:
     std::map<uint32_t, DataPacket::Ptr> _pkt_map;
 };
 
+/**
+ * 接收窗口，包按与期望序号的偏移存放在环形缓冲中，并用位图记录各位置是否已收到，
+ * 丢包区间与最早的包按64位一组扫描位图得到，不再逐个位置遍历
+ * Receive window, packets are stored in a circular buffer by their offset from the expected seq and a bitmap records
+ * which positions have been received, loss ranges and the earliest packet are found by scanning the bitmap 64 positions at a time
+ */
 class PacketRecvQueue : public PacketQueueInterface {
 public:
     using Ptr = std::shared_ptr<PacketRecvQueue>;
@@ -86,6 +92,12 @@ private:
     DataPacket::Ptr getFirst();
     DataPacket::Ptr getLast();
     bool TLPKTDrop();
+    void setPkt(uint32_t pos, DataPacket::Ptr pkt);
+    DataPacket::Ptr takePkt(uint32_t pos);
+    void moveStart(uint32_t count);
+    // 查找相对_start偏移在[offset, count)内第一个已收到(present为true)或缺失的位置，没有时返回count
+    // Find the first received (present is true) or missing position whose offset from _start is in [offset, count), count if none
+    uint32_t findSlot(uint32_t offset, uint32_t count, bool present) const;
 
 private:
     uint32_t _pkt_cap;
@@ -95,6 +107,9 @@ private:
     uint32_t _srt_flag;
 
     std::vector<DataPacket::Ptr> _pkt_buf;
+    // 每个位置一位，1代表已收到
+    // One bit per position, 1 means received
+    std::vector<uint64_t> _pkt_bits;
     uint32_t _start = 0;
     uint32_t _end = 0;
     size_t _size = 0;
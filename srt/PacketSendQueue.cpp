@@ -5,28 +5,49 @@ namespace SRT {
 PacketSendQueue::PacketSendQueue(uint32_t max_size, uint32_t latency,uint32_t flag)
     : _srt_flag(flag)
     , _pkt_cap(max_size)
-    , _pkt_latency(latency) {}
+    , _pkt_latency(latency) {
+    _pkt_buf.resize(std::max<uint32_t>(_pkt_cap, 1));
+}
+
+void PacketSendQueue::popFront() {
+    _pkt_buf[_start].reset();
+    _start = (_start + 1) % _pkt_buf.size();
+    _first_seq = genExpectedSeq(_first_seq + 1);
+    --_size;
+}
 
 bool PacketSendQueue::drop(uint32_t num) {
-    decltype(_pkt_cache.begin()) it;
-    for (it = _pkt_cache.begin(); it != _pkt_cache.end(); ++it) {
-        if ((*it)->packet_seq_number == num) {
-            break;
-        }
+    // ack序号为对端期望的下一个包，等于最新包序号加一时全部清理
+    // The ack seq is the next packet expected by the peer, everything is removed when it equals the newest seq plus one
+    auto diff = genExpectedSeq(num - _first_seq);
+    if (diff > _size) {
+        return true;
     }
-    if (it != _pkt_cache.end()) {
-        _pkt_cache.erase(_pkt_cache.begin(), it);
+    while (diff--) {
+        popFront();
     }
     return true;
 }
 
 bool PacketSendQueue::inputPacket(DataPacket::Ptr pkt) {
-    _pkt_cache.push_back(pkt);
-    while (_pkt_cache.size() > _pkt_cap) {
-        _pkt_cache.pop_front();
+    if (_size && pkt->packet_seq_number != genExpectedSeq(_first_seq + _size)) {
+        // 序号不连续，无法再按偏移索引，清空重来
+        // The seq is not contiguous so offsets no longer index the packets, start over
+        TraceL << "send seq jump from " << genExpectedSeq(_first_seq + _size - 1) << " to " << pkt->packet_seq_number;
+        while (_size) {
+            popFront();
+        }
+    }
+    if (!_size) {
+        _first_seq = pkt->packet_seq_number;
+    }
+    if (_size == _pkt_buf.size()) {
+        popFront();
     }
+    _pkt_buf[(_start + _size) % _pkt_buf.size()] = std::move(pkt);
+    ++_size;
     while (timeLatency() > _pkt_latency && TLPKTDrop()) {
-        _pkt_cache.pop_front();
+        popFront();
     }
     return true;
 }
@@ -35,37 +56,24 @@ bool PacketSendQueue::TLPKTDrop(){
     return (_srt_flag&HSExtMessage::HS_EXT_MSG_TLPKTDROP) && (_srt_flag &HSExtMessage::HS_EXT_MSG_TSBPDSND);
 }
 
-std::list<DataPacket::Ptr> PacketSendQueue::findPacketBySeq(uint32_t start, uint32_t end) {
-    std::list<DataPacket::Ptr> re;
-    decltype(_pkt_cache.begin()) it;
-    for (it = _pkt_cache.begin(); it != _pkt_cache.end(); ++it) {
-        if ((*it)->packet_seq_number == start) {
-            break;
-        }
-    }
-
-    if (start == end) {
-        if (it != _pkt_cache.end()) {
-            re.push_back(*it);
-        }
-        return re;
+size_t PacketSendQueue::forEachPacket(uint32_t start, uint32_t end, const onPacket &cb) {
+    auto offset = genExpectedSeq(start - _first_seq);
+    if (offset >= _size) {
+        return 0;
     }
-
-    for (; it != _pkt_cache.end(); ++it) {
-        re.push_back(*it);
-        if ((*it)->packet_seq_number == end) {
-            break;
-        }
+    auto count = std::min<size_t>(genExpectedSeq(end - start) + 1, _size - offset);
+    for (size_t i = 0; i < count; ++i) {
+        cb(at(offset + i));
     }
-    return re;
+    return count;
 }
 
 uint32_t PacketSendQueue::timeLatency() {
-    if (_pkt_cache.empty()) {
+    if (!_size) {
         return 0;
     }
-    auto first = _pkt_cache.front()->timestamp;
-    auto last = _pkt_cache.back()->timestamp;
+    auto first = at(0)->timestamp;
+    auto last = at(_size - 1)->timestamp;
     uint32_t dur;
 
     if (last > first) {
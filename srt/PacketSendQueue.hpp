@@ -3,34 +3,62 @@
 
 #include "Packet.hpp"
 #include <algorithm>
-#include <list>
+#include <functional>
 #include <memory>
-#include <set>
-#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace SRT {
 
+/**
+ * 发送缓存，用于nak重传
+ * 发送的包序号连续，按序号偏移索引到环形缓冲中，ack清理、nak查找与重传均为O(1)定位
+ * Send buffer used for nak retransmission
+ * Sent packets have contiguous sequence numbers and are indexed into a circular buffer by their offset,
+ * so ack trimming and nak lookup locate packets in O(1)
+ */
 class PacketSendQueue {
 public:
     using Ptr = std::shared_ptr<PacketSendQueue>;
     using LostPair = std::pair<uint32_t, uint32_t>;
+    using onPacket = std::function<void(const DataPacket::Ptr &pkt)>;
 
     PacketSendQueue(uint32_t max_size, uint32_t latency,uint32_t flag = 0xbf);
     ~PacketSendQueue() = default;
 
+    /**
+     * 清理序号num之前的包(对端已确认)
+     * Remove the packets before seq num (acknowledged by the peer)
+     */
     bool drop(uint32_t num);
     bool inputPacket(DataPacket::Ptr pkt);
-    std::list<DataPacket::Ptr> findPacketBySeq(uint32_t start, uint32_t end);
+
+    /**
+     * 遍历缓存中序号[start, end]的包，start不在缓存中时不遍历
+     * Visit the cached packets with seq in [start, end], nothing is visited when start is not cached
+     * @return 遍历的包个数
+     * @return Number of packets visited
+     */
+    size_t forEachPacket(uint32_t start, uint32_t end, const onPacket &cb);
+
+    size_t getSize() const { return _size; }
 
 private:
     uint32_t timeLatency();
     bool TLPKTDrop();
+    void popFront();
+    const DataPacket::Ptr &at(size_t offset) const { return _pkt_buf[(_start + offset) % _pkt_buf.size()]; }
+
 private:
     uint32_t _srt_flag;
     uint32_t _pkt_cap;
     uint32_t _pkt_latency;
-    std::list<DataPacket::Ptr> _pkt_cache;
+    // 最早的包在环形缓冲中的位置及其序号
+    // Position of the oldest packet in the circular buffer and its seq
+    size_t _start = 0;
+    size_t _size = 0;
+    uint32_t _first_seq = 0;
+    std::vector<DataPacket::Ptr> _pkt_buf;
 };
 
 } // namespace SRT
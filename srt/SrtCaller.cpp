@@ -534,23 +534,16 @@ void SrtCaller::sendControlPacket(SRT::ControlPacket::Ptr pkt, bool flush) {
 }
 
 void SrtCaller::sendDataPacket(SRT::DataPacket::Ptr pkt, char *buf, int len, bool flush) {
-    auto data = buf;
-    auto size = len;
-    BufferLikeString::Ptr payload;
+    pkt->storeToData((uint8_t *)buf, len);
     if (_crypto) {
-        payload = _crypto->encrypt(pkt, const_cast<char*>(buf), len);
-        if (!payload) {
+        if (!_crypto->encrypt(pkt)) {
             WarnL << "encrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
             return;
         }
 
-        data = payload->data();
-        size = payload->size();
-
         tryAnnounceKeyMaterial();
     }
 
-    pkt->storeToData((uint8_t *)data, size);
     sendPacket(pkt, flush);
     _send_buf->inputPacket(pkt);
     return;
@@ -779,22 +772,18 @@ void SrtCaller::handleNAK(uint8_t *buf, int len, struct sockaddr *addr) {
     //TraceL;
     NAKPacket pkt;
     pkt.loadFromData(buf, len);
-    bool empty = false;
     bool flush = false;
 
     for (auto& it : pkt.lost_list) {
         if (pkt.lost_list.back() == it) {
             flush = true;
         }
-        empty = true;
-        auto re_list = _send_buf->findPacketBySeq(it.first, it.second - 1);
-        for (auto& pkt : re_list) {
+        auto count = _send_buf->forEachPacket(it.first, it.second - 1, [&](const DataPacket::Ptr &pkt) {
             pkt->R = 1;
             pkt->storeToHeader();
             sendPacket(pkt, flush);
-            empty = false;
-        }
-        if (empty) {
+        });
+        if (!count) {
             sendMsgDropReq(it.first, it.second - 1);
         }
     }
@@ -907,14 +896,9 @@ void SrtCaller::handleDataPacket(uint8_t *buf, int len, struct sockaddr *addr) {
     DataPacket::Ptr pkt = std::make_shared<DataPacket>();
     pkt->loadFromData(buf, len);
 
-    if (_crypto) {
-        auto payload = _crypto->decrypt(pkt, pkt->payloadData(), pkt->payloadSize());
-        if (!payload) {
-            WarnL << "decrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
-            return;
-        }
-
-        pkt->reloadPayload((uint8_t*)payload->data(), payload->size());
+    if (_crypto && !_crypto->decrypt(pkt)) {
+        WarnL << "decrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
+        return;
     }
 
     _estimated_link_capacity_context->inputPacket(_now, pkt);
@@ -7,6 +7,7 @@
 #include "Ack.hpp"
 #include "Packet.hpp"
 #include "SrtTransport.hpp"
+#include "Common/Metrics.h"
 
 namespace SRT {
 #define SRT_FIELD "srt."
@@ -93,6 +94,7 @@ void SrtTransport::createTimerForCheckAlive(){
 
 void SrtTransport::inputSockData(uint8_t *buf, int len, struct sockaddr_storage *addr) {
     _alive_ticker.resetTime();
+    mediakit::Metrics::srt.bytes_in.add(len);
     if(!_timer){
         createTimerForCheckAlive();
     }
@@ -439,22 +441,19 @@ void SrtTransport::handleNAK(uint8_t *buf, int len, struct sockaddr_storage *add
     // TraceL;
     NAKPacket pkt;
     pkt.loadFromData(buf, len);
-    bool empty = false;
     bool flush = false;
 
     for (auto& it : pkt.lost_list) {
         if (pkt.lost_list.back() == it) {
             flush = true;
         }
-        empty = true;
-        auto re_list = _send_buf->findPacketBySeq(it.first, it.second - 1);
-        for (auto& pkt : re_list) {
+        auto count = _send_buf->forEachPacket(it.first, it.second - 1, [&](const DataPacket::Ptr &pkt) {
             pkt->R = 1;
             pkt->storeToHeader();
+            mediakit::Metrics::nack_retransmits_srt.add();
             sendPacket(pkt, flush);
-            empty = false;
-        }
-        if (empty) {
+        });
+        if (!count) {
             sendMsgDropReq(it.first, it.second - 1);
         }
     }
@@ -747,17 +746,13 @@ void SrtTransport::sendShutDown() {
 }
 
 void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_storage *addr) {
+    mediakit::Metrics::srt.packets_in.add();
     DataPacket::Ptr pkt = std::make_shared<DataPacket>();
     pkt->loadFromData(buf, len);
 
-    if (_crypto) {
-        auto payload = _crypto->decrypt(pkt, pkt->payloadData(), pkt->payloadSize());
-        if (!payload) {
-            WarnL << "decrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
-            return;
-        }
-
-        pkt->reloadPayload((uint8_t*)payload->data(), payload->size());
+    if (_crypto && !_crypto->decrypt(pkt)) {
+        WarnL << "decrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
+        return;
     }
 
     _estimated_link_capacity_context->inputPacket(_now,pkt);
@@ -829,23 +824,17 @@ void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_stora
 }
 
 void SrtTransport::sendDataPacket(DataPacket::Ptr pkt, char *buf, int len, bool flush) {
-    auto data = buf;
-    auto size = len;
-    BufferLikeString::Ptr payload;
+    pkt->storeToData((uint8_t *)buf, len);
     if (_crypto) {
-        payload = _crypto->encrypt(pkt, const_cast<char*>(buf), len);
-        if (!payload) {
+        if (!_crypto->encrypt(pkt)) {
             WarnL << "encrypt pkt->packet_seq_number: " << pkt->packet_seq_number << ", timestamp: " << "pkt->timestamp " << " fail";
             return;
         }
 
-        data = payload->data();
-        size = payload->size();
-
         tryAnnounceKeyMaterial();
     }
 
-    pkt->storeToData((uint8_t *)data, size);
+    mediakit::Metrics::srt.packets_out.add();
     sendPacket(pkt, flush);
     _send_buf->inputPacket(pkt);
     return;
@@ -859,6 +848,7 @@ void SrtTransport::sendPacket(Buffer::Ptr pkt, bool flush) {
     if (_selected_session) {
         auto tmp = _packet_pool.obtain2();
         tmp->assign(pkt->data(), pkt->size());
+        mediakit::Metrics::srt.bytes_out.add(pkt->size());
         _selected_session->setSendFlushFlag(flush);
         _selected_session->send(std::move(tmp));
     } else {
@@ -0,0 +1,168 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+#if defined(ENABLE_IO_URING)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "Util/logger.h"
+#include "Util/semaphore.h"
+#include "Poller/EventPoller.h"
+#include "Common/IoUringReader.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static constexpr size_t kReadSize = 64 * 1024;
+
+struct Result {
+    double seconds;
+    double cpu_seconds;
+};
+
+static double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+// 丢弃文件的页缓存，模拟冷数据点播
+// Drop the page cache of the file to simulate cold vod
+static void dropCache(int fd) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+template <typename FUNC>
+static Result measure(int fd, FUNC &&func) {
+    dropCache(fd);
+    auto cpu = cpuSeconds();
+    auto start = chrono::steady_clock::now();
+    func();
+    auto seconds = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000000.0;
+    return Result { seconds, cpuSeconds() - cpu };
+}
+
+static void print(const char *name, const Result &result, size_t file_size) {
+    auto requests = file_size / kReadSize;
+    cout << name << (size_t)(file_size / 1024.0 / 1024.0 / result.seconds) << " MB/s, "
+         << (size_t)(requests / result.seconds) << " reads/s, "
+         << (size_t)(result.cpu_seconds * 1000000 / requests) << " cpu us/read" << endl;
+}
+
+// 该程序用于对比http点播时mmap、pread与io_uring读冷数据文件的吞吐量与cpu开销
+// 模拟一个poller线程同时服务多个点播客户端，每个客户端顺序读取文件中的一段
+// This program compares the throughput and cpu cost of mmap, pread and io_uring when reading cold files for http vod
+// It simulates one poller thread serving several vod clients at the same time, each client reads one slice of the file sequentially
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cout << "usage: " << argv[0] << " file [clients]" << endl;
+        return -1;
+    }
+    size_t clients = argc > 2 ? atoi(argv[2]) : 32;
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd == -1) {
+        cout << "open " << argv[1] << " failed: " << strerror(errno) << endl;
+        return -1;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size_t file_size = st.st_size / (clients * kReadSize) * (clients * kReadSize);
+    if (!file_size) {
+        cout << "file is too small" << endl;
+        return -1;
+    }
+    auto slice = file_size / clients;
+    vector<char> scratch(kReadSize);
+
+    // mmap：发送时拷贝映射内存，冷数据在poller线程中触发缺页中断
+    // mmap: the mapped memory is copied when sending, cold data triggers page faults in the poller thread
+    auto addr = (char *)mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    print("mmap:     ", measure(fd, [&]() {
+        for (size_t offset = 0; offset < slice; offset += kReadSize) {
+            for (size_t i = 0; i < clients; ++i) {
+                memcpy(scratch.data(), addr + i * slice + offset, kReadSize);
+            }
+        }
+    }), file_size);
+    munmap(addr, file_size);
+
+    // pread：poller线程同步阻塞读
+    // pread: blocking reads in the poller thread
+    print("pread:    ", measure(fd, [&]() {
+        for (size_t offset = 0; offset < slice; offset += kReadSize) {
+            for (size_t i = 0; i < clients; ++i) {
+                if (pread(fd, scratch.data(), kReadSize, i * slice + offset) != (ssize_t)kReadSize) {
+                    cout << "pread failed: " << strerror(errno) << endl;
+                    exit(-1);
+                }
+            }
+        }
+    }), file_size);
+
+    // io_uring：每个客户端同时只有一个读请求，与http文件发送一致
+    // io_uring: each client has only one read in flight, the same as sending http files
+    auto poller = EventPollerPool::Instance().getPoller();
+    print("io_uring: ", measure(fd, [&]() {
+        semaphore sem;
+        function<void(size_t, size_t)> read_slice;
+        poller->async([&]() {
+            auto reader = IoUringReader::getCurrent();
+            if (!reader) {
+                cout << "io_uring is not supported" << endl;
+                sem.post(clients);
+                return;
+            }
+            read_slice = [&, reader](size_t index, size_t offset) {
+                if (offset == slice) {
+                    sem.post();
+                    return;
+                }
+                reader->read(fd, index * slice + offset, kReadSize, [&, index, offset](const Buffer::Ptr &buf, int err) {
+                    if (!buf || buf->size() != kReadSize) {
+                        cout << "io_uring read failed: " << strerror(err) << endl;
+                        exit(-1);
+                    }
+                    read_slice(index, offset + kReadSize);
+                });
+            };
+            for (size_t i = 0; i < clients; ++i) {
+                read_slice(i, 0);
+            }
+        });
+        for (size_t i = 0; i < clients; ++i) {
+            sem.wait();
+        }
+        poller->sync([&]() { read_slice = nullptr; });
+    }), file_size);
+
+    close(fd);
+    return 0;
+}
+
+#else
+
+int main(int argc, char *argv[]) {
+    std::cout << "io_uring is not enabled, please build with -DENABLE_IO_URING=ON" << std::endl;
+    return 0;
+}
+
+#endif // defined(ENABLE_IO_URING)
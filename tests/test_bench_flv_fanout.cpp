@@ -0,0 +1,169 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <ctime>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Poller/EventPoller.h"
+#include "Common/config.h"
+#include "Rtmp/FlvMuxer.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class SourceListener : public MediaSourceEvent {
+public:
+    SourceListener(EventPoller::Ptr poller) : _poller(std::move(poller)) {}
+
+    EventPoller::Ptr getOwnerPoller(MediaSource &sender) override { return _poller; }
+
+    int totalReaderCount(MediaSource &sender) override { return sender.readerCount(); }
+
+private:
+    EventPoller::Ptr _poller;
+};
+
+// 模拟http-flv播放器：统计收到的flv数据量后直接丢弃，不产生网络开销
+// Simulated http-flv player: counts the flv bytes it receives and drops them, no network cost involved
+class FlvViewer : public FlvMuxer, public std::enable_shared_from_this<FlvViewer> {
+public:
+    using Ptr = std::shared_ptr<FlvViewer>;
+
+    void play(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr &media) { start(poller, media); }
+
+    size_t bytes = 0;
+
+private:
+    void onWrite(const Buffer::Ptr &data, bool flush) override { bytes += data->size(); }
+    void onDetach() override {}
+    std::shared_ptr<FlvMuxer> getSharedPtr() override { return shared_from_this(); }
+};
+
+// 模拟4Mbps、30fps的视频与44.1kHz的aac音频，一个GOP为2秒
+// Simulate 4Mbps 30fps video and 44.1kHz aac audio, one GOP lasts 2 seconds
+static vector<RtmpPacket::Ptr> makeRtmpPackets(size_t seconds) {
+    vector<RtmpPacket::Ptr> ret;
+    uint32_t audio_stamp = 0;
+    for (uint32_t frame = 0; frame < seconds * 30; ++frame) {
+        auto stamp = frame * 1000 / 30;
+        auto video = RtmpPacket::create();
+        video->type_id = MSG_VIDEO;
+        video->time_stamp = stamp;
+        video->buffer.assign(frame % 60 ? 14 * 1024 : 64 * 1024, 'v');
+        // 关键帧与普通帧的flv视频tag头
+        // Flv video tag header of key frames and other frames
+        video->buffer[0] = frame % 60 ? 0x27 : 0x17;
+        video->buffer[1] = 0x01;
+        ret.emplace_back(std::move(video));
+        for (; audio_stamp <= stamp; audio_stamp += 23) {
+            auto audio = RtmpPacket::create();
+            audio->type_id = MSG_AUDIO;
+            audio->time_stamp = audio_stamp;
+            audio->buffer.assign(300, 'a');
+            audio->buffer[0] = (char)0xAF;
+            audio->buffer[1] = 0x01;
+            ret.emplace_back(std::move(audio));
+        }
+    }
+    return ret;
+}
+
+struct BenchResult {
+    // 推流与分发给所有播放器消耗的进程cpu时间
+    // Process cpu time spent on writing the stream and dispatching it to all players
+    double cpu_us = 0;
+    size_t bytes_per_viewer = 0;
+    bool ok = true;
+};
+
+// 创建viewer_count个真实的FlvMuxer播放同一rtmp源，返回推流期间的cpu开销
+// Attach viewer_count real FlvMuxer players to one rtmp source and return the cpu cost while the stream is written
+static BenchResult runBench(const EventPoller::Ptr &poller, bool share_mux, size_t viewer_count, const vector<RtmpPacket::Ptr> &packets) {
+    mINI::Instance()[Rtmp::kFlvShareMux] = share_mux ? 1 : 0;
+    NOTICE_EMIT(BroadcastReloadConfigArgs, Broadcast::kBroadcastReloadConfig);
+
+    BenchResult ret;
+    auto listener = std::make_shared<SourceListener>(poller);
+    auto src = std::make_shared<RtmpMediaSource>(MediaTuple { DEFAULT_VHOST, "live", share_mux ? "flv_shared" : "flv_per_player", "" });
+    src->setListener(listener);
+
+    vector<FlvViewer::Ptr> viewers;
+    poller->sync([&]() {
+        for (size_t i = 0; i < viewer_count; ++i) {
+            auto viewer = std::make_shared<FlvViewer>();
+            viewer->play(poller, src);
+            // 不统计flv文件头
+            // The flv file header is not counted
+            viewer->bytes = 0;
+            viewers.emplace_back(std::move(viewer));
+        }
+    });
+
+    auto start = std::clock();
+    for (auto &pkt : packets) {
+        poller->sync([&]() { src->onWrite(pkt); });
+    }
+    // 等待环形缓存异步分发完毕
+    // Wait for the asynchronous dispatch of the ring buffer
+    poller->sync([]() {});
+    ret.cpu_us = (std::clock() - start) * 1000000.0 / CLOCKS_PER_SEC;
+
+    ret.bytes_per_viewer = viewers[0]->bytes;
+    for (auto &viewer : viewers) {
+        if (viewer->bytes != ret.bytes_per_viewer) {
+            ErrorL << "flv bytes differ between players: " << viewer->bytes << " != " << ret.bytes_per_viewer;
+            ret.ok = false;
+            break;
+        }
+    }
+    poller->sync([&]() {
+        for (auto &viewer : viewers) {
+            viewer->stop();
+        }
+        viewers.clear();
+        src = nullptr;
+    });
+    return ret;
+}
+
+// 该程序用于对比http-flv播放时逐个播放器封装flv tag与共享flv复用源的每观众cpu开销
+// This program compares the per-viewer cpu cost of framing flv tags per player versus sharing one flv muxing source
+int main(int argc, char *argv[]) {
+    size_t viewer_count = argc > 1 ? atoi(argv[1]) : 1000;
+    size_t seconds = argc > 2 ? atoi(argv[2]) : 10;
+    if (viewer_count == 0) {
+        viewer_count = 1;
+    }
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    auto poller = EventPollerPool::Instance().getPoller();
+    auto packets = makeRtmpPackets(seconds);
+    auto per_player = runBench(poller, false, viewer_count, packets);
+    auto shared = runBench(poller, true, viewer_count, packets);
+
+    if (!per_player.ok || !shared.ok) {
+        return -1;
+    }
+    if (per_player.bytes_per_viewer != shared.bytes_per_viewer) {
+        cout << "flv bytes mismatch: " << per_player.bytes_per_viewer << " != " << shared.bytes_per_viewer << endl;
+        return -1;
+    }
+
+    auto total = viewer_count * packets.size();
+    cout << "viewers:" << viewer_count << " packets:" << packets.size() << " bytes/viewer:" << shared.bytes_per_viewer << endl;
+    cout << "per-player mux: " << per_player.cpu_us * 1000 / total << " ns/packet/viewer, "
+         << per_player.cpu_us / viewer_count << " us/viewer" << endl;
+    cout << "shared mux:     " << shared.cpu_us * 1000 / total << " ns/packet/viewer, "
+         << shared.cpu_us / viewer_count << " us/viewer" << endl;
+    return 0;
+}
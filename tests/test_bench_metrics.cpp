@@ -0,0 +1,62 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include "Common/Metrics.h"
+
+using namespace std;
+using namespace mediakit;
+
+static atomic<int64_t> s_shared { 0 };
+static Metric s_metric("zlm_bench_metric_total", "Benchmark metric");
+
+template <typename FUNC>
+static double measure(size_t threads, size_t count, FUNC &&func) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t n = 0; n < count; ++n) {
+                func();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto seconds = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000000.0;
+    return threads * count / seconds / 1000000.0;
+}
+
+// 该程序用于对比多线程下共享原子变量计数与按线程分片计数的开销
+// 模拟多个poller线程在收发热路径上同时累加同一个统计指标
+// This program compares the cost of counting with a shared atomic variable and with per thread shards
+// It simulates several poller threads increasing the same metric on the send/receive hot path at the same time
+int main(int argc, char *argv[]) {
+    size_t threads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    size_t count = argc > 2 ? atoi(argv[2]) : 10000000;
+
+    auto atomic_rate = measure(threads, count, []() { s_shared.fetch_add(1, memory_order_relaxed); });
+    auto shard_rate = measure(threads, count, []() { s_metric.add(1); });
+
+    cout << "threads: " << threads << ", increments per thread: " << count << endl;
+    cout << "shared atomic: " << atomic_rate << " M increments/s, total " << s_shared.load() << endl;
+    cout << "thread shards: " << shard_rate << " M increments/s, total " << s_metric.value() << endl;
+    if (s_metric.value() != (int64_t)(threads * count)) {
+        cout << "sharded total mismatch" << endl;
+        return -1;
+    }
+    return 0;
+}
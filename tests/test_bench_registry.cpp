@@ -0,0 +1,110 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Common/config.h"
+#include "Common/MediaSource.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+// 仅用于压测注册表的空媒体源
+// Dummy media source used only for registry benchmarking
+class BenchMediaSource : public MediaSource {
+public:
+    using MediaSource::MediaSource;
+    int readerCount() override { return 0; }
+};
+
+static MediaTuple makeTuple(size_t index) {
+    MediaTuple tuple;
+    tuple.vhost = DEFAULT_VHOST;
+    tuple.app = "live";
+    tuple.stream = "stream_" + to_string(index);
+    return tuple;
+}
+
+// 多线程并发查找，同时有一个线程不断注册/注销，模拟播放器重连风暴
+// Concurrent lookups from several threads while one thread keeps registering/unregistering, simulating a player reconnect storm
+static void bench(size_t stream_count, size_t thread_count, size_t seconds) {
+    atomic<bool> exit_flag { false };
+    atomic<uint64_t> find_count { 0 };
+    atomic<uint64_t> regist_count { 0 };
+
+    vector<thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&, i]() {
+            uint64_t count = 0;
+            size_t index = i;
+            while (!exit_flag) {
+                index = (index * 1103515245 + 12345) % stream_count;
+                auto tuple = makeTuple(index);
+                MediaSource::find(RTSP_SCHEMA, tuple.vhost, tuple.app, tuple.stream);
+                ++count;
+            }
+            find_count += count;
+        });
+    }
+
+    threads.emplace_back([&]() {
+        uint64_t count = 0;
+        while (!exit_flag) {
+            auto src = std::make_shared<BenchMediaSource>(RTMP_SCHEMA, makeTuple(stream_count + count % 1000));
+            src->regist();
+            src->unregist();
+            ++count;
+        }
+        regist_count += count;
+    });
+
+    sleep(seconds);
+    exit_flag = true;
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    cout << "threads:" << thread_count
+         << " find/s:" << find_count / seconds
+         << " find/s per thread:" << find_count / seconds / thread_count
+         << " regist/s:" << regist_count / seconds << endl;
+}
+
+// 该程序用于测试MediaSource注册表在多核下的并发查找与注册性能
+// This program benchmarks concurrent find/register throughput of the MediaSource registry across core counts
+int main(int argc, char *argv[]) {
+    size_t stream_count = argc > 1 ? atoi(argv[1]) : 20000;
+    size_t max_threads = argc > 2 ? atoi(argv[2]) : thread::hardware_concurrency();
+    size_t seconds = argc > 3 ? atoi(argv[3]) : 3;
+
+    // 只打印警告以上日志，避免注册日志干扰测试结果
+    // Only print warnings and above, to keep registration logs from skewing the results
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+    loadIniConfig();
+
+    vector<MediaSource::Ptr> sources;
+    sources.reserve(stream_count);
+    for (size_t i = 0; i < stream_count; ++i) {
+        auto src = std::make_shared<BenchMediaSource>(RTSP_SCHEMA, makeTuple(i));
+        src->regist();
+        sources.emplace_back(std::move(src));
+    }
+    cout << "registered streams:" << stream_count << endl;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        bench(stream_count, threads, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <ctime>
+#include <iostream>
+#include <srtp2/srtp.h>
+#include "Util/logger.h"
+#include "Rtsp/Rtsp.h"
+#include "../webrtc/Sdp.h"
+#include "../webrtc/RtpExt.h"
+#include "../webrtc/SrtpSession.hpp"
+#include "../webrtc/WebRtcTransport.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static constexpr size_t kRtpPayloadSize = 1200;
+static constexpr uint8_t kSourceExtId = (uint8_t) RtpExtType::abs_send_time;
+static constexpr uint8_t kAnswerPt = 106;
+
+// 构造一个带abs-send-time扩展的rtp包，ext id为rtsp源内部统一使用的ext type
+// Make an rtp with an abs-send-time extension, whose ext id is the ext type used internally by rtsp sources
+static RtpPacket::Ptr makeRtp(uint16_t seq) {
+    auto rtp = RtpPacket::create();
+    rtp->setCapacity(RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize + 8 + kRtpPayloadSize);
+    rtp->setSize(rtp->getCapacity());
+    memset(rtp->data(), 0, rtp->size());
+    auto header = rtp->getHeader();
+    header->version = RtpPacket::kRtpVersion;
+    header->ext = 1;
+    header->pt = 96;
+    header->seq = htons(seq);
+    header->ssrc = htonl(0x12345678);
+    auto ext = (uint8_t *)header + RtpPacket::kRtpHeaderSize;
+    ext[0] = 0xBE;
+    ext[1] = 0xDE;
+    ext[2] = 0;
+    ext[3] = 1;
+    ext[4] = (kSourceExtId << 4) | 2;
+    rtp->type = TrackVideo;
+    return rtp;
+}
+
+static RtcMedia makeMedia() {
+    RtcMedia media;
+    media.type = TrackVideo;
+    SdpAttrExtmap extmap;
+    extmap.id = 3;
+    extmap.ext = RtpExt::getExtUrl(RtpExtType::abs_send_time);
+    media.extmap.emplace_back(std::move(extmap));
+    return media;
+}
+
+struct Viewer {
+    RtpExtContext::Ptr ext_ctx;
+    shared_ptr<RTC::SrtpSession> srtp;
+    ResourcePool<BufferRaw> pool;
+    vector<BufferRaw::Ptr> encrypted;
+    uint32_t ssrc;
+};
+
+// 与WebRtcTransportImp::rewriteRtp一致：拷贝后改写rtp ext id与pt
+// Same as WebRtcTransportImp::rewriteRtp: copy, then rewrite the rtp ext ids and pt
+static Buffer::Ptr rewriteRtp(Viewer &viewer, const RtpPacket::Ptr &rtp) {
+    auto len = rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    auto ret = BufferRaw::create();
+    ret->setCapacity(len + SRTP_MAX_TRAILER_LEN);
+    memcpy(ret->data(), rtp->data() + RtpPacket::kRtpTcpHeaderSize, len);
+    ret->setSize(len);
+    auto header = (RtpHeader *)ret->data();
+    viewer.ext_ctx->changeRtpExtId(header, false);
+    header->pt = kAnswerPt;
+    return ret;
+}
+
+// 与WebRtcTransport::sendRewrittenRtpList一致：整组替换ssrc并加密到池化内存
+// Same as WebRtcTransport::sendRewrittenRtpList: patch the ssrc and encrypt the whole list into pooled buffers
+static void encryptList(Viewer &viewer, const vector<Buffer::Ptr> &list) {
+    viewer.encrypted.clear();
+    for (auto &buf : list) {
+        auto len = (int)buf->size();
+        auto pkt = viewer.pool.obtain2();
+        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN);
+        memcpy(pkt->data(), buf->data(), len);
+        ((RtpHeader *)pkt->data())->ssrc = htonl(viewer.ssrc);
+        if (viewer.srtp->EncryptRtp((uint8_t *)pkt->data(), &len)) {
+            pkt->setSize(len);
+            viewer.encrypted.emplace_back(std::move(pkt));
+        }
+    }
+    viewer.encrypted.clear();
+}
+
+// 逐包发送路径：拷贝到池化内存后改写、替换ssrc并加密(onSendRtp + onBeforeEncryptRtp)
+// Per packet path: copy into pooled memory, rewrite, patch ssrc and encrypt (onSendRtp + onBeforeEncryptRtp)
+static void sendPerPacket(Viewer &viewer, const RtspMediaSource::RingDataType &batch) {
+    batch->for_each([&](const RtpPacket::Ptr &rtp) {
+        auto len = (int)(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+        auto pkt = viewer.pool.obtain2();
+        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2);
+        memcpy(pkt->data(), rtp->data() + RtpPacket::kRtpTcpHeaderSize, len);
+        auto header = (RtpHeader *)pkt->data();
+        viewer.ext_ctx->changeRtpExtId(header, false);
+        header->pt = kAnswerPt;
+        header->ssrc = htonl(viewer.ssrc);
+        if (viewer.srtp->EncryptRtp((uint8_t *)pkt->data(), &len)) {
+            pkt->setSize(len);
+        }
+    });
+}
+
+static double cpuUs(clock_t start) {
+    return (double)(clock() - start) * 1000000 / CLOCKS_PER_SEC;
+}
+
+// 该程序用于对比rtc播放时逐个播放器改写rtp与共享改写rtp(SharedRtpRewriteCache)的每观众cpu开销
+// This program compares the per-viewer cpu cost of rewriting rtp per player versus sharing the rewritten rtp (SharedRtpRewriteCache)
+int main(int argc, char *argv[]) {
+    size_t viewer_count = argc > 1 ? atoi(argv[1]) : 1000;
+    size_t packet_count = argc > 2 ? atoi(argv[2]) : 50;
+    size_t batch_count = argc > 3 ? atoi(argv[3]) : 20;
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    auto media = makeMedia();
+    vector<Viewer> viewers(viewer_count);
+    uint32_t ssrc = 1;
+    for (auto &viewer : viewers) {
+        uint8_t key[SRTP_AES_ICM_128_KEY_LEN_WSALT];
+        for (auto &byte : key) {
+            byte = rand() & 0xFF;
+        }
+        viewer.ext_ctx = std::make_shared<RtpExtContext>(media);
+        viewer.srtp = std::make_shared<RTC::SrtpSession>(RTC::SrtpSession::Type::OUTBOUND, RTC::SrtpSession::CryptoSuite::AES_CM_128_HMAC_SHA1_80, key, sizeof(key));
+        viewer.ssrc = ssrc++;
+    }
+    // 所有观众协商结果一致，共享同一个改写签名
+    // All viewers negotiated the same parameters, so they share one rewrite signature
+    auto rewrite_key = viewers[0].ext_ctx->getSendKey() + "|" + to_string(kAnswerPt);
+
+    uint16_t seq = 0;
+    auto make_batch = [&]() {
+        auto ret = std::make_shared<List<RtpPacket::Ptr>>();
+        for (size_t i = 0; i < packet_count; ++i) {
+            ret->emplace_back(makeRtp(seq++));
+        }
+        return ret;
+    };
+
+    auto run = [&](size_t viewers_used, bool shared) {
+        auto start = clock();
+        for (size_t n = 0; n < batch_count; ++n) {
+            // 每组rtp都是新的环形缓存数据，与直播时一致
+            // Every batch is fresh ring data, as in a live stream
+            RtspMediaSource::RingDataType batch = make_batch();
+            for (size_t i = 0; i < viewers_used; ++i) {
+                auto &viewer = viewers[i];
+                if (!shared) {
+                    sendPerPacket(viewer, batch);
+                    continue;
+                }
+                auto &rewritten = SharedRtpRewriteCache::Instance().get(batch, rewrite_key, [&](const RtpPacket::Ptr &rtp) {
+                    return rewriteRtp(viewer, rtp);
+                });
+                encryptList(viewer, rewritten);
+            }
+        }
+        return cpuUs(start);
+    };
+
+    auto report = [&](const char *name, size_t viewers_used, double us) {
+        auto total = viewers_used * packet_count * batch_count;
+        cout << name << " viewers:" << viewers_used << " cpu:" << (size_t)us << "us "
+             << us * 1000 / total << " ns/packet/viewer " << us / viewers_used << " us/viewer" << endl;
+    };
+
+    cout << "packets/batch:" << packet_count << " batches:" << batch_count << endl;
+    report("per-player rewrite  ", viewer_count, run(viewer_count, false));
+    report("shared rewrite      ", viewer_count, run(viewer_count, true));
+    // 单观众时共享路径多一次分配与拷贝，WebRtcPlayer此时走逐包路径
+    // With a single viewer the shared path costs an extra allocation and copy, so WebRtcPlayer uses the per packet path
+    report("per-player 1 viewer ", 1, run(1, false));
+    report("shared 1 viewer     ", 1, run(1, true));
+    return 0;
+}
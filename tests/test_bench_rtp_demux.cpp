@@ -0,0 +1,198 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <pcap.h>
+#include <sys/resource.h>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Network/sockutil.h"
+#include "Common/config.h"
+#include "Common/Metrics.h"
+#include "Common/MediaSource.h"
+#include "Rtp/RtpServer.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+struct PcapRtp {
+    // 相对首包的时间，单位微秒
+    // Time relative to the first packet, in microseconds
+    uint64_t time_us;
+    string rtp;
+};
+
+// 读取pcap中第一个udp rtp流(按首个rtp包的ssrc过滤)
+// Load the first udp rtp stream of the pcap (filtered by the ssrc of the first rtp packet)
+static vector<PcapRtp> loadPcap(const char *path) {
+    vector<PcapRtp> ret;
+    char errbuf[PCAP_ERRBUF_SIZE] = { 0 };
+    std::shared_ptr<pcap_t> handle(pcap_open_offline(path, errbuf), [](pcap_t *handle) {
+        if (handle) {
+            pcap_close(handle);
+        }
+    });
+    if (!handle) {
+        WarnL << "open file failed:" << path << " error: " << errbuf;
+        return ret;
+    }
+
+    uint32_t ssrc = 0;
+    uint64_t first_us = 0;
+    struct pcap_pkthdr *header;
+    const u_char *data;
+    while (pcap_next_ex(handle.get(), &header, &data) == 1) {
+        // 以太网头14字节 + ipv4头 + udp头8字节
+        // 14 bytes ethernet header + ipv4 header + 8 bytes udp header
+        if (header->caplen < 14 + 20 + 8 || data[12] != 0x08 || data[13] != 0x00) {
+            continue;
+        }
+        auto ip = data + 14;
+        auto ip_len = (ip[0] & 0x0F) * 4;
+        if (ip[9] != 17 || header->caplen < 14 + ip_len + 8u) {
+            continue;
+        }
+        auto udp = ip + ip_len;
+        auto rtp = (const char *)udp + 8;
+        auto rtp_len = (size_t)((udp[4] << 8) | udp[5]) - 8;
+        if (rtp_len > header->caplen - 14 - ip_len - 8) {
+            continue;
+        }
+        uint32_t rtp_ssrc = 0;
+        if (!isRtp(rtp, rtp_len) || !getSSRC(rtp, rtp_len, rtp_ssrc) || (ssrc && rtp_ssrc != ssrc)) {
+            continue;
+        }
+        uint64_t now_us = header->ts.tv_sec * 1000000ULL + header->ts.tv_usec;
+        if (!ssrc) {
+            ssrc = rtp_ssrc;
+            first_us = now_us;
+        }
+        ret.emplace_back(PcapRtp { now_us - first_us, string(rtp, rtp_len) });
+    }
+    return ret;
+}
+
+static uint64_t getCpuUS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static size_t countStreams() {
+    size_t ret = 0;
+    MediaSource::for_each_media([&](const MediaSource::Ptr &src) { ++ret; }, RTSP_SCHEMA, DEFAULT_VHOST, kRtpAppName);
+    return ret;
+}
+
+// 以同一来源地址按原始节奏回放pcap中的rtp流，每个包改写ssrc后复制为多路流，模拟大量设备经同一网关推流到单端口
+// Replay the rtp stream of the pcap at its original pace from a single source address, every packet is copied into several streams with
+// rewritten ssrcs, simulating many devices publishing to the single port through the same gateway
+static void replay(const vector<PcapRtp> &packets, size_t streams, uint16_t port, const atomic<bool> &exit_flag, atomic<uint64_t> &sent) {
+    auto fd = SockUtil::bindUdpSock(0, "127.0.0.1");
+    struct sockaddr_storage addr = SockUtil::make_sockaddr("127.0.0.1", port);
+    auto addr_len = SockUtil::get_sock_len((struct sockaddr *)&addr);
+    SockUtil::setSendBuf(fd, 16 * 1024 * 1024);
+
+    auto duration_us = packets.back().time_us + 40 * 1000;
+    uint32_t duration_stamp = ntohl(*(uint32_t *)(packets.back().rtp.data() + 4)) - ntohl(*(uint32_t *)(packets.front().rtp.data() + 4)) + 3600;
+    Ticker ticker;
+    string rtp;
+    for (uint32_t loop = 0; !exit_flag; ++loop) {
+        for (auto &packet : packets) {
+            auto due_us = loop * duration_us + packet.time_us;
+            while (ticker.elapsedTime() * 1000 < due_us && !exit_flag) {
+                usleep(500);
+            }
+            rtp = packet.rtp;
+            auto data = (uint8_t *)&rtp[0];
+            // 循环回放时seq与时间戳继续递增
+            // Seq and timestamp keep increasing when the pcap is replayed in a loop
+            *(uint16_t *)(data + 2) = htons(ntohs(*(uint16_t *)(data + 2)) + loop * packets.size());
+            *(uint32_t *)(data + 4) = htonl(ntohl(*(uint32_t *)(data + 4)) + loop * duration_stamp);
+            for (size_t i = 0; i < streams; ++i) {
+                *(uint32_t *)(data + 8) = htonl(10000 + i);
+                if (::sendto(fd, rtp.data(), rtp.size(), 0, (struct sockaddr *)&addr, addr_len) > 0) {
+                    ++sent;
+                }
+            }
+        }
+    }
+    close(fd);
+}
+
+// 该程序用于测试单端口国标rtp服务器在大量流下的ps/ts解复用吞吐，对比是否按ssrc把解复用分散到多个线程(rtp_proxy.demux_workers)
+// This program benchmarks the ps/ts demuxing throughput of the single port gb28181 rtp server with many streams,
+// comparing with and without spreading the demuxing over several threads by ssrc (rtp_proxy.demux_workers)
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cout << "usage: " << argv[0] << " <ps or ts over udp rtp pcap> [streams=200] [demux_workers=0] [seconds=10] [port=10000]" << endl;
+        return -1;
+    }
+    size_t streams = argc > 2 ? atoi(argv[2]) : 200;
+    size_t workers = argc > 3 ? atoi(argv[3]) : 0;
+    size_t seconds = argc > 4 ? atoi(argv[4]) : 10;
+    uint16_t port = argc > 5 ? atoi(argv[5]) : 10000;
+
+    // 只打印警告以上日志，避免推流日志干扰测试结果
+    // Only print warnings and above, to keep publishing logs from skewing the results
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+    loadIniConfig();
+    mINI::Instance()[RtpProxy::kUdpBatchRecv] = 1;
+    mINI::Instance()[RtpProxy::kDemuxWorkers] = workers;
+
+    auto packets = loadPcap(argv[1]);
+    if (packets.size() < 2) {
+        cout << "no rtp found in " << argv[1] << endl;
+        return -1;
+    }
+    cout << "rtp packets:" << packets.size() << " duration(ms):" << packets.back().time_us / 1000 << " streams:" << streams
+         << " demux_workers:" << workers << " threads:" << EventPollerPool::Instance().getExecutorSize() << endl;
+
+    auto server = std::make_shared<RtpServer>();
+    server->start(port, "127.0.0.1", MediaTuple { DEFAULT_VHOST, kRtpAppName, "", "" }, RtpServer::NONE);
+
+    atomic<bool> exit_flag { false };
+    atomic<uint64_t> sent { 0 };
+    thread sender([&]() { replay(packets, streams, port, exit_flag, sent); });
+
+    uint64_t last_sent = 0;
+    uint64_t last_recv = Metrics::rtp.packets_in.value();
+    uint64_t last_cpu = getCpuUS();
+    Ticker ticker;
+    for (size_t i = 0; i < seconds; ++i) {
+        sleep(1);
+        auto elapsed_us = ticker.elapsedTime() * 1000;
+        ticker.resetTime();
+        uint64_t now_sent = sent;
+        uint64_t now_recv = Metrics::rtp.packets_in.value();
+        uint64_t now_cpu = getCpuUS();
+
+        string load;
+        for (auto val : EventPollerPool::Instance().getExecutorLoad()) {
+            load += to_string(val) + " ";
+        }
+        cout << "sent/s:" << (now_sent - last_sent) << " processed/s:" << (now_recv - last_recv)
+             << " streams:" << countStreams() << " cpu:" << (now_cpu - last_cpu) * 100 / (elapsed_us ? elapsed_us : 1) << "%"
+             << " thread load:" << load << endl;
+        last_sent = now_sent;
+        last_recv = now_recv;
+        last_cpu = now_cpu;
+    }
+
+    exit_flag = true;
+    sender.join();
+    server = nullptr;
+    return 0;
+}
@@ -0,0 +1,96 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include "srt/PacketQueue.hpp"
+
+using namespace std;
+using namespace SRT;
+
+// 该程序用于测试srt接收窗口在丢包下的处理能力：每路流按丢包率丢包，丢失的包一半在约一个rtt后重传到达，另一半等到超出延时后被丢弃，
+// 每20ms获取一次丢包区间(nak周期)；输出每秒可处理的包数与单核可承载的流数
+// This program benchmarks the srt receive window under loss: packets of every stream are lost at the loss rate, half of them
+// are retransmitted about one rtt later and the other half are given up once past the latency, loss ranges are fetched every 20ms (the nak period);
+// it prints the packets handled per second and how many streams one core could carry
+int main(int argc, char *argv[]) {
+    size_t streams = argc > 1 ? atoi(argv[1]) : 100;
+    size_t mbps = argc > 2 ? atoi(argv[2]) : 8;
+    size_t seconds = argc > 3 ? atoi(argv[3]) : 10;
+    size_t cap = argc > 4 ? atoi(argv[4]) : 8192;
+    if (!streams || !mbps || !seconds || !cap) {
+        cout << "usage: " << argv[0] << " [streams=100] [mbps per stream=8] [media seconds=10] [window=8192]" << endl;
+        return -1;
+    }
+
+    // 每个包1316字节负载
+    // 1316 bytes of payload per packet
+    size_t pkts_per_sec = mbps * 1000 * 1000 / 8 / 1316;
+    size_t pkts_per_nak = std::max<size_t>(pkts_per_sec / 50, 1);
+    size_t rtt_pkts = std::max<size_t>(pkts_per_sec / 20, 1);
+    cout << "streams:" << streams << " packets per second per stream:" << pkts_per_sec << " window:" << cap << endl;
+
+    for (auto loss : { 0.0, 0.01, 0.05, 0.1 }) {
+        mt19937 rng(12345);
+        uniform_real_distribution<double> lost(0, 1);
+        struct Stream {
+            PacketRecvQueue::Ptr queue;
+            vector<pair<size_t, DataPacket::Ptr> > retransmit;
+        };
+        vector<Stream> feeds(streams);
+        for (auto &feed : feeds) {
+            feed.queue = std::make_shared<PacketRecvQueue>(cap, 0, 120 * 1000);
+        }
+
+        size_t handled = 0;
+        size_t losts = 0;
+        list<DataPacket::Ptr> out;
+        chrono::steady_clock::duration cost { 0 };
+        for (size_t i = 0; i < pkts_per_sec * seconds; ++i) {
+            // 包对象的创建不计入耗时
+            // Creating the packets is not timed
+            vector<DataPacket::Ptr> pkts(streams);
+            for (auto &pkt : pkts) {
+                pkt = std::make_shared<DataPacket>();
+                pkt->packet_seq_number = i;
+                pkt->timestamp = (uint32_t)(i * 1000 * 1000 / pkts_per_sec);
+            }
+            auto start = chrono::steady_clock::now();
+            for (size_t j = 0; j < streams; ++j) {
+                auto &feed = feeds[j];
+                auto val = lost(rng);
+                if (val < loss / 2) {
+                    feed.retransmit.emplace_back(i + rtt_pkts, std::move(pkts[j]));
+                } else if (val >= loss) {
+                    feed.queue->inputPacket(std::move(pkts[j]), out);
+                    ++handled;
+                }
+                while (!feed.retransmit.empty() && feed.retransmit.front().first <= i) {
+                    feed.queue->inputPacket(std::move(feed.retransmit.front().second), out);
+                    feed.retransmit.erase(feed.retransmit.begin());
+                    ++handled;
+                }
+                if (i % pkts_per_nak == 0) {
+                    losts += feed.queue->getLostSeq().size();
+                }
+                out.clear();
+            }
+            cost += chrono::steady_clock::now() - start;
+        }
+        auto us = chrono::duration_cast<chrono::microseconds>(cost).count();
+        auto pps = us ? handled * 1000000.0 / us : 0;
+        cout << "loss:" << loss * 100 << "% packets:" << handled << " loss ranges:" << losts << " cost(ms):" << us / 1000
+             << " packets/s:" << (size_t)pps << " streams per core:" << (size_t)(pps / pkts_per_sec) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <list>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include "srt/PacketSendQueue.hpp"
+
+using namespace std;
+using namespace SRT;
+
+// 旧版按链表遍历查找的发送缓存，用于对比
+// The former send buffer that scans a list, used for comparison
+class ListSendQueue {
+public:
+    ListSendQueue(size_t cap) : _cap(cap) {}
+
+    void drop(uint32_t num) {
+        auto it = _cache.begin();
+        for (; it != _cache.end(); ++it) {
+            if ((*it)->packet_seq_number == num) {
+                break;
+            }
+        }
+        if (it != _cache.end()) {
+            _cache.erase(_cache.begin(), it);
+        }
+    }
+
+    void inputPacket(DataPacket::Ptr pkt) {
+        _cache.push_back(std::move(pkt));
+        while (_cache.size() > _cap) {
+            _cache.pop_front();
+        }
+    }
+
+    size_t forEachPacket(uint32_t start, uint32_t end, const PacketSendQueue::onPacket &cb) {
+        list<DataPacket::Ptr> re;
+        auto it = _cache.begin();
+        for (; it != _cache.end(); ++it) {
+            if ((*it)->packet_seq_number == start) {
+                break;
+            }
+        }
+        for (; it != _cache.end(); ++it) {
+            re.push_back(*it);
+            if ((*it)->packet_seq_number == end) {
+                break;
+            }
+        }
+        for (auto &pkt : re) {
+            cb(pkt);
+        }
+        return re.size();
+    }
+
+private:
+    size_t _cap;
+    list<DataPacket::Ptr> _cache;
+};
+
+struct Result {
+    double nak_ns;
+    size_t naks;
+    size_t retransmits;
+};
+
+// 模拟发送端：先填满缓存，之后每发送一个包，按丢包率在最近一个rtt内发送的包中产生nak(连续丢失1~3个)，
+// 每rtt收到一次ack；统计nak查找加重传遍历的平均耗时
+// Simulate the sender: fill the cache first, then for every packet sent, naks are generated at the loss rate
+// for packets sent within the last rtt (1~3 consecutive losses), and an ack arrives every rtt;
+// the average time of nak lookup plus retransmit visiting is measured
+template <typename Queue>
+static Result run(Queue &queue, size_t cache, size_t rtt_pkts, double loss, size_t rounds) {
+    mt19937 rng(12345);
+    uniform_real_distribution<double> lost(0, 1);
+    uniform_int_distribution<uint32_t> burst(1, 3);
+    uniform_int_distribution<uint32_t> back(1, rtt_pkts);
+
+    uint32_t seq = 0;
+    auto send = [&]() {
+        auto pkt = std::make_shared<DataPacket>();
+        pkt->packet_seq_number = seq;
+        pkt->timestamp = seq;
+        queue.inputPacket(std::move(pkt));
+        seq = genExpectedSeq(seq + 1);
+    };
+    for (size_t i = 0; i < cache; ++i) {
+        send();
+    }
+
+    Result ret { 0, 0, 0 };
+    chrono::steady_clock::duration cost { 0 };
+    for (size_t i = 0; i < rounds; ++i) {
+        send();
+        if (i % rtt_pkts == 0) {
+            // 对端确认到一个缓存之前的包，缓存大小保持不变
+            // The peer acknowledges up to one cache ago, so the cache size stays the same
+            queue.drop(genExpectedSeq(seq - cache));
+        }
+        if (lost(rng) >= loss) {
+            continue;
+        }
+        auto first = genExpectedSeq(seq - back(rng));
+        auto last = genExpectedSeq(first + burst(rng) - 1);
+        auto start = chrono::steady_clock::now();
+        ret.retransmits += queue.forEachPacket(first, last, [](const DataPacket::Ptr &pkt) { pkt->R = 1; });
+        cost += chrono::steady_clock::now() - start;
+        ++ret.naks;
+    }
+    ret.nak_ns = ret.naks ? chrono::duration_cast<chrono::nanoseconds>(cost).count() / (double)ret.naks : 0;
+    return ret;
+}
+
+// 该程序用于测试srt发送缓存处理nak的耗时，对比按序号索引的环形缓冲与旧版链表遍历
+// This program benchmarks how long the srt send buffer takes to handle naks,
+// comparing the seq indexed circular buffer with the former list scan
+int main(int argc, char *argv[]) {
+    // 默认约20Mbps码率、4倍延时下缓存的包数
+    // By default roughly the packets cached at 20Mbps with a 4x latency multiplier
+    size_t cache = argc > 1 ? atoi(argv[1]) : 32768;
+    size_t rtt_pkts = argc > 2 ? atoi(argv[2]) : 400;
+    size_t rounds = argc > 3 ? atoi(argv[3]) : 200000;
+    if (!cache || !rtt_pkts || rtt_pkts > cache) {
+        cout << "usage: " << argv[0] << " [cache packets=32768] [packets per rtt=400] [packets sent=200000]" << endl;
+        return -1;
+    }
+
+    cout << "cache:" << cache << " packets per rtt:" << rtt_pkts << " packets sent:" << rounds << endl;
+    for (auto loss : { 0.001, 0.01, 0.05, 0.1, 0.2 }) {
+        PacketSendQueue indexed(cache, 0xffffffff, 0);
+        ListSendQueue scanned(cache);
+        auto ret_indexed = run(indexed, cache, rtt_pkts, loss, rounds);
+        auto ret_scanned = run(scanned, cache, rtt_pkts, loss, rounds);
+        cout << "loss:" << loss * 100 << "% naks:" << ret_indexed.naks << " retransmits:" << ret_indexed.retransmits << "/"
+             << ret_scanned.retransmits << " indexed:" << ret_indexed.nak_ns << "ns/nak list:" << ret_scanned.nak_ns
+             << "ns/nak speedup:" << (ret_indexed.nak_ns ? ret_scanned.nak_ns / ret_indexed.nak_ns : 0) << "x" << endl;
+    }
+    return 0;
+}
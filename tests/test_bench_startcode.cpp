@@ -0,0 +1,103 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iostream>
+#include "ext-codec/H264.h"
+
+using namespace std;
+using namespace mediakit;
+
+// 优化前splitH264使用的逐字节查找
+// The byte by byte search used by splitH264 before
+static const char *memfind(const char *buf, ssize_t len, const char *subbuf, ssize_t sublen) {
+    for (auto i = 0; i < len - sublen; ++i) {
+        if (memcmp(buf + i, subbuf, sublen) == 0) {
+            return buf + i;
+        }
+    }
+    return NULL;
+}
+
+// 模拟一个4K IDR帧：sps/pps加上8个slice，slice负载为经过防竞争处理的随机数据
+// Simulate a 4K IDR frame: sps/pps plus 8 slices, the slice payload is random data with emulation prevention applied
+static string makeIdrFrame(size_t bytes) {
+    mt19937 rng(4096);
+    string frame;
+    frame.append("\x00\x00\x00\x01\x67\x64\x00\x33\xac\x1b\x1a\x80\x0f\x00\x10\xfb\x01\x10\x00\x00\x03\x00\x10\x00\x00\x07\x88\xf1\x83\x2a", 30);
+    frame.append("\x00\x00\x00\x01\x68\xee\x3c\xb0", 8);
+    for (int slice = 0; slice < 8; ++slice) {
+        frame.append(slice ? string("\x00\x00\x01\x65", 4) : string("\x00\x00\x00\x01\x65", 5));
+        int zeros = 0;
+        for (size_t i = 0; i < bytes / 8; ++i) {
+            // 约1/16的字节为0，接近真实码流中0x00的密度
+            // About 1/16 of the bytes are 0, close to the 0x00 density of real streams
+            auto byte = (uint8_t)(rng() % 16 ? rng() : 0);
+            if (zeros >= 2 && byte <= 3) {
+                frame.push_back(3);
+                zeros = 0;
+            }
+            frame.push_back((char)byte);
+            zeros = byte ? 0 : zeros + 1;
+        }
+        frame.push_back((char)0x80);
+    }
+    return frame;
+}
+
+template <typename FUNC>
+static void bench(const char *name, const string &frame, size_t rounds, FUNC &&find) {
+    size_t nal_count = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        auto ptr = frame.data();
+        auto end = ptr + frame.size();
+        while (auto next = find(ptr, end - ptr)) {
+            ++nal_count;
+            ptr = next + 3;
+        }
+    }
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << (double)frame.size() * rounds / ns << " GB/s, nal count: " << nal_count / rounds << endl;
+}
+
+// 该程序用于对比H264/H265起始码查找优化前后的吞吐
+// 用法：test_bench_startcode [annexb文件] [轮数]，不指定文件时使用模拟的4K IDR帧
+// This program compares the throughput of the H264/H265 start code search before and after the optimization
+// Usage: test_bench_startcode [annexb file] [rounds], a simulated 4K IDR frame is used if no file is given
+int main(int argc, char *argv[]) {
+    string frame;
+    if (argc > 1) {
+        ifstream file(argv[1], ios::binary);
+        if (!file) {
+            cerr << "open file failed: " << argv[1] << endl;
+            return -1;
+        }
+        stringstream ss;
+        ss << file.rdbuf();
+        frame = ss.str();
+    } else {
+        frame = makeIdrFrame(600 * 1024);
+    }
+    // 默认共扫描约2GB数据
+    // Scan about 2GB of data by default
+    size_t rounds = argc > 2 ? atoi(argv[2]) : std::max<size_t>(1, ((size_t)2 << 30) / std::max<size_t>(frame.size(), 1));
+    cout << "data size: " << frame.size() << " bytes, rounds: " << rounds << endl;
+
+    bench("memfind", frame, rounds, [](const char *ptr, size_t len) { return memfind(ptr, len, "\x00\x00\x01", 3); });
+    bench("findStartCode", frame, rounds, [](const char *ptr, size_t len) { return findStartCode(ptr, len); });
+    return 0;
+}
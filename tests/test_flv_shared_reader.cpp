@@ -0,0 +1,117 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <mutex>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Poller/EventPoller.h"
+#include "Rtmp/RtmpMediaSource.h"
+#include "Rtmp/FlvMediaSource.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+// 记录rtmp源上报的观看人数变化
+// Record the reader count changes reported by the rtmp source
+class ReaderListener : public MediaSourceEvent {
+public:
+    ReaderListener(EventPoller::Ptr poller) : _poller(std::move(poller)) {}
+
+    EventPoller::Ptr getOwnerPoller(MediaSource &sender) override { return _poller; }
+
+    int totalReaderCount(MediaSource &sender) override { return sender.readerCount(); }
+
+    void onReaderChanged(MediaSource &sender, int size) override {
+        lock_guard<mutex> lck(_mtx);
+        _sizes.emplace_back(size);
+    }
+
+    vector<int> sizes() {
+        lock_guard<mutex> lck(_mtx);
+        return _sizes;
+    }
+
+private:
+    mutex _mtx;
+    vector<int> _sizes;
+    EventPoller::Ptr _poller;
+};
+
+static RtmpPacket::Ptr makeVideoPacket(uint32_t stamp, bool key) {
+    auto pkt = RtmpPacket::create();
+    pkt->type_id = MSG_VIDEO;
+    pkt->time_stamp = stamp;
+    pkt->buffer.assign(1024, 'v');
+    pkt->buffer[0] = key ? 0x17 : 0x27;
+    pkt->buffer[1] = 0x01;
+    return pkt;
+}
+
+// 该程序用于验证共享flv复用源附着rtmp源到其首个播放器附着期间，rtmp源观看人数不会短暂变为0
+// This program checks that the reader count of the rtmp source never drops to 0 between the shared flv muxing source
+// attaching to it and the first flv player attaching
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    auto poller = EventPollerPool::Instance().getPoller();
+    auto listener = std::make_shared<ReaderListener>(poller);
+    auto src = std::make_shared<RtmpMediaSource>(MediaTuple { DEFAULT_VHOST, "live", "flv_share", "" });
+    src->setListener(listener);
+
+    bool ok = true;
+    FlvMediaSource::RingType::RingReader::Ptr player;
+    std::shared_ptr<FlvMediaSource> flv_src;
+    poller->sync([&]() {
+        for (uint32_t i = 0; i < 30; ++i) {
+            src->onWrite(makeVideoPacket(i * 40, i == 0));
+        }
+
+        flv_src = src->getFlvSource(poller);
+        if (!flv_src) {
+            ErrorL << "create the shared flv muxing source failed";
+            ok = false;
+            return;
+        }
+        if (src->readerCount() != 1) {
+            ErrorL << "reader count before the first flv player attaches: " << src->readerCount();
+            ok = false;
+        }
+
+        player = flv_src->attach(poller);
+        if (!player || src->readerCount() != 1) {
+            ErrorL << "reader count after the first flv player attaches: " << src->readerCount();
+            ok = false;
+        }
+    });
+    // 等待异步的观看人数回调执行完毕
+    // Wait for the asynchronous reader count callbacks
+    poller->sync([]() {});
+
+    auto sizes = listener->sizes();
+    if (sizes.empty()) {
+        ErrorL << "no reader count change reported";
+        ok = false;
+    }
+    for (auto size : sizes) {
+        if (size <= 0) {
+            ErrorL << "reader count dropped to " << size << " while the flv player was attaching";
+            ok = false;
+        }
+    }
+
+    poller->sync([&]() {
+        player = nullptr;
+        flv_src = nullptr;
+    });
+    cout << (ok ? "passed" : "failed") << endl;
+    return ok ? 0 : -1;
+}
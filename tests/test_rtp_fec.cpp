@@ -0,0 +1,242 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "Rtsp/RtpFec.h"
+
+using namespace std;
+using namespace mediakit;
+
+static constexpr uint8_t kMediaPT = 96;
+static constexpr uint8_t kRedPT = 100;
+static constexpr uint8_t kUlpfecPT = 101;
+static constexpr uint32_t kSSRC = 0x12345678;
+
+static size_t s_failed = 0;
+
+static void check(const char *what, bool ok) {
+    if (!ok) {
+        ++s_failed;
+        cout << what << " failed" << endl;
+    }
+}
+
+static void saveBE16(uint8_t *ptr, uint16_t val) {
+    ptr[0] = val >> 8;
+    ptr[1] = val & 0xFF;
+}
+
+static void saveBE32(uint8_t *ptr, uint32_t val) {
+    ptr[0] = val >> 24;
+    ptr[1] = (val >> 16) & 0xFF;
+    ptr[2] = (val >> 8) & 0xFF;
+    ptr[3] = val & 0xFF;
+}
+
+// 生成rtp包，未指定负载时负载长度与内容随seq变化，用于检验长度与负载的恢复
+// Build an rtp packet, without a given payload its length and content vary with seq, to check the length and payload recovery
+static string makeRtp(uint16_t seq, uint8_t pt = kMediaPT, bool mark = false, const string &payload = "") {
+    string ret(RtpPacket::kRtpHeaderSize, '\0');
+    auto data = (uint8_t *)&ret[0];
+    data[0] = RtpPacket::kRtpVersion << 6;
+    data[1] = (mark ? 0x80 : 0) | pt;
+    saveBE16(data + 2, seq);
+    saveBE32(data + 4, seq * 3000u);
+    saveBE32(data + 8, kSSRC);
+    if (!payload.empty()) {
+        return ret + payload;
+    }
+    for (size_t i = 0; i < 20u + seq % 7 * 10; ++i) {
+        ret.push_back((char)(seq * 31 + i));
+    }
+    return ret;
+}
+
+static vector<string> makeMedia(uint16_t first, uint16_t count) {
+    vector<string> ret;
+    for (uint16_t i = 0; i < count; ++i) {
+        ret.emplace_back(makeRtp(first + i));
+    }
+    return ret;
+}
+
+static void inputMedia(RtpFecReceiver &fec, const string &raw) {
+    auto rtp = RtpPacket::create(RtpPacket::kRtpTcpHeaderSize + raw.size());
+    rtp->setSize(RtpPacket::kRtpTcpHeaderSize + raw.size());
+    auto data = (uint8_t *)rtp->data();
+    data[0] = '$';
+    data[1] = 0;
+    saveBE16(data + 2, (uint16_t)raw.size());
+    memcpy(data + RtpPacket::kRtpTcpHeaderSize, raw.data(), raw.size());
+    fec.inputMedia(rtp);
+}
+
+static void inputFec(RtpFecReceiver &fec, const string &raw) {
+    fec.inputFec((const uint8_t *)raw.data(), raw.size());
+}
+
+static vector<string> popAll(RtpFecReceiver &fec) {
+    vector<string> ret;
+    string packet;
+    while (fec.popPacket(packet)) {
+        ret.emplace_back(std::move(packet));
+    }
+    return ret;
+}
+
+// 按rfc2198封装red包，blocks为主负载之前连续seq的冗余块(从旧到新)
+// Build a red packet as rfc2198, blocks are the redundant blocks of the consecutive seqs before the primary block (from old to new)
+static string makeRed(const vector<string> &blocks, const string &primary) {
+    auto primary_header = (const uint8_t *)primary.data();
+    uint32_t primary_stamp = primary_header[4] << 24 | primary_header[5] << 16 | primary_header[6] << 8 | primary_header[7];
+    string payload;
+    for (auto &block : blocks) {
+        auto header = (const uint8_t *)block.data();
+        uint32_t stamp = header[4] << 24 | header[5] << 16 | header[6] << 8 | header[7];
+        auto size = block.size() - RtpPacket::kRtpHeaderSize;
+        uint8_t block_header[4];
+        block_header[0] = 0x80 | (header[1] & 0x7F);
+        saveBE16(block_header + 1, (uint16_t)((primary_stamp - stamp) << 2 | size >> 8));
+        block_header[3] = size & 0xFF;
+        payload.append((const char *)block_header, 4);
+    }
+    payload.push_back(primary_header[1] & 0x7F);
+    for (auto &block : blocks) {
+        payload.append(block, RtpPacket::kRtpHeaderSize, string::npos);
+    }
+    payload.append(primary, RtpPacket::kRtpHeaderSize, string::npos);
+    uint16_t seq = primary_header[2] << 8 | primary_header[3];
+    return makeRtp(seq, kRedPT, primary_header[1] & 0x80, payload);
+}
+
+// 按rfc5109生成level 0的ulpfec包
+// @param protection_len 保护长度，0代表覆盖最长的被保护包
+// Build a level 0 ulpfec packet as rfc5109
+// @param protection_len Protection length, 0 means covering the longest protected packet
+static string makeUlpfec(uint16_t seq, const vector<string> &media, bool long_mask, size_t protection_len = 0) {
+    if (!protection_len) {
+        for (auto &raw : media) {
+            protection_len = (std::max)(protection_len, raw.size() - RtpPacket::kRtpHeaderSize);
+        }
+    }
+    auto seq_base = (uint16_t)((uint8_t)media[0][2] << 8 | (uint8_t)media[0][3]);
+    uint8_t bits[2] = { 0, 0 };
+    uint32_t stamp = 0;
+    uint16_t length = 0;
+    uint64_t mask = 0;
+    string xor_payload(protection_len, '\0');
+    for (auto &raw : media) {
+        auto header = (const uint8_t *)raw.data();
+        bits[0] ^= header[0];
+        bits[1] ^= header[1];
+        stamp ^= header[4] << 24 | header[5] << 16 | header[6] << 8 | header[7];
+        auto size = raw.size() - RtpPacket::kRtpHeaderSize;
+        length ^= (uint16_t)size;
+        for (size_t i = 0; i < (std::min)(size, protection_len); ++i) {
+            xor_payload[i] ^= raw[RtpPacket::kRtpHeaderSize + i];
+        }
+        uint16_t media_seq = header[2] << 8 | header[3];
+        mask |= 1ULL << (47 - (uint16_t)(media_seq - seq_base));
+    }
+
+    string payload(10 + (long_mask ? 8 : 4), '\0');
+    auto fec = (uint8_t *)&payload[0];
+    fec[0] = (long_mask ? 0x40 : 0) | (bits[0] & 0x3F);
+    fec[1] = bits[1];
+    saveBE16(fec + 2, seq_base);
+    saveBE32(fec + 4, stamp);
+    saveBE16(fec + 8, length);
+    saveBE16(fec + 10, (uint16_t)protection_len);
+    saveBE16(fec + 12, (uint16_t)(mask >> 32));
+    if (long_mask) {
+        saveBE32(fec + 14, (uint32_t)mask);
+    }
+    return makeRtp(seq, kUlpfecPT, false, payload + xor_payload);
+}
+
+// red包的冗余块中，已收到的包不再输出，丢失的包与主负载按原样解封装
+// Among the redundant blocks of a red packet, received packets are not output again, the lost one and the primary block are decapsulated as they were
+static void test_red() {
+    RtpFecReceiver fec(kRedPT, kUlpfecPT);
+    auto media = makeMedia(10, 3);
+    media[2] = makeRtp(12, kMediaPT, true);
+    auto red = makeRed({ media[0], media[1] }, media[2]);
+    check("red primary pt", RtpFecReceiver::getRedPrimaryPT((const uint8_t *)red.data(), red.size()) == kMediaPT);
+
+    inputMedia(fec, media[0]);
+    inputFec(fec, red);
+    auto out = popAll(fec);
+    check("red decapsulation", out.size() == 2 && out[0] == media[1] && out[1] == media[2]);
+}
+
+// 保护范围内恰好丢失一个包时，ulpfec恢复出与原包完全相同的rtp包
+// When exactly one protected packet is lost, ulpfec recovers an rtp packet identical to the original one
+static void test_ulpfec(const char *what, uint16_t first, uint16_t count, uint16_t lost, bool long_mask) {
+    RtpFecReceiver fec(kRedPT, kUlpfecPT);
+    auto media = makeMedia(first, count);
+    // 丢失的包带mark位，检验mark位的恢复
+    // The lost packet carries the mark bit, to check the mark bit is recovered
+    media[lost] = makeRtp(first + lost, kMediaPT, true);
+    for (auto &raw : media) {
+        if (raw != media[lost]) {
+            inputMedia(fec, raw);
+        }
+    }
+    inputFec(fec, makeUlpfec(1000, media, long_mask));
+    auto out = popAll(fec);
+    check(what, out.size() == 1 && out[0] == media[lost]);
+}
+
+// 丢失的包比保护长度更长时无法恢复，不能输出被截断的包
+// A lost packet longer than the protection length can not be recovered, no truncated packet must be output
+static void test_protection_len() {
+    RtpFecReceiver fec(kRedPT, kUlpfecPT);
+    auto media = makeMedia(80, 4);
+    inputMedia(fec, media[0]);
+    inputMedia(fec, media[1]);
+    inputMedia(fec, media[3]);
+    inputFec(fec, makeUlpfec(1000, media, false, media[2].size() - RtpPacket::kRtpHeaderSize - 10));
+    check("loss longer than the protection length", popAll(fec).empty());
+}
+
+// fec包先于被保护的媒体包到达时(丢失多于一个)挂起，等迟到的媒体包到达后再恢复
+// A fec packet arriving before the protected media (more than one lost) waits, and recovers once the late media packet arrives
+static void test_pending() {
+    RtpFecReceiver fec(kRedPT, kUlpfecPT);
+    auto media = makeMedia(90, 4);
+    inputMedia(fec, media[0]);
+    inputMedia(fec, media[1]);
+    inputFec(fec, makeUlpfec(1000, media, false));
+    check("pending fec recovered early", popAll(fec).empty());
+    inputMedia(fec, media[3]);
+    auto out = popAll(fec);
+    check("pending fec", out.size() == 1 && out[0] == media[2]);
+}
+
+// 该程序用于校验red解封装与ulpfec丢包恢复
+// This program verifies the red decapsulation and the ulpfec loss recovery
+int main(int argc, char *argv[]) {
+    test_red();
+    test_ulpfec("ulpfec short mask", 20, 6, 3, false);
+    test_ulpfec("ulpfec long mask", 30, 40, 35, true);
+    test_protection_len();
+    test_pending();
+
+    if (s_failed) {
+        cout << "failed: " << s_failed << endl;
+        return -1;
+    }
+    cout << "all passed" << endl;
+    return 0;
+}
@@ -9,15 +9,61 @@
  */
 
 #include <map>
+#include <set>
 #include <list>
+#include <chrono>
+#include <vector>
 #include <iostream>
 #include <functional>
 #include "Rtsp/RtpReceiver.h"
+#include "Common/Metrics.h"
 
 using namespace std;
 using namespace mediakit;
 
-void test_real() {
+// 输入时seq不在已输出的最后一个seq之后，说明该包迟到了(已被当作丢包跳过)，排序器可以丢弃它
+// The seq is not after the last output seq when input, so the packet is late (already skipped as lost) and the sorter may drop it
+static bool is_late(uint16_t seq, const list<uint16_t> &sorted_list) {
+    return !sorted_list.empty() && (uint16_t)(seq - sorted_list.back() - 1) >= 0x8000;
+}
+
+// 检查排序结果：输出的seq按回环距离严格递增(即无重复、无乱序)，只包含输入过的seq，
+// 且除了迟到的包、flush前仍在缓存中的包与排序器统计为溢出丢弃的包外，输入的每个seq都被输出
+// Check the sorted output: the seqs strictly increase by wraparound distance (no duplicates, no reordering), only input seqs are output,
+// and every input seq is output except late ones, those still cached before flush and those the sorter counted as overflow drops
+static bool check_sorted(const list<uint16_t> &input_list, const set<uint16_t> &late_set, const list<uint16_t> &sorted_list, size_t max_missing) {
+    set<uint16_t> input_set(input_list.begin(), input_list.end());
+    bool ok = true;
+    size_t index = 0;
+    uint16_t last = 0;
+    for (auto seq : sorted_list) {
+        if (!input_set.count(seq)) {
+            cout << "错误(error): 输出了未输入的seq(output seq never input): " << seq << endl;
+            ok = false;
+        }
+        if (index++ && (uint16_t)(seq - last) - 1 >= 0x7FFF) {
+            cout << "错误(error): 输出乱序或重复(out of order or duplicate output): " << last << " -> " << seq << endl;
+            ok = false;
+        }
+        last = seq;
+    }
+    size_t missing = 0;
+    set<uint16_t> sorted_set(sorted_list.begin(), sorted_list.end());
+    for (auto seq : input_set) {
+        if (!sorted_set.count(seq) && !late_set.count(seq)) {
+            ++missing;
+        }
+    }
+    if (missing > max_missing) {
+        cout << "错误(error): 丢失的seq个数(missing seqs): " << missing << " > " << max_missing << endl;
+        ok = false;
+    }
+    cout << (ok ? "检查通过(check passed)" : "检查失败(check failed)") << endl;
+    return ok;
+}
+
+template <bool kRingWindow>
+bool test_real() {
     // 这个是一次真实的rtp seq记录  [AUTO-TRANSLATED:a0cbaeff]
     // This is a real rtp seq record
     list<uint16_t> input_list = {15125, 15126, 15127, 15128, 15129, 15130, 15131, 15132, 15133, 15134, 15135, 15136,
@@ -101,18 +147,24 @@ void test_real() {
                                  16067, 16068, 16069, 16070, 16071, 16072, 16073, 16074, 16075, 16076, 16077, 16078,
                                  16079, 16080, 16081, 16082, 16083, 16084};
 
-    PacketSortor<uint16_t, uint16_t> sortor;
+    auto dropped = Metrics::dropped_sort_overflow.value();
+    PacketSortor<uint16_t, uint16_t, kRingWindow> sortor;
     list<uint16_t> sorted_list;
     sortor.setOnSort([&](uint16_t seq, uint16_t packet) {
         sorted_list.push_back(seq);
     });
 
+    set<uint16_t> late_set;
     for (auto &seq : input_list) {
+        if (is_late(seq, sorted_list)) {
+            late_set.emplace(seq);
+        }
         sortor.sortPacket(seq, seq);
     }
 
+    auto jitter_size = sortor.getJitterSize();
     cout << "输入数据个数:" << input_list.size()
-         << " 抖动缓冲区大小:" << sortor.getJitterSize();
+         << " 抖动缓冲区大小:" << jitter_size;
 
     // 清空缓存  [AUTO-TRANSLATED:a7d8287a]
     // Clear cache
@@ -120,7 +172,7 @@ void test_real() {
 
     cout << " 输出数据个数:" << sorted_list.size() << endl;
 
-#if 1
+#if 0
     {
         cout << endl;
         cout << "排序前:" << endl;
@@ -147,15 +199,26 @@ void test_real() {
         cout << endl;
     }
 #endif
+    return check_sorted(input_list, late_set, sorted_list, jitter_size + (size_t)(Metrics::dropped_sort_overflow.value() - dropped));
 }
 
-void test_rand(){
-    srand((unsigned) time(NULL));
-    PacketSortor<uint16_t, uint16_t> sortor;
+template <bool kRingWindow>
+bool test_rand(unsigned seed) {
+    srand(seed);
+    auto dropped = Metrics::dropped_sort_overflow.value();
+    PacketSortor<uint16_t, uint16_t, kRingWindow> sortor;
     list<uint16_t> input_list, sorted_list, drop_list, repeat_list;
+    set<uint16_t> late_set;
     sortor.setOnSort([&](uint16_t seq, const uint16_t &packet) {
         sorted_list.push_back(seq);
     });
+    auto input_packet = [&](uint16_t seq) {
+        if (is_late(seq, sorted_list)) {
+            late_set.emplace(seq);
+        }
+        sortor.sortPacket(seq, seq);
+        input_list.push_back(seq);
+    };
 
     for (int i = 0; i < 1000;) {
         // 模拟乱序，count是连续倒序次数,最多连续乱序8次  [AUTO-TRANSLATED:76bd8e43]
@@ -179,15 +242,13 @@ void test_rand(){
                 if (seq % (1 + rand() % 100) == 0) {
                     // 模拟重复，概率5%左右  [AUTO-TRANSLATED:f096bdf1]
                     // Simulate duplication, about 5% probability
-                    sortor.sortPacket(seq, seq);
-                    input_list.push_back(seq);
+                    input_packet(seq);
                     ++input;
                 }
                 if (seq % (1 + rand() % 100) != 0) {
                     // 模拟丢包，概率5%左右  [AUTO-TRANSLATED:91a54869]
                     // Simulate packet loss, about 5% probability
-                    sortor.sortPacket(seq, seq);
-                    input_list.push_back(seq);
+                    input_packet(seq);
                     ++input;
                 }
             }
@@ -208,14 +269,14 @@ void test_rand(){
                     break;
             }
 #else
-            sortor.sortPacket(seq, seq);
-            input_list.push_back(seq);
+            input_packet(seq);
 #endif
         }
         i += (count + 1);
     }
+    auto jitter_size = sortor.getJitterSize();
     cout << "输入数据个数:" << input_list.size()
-         << " 抖动缓冲区大小:" << sortor.getJitterSize()
+         << " 抖动缓冲区大小:" << jitter_size
          << " 丢包个数:" << drop_list.size()
          << " 重复包个数:" << repeat_list.size();
 
@@ -225,7 +286,7 @@ void test_rand(){
 
     cout << " 输出数据个数:" << sorted_list.size() << endl;
 
-#if 1
+#if 0
     {
         cout << endl;
         cout << "丢包列表:" << endl;
@@ -278,6 +339,66 @@ void test_rand(){
         cout << endl;
     }
 #endif
+    return check_sorted(input_list, late_set, sorted_list, jitter_size + (size_t)(Metrics::dropped_sort_overflow.value() - dropped));
+}
+
+// 生成压测用的seq序列
+// @param reorder 乱序的包组最大长度，0为不乱序
+// @param loss_percent 丢包率
+// Generate the seq sequence for benchmarking
+// @param reorder Max length of a reordered packet group, 0 for no reordering
+// @param loss_percent Packet loss percent
+static vector<uint16_t> make_bench_input(size_t count, int reorder, int loss_percent) {
+    vector<uint16_t> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count;) {
+        size_t group = reorder ? 1 + rand() % reorder : 1;
+        for (size_t j = i + group; j-- > i;) {
+            if (loss_percent && rand() % 100 < loss_percent) {
+                continue;
+            }
+            ret.push_back((uint16_t)j);
+        }
+        i += group;
+    }
+    return ret;
+}
+
+template <bool kRingWindow>
+static void bench_sortor(const char *name, const vector<uint16_t> &input, int times) {
+    size_t output = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < times; ++i) {
+        PacketSortor<uint16_t, uint16_t, kRingWindow> sortor;
+        sortor.setOnSort([&](uint16_t seq, uint16_t packet) {
+            ++output;
+        });
+        for (auto &seq : input) {
+            sortor.sortPacket(seq, seq);
+        }
+        sortor.flush();
+    }
+    auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    auto total = input.size() * times;
+    cout << "  " << name << ": " << (us ? total / us : 0) << " Mpps, " << (total ? us * 1000 / total : 0) << " ns/packet"
+         << ", output:" << output / times << "/" << input.size() << endl;
+}
+
+// 对比std::map排序器与环形窗口排序器在顺序、乱序、丢包输入下的吞吐量
+// Compare the throughput of the std::map sorter and the ring window sorter under in-order, reordered and lossy inputs
+void test_bench(size_t count, int times) {
+    struct {
+        const char *name;
+        int reorder;
+        int loss_percent;
+    } cases[] = { { "顺序(in-order)", 0, 0 }, { "乱序(reordered)", 8, 0 }, { "丢包(lossy 5%)", 0, 5 }, { "乱序+丢包(reordered+lossy)", 8, 5 } };
+
+    for (auto &item : cases) {
+        auto input = make_bench_input(count, item.reorder, item.loss_percent);
+        cout << item.name << endl;
+        bench_sortor<false>("map ", input, times);
+        bench_sortor<true>("ring", input, times);
+    }
 }
 
 // 该测试程序用于检验rtp排序算法的正确性  [AUTO-TRANSLATED:251b9c45]
@@ -285,12 +406,28 @@ void test_rand(){
 int main(int argc, char *argv[]) {
     // 测试真实的rtp seq  [AUTO-TRANSLATED:d87b1d7a]
     // Test real rtp seq
+    // std::map排序器与环形窗口排序器使用相同的输入与检查
+    // The std::map sorter and the ring window sorter go through the same inputs and checks
+    bool ok = true;
     cout << "###### 真实的rtp seq #####" << endl;
-    test_real();
+    cout << "map : ";
+    ok = test_real<false>() && ok;
+    cout << "ring: ";
+    ok = test_real<true>() && ok;
 
     // 模拟rtp乱序、回环、丢包、重复情况  [AUTO-TRANSLATED:cc92ba9d]
     // Simulate rtp out-of-order, loopback, packet loss, and duplication scenarios
     cout << "###### 模拟的rtp seq #####" << endl;
-    test_rand();
-    return 0;
+    auto seed = (unsigned)time(NULL);
+    cout << "seed:" << seed << endl;
+    cout << "map : ";
+    ok = test_rand<false>(seed) && ok;
+    cout << "ring: ";
+    ok = test_rand<true>(seed) && ok;
+
+    // 排序器吞吐量压测
+    // Sorter throughput benchmark
+    cout << "###### 吞吐量压测 #####" << endl;
+    test_bench(argc > 1 ? atoi(argv[1]) : 100000, argc > 2 ? atoi(argv[2]) : 20);
+    return ok ? 0 : 1;
 }
\ No newline at end of file
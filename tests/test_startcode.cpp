@@ -0,0 +1,103 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <string>
+#include <iostream>
+#include "ext-codec/H264.h"
+
+using namespace std;
+using namespace mediakit;
+
+static size_t s_failed = 0;
+
+static void check(const string &impl, const char *what, const string &buf, size_t len, const char *expect, const char *got) {
+    if (expect == got) {
+        return;
+    }
+    ++s_failed;
+    auto pos = [&](const char *ptr) { return ptr ? to_string(ptr - buf.data()) : string("null"); };
+    cout << impl << " " << what << " len:" << len << " expect:" << pos(expect) << " got:" << pos(got) << endl;
+}
+
+// 在不含0的数据中放置一个起始码，校验各实现都能在正确位置找到它，覆盖16与32字节块的边界及缓冲区末尾
+// Put a start code into data without zeros and check every implementation finds it at the right position,
+// covering the 16 and 32 byte block boundaries and the very end of the buffer
+static void test_position(const vector<pair<string, FindStartCode>> &impls) {
+    for (size_t len = 3; len <= 100; ++len) {
+        for (size_t prefix = 3; prefix <= 4; ++prefix) {
+            if (prefix > len) {
+                continue;
+            }
+            for (size_t offset = 0; offset + prefix <= len; ++offset) {
+                string buf(len, (char)0x55);
+                // 4字节起始码0x00 00 00 01时应返回其中0x00 00 01的位置
+                // For the 4 byte start code 0x00 00 00 01 the position of its 0x00 00 01 is expected
+                buf.replace(offset, prefix, prefix == 3 ? string("\x00\x00\x01", 3) : string("\x00\x00\x00\x01", 4));
+                auto expect = buf.data() + offset + prefix - 3;
+                for (auto &impl : impls) {
+                    check(impl.first, prefix == 3 ? "3 byte" : "4 byte", buf, len, expect, impl.second(buf.data(), len));
+                    // 起始码最后一个字节在长度之外时不应被找到
+                    // The start code must not be found when its last byte is beyond the length
+                    check(impl.first, "truncated", buf, offset + prefix - 1, nullptr, impl.second(buf.data(), offset + prefix - 1));
+                }
+            }
+        }
+    }
+}
+
+// 随机数据(0x00与0x01密集)与逐字节的标量实现对比，每个实现从每个起始偏移重复查找到数据末尾
+// Random data (dense with 0x00 and 0x01) compared with the scalar byte by byte implementation,
+// every implementation searches repeatedly from each start offset to the end of the data
+static void test_random(const vector<pair<string, FindStartCode>> &impls, size_t rounds) {
+    mt19937 rng(1234);
+    for (size_t round = 0; round < rounds; ++round) {
+        string buf(1 + rng() % 200, '\0');
+        auto density = 2 + rng() % 16;
+        for (auto &ch : buf) {
+            auto r = rng() % density;
+            ch = (char)(r == 0 ? 0 : (r == 1 ? 1 : rng()));
+        }
+        for (size_t start = 0; start < buf.size(); start += 1 + rng() % 7) {
+            auto ptr = buf.data() + start;
+            auto len = buf.size() - start;
+            auto expect = impls[0].second(ptr, len);
+            for (size_t i = 1; i < impls.size(); ++i) {
+                check(impls[i].first, "random", buf, len, expect, impls[i].second(ptr, len));
+            }
+        }
+    }
+}
+
+// 该程序用于校验SSE2/AVX2/NEON加速的起始码查找与标量实现的结果一致
+// This program verifies the SSE2/AVX2/NEON accelerated start code search gives the same results as the scalar implementation
+int main(int argc, char *argv[]) {
+    auto impls = getFindStartCodeImpls();
+    cout << "implementations:";
+    for (auto &impl : impls) {
+        cout << " " << impl.first;
+    }
+    cout << endl;
+
+    test_position(impls);
+    test_random(impls, argc > 1 ? atoi(argv[1]) : 100000);
+
+    // 对外接口使用的实现也必须一致
+    // The implementation behind the public interface must agree as well
+    string frame("\x65\x88\x00\x00\x03\x00\x00\x00\x01\x41", 10);
+    check("findStartCode", "public", frame, frame.size(), frame.data() + 6, findStartCode(frame.data(), frame.size()));
+
+    if (s_failed) {
+        cout << "failed: " << s_failed << endl;
+        return -1;
+    }
+    cout << "all passed" << endl;
+    return 0;
+}
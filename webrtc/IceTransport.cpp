@@ -188,6 +188,19 @@ void IceTransport::sendSocketData_l(const Buffer::Ptr& buf, const Pair::Ptr& pai
     TraceL << "data: " << hexdump(buf->data(), buf->size());
 #endif
 
+    if (pair->_socket->getSock()->sockType() == SockNum::Sock_UDP) {
+        // udp模式下先缓存，flush时批量发出(sendmmsg/GSO)
+        // In udp mode, buffer first and send in batch on flush (sendmmsg/GSO)
+        pair->_udp_batch.input(buf);
+        if (flush) {
+            sockaddr_storage peer_addr;
+            pair->get_peer_addr(peer_addr);
+            auto addr_len = SockUtil::get_sock_len((const struct sockaddr*)&peer_addr);
+            pair->_udp_batch.flush(pair->_socket->getSock(), (struct sockaddr*)&peer_addr, addr_len);
+        }
+        return;
+    }
+
     sockaddr_storage peer_addr;
     pair->get_peer_addr(peer_addr);
     auto addr_len = SockUtil::get_sock_len((const struct sockaddr*)&peer_addr);
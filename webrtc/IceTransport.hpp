@@ -25,6 +25,7 @@
 #include "Network/Socket.h"
 #include "Network/UdpClient.h"
 #include "Network/Session.h"
+#include "Common/UdpBatchSender.h"
 #include "logger.h"
 #include "StunPacket.hpp"
 
@@ -301,6 +302,9 @@ public:
 
         //中继后地址，用于实现TURN转发地址，当该地址不为空时，该地址为真正的peer地址,_peer_host和_peer_port表示中继地址
         std::shared_ptr<sockaddr_storage> _relayed_addr;
+
+        //udp批量发送器，flush时一次性发出缓存的包
+        mediakit::UdpBatchSender _udp_batch;
     };
 
     class Listener {
@@ -646,6 +646,17 @@ RtpExt RtpExtContext::changeRtpExtId(const RtpHeader *header, bool is_recv, stri
     return ret;
 }
 
+string RtpExtContext::getSendKey() const {
+    string ret;
+    for (auto &pr : _rtp_ext_type_to_id) {
+        ret += to_string((int) pr.first);
+        ret += '=';
+        ret += to_string((int) pr.second);
+        ret += ';';
+    }
+    return ret;
+}
+
 void RtpExtContext::setOnGetRtp(OnGetRtp cb) {
     _cb = std::move(cb);
 }
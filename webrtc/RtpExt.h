@@ -124,6 +124,9 @@ public:
     std::string getRid(uint32_t ssrc) const;
     void setRid(uint32_t ssrc, const std::string &rid);
     RtpExt changeRtpExtId(const RtpHeader *header, bool is_recv, std::string *rid_ptr = nullptr, RtpExtType type = RtpExtType::padding);
+    // 发送rtp时ext id改写规则的签名，签名相同的上下文改写结果一致
+    // Signature of the ext id rewrite rule used when sending rtp, contexts with equal signatures rewrite identically
+    std::string getSendKey() const;
 
 private:
     void onGetRtp(uint8_t pt, uint32_t ssrc, const std::string &rid);
@@ -22,7 +22,13 @@ namespace mediakit {
 namespace Rtc {
 #define RTC_FIELD "rtc."
 const string kBfilter = RTC_FIELD "bfilter";
-static onceToken token([]() { mINI::Instance()[kBfilter] = 0; });
+// 同线程内协商参数一致的播放器共享改写后的rtp，每个播放器只需拷贝、替换ssrc并加密
+// Players on the same thread with identical negotiation share rewritten rtp, each player only copies, patches ssrc and encrypts
+const string kSharedRewrite = RTC_FIELD "sharedRewrite";
+static onceToken token([]() {
+    mINI::Instance()[kBfilter] = 0;
+    mINI::Instance()[kSharedRewrite] = 1;
+});
 } // namespace Rtc
 
 H264BFrameFilter::H264BFrameFilter()
@@ -195,6 +201,10 @@ WebRtcPlayer::WebRtcPlayer(const EventPoller::Ptr &poller,
 
     GET_CONFIG(bool, enable, Rtc::kBfilter);
     _bfliter_flag = enable;
+    GET_CONFIG(bool, shared_rewrite, Rtc::kSharedRewrite);
+    // b帧过滤会逐个播放器修改rtp，此时不能共享
+    // B-frame filtering modifies rtp per player, sharing is not possible then
+    _shared_rewrite = shared_rewrite && !enable;
     _is_h264 = false;
     _bfilter = std::make_shared<H264BFrameFilter>();
 }
@@ -228,6 +238,16 @@ void WebRtcPlayer::onStartWebRTC() {
                 strong_self->_send_config_frames_once = false;
             }
 
+            if (strong_self->_shared_rewrite) {
+                // 只有一个播放器时共享改写没有收益，反而多一次内存分配与拷贝
+                // With a single player sharing gains nothing and only adds an allocation and a copy
+                auto src = strong_self->_play_src.lock();
+                if (src && src->readerCount() >= 2) {
+                    strong_self->onSendRtpList(pkt);
+                    return;
+                }
+            }
+
             size_t i = 0;
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 if (strong_self->_bfliter_flag) {
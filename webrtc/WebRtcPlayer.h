@@ -158,6 +158,7 @@ private:
 
     bool _is_h264 { false };
     bool _bfliter_flag { false };
+    bool _shared_rewrite { false };
     std::shared_ptr<H264BFrameFilter> _bfilter;
 };
 
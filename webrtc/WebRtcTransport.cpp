@@ -16,6 +16,7 @@
 #include "Util/base64.h"
 #include "Network/sockutil.h"
 #include "Common/config.h"
+#include "Common/Metrics.h"
 #include "Nack.h"
 #include "RtpExt.h"
 #include "Rtcp/Rtcp.h"
@@ -745,6 +746,7 @@ void WebRtcTransport::inputSockData(const char *buf, int len, const SocketHelper
 void WebRtcTransport::inputSockData(const char *buf, int len, const IceTransport::Pair::Ptr& pair) {
     // DebugL;
     _recv_ticker.resetTime();
+    Metrics::webrtc.bytes_in.add(len);
     if (_ice_agent->processSocketData((const uint8_t *)buf, len, pair)) {
         return;
     }
@@ -789,6 +791,32 @@ void WebRtcTransport::sendRtpPacket(const char *buf, int len, bool flush, void *
     }
 }
 
+void WebRtcTransport::sendRewrittenRtpList(const std::vector<std::pair<const Buffer *, uint32_t>> &list) {
+    if (!_srtp_session_send || list.empty()) {
+        return;
+    }
+    // libsrtp没有多包加密接口，这里先连续加密整组rtp(密钥上下文保持在缓存中)，再统一发送
+    // libsrtp has no multi-packet protect api, so the whole list is encrypted back to back first
+    // (keeping the key context hot in cache) and only then handed to the socket
+    _encrypted_batch.clear();
+    _encrypted_batch.reserve(list.size());
+    for (auto &pr : list) {
+        auto len = (int)pr.first->size();
+        auto pkt = _packet_pool.obtain2();
+        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN);
+        memcpy(pkt->data(), pr.first->data(), len);
+        ((RtpHeader *)pkt->data())->ssrc = htonl(pr.second);
+        if (_srtp_session_send->EncryptRtp(reinterpret_cast<uint8_t *>(pkt->data()), &len)) {
+            pkt->setSize(len);
+            _encrypted_batch.emplace_back(std::move(pkt));
+        }
+    }
+    for (size_t i = 0; i < _encrypted_batch.size(); ++i) {
+        onSendSockData(std::move(_encrypted_batch[i]), i + 1 == _encrypted_batch.size());
+    }
+    _encrypted_batch.clear();
+}
+
 void WebRtcTransport::sendRtcpPacket(const char *buf, int len, bool flush, void *ctx) {
     if (_srtp_session_send) {
         auto pkt = _packet_pool.obtain2();
@@ -961,6 +989,12 @@ void WebRtcTransportImp::onStartWebRTC() {
             ++index;
         }
     }
+
+    for (auto &track : _type_to_track) {
+        if (track) {
+            _send_rewrite_key += to_string((int)track->media->type) + ':' + to_string((int)track->plan_rtp->pt) + ':' + track->rtp_ext_ctx->getSendKey() + '|';
+        }
+    }
 }
 
 void WebRtcTransportImp::onCheckAnswer(RtcSession &sdp) {
@@ -1332,6 +1366,7 @@ void WebRtcTransportImp::updateTicker() {
 
 void WebRtcTransportImp::onRtp(const char *buf, size_t len, uint64_t stamp_ms) {
     _bytes_usage += len;
+    Metrics::webrtc.packets_in.add();
     _alive_ticker.resetTime();
 
     RtpHeader *rtp = (RtpHeader *)buf;
@@ -1492,15 +1527,21 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
         // 发送rtx重传包  [AUTO-TRANSLATED:ae60e1fd]
         // Send RTX retransmission packets
         // TraceL << "send rtx rtp:" << rtp->getSeq();
+        Metrics::nack_retransmits_webrtc.add();
     }
     pair<bool /*rtx*/, MediaTrack *> ctx { rtx, track.get() };
     sendRtpPacket(rtp->data() + RtpPacket::kRtpTcpHeaderSize, rtp->size() - RtpPacket::kRtpTcpHeaderSize, flush, &ctx);
     _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    Metrics::webrtc.packets_out.add();
+    Metrics::webrtc.bytes_out.add(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+    onSendRtcpSR(*track);
+}
 
+void WebRtcTransportImp::onSendRtcpSR(MediaTrack &track) {
     if (_rtcp_sr_send_ticker.elapsedTime() > 5000) {
         _rtcp_sr_send_ticker.resetTime();
-        if (track->rtcp_context_send) {
-            auto sr = track->rtcp_context_send->createRtcpSR(track->answer_ssrc_rtp);
+        if (track.rtcp_context_send) {
+            auto sr = track.rtcp_context_send->createRtcpSR(track.answer_ssrc_rtp);
             if (sr && sr->size() > 0) {
                 sendRtcpPacket(sr->data(), sr->size(), true);
             }
@@ -1508,6 +1549,85 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
     }
 }
 
+SharedRtpRewriteCache &SharedRtpRewriteCache::Instance() {
+    static thread_local SharedRtpRewriteCache s_instance;
+    return s_instance;
+}
+
+const vector<Buffer::Ptr> &SharedRtpRewriteCache::get(const RtspMediaSource::RingDataType &pkt, const string &key, const RewriteCB &cb) {
+    if (_pkt.lock() != pkt) {
+        // 新的一组rtp，清空上一组的缓存
+        // A new rtp batch, drop the cache of the previous one
+        _pkt = pkt;
+        _cache.clear();
+    }
+    auto it = _cache.find(key);
+    if (it != _cache.end()) {
+        return it->second;
+    }
+    auto &ret = _cache[key];
+    ret.reserve(pkt->size());
+    pkt->for_each([&](const RtpPacket::Ptr &rtp) { ret.emplace_back(cb(rtp)); });
+    return ret;
+}
+
+Buffer::Ptr WebRtcTransportImp::rewriteRtp(const RtpPacket::Ptr &rtp) {
+    auto &track = _type_to_track[rtp->type];
+    if (!track) {
+        // 对方不支持该编码类型
+        // The other party does not support this encoding type
+        return nullptr;
+    }
+    auto len = rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    auto ret = BufferRaw::create();
+    ret->setCapacity(len + SRTP_MAX_TRAILER_LEN);
+    memcpy(ret->data(), rtp->data() + RtpPacket::kRtpTcpHeaderSize, len);
+    ret->setSize(len);
+    auto header = (RtpHeader *)ret->data();
+    track->rtp_ext_ctx->changeRtpExtId(header, false);
+    header->pt = track->plan_rtp->pt;
+    return ret;
+}
+
+void WebRtcTransportImp::onSendRtpList(const RtspMediaSource::RingDataType &pkt) {
+    auto &rewritten = SharedRtpRewriteCache::Instance().get(pkt, _send_rewrite_key, [this](const RtpPacket::Ptr &rtp) {
+        return rewriteRtp(rtp);
+    });
+
+    size_t i = 0;
+    size_t bytes = 0;
+    MediaTrack *sr_track = nullptr;
+    _send_list.clear();
+    pkt->for_each([&](const RtpPacket::Ptr &rtp) {
+        auto &buf = rewritten[i++];
+        if (!buf) {
+            return;
+        }
+        bytes += buf->size();
+        auto &track = _type_to_track[rtp->type];
+        // 统计rtp发送情况，好做sr汇报
+        // Statistics of RTP sending, for SR reporting
+        track->rtcp_context_send->onRtp(
+            rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate,
+            rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+        track->nack_list.pushBack(rtp);
+        _send_list.emplace_back(buf.get(), track->answer_ssrc_rtp);
+        if (!sr_track) {
+            sr_track = track.get();
+        }
+    });
+    sendRewrittenRtpList(_send_list);
+    _bytes_usage += bytes;
+    if (sr_track) {
+        // 与逐包发送一致，sr定时器到期后由首个发送的track汇报
+        // Like the per-packet path, the first track sent after the sr timer expires reports
+        onSendRtcpSR(*sr_track);
+    }
+    Metrics::webrtc.packets_out.add(_send_list.size());
+    Metrics::webrtc.bytes_out.add(bytes);
+    _send_list.clear();
+}
+
 void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx) {
     auto pr = (pair<bool /*rtx*/, MediaTrack *> *)ctx;
     auto header = (RtpHeader *)buf;
@@ -145,6 +145,10 @@ public:
     void inputSockData(const char *buf, int len, const toolkit::SocketHelper::Ptr& socket, struct sockaddr *addr = nullptr, int addr_len = 0);
     void inputSockData(const char *buf, int len, const IceTransport::Pair::Ptr& pair = nullptr);
     void sendRtpPacket(const char *buf, int len, bool flush, void *ctx = nullptr);
+    // 批量发送已改写好pt/rtp ext的明文rtp(替换ssrc后加密)，先整组加密再一次性交给socket，仅最后一个flush
+    // Send a list of plain rtp whose pt/rtp ext are already rewritten (ssrc patched before encryption);
+    // the whole list is encrypted first, then handed to the socket with a single flush on the last one
+    void sendRewrittenRtpList(const std::vector<std::pair<const toolkit::Buffer *, uint32_t /*ssrc*/>> &list);
     void sendRtcpPacket(const char *buf, int len, bool flush, void *ctx = nullptr);
     void sendDatachannel(uint16_t streamId, uint32_t ppid, const char *msg, size_t len);
 
@@ -248,6 +252,9 @@ private:
     // 循环池  [AUTO-TRANSLATED:b7059f37]
     // Cycle pool
     toolkit::ResourcePool<toolkit::BufferRaw> _packet_pool;
+    // sendRewrittenRtpList的加密结果暂存
+    // Encrypted packets of sendRewrittenRtpList awaiting the socket
+    std::vector<toolkit::BufferRaw::Ptr> _encrypted_batch;
 
     //超时功能实现
     toolkit::Ticker _recv_ticker;
@@ -260,6 +267,27 @@ private:
 #endif
 };
 
+/**
+ * 同一线程内，同一组rtp按协商签名缓存改写后(pt/rtp ext)的明文rtp
+ * 同一个rtsp环形缓存的读取器在同一个线程内是连续回调的，所以第一个播放器负责改写，后续播放器直接复用，
+ * 每个播放器只需要拷贝、替换ssrc并加密(srtp密钥每个会话都不一样，无法共享密文)
+ * Caches the rewritten (pt/rtp ext) plain rtp of one rtp batch per negotiation signature within a thread.
+ * Readers of the same rtsp ring are called back consecutively on one thread, so the first player rewrites and the
+ * following players reuse the result; each player only copies, patches the ssrc and encrypts
+ * (srtp keys differ per session, so ciphertext can not be shared)
+ */
+class SharedRtpRewriteCache {
+public:
+    using RewriteCB = std::function<toolkit::Buffer::Ptr(const RtpPacket::Ptr &rtp)>;
+
+    static SharedRtpRewriteCache &Instance();
+    const std::vector<toolkit::Buffer::Ptr> &get(const RtspMediaSource::RingDataType &pkt, const std::string &key, const RewriteCB &cb);
+
+private:
+    std::weak_ptr<toolkit::List<RtpPacket::Ptr>> _pkt;
+    std::unordered_map<std::string /*rewrite key*/, std::vector<toolkit::Buffer::Ptr>> _cache;
+};
+
 class RtpChannel;
 class MediaTrack {
 public:
@@ -319,6 +347,9 @@ public:
     bool canSendRtp(const RtcMedia& media) const;
     bool canRecvRtp(const RtcMedia& media) const;
     void onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx = false);
+    // 批量发送rtsp环形缓存中的一组rtp，同线程内协商参数一致的播放器共享改写后的明文rtp
+    // Send a batch of rtp from the rtsp ring, players on the same thread with identical negotiation share the rewritten plain rtp
+    void onSendRtpList(const RtspMediaSource::RingDataType &pkt);
 
     void createRtpChannel(const std::string &rid, uint32_t ssrc, MediaTrack &track);
     void safeShutdown(const toolkit::SockException &ex);
@@ -355,6 +386,8 @@ private:
     void onSortedRtp(MediaTrack &track, const std::string &rid, RtpPacket::Ptr rtp);
     void onSendNack(MediaTrack &track, const FCI_NACK &nack, uint32_t ssrc);
     void onSendTwcc(uint32_t ssrc, const std::string &twcc_fci);
+    void onSendRtcpSR(MediaTrack &track);
+    toolkit::Buffer::Ptr rewriteRtp(const RtpPacket::Ptr &rtp);
 
     void registerSelf();
     void unregisterSelf();
@@ -389,12 +422,18 @@ private:
     // 根据发送rtp的track类型获取相关信息  [AUTO-TRANSLATED:ff31c272]
     // Get relevant information based on the track type of the sent rtp
     MediaTrack::Ptr _type_to_track[2];
+    // onSendRtpList待加密发送的明文rtp
+    // Plain rtp of onSendRtpList pending encryption
+    std::vector<std::pair<const toolkit::Buffer *, uint32_t>> _send_list;
     // 根据rtcp的ssrc获取相关信息，收发rtp和rtx的ssrc都会记录  [AUTO-TRANSLATED:6c57cd48]
     // Get relevant information based on the ssrc of the rtcp, the ssrc of sending and receiving rtp and rtx will be recorded
     std::unordered_map<uint32_t/*ssrc*/, MediaTrack::Ptr> _ssrc_to_track;
     // 根据接收rtp的pt获取相关信息  [AUTO-TRANSLATED:39e56d7d]
     // Get relevant information based on the pt of the received rtp
     std::unordered_map<uint8_t/*pt*/, std::unique_ptr<WrappedMediaTrack>> _pt_to_track;
+    // 发送rtp时pt与rtp ext改写规则的签名，用于多个播放器共享改写结果
+    // Signature of the pt/rtp ext rewrite rule for sending rtp, used to share rewritten rtp between players
+    std::string _send_rewrite_key;
     std::vector<SdpAttrCandidate> _cands;
     // http访问时的host ip  [AUTO-TRANSLATED:e8fe6957]
     // Host ip for http access